@@ -0,0 +1,43 @@
+//Vertex Shader
+#if defined(VS_BUILD)
+layout(location = 0) in vec3 _Vertex;
+layout(location = 1) in vec2 _TexCoord;
+
+layout(location = 2) in vec4 _BoneIndices;
+layout(location = 3) in vec4 _BoneWeights;
+
+layout(location = 4) in vec3 _Normal;
+layout(location = 5) in vec3 _Tangent;
+
+// Per instance, a mat4 takes four attribute locations
+layout(location = 6) in mat4 _InstanceModel;
+
+out vec3 _FragVertex;
+out vec2 _FragTexCoord;
+out vec3 _FragNormal;
+out vec3 _FragTangent;
+
+out vec3 _FragBiTangent;
+
+out vec3 _FragPosition;
+
+uniform mat4 C_viewProj;
+
+void main()
+{
+	_FragVertex = _Vertex;
+	_FragTexCoord = _TexCoord;
+	_FragNormal = mat3(transpose(inverse(_InstanceModel))) * _Normal;
+	_FragTangent = _Tangent;
+	_FragPosition = vec3(_InstanceModel * vec4(_Vertex, 1.0));
+	_FragBiTangent = cross(_Normal, _Tangent);
+
+	gl_Position = C_viewProj * _InstanceModel * vec4(_Vertex, 1.0);
+}
+
+//Fragment Shader
+#elif defined(FS_BUILD)
+
+#include "forward-lighting-fragment.glh"
+
+#endif
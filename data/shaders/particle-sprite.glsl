@@ -0,0 +1,50 @@
+//Vertex Shader
+#if defined(VS_BUILD)
+// Per instance, xyz is the particle's position and w its density
+layout(location = 0) in vec4 _Particle;
+
+out vec2 _FragCorner;
+out vec4 _FragTint;
+
+uniform mat4 viewProj;
+uniform vec3 cameraRight;
+uniform vec3 cameraUp;
+uniform float particleSize;
+uniform vec4 sparseColor;
+uniform vec4 denseColor;
+
+void main()
+{
+	// Triangle strip corners of a quad, so no quad buffer is needed
+	vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+
+	// Particles inside a body of fluid shrink a little so the body reads as one surface
+	float density = clamp(_Particle.w, 0.0, 1.0);
+	float size = particleSize * mix(1.0, 0.75, density);
+	vec3 position = _Particle.xyz + (cameraRight * corner.x + cameraUp * corner.y) * size;
+
+	_FragCorner = corner;
+	_FragTint = mix(sparseColor, denseColor, density);
+	gl_Position = viewProj * vec4(position, 1.0);
+}
+
+//Fragment Shader
+#elif defined(FS_BUILD)
+in vec2 _FragCorner;
+in vec4 _FragTint;
+
+out vec4 _FragColor;
+
+void main()
+{
+	float distanceSquared = dot(_FragCorner, _FragCorner);
+	if (distanceSquared > 1.0)
+	{
+		discard;
+	}
+	// Shade the sprite like a sphere lit from the camera
+	float facing = sqrt(1.0 - distanceSquared);
+	_FragColor = vec4(_FragTint.rgb * (0.4 + 0.6 * facing), _FragTint.a);
+}
+
+#endif
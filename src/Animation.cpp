@@ -0,0 +1,173 @@
+#include "Animation.h"
+
+// Other
+#include <FBXFile.h>
+#include <xmmintrin.h>
+#include <algorithm>
+
+const float AnimationRig::FRAMES_PER_SECOND = 24.0f;
+
+// result = a * b, columns are built as weighted sums of a's columns.
+// _result may alias _b, each column of _b is read before it is written.
+static inline void MultiplyMatrices(const mat4& _a, const mat4& _b, mat4& _result) {
+	const float* a = &_a[0][0];
+	const float* b = &_b[0][0];
+	float* result = &_result[0][0];
+	__m128 a0 = _mm_loadu_ps(a);
+	__m128 a1 = _mm_loadu_ps(a + 4);
+	__m128 a2 = _mm_loadu_ps(a + 8);
+	__m128 a3 = _mm_loadu_ps(a + 12);
+	for (unsigned int column = 0; column < 4; ++column) {
+		const float* bColumn = b + column * 4;
+		__m128 sum = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(bColumn[0])), _mm_mul_ps(a1, _mm_set1_ps(bColumn[1]))),
+			_mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(bColumn[2])), _mm_mul_ps(a3, _mm_set1_ps(bColumn[3]))));
+		_mm_storeu_ps(result + column * 4, sum);
+	}
+}
+static inline void ComposeMatrix(const BonePose& _pose, mat4& _result) {
+	_result = glm::mat4_cast(_pose.rotation);
+	_result[0] *= _pose.scale.x;
+	_result[1] *= _pose.scale.y;
+	_result[2] *= _pose.scale.z;
+	_result[3] = vec4(_pose.translation, 1.0f);
+}
+
+// Public
+void AnimationClip::Sample(float _time, bool _loop, BonePose* _pose) const {
+	float time = 0.0f;
+	if (duration > 0.0f) {
+		if (_loop) {
+			time = fmodf(_time, duration);
+			if (time < 0.0f) {
+				time += duration;
+			}
+		} else {
+			time = glm::clamp(_time, 0.0f, duration);
+		}
+	}
+
+	for (unsigned int i = 0; i < tracks.size(); ++i) {
+		const AnimationTrack& track = tracks[i];
+		if (track.keys.empty()) {
+			continue;
+		}
+		BonePose& pose = _pose[track.bone];
+		unsigned int next = std::upper_bound(track.times.begin(), track.times.end(), time) - track.times.begin();
+		if (next == 0) {
+			pose = track.keys.front();
+		} else if (next == track.keys.size()) {
+			pose = track.keys.back();
+		} else {
+			float start = track.times[next - 1];
+			float end = track.times[next];
+			float weight = end > start ? (time - start) / (end - start) : 0.0f;
+			AnimationRig::BlendKey(track.keys[next - 1], track.keys[next], weight, pose);
+		}
+	}
+}
+
+AnimationRig::AnimationRig(const FBXSkeleton& _skeleton, const vector<FBXAnimation*>& _animations) :
+	boneCount(_skeleton.m_boneCount) {
+	// Note(Manny): Sorting by depth puts every parent before its children,
+	// whatever order the file listed the bones in
+	vector<unsigned int> depths(boneCount);
+	for (unsigned int i = 0; i < boneCount; ++i) {
+		unsigned int depth = 0;
+		int parent = _skeleton.m_parentIndex[i];
+		while (parent >= 0 && depth < boneCount) {
+			parent = _skeleton.m_parentIndex[parent];
+			depth++;
+		}
+		depths[i] = depth;
+	}
+	skeletonBones.resize(boneCount);
+	for (unsigned int i = 0; i < boneCount; ++i) {
+		skeletonBones[i] = i;
+	}
+	std::stable_sort(skeletonBones.begin(), skeletonBones.end(), [&depths](unsigned int _a, unsigned int _b) {
+		return depths[_a] < depths[_b];
+	});
+
+	vector<unsigned int> sortedBones(boneCount);
+	for (unsigned int i = 0; i < boneCount; ++i) {
+		sortedBones[skeletonBones[i]] = i;
+	}
+
+	parents.resize(boneCount);
+	bindPoses.resize(boneCount);
+	restPose.resize(boneCount);
+	for (unsigned int i = 0; i < boneCount; ++i) {
+		unsigned int bone = skeletonBones[i];
+		int parent = _skeleton.m_parentIndex[bone];
+		parents[i] = parent >= 0 ? (int)sortedBones[parent] : -1;
+		bindPoses[i] = _skeleton.m_bindPoses[bone];
+		restPose[i] = Decompose(_skeleton.m_nodes[bone]->m_localTransform);
+	}
+
+	// Frame numbers become seconds so sampling needs no knowledge of the file
+	for (unsigned int i = 0; i < _animations.size(); ++i) {
+		const FBXAnimation& animation = *_animations[i];
+		float startFrame = (float)animation.m_startFrame;
+
+		AnimationClip clip;
+		clip.name = animation.m_name;
+		clip.duration = ((float)animation.m_endFrame - startFrame) / FRAMES_PER_SECOND;
+		for (unsigned int j = 0; j < animation.m_trackCount; ++j) {
+			const FBXTrack& fbxTrack = animation.m_tracks[j];
+			if (fbxTrack.m_boneIndex >= boneCount) {
+				continue;
+			}
+			AnimationTrack track;
+			track.bone = sortedBones[fbxTrack.m_boneIndex];
+			track.times.resize(fbxTrack.m_keyframeCount);
+			track.keys.resize(fbxTrack.m_keyframeCount);
+			for (unsigned int k = 0; k < fbxTrack.m_keyframeCount; ++k) {
+				const FBXKeyFrame& keyFrame = fbxTrack.m_keyframes[k];
+				track.times[k] = ((float)keyFrame.m_key - startFrame) / FRAMES_PER_SECOND;
+				track.keys[k].translation = keyFrame.m_translation;
+				track.keys[k].rotation = keyFrame.m_rotation;
+				track.keys[k].scale = keyFrame.m_scale;
+			}
+			clip.tracks.push_back(track);
+		}
+		clips.push_back(clip);
+	}
+}
+void AnimationRig::BuildPalette(const BonePose* _pose, mat4* _globals, mat4* _palette) const {
+	// Parents come first, so their global transform is always ready
+	mat4 local;
+	for (unsigned int i = 0; i < boneCount; ++i) {
+		ComposeMatrix(_pose[i], local);
+		int parent = parents[i];
+		if (parent < 0) {
+			_globals[i] = local;
+		} else {
+			MultiplyMatrices(_globals[parent], local, _globals[i]);
+		}
+		MultiplyMatrices(_globals[i], bindPoses[i], _palette[skeletonBones[i]]);
+	}
+}
+
+// Static
+void AnimationRig::BlendPoses(const BonePose* _from, const BonePose* _to, float _weight, unsigned int _count, BonePose* _result) {
+	for (unsigned int i = 0; i < _count; ++i) {
+		BlendKey(_from[i], _to[i], _weight, _result[i]);
+	}
+}
+void AnimationRig::BlendKey(const BonePose& _from, const BonePose& _to, float _weight, BonePose& _result) {
+	// Note(Manny): A normalized lerp is close enough to a slerp between
+	// neighbouring keys, and it blends any number of poses the same way
+	quat to = glm::dot(_from.rotation, _to.rotation) < 0.0f ? -_to.rotation : _to.rotation;
+	_result.translation = glm::mix(_from.translation, _to.translation, _weight);
+	_result.rotation = glm::normalize(_from.rotation * (1.0f - _weight) + to * _weight);
+	_result.scale = glm::mix(_from.scale, _to.scale, _weight);
+}
+BonePose AnimationRig::Decompose(const mat4& _transform) {
+	BonePose pose;
+	pose.translation = vec3(_transform[3]);
+	pose.scale = vec3(glm::length(vec3(_transform[0])), glm::length(vec3(_transform[1])), glm::length(vec3(_transform[2])));
+	glm::mat3 rotation(vec3(_transform[0]) / pose.scale.x, vec3(_transform[1]) / pose.scale.y, vec3(_transform[2]) / pose.scale.z);
+	pose.rotation = glm::normalize(glm::quat_cast(rotation));
+	return pose;
+}
\ No newline at end of file
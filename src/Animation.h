@@ -0,0 +1,73 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: Animation.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: Skeletons and clips converted from the
+FBX data into a layout that is cheap to sample,
+blend and turn into skinning matrices.
+===============================================*/
+
+#ifndef _ANIMATION_H_
+#define _ANIMATION_H_
+
+// Utilities
+#include "GLM_Header.h"
+
+// Other
+#include <string>
+using std::string;
+#include <vector>
+using std::vector;
+
+// Forward declaration
+class FBXSkeleton;
+class FBXAnimation;
+
+struct BonePose {
+	vec3 translation;
+	quat rotation;
+	vec3 scale;
+};
+
+// Keys of one bone, sorted by time
+struct AnimationTrack {
+	unsigned int bone; //Index into the rig's sorted bones
+	vector<float> times; //Seconds from the start of the clip
+	vector<BonePose> keys;
+};
+
+class AnimationClip {
+public:
+	// Overwrites the pose of every bone the clip animates
+	void Sample(float _time, bool _loop, BonePose* _pose) const;
+
+	string name;
+	float duration; //Seconds
+	vector<AnimationTrack> tracks;
+};
+
+// Bones are stored parents first, so that one pass down the list builds every
+// global transform. Palettes are written back in the skeleton's own order,
+// which is the order the vertices' bone indices use.
+class AnimationRig {
+public:
+	AnimationRig(const FBXSkeleton& _skeleton, const vector<FBXAnimation*>& _animations);
+	void BuildPalette(const BonePose* _pose, mat4* _globals, mat4* _palette) const;
+	static void BlendPoses(const BonePose* _from, const BonePose* _to, float _weight, unsigned int _count, BonePose* _result);
+	static void BlendKey(const BonePose& _from, const BonePose& _to, float _weight, BonePose& _result);
+	static BonePose Decompose(const mat4& _transform);
+
+	unsigned int boneCount;
+	vector<int> parents; //Sorted index of each bone's parent, -1 for roots
+	vector<unsigned int> skeletonBones; //Skeleton index of each sorted bone
+	vector<mat4> bindPoses; //Inverse bind pose of each sorted bone
+	vector<BonePose> restPose;
+	vector<AnimationClip> clips;
+
+	static const float FRAMES_PER_SECOND; //Rate the FBX keys were baked at
+};
+
+#endif // _ANIMATION_H_
@@ -0,0 +1,177 @@
+#include "Animator.h"
+
+// Objects
+#include "GameObject.h"
+
+// Components
+#include "MeshRenderer.h"
+#include "ComponentPool.h"
+
+// Utilities
+#include "JobSystem.h"
+
+// GUI
+#include "imgui.h"
+
+// Debugging
+#include "Gizmos.h"
+
+// Other
+#include <chrono>
+
+bool Animator::drawBones = false;
+float Animator::updateTime = 0.0f;
+
+Animator::Animator(unsigned int _clip, float _speed, bool _loop) :
+	clip(_clip),
+	time(0.0f),
+	speed(_speed),
+	loop(_loop),
+	m_renderer(nullptr),
+	m_rig(nullptr),
+	m_fadeClip(0),
+	m_fadeTime(0.0f),
+	m_fadeElapsed(0.0f),
+	m_fadeDuration(0.0f) {}
+bool Animator::Startup() {
+	Bind();
+	return true;
+}
+void Animator::Shutdown() {
+	if (m_renderer != nullptr) {
+		m_renderer->drawCommandMesh.bones = nullptr;
+		m_renderer->drawCommandMesh.boneCount = 0;
+	}
+}
+bool Animator::Update() {
+	// Note(Manny): The pose is evaluated in UpdateAll, after every object has updated
+	if (transform && transform->isSelected) { Inspector(); }
+	return true;
+}
+void Animator::Inspector() {
+	ImGui::Begin("Inspector");
+	ImGui::BeginChild("Component", ImVec2(0, 0), true);
+	if (ImGui::TreeNode("Animator")) {
+		if (m_rig != nullptr) {
+			for (unsigned int i = 0; i < m_rig->clips.size(); ++i) {
+				if (ImGui::Selectable(m_rig->clips[i].name.c_str(), clip == i)) {
+					Play(i, 0.25f);
+				}
+			}
+			ImGui::Text("Bones: %u", m_rig->boneCount);
+		}
+		ImGui::DragFloat("Time", &time, 0.01f);
+		ImGui::DragFloat("Speed", &speed, 0.01f);
+		ImGui::Checkbox("Loop", &loop);
+		ImGui::TreePop();
+	}
+	ImGui::EndChild();
+	ImGui::End();
+}
+void Animator::Play(unsigned int _clip, float _fadeDuration) {
+	if (_fadeDuration > 0.0f && m_rig != nullptr) {
+		m_fadeClip = clip;
+		m_fadeTime = time;
+		m_fadeElapsed = 0.0f;
+		m_fadeDuration = _fadeDuration;
+	} else {
+		m_fadeDuration = 0.0f;
+	}
+	clip = _clip;
+	time = 0.0f;
+}
+
+// Static
+void Animator::UpdateAll(float _deltaTime) {
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	vector<Animator*>& animators = ComponentPool<Animator>::Get().components;
+
+	// Binding may build a model's rig, which only happens on this thread
+	for (unsigned int i = 0; i < animators.size(); ++i) {
+		animators[i]->Bind();
+	}
+
+	// Every animator only writes its own pose, so characters need no locking
+	JobSystem::ParallelFor(animators.size(), BATCH_SIZE, [&animators, _deltaTime](unsigned int _begin, unsigned int _end) {
+		for (unsigned int i = _begin; i < _end; ++i) {
+			animators[i]->Evaluate(_deltaTime);
+		}
+	});
+
+	if (drawBones) {
+		for (unsigned int i = 0; i < animators.size(); ++i) {
+			animators[i]->DrawBones();
+		}
+	}
+	updateTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Private
+bool Animator::Bind() {
+	if (m_rig != nullptr) {
+		return true;
+	}
+	if (m_renderer == nullptr) {
+		m_renderer = gameObject->GetComponent<MeshRenderer>();
+		if (m_renderer == nullptr) {
+			return false;
+		}
+	}
+	IndexedModel* model = m_renderer->mesh.model;
+	if (!model->isLoaded || model->GetRig() == nullptr || model->GetRig()->boneCount == 0) {
+		return false;
+	}
+
+	m_rig = model->GetRig();
+	m_pose = m_rig->restPose;
+	m_fadePose = m_rig->restPose;
+	m_globals.resize(m_rig->boneCount);
+	m_bones.resize(m_rig->boneCount);
+	m_renderer->drawCommandMesh.bones = &m_bones[0];
+	m_renderer->drawCommandMesh.boneCount = m_bones.size();
+	return true;
+}
+void Animator::Evaluate(float _deltaTime) {
+	if (m_rig == nullptr) {
+		return;
+	}
+	time += _deltaTime * speed;
+
+	// Bones a clip leaves alone keep their rest pose
+	const vector<AnimationClip>& clips = m_rig->clips;
+	m_pose = m_rig->restPose;
+	if (clip < clips.size()) {
+		clips[clip].Sample(time, loop, &m_pose[0]);
+	}
+
+	if (m_fadeDuration > 0.0f) {
+		m_fadeTime += _deltaTime * speed;
+		m_fadeElapsed += _deltaTime;
+		if (m_fadeElapsed >= m_fadeDuration || m_fadeClip >= clips.size()) {
+			m_fadeDuration = 0.0f;
+		} else {
+			m_fadePose = m_rig->restPose;
+			clips[m_fadeClip].Sample(m_fadeTime, loop, &m_fadePose[0]);
+			AnimationRig::BlendPoses(&m_fadePose[0], &m_pose[0], m_fadeElapsed / m_fadeDuration, m_rig->boneCount, &m_pose[0]);
+		}
+	}
+
+	m_rig->BuildPalette(&m_pose[0], &m_globals[0], &m_bones[0]);
+}
+void Animator::DrawBones() const {
+	if (m_rig == nullptr) {
+		return;
+	}
+	const mat4& worldMatrix = transform->worldMatrix;
+	for (unsigned int i = 0; i < m_rig->boneCount; ++i) {
+		mat4 bone = worldMatrix * m_globals[i];
+		vec3 bonePosition = vec3(bone[3]);
+		Gizmos::AddAABBFilled(bonePosition, vec3(3.0f), vec4(1, 0, 0, 1), &bone);
+
+		int parent = m_rig->parents[i];
+		if (parent >= 0) {
+			vec3 parentPosition = vec3(worldMatrix * m_globals[parent][3]);
+			Gizmos::AddLine(bonePosition, parentPosition, vec4(0, 1, 0, 1));
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: Animator.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: Plays the animation clips of a skinned
+mesh and hands the finished bone matrices to
+the object's MeshRenderer.
+===============================================*/
+
+#ifndef _ANIMATOR_H_
+#define _ANIMATOR_H_
+
+// Components
+#include "Component.h"
+
+// Utilities
+#include "GLM_Header.h"
+#include "Animation.h"
+
+// Other
+#include <vector>
+using std::vector;
+
+// Forward declaration
+class MeshRenderer;
+
+class Animator : public Component {
+public:
+	Animator(unsigned int _clip = 0, float _speed = 1.0f, bool _loop = true);
+	virtual bool Startup();
+	virtual void Shutdown();
+	virtual bool Update();
+	void Inspector();
+	void Play(unsigned int _clip, float _fadeDuration = 0.0f); //Cross fades from the playing clip
+	inline const vector<mat4>& GetBones() const { return m_bones; }
+	// Evaluates every animator once, spread across the job system's workers
+	static void UpdateAll(float _deltaTime);
+
+	unsigned int clip;
+	float time; //Seconds into the clip
+	float speed;
+	bool loop;
+
+	static bool drawBones; //Draws every skeleton with gizmos, for debugging
+	static float updateTime; //Milliseconds the last UpdateAll took
+private:
+	bool Bind(); //Finds the renderer and rig once the mesh has loaded
+	void Evaluate(float _deltaTime);
+	void DrawBones() const;
+
+	static const unsigned int BATCH_SIZE = 16; //Animators evaluated per job
+
+	MeshRenderer* m_renderer;
+	AnimationRig* m_rig;
+	unsigned int m_fadeClip; //Clip fading out, while m_fadeDuration is above zero
+	float m_fadeTime;
+	float m_fadeElapsed;
+	float m_fadeDuration;
+	vector<BonePose> m_pose;
+	vector<BonePose> m_fadePose;
+	vector<mat4> m_globals; //Model space transform of each sorted bone
+	vector<mat4> m_bones; //Skinning palette, in the skeleton's bone order
+};
+
+#endif // _ANIMATOR_H_
@@ -0,0 +1,78 @@
+#include "AssetLoader.h"
+
+// Utilities
+#include "JobSystem.h"
+
+// Debugging
+#include "Debug.h"
+
+// Other
+#include <string>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+const double AssetLoader::UPLOAD_BUDGET = 0.002;
+double AssetLoader::lastUploadTime = 0.0;
+std::mutex AssetLoader::sm_uploadMutex;
+deque<std::function<void()> > AssetLoader::sm_uploads;
+std::atomic<int> AssetLoader::sm_pendingCount(0);
+unsigned int AssetLoader::sm_batchCount = 0;
+Clock::time_point AssetLoader::sm_batchStart;
+
+// Static
+void AssetLoader::Load(const std::function<void()>& _load, const std::function<void()>& _upload) {
+	if (sm_pendingCount++ == 0) {
+		sm_batchCount = 0;
+		sm_batchStart = Clock::now();
+	}
+	sm_batchCount++;
+
+	// Imports can take seconds, so they never run on the main thread while it waits for other jobs
+	JobSystem::RunBackground([_load, _upload]() {
+		_load();
+		std::lock_guard<std::mutex> lock(sm_uploadMutex);
+		sm_uploads.push_back(_upload);
+	});
+}
+void AssetLoader::Update(double _budget) {
+	Clock::time_point start = Clock::now();
+	double elapsed = 0.0;
+	do {
+		std::function<void()> upload;
+		{
+			std::lock_guard<std::mutex> lock(sm_uploadMutex);
+			if (sm_uploads.empty()) {
+				break;
+			}
+			upload = sm_uploads.front();
+			sm_uploads.pop_front();
+		}
+		upload();
+
+		elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		if (--sm_pendingCount == 0) {
+			// Note(Manny): Time from the first request until everything is drawable
+			double loadTime = std::chrono::duration<double>(Clock::now() - sm_batchStart).count();
+			Debug::Log("Loaded " + std::to_string(sm_batchCount) + " assets in " +
+				std::to_string((int)(loadTime * 1000.0)) + "ms");
+		}
+	} while (elapsed < _budget);
+	lastUploadTime = elapsed;
+}
+void AssetLoader::Flush() {
+	while (sm_pendingCount.load() > 0) {
+		bool hasUpload;
+		{
+			std::lock_guard<std::mutex> lock(sm_uploadMutex);
+			hasUpload = !sm_uploads.empty();
+		}
+		if (hasUpload) {
+			Update(0.0);
+		} else if (!JobSystem::RunPendingJob()) {
+			std::this_thread::yield();
+		}
+	}
+}
+unsigned int AssetLoader::GetPendingCount() {
+	return (unsigned int)sm_pendingCount.load();
+}
\ No newline at end of file
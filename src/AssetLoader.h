@@ -0,0 +1,44 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: AssetLoader.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: Reads and decodes assets on the job
+system's workers, then hands them back to the
+main thread to create their GL objects.
+===============================================*/
+
+#ifndef _ASSET_LOADER_H_
+#define _ASSET_LOADER_H_
+
+// Other
+#include <deque>
+using std::deque;
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+
+class AssetLoader {
+public:
+	// _load runs on a worker and must not touch GL, _upload runs on the
+	// main thread during a later Update
+	static void Load(const std::function<void()>& _load, const std::function<void()>& _upload);
+	// Runs finished uploads until _budget seconds have passed, at least one runs every frame
+	static void Update(double _budget = UPLOAD_BUDGET);
+	static void Flush(); //Finishes every pending load on the calling thread
+	static unsigned int GetPendingCount();
+
+	static const double UPLOAD_BUDGET;
+	static double lastUploadTime; //Seconds spent uploading during the last update
+private:
+	static std::mutex sm_uploadMutex;
+	static deque<std::function<void()> > sm_uploads;
+	static std::atomic<int> sm_pendingCount;
+	static unsigned int sm_batchCount; //Assets requested since the loader was last idle
+	static std::chrono::high_resolution_clock::time_point sm_batchStart;
+};
+
+#endif // _ASSET_LOADER_H_
@@ -0,0 +1,316 @@
+#include "BoundsTree.h"
+
+// Other
+#include <algorithm>
+#include <cfloat>
+#include <utility>
+using std::pair;
+
+// Public
+void BoundsTree::Build(const vector<const Bounds*>& _bounds) {
+	m_bounds = _bounds;
+	m_items.clear();
+	m_nodes.clear();
+	m_centers.resize(m_bounds.size());
+	for (unsigned int i = 0; i < m_bounds.size(); ++i) {
+		if (m_bounds[i] == nullptr) {
+			continue;
+		}
+		m_items.push_back(i);
+		m_centers[i] = (m_bounds[i]->min + m_bounds[i]->max) * 0.5f;
+	}
+	if (m_items.empty()) {
+		m_builtSurfaceArea = 0.0f;
+		return;
+	}
+
+	m_nodes.reserve(m_items.size() * 2 / LEAF_SIZE + 1);
+	BuildNode(0, m_items.size());
+	m_builtSurfaceArea = GetSurfaceArea();
+}
+void BoundsTree::Refit() {
+	// Children always come after their parent, so walking backwards is bottom up
+	for (unsigned int i = m_nodes.size(); i-- > 0;) {
+		Node& node = m_nodes[i];
+		if (node.count == 0) {
+			const Node& left = m_nodes[i + 1];
+			const Node& right = m_nodes[node.first];
+			node.min = glm::min(left.min, right.min);
+			node.max = glm::max(left.max, right.max);
+			continue;
+		}
+		vec3 min(FLT_MAX);
+		vec3 max(-FLT_MAX);
+		for (unsigned int j = node.first; j < node.first + node.count; ++j) {
+			const Bounds& bounds = *m_bounds[m_items[j]];
+			min = glm::min(min, bounds.min);
+			max = glm::max(max, bounds.max);
+		}
+		node.min = min;
+		node.max = max;
+	}
+}
+bool BoundsTree::Raycast(const Ray& _ray, float _maxDistance, const IntersectFunction& _intersect, unsigned int& _item, float& _distance) const {
+	if (m_nodes.empty()) {
+		return false;
+	}
+
+	float closest = _maxDistance;
+	bool found = false;
+	unsigned int stack[STACK_SIZE];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		unsigned int nodeIndex = stack[--stackSize];
+		const Node& node = m_nodes[nodeIndex];
+		float distance;
+		if (!IntersectRay(node, _ray, closest, distance)) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (unsigned int i = node.first; i < node.first + node.count; ++i) {
+				const Bounds& bounds = *m_bounds[m_items[i]];
+				Node box = { bounds.min, bounds.max, 0, 0 };
+				if (IntersectRay(box, _ray, closest, distance) &&
+					_intersect(m_items[i], closest, distance) && distance < closest) {
+					closest = distance;
+					_item = m_items[i];
+					found = true;
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first so the farther one is more likely to be skipped
+		unsigned int left = nodeIndex + 1;
+		unsigned int right = node.first;
+		float leftDistance, rightDistance;
+		bool hitLeft = IntersectRay(m_nodes[left], _ray, closest, leftDistance);
+		bool hitRight = IntersectRay(m_nodes[right], _ray, closest, rightDistance);
+		if (hitLeft && hitRight) {
+			if (leftDistance < rightDistance) {
+				std::swap(left, right);
+			}
+			stack[stackSize++] = left;
+			stack[stackSize++] = right;
+		} else if (hitLeft) {
+			stack[stackSize++] = left;
+		} else if (hitRight) {
+			stack[stackSize++] = right;
+		}
+	}
+	_distance = closest;
+	return found;
+}
+void BoundsTree::RaycastAll(const Ray& _ray, float _maxDistance, const IntersectFunction& _intersect, vector<unsigned int>& _items, vector<float>& _distances) const {
+	_items.clear();
+	_distances.clear();
+	if (m_nodes.empty()) {
+		return;
+	}
+
+	unsigned int stack[STACK_SIZE];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		unsigned int nodeIndex = stack[--stackSize];
+		const Node& node = m_nodes[nodeIndex];
+		float distance;
+		if (!IntersectRay(node, _ray, _maxDistance, distance)) {
+			continue;
+		}
+		if (node.count == 0) {
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = nodeIndex + 1;
+			continue;
+		}
+		for (unsigned int i = node.first; i < node.first + node.count; ++i) {
+			const Bounds& bounds = *m_bounds[m_items[i]];
+			Node box = { bounds.min, bounds.max, 0, 0 };
+			if (IntersectRay(box, _ray, _maxDistance, distance) && _intersect(m_items[i], _maxDistance, distance)) {
+				_items.push_back(m_items[i]);
+				_distances.push_back(distance);
+			}
+		}
+	}
+}
+void BoundsTree::OverlapSphere(const vec3& _center, float _radius, vector<unsigned int>& _items) const {
+	_items.clear();
+	if (m_nodes.empty()) {
+		return;
+	}
+
+	float radiusSquared = _radius * _radius;
+	unsigned int stack[STACK_SIZE];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		unsigned int nodeIndex = stack[--stackSize];
+		const Node& node = m_nodes[nodeIndex];
+		if (GetDistanceSquared(node, _center) > radiusSquared) {
+			continue;
+		}
+		if (node.count == 0) {
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = nodeIndex + 1;
+			continue;
+		}
+		for (unsigned int i = node.first; i < node.first + node.count; ++i) {
+			const Bounds& bounds = *m_bounds[m_items[i]];
+			Node box = { bounds.min, bounds.max, 0, 0 };
+			if (GetDistanceSquared(box, _center) <= radiusSquared) {
+				_items.push_back(m_items[i]);
+			}
+		}
+	}
+}
+void BoundsTree::OverlapBox(const vec3& _center, const vec3& _halfSize, vector<unsigned int>& _items) const {
+	_items.clear();
+	if (m_nodes.empty()) {
+		return;
+	}
+
+	vec3 boxMin = _center - _halfSize;
+	vec3 boxMax = _center + _halfSize;
+	unsigned int stack[STACK_SIZE];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		unsigned int nodeIndex = stack[--stackSize];
+		const Node& node = m_nodes[nodeIndex];
+		if (glm::any(glm::lessThan(node.max, boxMin)) || glm::any(glm::greaterThan(node.min, boxMax))) {
+			continue;
+		}
+		if (node.count == 0) {
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = nodeIndex + 1;
+			continue;
+		}
+		for (unsigned int i = node.first; i < node.first + node.count; ++i) {
+			const Bounds& bounds = *m_bounds[m_items[i]];
+			if (!glm::any(glm::lessThan(bounds.max, boxMin)) && !glm::any(glm::greaterThan(bounds.min, boxMax))) {
+				_items.push_back(m_items[i]);
+			}
+		}
+	}
+}
+void BoundsTree::KNearest(const vec3& _point, unsigned int _count, vector<unsigned int>& _items) const {
+	_items.clear();
+	if (m_nodes.empty() || _count == 0) {
+		return;
+	}
+
+	// A max heap of the best items so far, the farthest of them on top
+	vector<pair<float, unsigned int> > nearest;
+	nearest.reserve(_count + 1);
+	float farthest = FLT_MAX;
+	unsigned int stack[STACK_SIZE];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		unsigned int nodeIndex = stack[--stackSize];
+		const Node& node = m_nodes[nodeIndex];
+		if (GetDistanceSquared(node, _point) >= farthest) {
+			continue;
+		}
+		if (node.count == 0) {
+			// Push the nearer child last so it is searched first
+			unsigned int left = nodeIndex + 1;
+			unsigned int right = node.first;
+			if (GetDistanceSquared(m_nodes[left], _point) < GetDistanceSquared(m_nodes[right], _point)) {
+				std::swap(left, right);
+			}
+			stack[stackSize++] = left;
+			stack[stackSize++] = right;
+			continue;
+		}
+		for (unsigned int i = node.first; i < node.first + node.count; ++i) {
+			const Bounds& bounds = *m_bounds[m_items[i]];
+			Node box = { bounds.min, bounds.max, 0, 0 };
+			float distance = GetDistanceSquared(box, _point);
+			if (distance >= farthest) {
+				continue;
+			}
+			nearest.push_back(pair<float, unsigned int>(distance, m_items[i]));
+			std::push_heap(nearest.begin(), nearest.end());
+			if (nearest.size() > _count) {
+				std::pop_heap(nearest.begin(), nearest.end());
+				nearest.pop_back();
+			}
+			if (nearest.size() == _count) {
+				farthest = nearest.front().first;
+			}
+		}
+	}
+
+	std::sort_heap(nearest.begin(), nearest.end());
+	for (unsigned int i = 0; i < nearest.size(); ++i) {
+		_items.push_back(nearest[i].second);
+	}
+}
+float BoundsTree::GetSurfaceArea() const {
+	if (m_nodes.empty()) {
+		return 0.0f;
+	}
+	return GetSurfaceArea(m_nodes[0].min, m_nodes[0].max);
+}
+
+// Private
+unsigned int BoundsTree::BuildNode(unsigned int _first, unsigned int _count) {
+	unsigned int nodeIndex = m_nodes.size();
+	m_nodes.push_back(Node());
+
+	vec3 min(FLT_MAX);
+	vec3 max(-FLT_MAX);
+	vec3 centerMin(FLT_MAX);
+	vec3 centerMax(-FLT_MAX);
+	for (unsigned int i = _first; i < _first + _count; ++i) {
+		const Bounds& bounds = *m_bounds[m_items[i]];
+		min = glm::min(min, bounds.min);
+		max = glm::max(max, bounds.max);
+		centerMin = glm::min(centerMin, m_centers[m_items[i]]);
+		centerMax = glm::max(centerMax, m_centers[m_items[i]]);
+	}
+	m_nodes[nodeIndex].min = min;
+	m_nodes[nodeIndex].max = max;
+
+	if (_count <= LEAF_SIZE) {
+		m_nodes[nodeIndex].first = _first;
+		m_nodes[nodeIndex].count = _count;
+		return nodeIndex;
+	}
+
+	// Split at the median of the axis the centers are most spread along
+	vec3 spread = centerMax - centerMin;
+	int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+	unsigned int half = _count / 2;
+	vector<vec3>& centers = m_centers;
+	std::nth_element(m_items.begin() + _first, m_items.begin() + _first + half, m_items.begin() + _first + _count,
+		[&centers, axis](unsigned int _a, unsigned int _b) { return centers[_a][axis] < centers[_b][axis]; });
+
+	// The left child is always the next node, only the right one is stored
+	BuildNode(_first, half);
+	unsigned int right = BuildNode(_first + half, _count - half);
+	m_nodes[nodeIndex].first = right;
+	m_nodes[nodeIndex].count = 0;
+	return nodeIndex;
+}
+bool BoundsTree::IntersectRay(const Node& _node, const Ray& _ray, float _maxDistance, float& _distance) {
+	// Slab test, a ray starting inside the box hits it at distance 0
+	vec3 t0 = (_node.min - _ray.origin) * _ray.invDirection;
+	vec3 t1 = (_node.max - _ray.origin) * _ray.invDirection;
+	vec3 tNear = glm::min(t0, t1);
+	vec3 tFar = glm::max(t0, t1);
+	float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+	float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, _maxDistance));
+	_distance = enter;
+	return enter <= exit;
+}
+float BoundsTree::GetDistanceSquared(const Node& _node, const vec3& _point) {
+	vec3 offset = glm::max(glm::max(_node.min - _point, _point - _node.max), vec3(0.0f));
+	return glm::dot(offset, offset);
+}
+float BoundsTree::GetSurfaceArea(const vec3& _min, const vec3& _max) {
+	vec3 size = glm::max(_max - _min, vec3(0.0f));
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
\ No newline at end of file
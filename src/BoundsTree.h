@@ -0,0 +1,74 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: BoundsTree.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: A bounding volume hierarchy over world
+space boxes, the tree behind the SpatialIndex.
+Queries return the indices the boxes were
+built with.
+===============================================*/
+
+#ifndef _BOUNDS_TREE_H_
+#define _BOUNDS_TREE_H_
+
+// Structs
+#include "Ray.h"
+#include "Bounds.h"
+
+// Utilities
+#include "GLM_Header.h"
+
+// Other
+#include <vector>
+using std::vector;
+#include <functional>
+
+// Split at the median of the widest axis. The boxes are read through the
+// pointers given to Build, so Refit picks up boxes that moved in place.
+// Nodes are flattened depth first, a branch's left child is the node after it.
+class BoundsTree {
+public:
+	// Tests an item the ray reached within _maxDistance, and sets the distance it was hit at
+	typedef std::function<bool(unsigned int _item, float _maxDistance, float& _distance)> IntersectFunction;
+
+	BoundsTree() : m_builtSurfaceArea(0.0f) {}
+	void Build(const vector<const Bounds*>& _bounds); //Null entries are left out of the tree
+	void Refit(); //Keeps the tree valid for boxes that moved, without making it tight again
+	// Closest item _intersect accepts, false if there is none
+	bool Raycast(const Ray& _ray, float _maxDistance, const IntersectFunction& _intersect, unsigned int& _item, float& _distance) const;
+	// Every item _intersect accepts, in no particular order
+	void RaycastAll(const Ray& _ray, float _maxDistance, const IntersectFunction& _intersect, vector<unsigned int>& _items, vector<float>& _distances) const;
+	void OverlapSphere(const vec3& _center, float _radius, vector<unsigned int>& _items) const;
+	void OverlapBox(const vec3& _center, const vec3& _halfSize, vector<unsigned int>& _items) const;
+	// The _count items whose boxes are closest to _point, closest first
+	void KNearest(const vec3& _point, unsigned int _count, vector<unsigned int>& _items) const;
+	float GetSurfaceArea() const; //Of the root box
+	inline float GetBuiltSurfaceArea() const { return m_builtSurfaceArea; }
+	inline bool IsEmpty() const { return m_nodes.empty(); }
+
+	static const unsigned int LEAF_SIZE = 4; //Most items kept in a leaf
+	static const unsigned int STACK_SIZE = 64; //Deeper than any median split tree gets
+private:
+	struct Node {
+		vec3 min;
+		vec3 max;
+		unsigned int first; //First item for leaves, right child for branches
+		unsigned int count; //Items in a leaf, 0 for branches whose left child is the next node
+	};
+
+	unsigned int BuildNode(unsigned int _first, unsigned int _count);
+	static bool IntersectRay(const Node& _node, const Ray& _ray, float _maxDistance, float& _distance);
+	static float GetDistanceSquared(const Node& _node, const vec3& _point);
+	static float GetSurfaceArea(const vec3& _min, const vec3& _max);
+
+	vector<const Bounds*> m_bounds; //Boxes the tree was built for
+	vector<unsigned int> m_items; //Box indices, grouped by leaf
+	vector<vec3> m_centers; //Scratch space for builds
+	vector<Node> m_nodes; //Parents always come before their children
+	float m_builtSurfaceArea;
+};
+
+#endif // _BOUNDS_TREE_H_
\ No newline at end of file
@@ -0,0 +1,367 @@
+#include "Broadphase.h"
+
+// Objects
+#include "GameObject.h"
+
+// Physics
+#include "PhysicsObject.h"
+
+// Components
+#include "Collider.h"
+#include "SphereCollider.h"
+#include "BoxCollider.h"
+
+// Other
+#include <algorithm>
+
+static float SurfaceArea(const vec3& _min, const vec3& _max) {
+	vec3 size = _max - _min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+// Broadphase
+void Broadphase::Update(vector<PhysicsObject*>& _actors, vector<BroadphasePair>& _pairs) {
+	GatherProxies(_actors);
+	_pairs.clear();
+	pairsTested = 0;
+
+	FindPairs(_pairs);
+	for (unsigned int i = 0; i < m_unbounded.size(); ++i) {
+		for (unsigned int j = 0; j < m_bounded.size(); ++j) {
+			AddPair(m_unbounded[i], m_bounded[j], _pairs);
+		}
+	}
+
+	// Note(Manny): Resolve in the same order the old actor loop did, so the
+	// result doesn't depend on which broadphase found the pairs
+	std::sort(_pairs.begin(), _pairs.end());
+}
+Broadphase* Broadphase::Create(BroadphaseType _type) {
+	switch (_type) {
+	case BROADPHASE_AABB_TREE: return new DynamicAABBTree();
+	default: return new SweepAndPrune();
+	}
+}
+bool Broadphase::Overlaps(const BroadphaseProxy& _a, const BroadphaseProxy& _b) {
+	return _a.min.x <= _b.max.x && _a.max.x >= _b.min.x &&
+		_a.min.y <= _b.max.y && _a.max.y >= _b.min.y &&
+		_a.min.z <= _b.max.z && _a.max.z >= _b.min.z;
+}
+void Broadphase::AddPair(unsigned int _proxyA, unsigned int _proxyB, vector<BroadphasePair>& _pairs) {
+	if (_proxyA > _proxyB) {
+		std::swap(_proxyA, _proxyB);
+	}
+	Collider* colliderA = m_proxies[_proxyA].collider;
+	Collider* colliderB = m_proxies[_proxyB].collider;
+	if (colliderA->gameObject == colliderB->gameObject) {
+		return;
+	}
+
+	BroadphasePair pair;
+	pair.colliderA = colliderA;
+	pair.colliderB = colliderB;
+	pair.proxyA = _proxyA;
+	pair.proxyB = _proxyB;
+	_pairs.push_back(pair);
+}
+void Broadphase::GatherProxies(vector<PhysicsObject*>& _actors) {
+	m_proxies.clear();
+	m_bounded.clear();
+	m_unbounded.clear();
+
+	for (unsigned int i = 0; i < _actors.size(); ++i) {
+		vector<Collider*>& colliders = _actors[i]->gameObject->colliders;
+		for (unsigned int j = 0; j < colliders.size(); ++j) {
+			Collider* collider = colliders[j];
+			// Note(Manny): Capsules and meshes have no narrowphase yet
+			if (!collider->enabled || collider->shapeId >= SHAPE_COUNT) {
+				continue;
+			}
+
+			BroadphaseProxy proxy;
+			proxy.collider = collider;
+			proxy.bounded = true;
+			switch (collider->shapeId) {
+			case SHAPE_SPHERE: {
+				SphereCollider* sphere = (SphereCollider*)collider;
+				proxy.min = sphere->transform->position - vec3(sphere->radius + collider->contactOffset);
+				proxy.max = sphere->transform->position + vec3(sphere->radius + collider->contactOffset);
+				break;
+			}
+			case SHAPE_BOX: {
+				// Bounds of the rotated box grown by the contact offset, bounds.size holds the half size
+				BoxCollider* box = (BoxCollider*)collider;
+				glm::mat3 rotation = glm::toMat3(box->transform->rotation);
+				vec3 extents = vec3(collider->contactOffset);
+				for (int axis = 0; axis < 3; ++axis) {
+					extents += glm::abs(rotation[axis]) * box->bounds.size[axis];
+				}
+				proxy.min = box->transform->position - extents;
+				proxy.max = box->transform->position + extents;
+				break;
+			}
+			default:
+				proxy.bounded = false;
+				proxy.min = proxy.max = vec3(0);
+				break;
+			}
+
+			if (proxy.bounded) {
+				m_bounded.push_back(m_proxies.size());
+			} else {
+				m_unbounded.push_back(m_proxies.size());
+			}
+			m_proxies.push_back(proxy);
+		}
+	}
+}
+
+// SweepAndPrune
+void SweepAndPrune::FindPairs(vector<BroadphasePair>& _pairs) {
+	ChooseAxis();
+	SortProxies();
+
+	for (unsigned int a = 0; a < m_order.size(); ++a) {
+		const BroadphaseProxy& proxyA = m_proxies[m_order[a]];
+		float maxA = proxyA.max[m_axis];
+		for (unsigned int b = a + 1; b < m_order.size(); ++b) {
+			const BroadphaseProxy& proxyB = m_proxies[m_order[b]];
+			if (proxyB.min[m_axis] > maxA) {
+				break;
+			}
+			pairsTested++;
+			if (Overlaps(proxyA, proxyB)) {
+				AddPair(m_order[a], m_order[b], _pairs);
+			}
+		}
+	}
+}
+void SweepAndPrune::ChooseAxis() {
+	if (m_bounded.empty()) {
+		return;
+	}
+	vec3 sum = vec3(0);
+	vec3 sumSqr = vec3(0);
+	for (unsigned int i = 0; i < m_bounded.size(); ++i) {
+		const BroadphaseProxy& proxy = m_proxies[m_bounded[i]];
+		vec3 center = (proxy.min + proxy.max) * 0.5f;
+		sum += center;
+		sumSqr += center * center;
+	}
+	float count = (float)m_bounded.size();
+	vec3 variance = sumSqr / count - (sum / count) * (sum / count);
+
+	m_axis = 0;
+	if (variance.y > variance[m_axis]) { m_axis = 1; }
+	if (variance.z > variance[m_axis]) { m_axis = 2; }
+}
+void SweepAndPrune::SortProxies() {
+	// Start from scratch whenever the set of colliders changed
+	bool changed = m_colliders.size() != m_bounded.size();
+	for (unsigned int i = 0; !changed && i < m_bounded.size(); ++i) {
+		changed = m_colliders[i] != m_proxies[m_bounded[i]].collider;
+	}
+	if (changed) {
+		m_colliders.resize(m_bounded.size());
+		for (unsigned int i = 0; i < m_bounded.size(); ++i) {
+			m_colliders[i] = m_proxies[m_bounded[i]].collider;
+		}
+		m_order = m_bounded;
+	}
+
+	for (unsigned int i = 1; i < m_order.size(); ++i) {
+		unsigned int proxy = m_order[i];
+		float min = m_proxies[proxy].min[m_axis];
+		int j = i - 1;
+		while (j >= 0 && m_proxies[m_order[j]].min[m_axis] > min) {
+			m_order[j + 1] = m_order[j];
+			j--;
+		}
+		m_order[j + 1] = proxy;
+	}
+}
+
+// DynamicAABBTree
+void DynamicAABBTree::FindPairs(vector<BroadphasePair>& _pairs) {
+	m_frame++;
+	vec3 fatMargin = vec3(margin);
+
+	for (unsigned int i = 0; i < m_bounded.size(); ++i) {
+		const BroadphaseProxy& proxy = m_proxies[m_bounded[i]];
+		map<Collider*, int>::iterator it = m_leaves.find(proxy.collider);
+
+		int leaf;
+		if (it == m_leaves.end()) {
+			leaf = AllocateNode();
+			m_nodes[leaf].min = proxy.min - fatMargin;
+			m_nodes[leaf].max = proxy.max + fatMargin;
+			InsertLeaf(leaf);
+			m_leaves[proxy.collider] = leaf;
+		} else {
+			leaf = it->second;
+			Node& node = m_nodes[leaf];
+			bool contained = glm::all(glm::greaterThanEqual(proxy.min, node.min)) &&
+				glm::all(glm::lessThanEqual(proxy.max, node.max));
+			if (!contained) {
+				RemoveLeaf(leaf);
+				m_nodes[leaf].min = proxy.min - fatMargin;
+				m_nodes[leaf].max = proxy.max + fatMargin;
+				InsertLeaf(leaf);
+			}
+		}
+		m_nodes[leaf].proxy = m_bounded[i];
+		m_nodes[leaf].frame = m_frame;
+	}
+
+	// Drop the leaves of colliders that are gone
+	for (map<Collider*, int>::iterator it = m_leaves.begin(); it != m_leaves.end();) {
+		if (m_nodes[it->second].frame != m_frame) {
+			RemoveLeaf(it->second);
+			FreeNode(it->second);
+			it = m_leaves.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for (unsigned int i = 0; i < m_bounded.size(); ++i) {
+		Query(m_bounded[i], _pairs);
+	}
+}
+int DynamicAABBTree::AllocateNode() {
+	int node;
+	if (m_freeNode != -1) {
+		node = m_freeNode;
+		m_freeNode = m_nodes[node].parent;
+	} else {
+		node = m_nodes.size();
+		m_nodes.push_back(Node());
+	}
+	m_nodes[node].parent = -1;
+	m_nodes[node].left = -1;
+	m_nodes[node].right = -1;
+	m_nodes[node].proxy = -1;
+	m_nodes[node].frame = 0;
+	return node;
+}
+void DynamicAABBTree::FreeNode(int _node) {
+	m_nodes[_node].parent = m_freeNode;
+	m_freeNode = _node;
+}
+void DynamicAABBTree::InsertLeaf(int _leaf) {
+	if (m_root == -1) {
+		m_root = _leaf;
+		m_nodes[_leaf].parent = -1;
+		return;
+	}
+
+	// Walk down towards the sibling that grows the tree's surface area the least
+	vec3 leafMin = m_nodes[_leaf].min;
+	vec3 leafMax = m_nodes[_leaf].max;
+	int index = m_root;
+	while (!m_nodes[index].IsLeaf()) {
+		const Node& node = m_nodes[index];
+		float area = SurfaceArea(node.min, node.max);
+		float combinedArea = SurfaceArea(glm::min(node.min, leafMin), glm::max(node.max, leafMax));
+		float cost = 2.0f * combinedArea;
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCosts[2];
+		int children[2] = { node.left, node.right };
+		for (int i = 0; i < 2; ++i) {
+			const Node& child = m_nodes[children[i]];
+			float childArea = SurfaceArea(glm::min(child.min, leafMin), glm::max(child.max, leafMax));
+			if (!child.IsLeaf()) {
+				childArea -= SurfaceArea(child.min, child.max);
+			}
+			childCosts[i] = childArea + inheritanceCost;
+		}
+
+		if (cost < childCosts[0] && cost < childCosts[1]) {
+			break;
+		}
+		index = childCosts[0] < childCosts[1] ? children[0] : children[1];
+	}
+
+	int sibling = index;
+	int oldParent = m_nodes[sibling].parent;
+	int newParent = AllocateNode();
+	m_nodes[newParent].parent = oldParent;
+	m_nodes[newParent].left = sibling;
+	m_nodes[newParent].right = _leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[_leaf].parent = newParent;
+
+	if (oldParent == -1) {
+		m_root = newParent;
+	} else if (m_nodes[oldParent].left == sibling) {
+		m_nodes[oldParent].left = newParent;
+	} else {
+		m_nodes[oldParent].right = newParent;
+	}
+	Refit(newParent);
+}
+void DynamicAABBTree::RemoveLeaf(int _leaf) {
+	if (_leaf == m_root) {
+		m_root = -1;
+		return;
+	}
+
+	int parent = m_nodes[_leaf].parent;
+	int grandParent = m_nodes[parent].parent;
+	int sibling = m_nodes[parent].left == _leaf ? m_nodes[parent].right : m_nodes[parent].left;
+
+	if (grandParent == -1) {
+		m_root = sibling;
+		m_nodes[sibling].parent = -1;
+	} else {
+		if (m_nodes[grandParent].left == parent) {
+			m_nodes[grandParent].left = sibling;
+		} else {
+			m_nodes[grandParent].right = sibling;
+		}
+		m_nodes[sibling].parent = grandParent;
+		Refit(grandParent);
+	}
+	FreeNode(parent);
+}
+void DynamicAABBTree::Refit(int _node) {
+	while (_node != -1) {
+		Node& node = m_nodes[_node];
+		node.min = glm::min(m_nodes[node.left].min, m_nodes[node.right].min);
+		node.max = glm::max(m_nodes[node.left].max, m_nodes[node.right].max);
+		_node = node.parent;
+	}
+}
+void DynamicAABBTree::Query(unsigned int _proxy, vector<BroadphasePair>& _pairs) {
+	if (m_root == -1) {
+		return;
+	}
+	const BroadphaseProxy& proxy = m_proxies[_proxy];
+
+	m_stack.clear();
+	m_stack.push_back(m_root);
+	while (!m_stack.empty()) {
+		const Node& node = m_nodes[m_stack.back()];
+		m_stack.pop_back();
+
+		pairsTested++;
+		bool overlaps = proxy.min.x <= node.max.x && proxy.max.x >= node.min.x &&
+			proxy.min.y <= node.max.y && proxy.max.y >= node.min.y &&
+			proxy.min.z <= node.max.z && proxy.max.z >= node.min.z;
+		if (!overlaps) {
+			continue;
+		}
+
+		if (node.IsLeaf()) {
+			// Both proxies find each other, only the lower one reports the pair
+			unsigned int other = node.proxy;
+			if (other > _proxy && Overlaps(proxy, m_proxies[other])) {
+				AddPair(_proxy, other, _pairs);
+			}
+		} else {
+			m_stack.push_back(node.left);
+			m_stack.push_back(node.right);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: Broadphase.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: Finds the pairs of colliders whose
+bounding boxes overlap so that only those
+pairs reach the narrowphase.
+===============================================*/
+
+#ifndef _BROADPHASE_H_
+#define _BROADPHASE_H_
+
+// Utilities
+#include "GLM_Header.h"
+
+// Other
+#include <vector>
+using std::vector;
+#include <map>
+using std::map;
+
+// Forward declaration
+class Collider;
+class PhysicsObject;
+
+enum BroadphaseType {
+	BROADPHASE_SWEEP_AND_PRUNE,
+	BROADPHASE_AABB_TREE
+};
+
+struct BroadphaseProxy {
+	Collider* collider;
+	vec3 min;
+	vec3 max;
+	bool bounded; //False for planes, which overlap everything
+};
+
+// colliderA always belongs to the actor that comes first in the actor list
+struct BroadphasePair {
+	Collider* colliderA;
+	Collider* colliderB;
+	unsigned int proxyA;
+	unsigned int proxyB;
+	bool operator<(const BroadphasePair& _other) const {
+		return proxyA != _other.proxyA ? proxyA < _other.proxyA : proxyB < _other.proxyB;
+	}
+};
+
+class Broadphase {
+public:
+	Broadphase() : pairsTested(0) {}
+	virtual ~Broadphase() {}
+	// Fills _pairs with every overlapping pair, each pair is only listed once
+	void Update(vector<PhysicsObject*>& _actors, vector<BroadphasePair>& _pairs);
+	static Broadphase* Create(BroadphaseType _type);
+	static bool Overlaps(const BroadphaseProxy& _a, const BroadphaseProxy& _b);
+
+	unsigned int pairsTested; //Box tests made during the last update
+protected:
+	virtual void FindPairs(vector<BroadphasePair>& _pairs) = 0;
+	void AddPair(unsigned int _proxyA, unsigned int _proxyB, vector<BroadphasePair>& _pairs);
+
+	vector<BroadphaseProxy> m_proxies; //Every collider, in actor order
+	vector<unsigned int> m_bounded; //Proxies the broadphase sorts
+	vector<unsigned int> m_unbounded; //Proxies paired with everything
+private:
+	void GatherProxies(vector<PhysicsObject*>& _actors);
+};
+
+// Keeps the proxies sorted by their minimum on the axis the colliders are
+// most spread along. The order barely changes between frames, so the
+// insertion sort that restores it is close to linear.
+class SweepAndPrune : public Broadphase {
+public:
+	SweepAndPrune() : m_axis(0) {}
+protected:
+	virtual void FindPairs(vector<BroadphasePair>& _pairs);
+private:
+	void ChooseAxis();
+	void SortProxies();
+
+	vector<Collider*> m_colliders; //Bounded colliders the order was built for
+	vector<unsigned int> m_order;
+	int m_axis;
+};
+
+// A bounding volume tree over fattened collider bounds. A leaf is only
+// reinserted once its collider moves out of the fattened box.
+class DynamicAABBTree : public Broadphase {
+public:
+	DynamicAABBTree() : margin(0.1f), m_root(-1), m_freeNode(-1), m_frame(0) {}
+
+	float margin; //How far the bounds are grown on every side
+protected:
+	virtual void FindPairs(vector<BroadphasePair>& _pairs);
+private:
+	struct Node {
+		vec3 min;
+		vec3 max;
+		int parent; //Doubles as the next free node once released
+		int left;
+		int right;
+		int proxy; //Proxy index for leaves, -1 for branches
+		unsigned int frame; //Last frame the leaf's collider was seen
+		inline bool IsLeaf() const { return left == -1; }
+	};
+
+	int AllocateNode();
+	void FreeNode(int _node);
+	void InsertLeaf(int _leaf);
+	void RemoveLeaf(int _leaf);
+	void Refit(int _node);
+	void Query(unsigned int _proxy, vector<BroadphasePair>& _pairs);
+
+	vector<Node> m_nodes;
+	vector<int> m_stack;
+	map<Collider*, int> m_leaves;
+	int m_root;
+	int m_freeNode;
+	unsigned int m_frame;
+};
+
+#endif // _BROADPHASE_H_
@@ -24,7 +24,7 @@ Copyright (c) 2015 Emmanuel Vaccaro
 class Rigidbody;
 class Collider : public Component {
 public:
-	Collider() : attachedRigidbody(nullptr), enabled(true) {}
+	Collider() : attachedRigidbody(nullptr), enabled(true), isTrigger(false), contactOffset(0.02f) {}
 	~Collider() {}
 	virtual bool Startup() { return true; }
 	virtual void Shutdown() {}
@@ -18,10 +18,12 @@ class Transform;
 class RenderingEngine;
 class Shader;
 class Camera;
+class ComponentPoolBase;
 
 class Component {
 public:
-	Component() : gameObject(nullptr), transform(nullptr) {}
+	Component() : gameObject(nullptr), transform(nullptr), pool(nullptr), poolIndex(0) {}
+	virtual ~Component() {}
 	virtual bool Startup(){ return true; }
 	virtual void Shutdown(){}
 	virtual bool Update() = 0;
@@ -29,6 +31,8 @@ public:
 
 	GameObject* gameObject;
 	Transform*  transform;
+	ComponentPoolBase* pool; //Pool that owns this component's memory
+	unsigned int poolIndex; //Index into the owning pool's component list
 };
 
 #endif //_COMPONENT_H_
\ No newline at end of file
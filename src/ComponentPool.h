@@ -0,0 +1,140 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: ComponentPool.h
+@date: 15/08/2015
+@author: Emmanuel Vaccaro
+@brief: Per-type storage for components with
+compile-time type ids.
+===============================================*/
+
+#ifndef _COMPONENT_POOL_H_
+#define _COMPONENT_POOL_H_
+
+// Components
+#include "Component.h"
+
+// Other
+#include <vector>
+using std::vector;
+#include <new>
+#include <atomic>
+
+// Hands out a unique id for every component type. Ids are registered while
+// statics are initialized, before main starts any thread, so GetComponent
+// never has to register a type from a worker
+class ComponentTypeCounter {
+public:
+	typedef bool (*IsTypeFunction)(Component* _component);
+	static unsigned int Register(IsTypeFunction _isType);
+	static const vector<IsTypeFunction>& GetTypes(); //Indexed by type id
+
+	static std::atomic<unsigned int> typeCount;
+private:
+	static vector<IsTypeFunction>& Types();
+};
+
+template<typename T>
+class ComponentType {
+public:
+	static unsigned int GetId() {
+		// Note(Manny): The id is a local static so it is set on first use, even
+		// when that use comes from another static's initializer. Touching
+		// sm_registered makes sure that first use happens before main, VS2013
+		// does not guard local statics against two threads
+		static const unsigned int id = ComponentTypeCounter::Register(&IsType);
+		(void)sm_registered;
+		return id;
+	}
+private:
+	static bool IsType(Component* _component) {
+		return dynamic_cast<T*>(_component) != nullptr;
+	}
+
+	static const bool sm_registered;
+};
+template<typename T>
+const bool ComponentType<T>::sm_registered = (ComponentType<T>::GetId(), true);
+
+class ComponentPoolBase {
+public:
+	virtual ~ComponentPoolBase() {}
+	virtual void Destroy(Component* _component) = 0;
+	virtual void DestroyAll() = 0;
+	// Destroys the components of every pool, has to run while the GL context
+	// still exists rather than when the static pools are destroyed
+	static void DestroyPools();
+protected:
+	static vector<ComponentPoolBase*>& GetPools();
+};
+
+// Components are constructed in place inside fixed size chunks, so they sit
+// next to each other in memory and never move once created. Destroyed slots
+// are reused by the next component of the same type.
+template<typename T>
+class ComponentPool : public ComponentPoolBase {
+public:
+	static const unsigned int CHUNK_SIZE = 128;
+
+	ComponentPool() {
+		GetPools().push_back(this);
+	}
+	virtual ~ComponentPool() {
+		DestroyAll();
+		for (unsigned int i = 0; i < m_chunks.size(); ++i) {
+			::operator delete(m_chunks[i]);
+		}
+	}
+	T* Create(const T& _source) {
+		if (m_freeSlots.empty()) {
+			AddChunk();
+		}
+		void* slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+
+		T* component = new (slot) T(_source);
+		component->pool = this;
+		component->poolIndex = components.size();
+		components.push_back(component);
+		return component;
+	}
+	virtual void Destroy(Component* _component) {
+		T* component = static_cast<T*>(_component);
+		unsigned int index = component->poolIndex;
+
+		// Swap the last component into the removed entry to keep the list packed
+		components[index] = components.back();
+		components[index]->poolIndex = index;
+		components.pop_back();
+
+		component->~T();
+		m_freeSlots.push_back(component);
+	}
+	virtual void DestroyAll() {
+		for (unsigned int i = 0; i < components.size(); ++i) {
+			components[i]->~T();
+			m_freeSlots.push_back(components[i]);
+		}
+		components.clear();
+	}
+	static ComponentPool<T>& Get() {
+		static ComponentPool<T> pool;
+		return pool;
+	}
+
+	vector<T*> components; //Every live component of this type
+private:
+	void AddChunk() {
+		char* chunk = (char*)::operator new(sizeof(T) * CHUNK_SIZE);
+		m_chunks.push_back(chunk);
+		for (int i = CHUNK_SIZE - 1; i >= 0; --i) {
+			m_freeSlots.push_back(chunk + sizeof(T) * i);
+		}
+	}
+
+	vector<char*> m_chunks;
+	vector<void*> m_freeSlots;
+};
+
+#endif // _COMPONENT_POOL_H_
\ No newline at end of file
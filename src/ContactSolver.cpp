@@ -0,0 +1,442 @@
+#include "ContactSolver.h"
+
+// Physics
+#include "IslandBuilder.h"
+
+// Utilities
+#include "JobSystem.h"
+
+// Other
+#include <algorithm>
+#include <climits>
+
+ContactSolver::ContactSolver() :
+	velocityIterations(8),
+	positionIterations(3),
+	warmStarting(true),
+	splitImpulse(true),
+	baumgarte(0.2f),
+	penetrationSlop(0.01f),
+	restitutionThreshold(1.0f),
+	warmStartedCount(0),
+	matchDistance(0.05f),
+	colourCount(0) {}
+
+// Public
+void ContactSolver::Step(vector<SolverBody>& _bodies, vector<ContactConstraint>& _constraints, const IslandBuilder& _islands, const vec3& _gravity, float _timeStep) {
+	IntegrateForces(_bodies, _gravity, _timeStep);
+	MatchCache(_constraints);
+	PreStep(_bodies, _constraints, _timeStep);
+	ColourIslands(_bodies, _constraints, _islands);
+
+	m_pseudoVelocity.assign(_bodies.size(), vec3(0));
+	m_pseudoAngularVelocity.assign(_bodies.size(), vec3(0));
+	m_pseudoImpulses.assign(_constraints.size() * 8, 0.0f);
+
+	// Small islands touch no body another island moves, so each job runs one start to finish
+	JobSystem::ParallelFor(m_smallIslands.size(), ISLAND_BATCH_SIZE, [this, &_bodies, &_constraints, &_islands, _timeStep](unsigned int _begin, unsigned int _end) {
+		for (unsigned int i = _begin; i < _end; ++i) {
+			const Island& island = _islands.islands[m_smallIslands[i]];
+			SolveIsland(_bodies, _constraints, &_islands.constraints[island.firstConstraint], island.constraintCount, _timeStep);
+		}
+	});
+	SolveColours(_bodies, _constraints, _timeStep);
+	Integrate(_bodies, _timeStep);
+
+	m_cache = _constraints;
+	std::sort(m_cache.begin(), m_cache.end(), ComparePairs);
+}
+void ContactSolver::Clear() {
+	m_cache.clear();
+}
+
+// Private
+void ContactSolver::IntegrateForces(vector<SolverBody>& _bodies, const vec3& _gravity, float _timeStep) {
+	JobSystem::ParallelFor(_bodies.size(), BODY_BATCH_SIZE, [&_bodies, &_gravity, _timeStep](unsigned int _begin, unsigned int _end) {
+		for (unsigned int i = _begin; i < _end; ++i) {
+			SolverBody& body = _bodies[i];
+			glm::mat3 rotation = glm::toMat3(body.rotation);
+			body.inverseInertia = rotation * glm::mat3(
+				body.localInverseInertia.x, 0, 0,
+				0, body.localInverseInertia.y, 0,
+				0, 0, body.localInverseInertia.z) * glm::transpose(rotation);
+			if (body.inverseMass == 0.0f) {
+				continue;
+			}
+			vec3 acceleration = body.force * body.inverseMass + (body.useGravity ? _gravity : vec3(0));
+			body.velocity += acceleration * _timeStep;
+			body.angularVelocity += body.inverseInertia * body.torque * _timeStep;
+			body.velocity *= 1.0f / (1.0f + _timeStep * body.linearDamping);
+			body.angularVelocity *= 1.0f / (1.0f + _timeStep * body.angularDamping);
+		}
+	});
+}
+void ContactSolver::MatchCache(vector<ContactConstraint>& _constraints) {
+	JobSystem::ParallelFor(_constraints.size(), CONSTRAINT_BATCH_SIZE, [this, &_constraints](unsigned int _begin, unsigned int _end) {
+		for (unsigned int i = _begin; i < _end; ++i) {
+			Manifold& manifold = _constraints[i].manifold;
+			vector<ContactConstraint>::const_iterator cached = std::lower_bound(m_cache.begin(), m_cache.end(), _constraints[i], ComparePairs);
+			bool found = warmStarting && cached != m_cache.end() &&
+				cached->colliderA == _constraints[i].colliderA && cached->colliderB == _constraints[i].colliderB;
+			// Note(Manny): Faces that line up exactly clip to different features as the
+			// bodies wobble, so unmatched contacts fall back to the nearest old one
+			bool used[8] = {};
+			float matchDistanceSquared = matchDistance * matchDistance;
+			for (int j = 0; j < manifold.contactCount; ++j) {
+				Contact& contact = manifold.contacts[j];
+				contact.normalImpulse = 0.0f;
+				contact.tangentImpulse[0] = 0.0f;
+				contact.tangentImpulse[1] = 0.0f;
+				contact.warmStarted = 0;
+				if (!found) {
+					continue;
+				}
+				const Manifold& old = cached->manifold;
+				int match = -1;
+				for (int k = 0; k < old.contactCount; ++k) {
+					if (!used[k] && old.contacts[k].fp.key == contact.fp.key) {
+						match = k;
+						break;
+					}
+				}
+				if (match < 0) {
+					float closest = matchDistanceSquared;
+					for (int k = 0; k < old.contactCount; ++k) {
+						vec3 offset = old.contacts[k].position - contact.position;
+						float distanceSquared = glm::dot(offset, offset);
+						if (!used[k] && distanceSquared < closest) {
+							closest = distanceSquared;
+							match = k;
+						}
+					}
+				}
+				if (match >= 0) {
+					const Contact& oldContact = old.contacts[match];
+					contact.normalImpulse = oldContact.normalImpulse;
+					contact.tangentImpulse[0] = oldContact.tangentImpulse[0];
+					contact.tangentImpulse[1] = oldContact.tangentImpulse[1];
+					contact.warmStarted = oldContact.warmStarted < 255 ? oldContact.warmStarted + 1 : 255;
+					used[match] = true;
+				}
+			}
+		}
+	});
+
+	warmStartedCount = 0;
+	for (unsigned int i = 0; i < _constraints.size(); ++i) {
+		const Manifold& manifold = _constraints[i].manifold;
+		for (int j = 0; j < manifold.contactCount; ++j) {
+			warmStartedCount += manifold.contacts[j].warmStarted > 0 ? 1 : 0;
+		}
+	}
+}
+void ContactSolver::PreStep(vector<SolverBody>& _bodies, vector<ContactConstraint>& _constraints, float _timeStep) {
+	JobSystem::ParallelFor(_constraints.size(), CONSTRAINT_BATCH_SIZE, [this, &_bodies, &_constraints, _timeStep](unsigned int _begin, unsigned int _end) {
+		for (unsigned int i = _begin; i < _end; ++i) {
+			ContactConstraint& constraint = _constraints[i];
+			const SolverBody& bodyA = _bodies[constraint.bodyA];
+			const SolverBody& bodyB = _bodies[constraint.bodyB];
+			Manifold& manifold = constraint.manifold;
+			ComputeBasis(manifold.normal, &manifold.tangentVectors[0], &manifold.tangentVectors[1]);
+
+			for (int j = 0; j < manifold.contactCount; ++j) {
+				Contact& contact = manifold.contacts[j];
+				vec3 rA = contact.position - bodyA.position;
+				vec3 rB = contact.position - bodyB.position;
+
+				// Effective mass along each direction
+				float inverseMass = bodyA.inverseMass + bodyB.inverseMass;
+				vec3 rAxN = glm::cross(rA, manifold.normal);
+				vec3 rBxN = glm::cross(rB, manifold.normal);
+				float normalMass = inverseMass + glm::dot(rAxN, bodyA.inverseInertia * rAxN) + glm::dot(rBxN, bodyB.inverseInertia * rBxN);
+				contact.normalMass = normalMass > 0.0f ? 1.0f / normalMass : 0.0f;
+				for (int k = 0; k < 2; ++k) {
+					vec3 rAxT = glm::cross(rA, manifold.tangentVectors[k]);
+					vec3 rBxT = glm::cross(rB, manifold.tangentVectors[k]);
+					float tangentMass = inverseMass + glm::dot(rAxT, bodyA.inverseInertia * rAxT) + glm::dot(rBxT, bodyB.inverseInertia * rBxT);
+					contact.tangentMass[k] = tangentMass > 0.0f ? 1.0f / tangentMass : 0.0f;
+				}
+
+				// Bounce off fast impacts, and without split impulses push out of penetration too
+				vec3 relativeVelocity = bodyB.velocity + glm::cross(bodyB.angularVelocity, rB) -
+					bodyA.velocity - glm::cross(bodyA.angularVelocity, rA);
+				float closingSpeed = glm::dot(relativeVelocity, manifold.normal);
+				if (contact.penetration < 0.0f) {
+					// Speculative contact, the bodies may close the gap this step but no more
+					contact.bias = contact.penetration / _timeStep;
+				} else {
+					contact.bias = closingSpeed < -restitutionThreshold ? -constraint.restitution * closingSpeed : 0.0f;
+					if (!splitImpulse) {
+						contact.bias += baumgarte / _timeStep * glm::max(0.0f, contact.penetration - penetrationSlop);
+					}
+				}
+			}
+		}
+	});
+}
+void ContactSolver::ColourIslands(const vector<SolverBody>& _bodies, const vector<ContactConstraint>& _constraints, const IslandBuilder& _islands) {
+	m_smallIslands.clear();
+	m_colouredConstraints.clear();
+	m_serialConstraints.clear();
+	m_bodyColours.assign(_bodies.size(), 0);
+	vector<unsigned int> colours(_constraints.size(), MAX_COLOURS);
+	unsigned int colourSizes[MAX_COLOURS] = {};
+
+	// Too few constraints to keep the threads busy are not worth colouring,
+	// their islands converge better solved whole in island order
+	unsigned int largeIslandSize = LARGE_ISLAND_SIZE;
+	unsigned int largeConstraintCount = 0;
+	for (unsigned int i = 0; i < _islands.islands.size(); ++i) {
+		if (_islands.islands[i].constraintCount >= LARGE_ISLAND_SIZE) {
+			largeConstraintCount += _islands.islands[i].constraintCount;
+		}
+	}
+	if (largeConstraintCount < PARALLEL_COLOUR_SIZE) {
+		largeIslandSize = UINT_MAX;
+	}
+
+	// Greedy colouring in island order, each constraint takes the first colour
+	// that neither of its moving bodies is in yet
+	for (unsigned int i = 0; i < _islands.islands.size(); ++i) {
+		const Island& island = _islands.islands[i];
+		if (island.constraintCount < largeIslandSize) {
+			m_smallIslands.push_back(i);
+			continue;
+		}
+		for (unsigned int j = 0; j < island.constraintCount; ++j) {
+			unsigned int index = _islands.constraints[island.firstConstraint + j];
+			const ContactConstraint& constraint = _constraints[index];
+			unsigned long long used = 0;
+			if (_bodies[constraint.bodyA].inverseMass > 0.0f) {
+				used |= m_bodyColours[constraint.bodyA];
+			}
+			if (_bodies[constraint.bodyB].inverseMass > 0.0f) {
+				used |= m_bodyColours[constraint.bodyB];
+			}
+			if (used == ~0ULL) {
+				m_serialConstraints.push_back(index);
+				continue;
+			}
+			unsigned int colour = 0;
+			while (used & (1ULL << colour)) {
+				colour++;
+			}
+			unsigned long long bit = 1ULL << colour;
+			m_bodyColours[constraint.bodyA] |= bit;
+			m_bodyColours[constraint.bodyB] |= bit;
+			colours[index] = colour;
+			colourSizes[colour]++;
+		}
+	}
+
+	colourCount = 0;
+	m_colourStarts.assign(1, 0);
+	for (unsigned int colour = 0; colour < MAX_COLOURS && colourSizes[colour] > 0; ++colour) {
+		m_colourStarts.push_back(m_colourStarts.back() + colourSizes[colour]);
+		colourCount++;
+	}
+	m_colouredConstraints.resize(m_colourStarts.back());
+	unsigned int filled[MAX_COLOURS] = {};
+	for (unsigned int i = 0; i < _islands.islands.size(); ++i) {
+		const Island& island = _islands.islands[i];
+		if (island.constraintCount < largeIslandSize) {
+			continue;
+		}
+		for (unsigned int j = 0; j < island.constraintCount; ++j) {
+			unsigned int index = _islands.constraints[island.firstConstraint + j];
+			unsigned int colour = colours[index];
+			if (colour < MAX_COLOURS) {
+				m_colouredConstraints[m_colourStarts[colour] + filled[colour]++] = index;
+			}
+		}
+	}
+
+	// Split each colour into batches, a batch waits for every batch of the colours before it
+	m_batches.clear();
+	for (unsigned int colour = 0; colour < colourCount; ++colour) {
+		unsigned int waitCount = m_batches.size();
+		for (unsigned int begin = m_colourStarts[colour]; begin < m_colourStarts[colour + 1]; begin += CONSTRAINT_BATCH_SIZE) {
+			ColourBatch batch;
+			batch.begin = begin;
+			batch.end = glm::min(begin + CONSTRAINT_BATCH_SIZE, m_colourStarts[colour + 1]);
+			batch.waitCount = waitCount;
+			batch.isSerial = false;
+			m_batches.push_back(batch);
+		}
+	}
+	if (!m_serialConstraints.empty()) {
+		ColourBatch batch;
+		batch.begin = 0;
+		batch.end = m_serialConstraints.size();
+		batch.waitCount = m_batches.size();
+		batch.isSerial = true;
+		m_batches.push_back(batch);
+	}
+}
+void ContactSolver::SolveIsland(vector<SolverBody>& _bodies, vector<ContactConstraint>& _constraints, const unsigned int* _indices, unsigned int _count, float _timeStep) {
+	for (unsigned int i = 0; i < _count; ++i) {
+		WarmStart(_bodies, _constraints[_indices[i]]);
+	}
+	for (int iteration = 0; iteration < velocityIterations; ++iteration) {
+		for (unsigned int i = 0; i < _count; ++i) {
+			SolveVelocity(_bodies, _constraints[_indices[i]]);
+		}
+	}
+	if (splitImpulse) {
+		for (int iteration = 0; iteration < positionIterations; ++iteration) {
+			for (unsigned int i = 0; i < _count; ++i) {
+				SolvePosition(_bodies, _constraints[_indices[i]], &m_pseudoImpulses[_indices[i] * 8], _timeStep);
+			}
+		}
+	}
+}
+void ContactSolver::SolveColours(vector<SolverBody>& _bodies, vector<ContactConstraint>& _constraints, float _timeStep) {
+	if (m_batches.empty()) {
+		return;
+	}
+
+	// Note(Manny): Every pass goes through the colours in order and then the
+	// constraints that fit no colour, the same order a single thread would use.
+	// Rather than a job and a wait per colour, one job per thread claims batches
+	// in that order and only spins when the colour before is still being solved
+	int passes = 1 + velocityIterations + (splitImpulse ? positionIterations : 0);
+	unsigned int batchCount = m_batches.size();
+	unsigned int totalCount = batchCount * passes;
+	std::atomic<unsigned int> nextBatch(0);
+	std::atomic<unsigned int> finishedCount(0);
+	std::function<void()> solveBatches = [&]() {
+		for (unsigned int i = nextBatch++; i < totalCount; i = nextBatch++) {
+			int pass = i / batchCount;
+			const ColourBatch& batch = m_batches[i % batchCount];
+			unsigned int readyCount = pass * batchCount + batch.waitCount;
+			while (finishedCount.load() < readyCount) {
+				std::this_thread::yield();
+			}
+			const vector<unsigned int>& indices = batch.isSerial ? m_serialConstraints : m_colouredConstraints;
+			for (unsigned int j = batch.begin; j < batch.end; ++j) {
+				unsigned int index = indices[j];
+				if (pass == 0) {
+					WarmStart(_bodies, _constraints[index]);
+				} else if (pass <= velocityIterations) {
+					SolveVelocity(_bodies, _constraints[index]);
+				} else {
+					SolvePosition(_bodies, _constraints[index], &m_pseudoImpulses[index * 8], _timeStep);
+				}
+			}
+			finishedCount++;
+		}
+	};
+
+	// The calling thread takes part too, so the batches finish even if no worker is free
+	JobCounter counter;
+	for (unsigned int i = 1; i < JobSystem::GetThreadCount(); ++i) {
+		JobSystem::Run(solveBatches, &counter);
+	}
+	solveBatches();
+	JobSystem::Wait(counter);
+}
+void ContactSolver::WarmStart(vector<SolverBody>& _bodies, const ContactConstraint& _constraint) {
+	SolverBody& bodyA = _bodies[_constraint.bodyA];
+	SolverBody& bodyB = _bodies[_constraint.bodyB];
+	const Manifold& manifold = _constraint.manifold;
+	for (int j = 0; j < manifold.contactCount; ++j) {
+		const Contact& contact = manifold.contacts[j];
+		vec3 impulse = manifold.normal * contact.normalImpulse +
+			manifold.tangentVectors[0] * contact.tangentImpulse[0] +
+			manifold.tangentVectors[1] * contact.tangentImpulse[1];
+		ApplyImpulse(bodyA, bodyA.velocity, bodyA.angularVelocity, contact.position - bodyA.position, -impulse);
+		ApplyImpulse(bodyB, bodyB.velocity, bodyB.angularVelocity, contact.position - bodyB.position, impulse);
+	}
+}
+void ContactSolver::SolveVelocity(vector<SolverBody>& _bodies, ContactConstraint& _constraint) {
+	SolverBody& bodyA = _bodies[_constraint.bodyA];
+	SolverBody& bodyB = _bodies[_constraint.bodyB];
+	Manifold& manifold = _constraint.manifold;
+	for (int j = 0; j < manifold.contactCount; ++j) {
+		Contact& contact = manifold.contacts[j];
+		vec3 rA = contact.position - bodyA.position;
+		vec3 rB = contact.position - bodyB.position;
+
+		// Friction first, limited by last iteration's normal impulse
+		for (int k = 0; k < 2; ++k) {
+			const vec3& tangent = manifold.tangentVectors[k];
+			vec3 relativeVelocity = bodyB.velocity + glm::cross(bodyB.angularVelocity, rB) -
+				bodyA.velocity - glm::cross(bodyA.angularVelocity, rA);
+			float lambda = -glm::dot(relativeVelocity, tangent) * contact.tangentMass[k];
+			float maxLambda = _constraint.friction * contact.normalImpulse;
+			float oldImpulse = contact.tangentImpulse[k];
+			contact.tangentImpulse[k] = glm::clamp(oldImpulse + lambda, -maxLambda, maxLambda);
+			vec3 impulse = tangent * (contact.tangentImpulse[k] - oldImpulse);
+			ApplyImpulse(bodyA, bodyA.velocity, bodyA.angularVelocity, rA, -impulse);
+			ApplyImpulse(bodyB, bodyB.velocity, bodyB.angularVelocity, rB, impulse);
+		}
+
+		// The accumulated impulse may only push, but single iterations may pull back
+		vec3 relativeVelocity = bodyB.velocity + glm::cross(bodyB.angularVelocity, rB) -
+			bodyA.velocity - glm::cross(bodyA.angularVelocity, rA);
+		float lambda = contact.normalMass * (contact.bias - glm::dot(relativeVelocity, manifold.normal));
+		float oldImpulse = contact.normalImpulse;
+		contact.normalImpulse = glm::max(oldImpulse + lambda, 0.0f);
+		vec3 impulse = manifold.normal * (contact.normalImpulse - oldImpulse);
+		ApplyImpulse(bodyA, bodyA.velocity, bodyA.angularVelocity, rA, -impulse);
+		ApplyImpulse(bodyB, bodyB.velocity, bodyB.angularVelocity, rB, impulse);
+	}
+}
+void ContactSolver::SolvePosition(const vector<SolverBody>& _bodies, const ContactConstraint& _constraint, float* _impulses, float _timeStep) {
+	// Note(Manny): Same as the normal velocity constraint, but on velocities
+	// that only move the bodies this step and are then thrown away
+	const SolverBody& bodyA = _bodies[_constraint.bodyA];
+	const SolverBody& bodyB = _bodies[_constraint.bodyB];
+	vec3& velocityA = m_pseudoVelocity[_constraint.bodyA];
+	vec3& angularVelocityA = m_pseudoAngularVelocity[_constraint.bodyA];
+	vec3& velocityB = m_pseudoVelocity[_constraint.bodyB];
+	vec3& angularVelocityB = m_pseudoAngularVelocity[_constraint.bodyB];
+	const Manifold& manifold = _constraint.manifold;
+	for (int j = 0; j < manifold.contactCount; ++j) {
+		const Contact& contact = manifold.contacts[j];
+		vec3 rA = contact.position - bodyA.position;
+		vec3 rB = contact.position - bodyB.position;
+		vec3 relativeVelocity = velocityB + glm::cross(angularVelocityB, rB) - velocityA - glm::cross(angularVelocityA, rA);
+		float bias = baumgarte / _timeStep * (contact.penetration - penetrationSlop);
+		float lambda = contact.normalMass * (bias - glm::dot(relativeVelocity, manifold.normal));
+		float oldImpulse = _impulses[j];
+		_impulses[j] = glm::max(oldImpulse + lambda, 0.0f);
+		vec3 impulse = manifold.normal * (_impulses[j] - oldImpulse);
+		ApplyImpulse(bodyA, velocityA, angularVelocityA, rA, -impulse);
+		ApplyImpulse(bodyB, velocityB, angularVelocityB, rB, impulse);
+	}
+}
+void ContactSolver::Integrate(vector<SolverBody>& _bodies, float _timeStep) {
+	JobSystem::ParallelFor(_bodies.size(), BODY_BATCH_SIZE, [this, &_bodies, _timeStep](unsigned int _begin, unsigned int _end) {
+		for (unsigned int i = _begin; i < _end; ++i) {
+			SolverBody& body = _bodies[i];
+			if (body.inverseMass == 0.0f) {
+				continue;
+			}
+			vec3 angularVelocity = body.angularVelocity + m_pseudoAngularVelocity[i];
+			body.position += (body.velocity + m_pseudoVelocity[i]) * _timeStep;
+			body.rotation = glm::normalize(body.rotation + quat(0.0f, angularVelocity) * body.rotation * (0.5f * _timeStep));
+		}
+	});
+}
+
+// Static
+void ContactSolver::ApplyImpulse(const SolverBody& _body, vec3& _velocity, vec3& _angularVelocity, const vec3& _relativePoint, const vec3& _impulse) {
+	if (_body.inverseMass == 0.0f) {
+		return;
+	}
+	_velocity += _impulse * _body.inverseMass;
+	_angularVelocity += _body.inverseInertia * glm::cross(_relativePoint, _impulse);
+}
+void ContactSolver::ComputeBasis(const vec3& _normal, vec3* _tangent0, vec3* _tangent1) {
+	// Built from the normal alone, so a steady normal keeps the same friction axes
+	if (glm::abs(_normal.x) >= 0.57735027f) {
+		*_tangent0 = glm::normalize(vec3(_normal.y, -_normal.x, 0.0f));
+	} else {
+		*_tangent0 = glm::normalize(vec3(0.0f, _normal.z, -_normal.y));
+	}
+	*_tangent1 = glm::cross(_normal, *_tangent0);
+}
+bool ContactSolver::ComparePairs(const ContactConstraint& _a, const ContactConstraint& _b) {
+	return _a.colliderA != _b.colliderA ? _a.colliderA < _b.colliderA : _a.colliderB < _b.colliderB;
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: ContactSolver.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: An iterative sequential impulse solver
+that resolves every contact of a step together
+and steps the bodies forward.
+===============================================*/
+
+#ifndef _CONTACT_SOLVER_H_
+#define _CONTACT_SOLVER_H_
+
+// Structs
+#include "OBB.h"
+
+// Utilities
+#include "GLM_Header.h"
+
+// Other
+#include <vector>
+using std::vector;
+
+// Forward declaration
+class Collider;
+
+// A body as the solver sees it, copied in before a step and back out after
+struct SolverBody {
+	vec3 position;
+	quat rotation;
+	vec3 velocity;
+	vec3 angularVelocity;
+	vec3 force; //Applied over the whole step
+	vec3 torque;
+	vec3 localInverseInertia; //Inverse of the diagonal inertia tensor
+	glm::mat3 inverseInertia; //World space, kept up to date by the solver
+	float inverseMass; //0 for bodies that nothing moves
+	float linearDamping;
+	float angularDamping;
+	float sleepTime; //Seconds the body has been slow enough to sleep, kept by the IslandBuilder
+	bool useGravity;
+};
+
+// A touching pair of colliders. The colliders only identify the pair from
+// one step to the next, the solver never reads them
+struct ContactConstraint {
+	const Collider* colliderA;
+	const Collider* colliderB;
+	unsigned int bodyA;
+	unsigned int bodyB;
+	float friction;
+	float restitution;
+	Manifold manifold;
+};
+
+// Forward declaration
+class IslandBuilder;
+
+// Contacts are matched to the previous step's by collider pair and feature
+// pair, or failing that by position, and start from the impulse they ended
+// on. A resting stack is then already close to solved, so it needs far fewer
+// iterations to stay still.
+//
+// Islands share no moving bodies, so small ones are solved start to finish
+// as jobs of their own. Large islands are split into colours whose
+// constraints share no moving bodies, each colour is solved in parallel and
+// the colours one after another. Neither depends on which thread runs what,
+// so a step gives the same result whatever the thread count.
+class ContactSolver {
+public:
+	ContactSolver();
+	// Integrates forces, solves the contacts and moves the bodies by one step,
+	// _islands has to be built from the same bodies and constraints
+	void Step(vector<SolverBody>& _bodies, vector<ContactConstraint>& _constraints, const IslandBuilder& _islands, const vec3& _gravity, float _timeStep);
+	void Clear(); //Forgets the impulses carried between steps
+
+	int velocityIterations;
+	int positionIterations; //Split impulse passes, unused with Baumgarte
+	bool warmStarting;
+	bool splitImpulse; //Pushes bodies apart without adding velocity, otherwise Baumgarte
+	float baumgarte; //Fraction of the penetration removed each step
+	float penetrationSlop; //Penetration left alone so resting contacts persist
+	float restitutionThreshold; //Closing speed below which nothing bounces
+	unsigned int warmStartedCount; //Contacts that carried their impulse over last step
+	float matchDistance; //Furthest a contact can move and still be matched without its features
+	unsigned int colourCount; //Colours the large islands needed last step
+
+	static const unsigned int BODY_BATCH_SIZE = 256; //Bodies integrated per job
+	static const unsigned int CONSTRAINT_BATCH_SIZE = 64; //Constraints prepared or solved per job
+	static const unsigned int ISLAND_BATCH_SIZE = 16; //Small islands solved per job
+	static const unsigned int LARGE_ISLAND_SIZE = 256; //Constraints from which an island is coloured
+	static const unsigned int MAX_COLOURS = 64; //Constraints that fit no colour are solved on one thread
+	static const unsigned int PARALLEL_COLOUR_SIZE = 1024; //Constraints in large islands from which they are coloured at all
+private:
+	// Constraints of one colour solved together, or the ones that fit no colour
+	struct ColourBatch {
+		unsigned int begin;
+		unsigned int end;
+		unsigned int waitCount; //Batches of the pass that have to finish first
+		bool isSerial; //Indexes m_serialConstraints rather than m_colouredConstraints
+	};
+
+	void IntegrateForces(vector<SolverBody>& _bodies, const vec3& _gravity, float _timeStep);
+	void MatchCache(vector<ContactConstraint>& _constraints);
+	void PreStep(vector<SolverBody>& _bodies, vector<ContactConstraint>& _constraints, float _timeStep);
+	void ColourIslands(const vector<SolverBody>& _bodies, const vector<ContactConstraint>& _constraints, const IslandBuilder& _islands);
+	void SolveIsland(vector<SolverBody>& _bodies, vector<ContactConstraint>& _constraints, const unsigned int* _indices, unsigned int _count, float _timeStep);
+	void SolveColours(vector<SolverBody>& _bodies, vector<ContactConstraint>& _constraints, float _timeStep);
+	void WarmStart(vector<SolverBody>& _bodies, const ContactConstraint& _constraint);
+	void SolveVelocity(vector<SolverBody>& _bodies, ContactConstraint& _constraint);
+	void SolvePosition(const vector<SolverBody>& _bodies, const ContactConstraint& _constraint, float* _impulses, float _timeStep);
+	void Integrate(vector<SolverBody>& _bodies, float _timeStep);
+	// Bodies that nothing moves are left untouched, so islands can share them between threads
+	static void ApplyImpulse(const SolverBody& _body, vec3& _velocity, vec3& _angularVelocity, const vec3& _relativePoint, const vec3& _impulse);
+	static void ComputeBasis(const vec3& _normal, vec3* _tangent0, vec3* _tangent1);
+	static bool ComparePairs(const ContactConstraint& _a, const ContactConstraint& _b);
+
+	vector<ContactConstraint> m_cache; //Last step's constraints, sorted by collider pair
+	vector<vec3> m_pseudoVelocity; //Split impulse velocities, dropped after each step
+	vector<vec3> m_pseudoAngularVelocity;
+	vector<float> m_pseudoImpulses; //Accumulated split impulse, eight per constraint
+	vector<unsigned int> m_smallIslands; //Islands solved as a whole by one job
+	vector<unsigned int> m_colouredConstraints; //Constraints of the large islands, grouped by colour
+	vector<unsigned int> m_colourStarts; //First coloured constraint of each colour, and the end
+	vector<unsigned int> m_serialConstraints; //Constraints of the large islands that fit no colour
+	vector<ColourBatch> m_batches; //One pass over the colours, in solving order
+	vector<unsigned long long> m_bodyColours; //Bit per colour used by each body's constraints
+};
+
+#endif // _CONTACT_SOLVER_H_
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "CookedMesh.h"
+
+// Structs
+#include "Mesh.h"
+
+// Debugging
+#include "Debug.h"
+
+// Other
+#include <fstream>
+#include <cstring>
+
+static const char CookedMeshMagic[4] = { 'C', 'M', 'S', 'H' };
+
+// Blobs start on 16 byte boundaries inside the file
+static unsigned long long AlignOffset(unsigned long long _offset) {
+	return (_offset + 15) & ~15ULL;
+}
+
+// Public
+bool CookedMesh::Open(const string& _fileName, unsigned int _importFlags) {
+	Close();
+
+	unsigned long long sourceTime, sourceSize;
+	if (!MappedFile::GetFileInfo(_fileName, sourceTime, sourceSize) ||
+		!m_file.Open(GetCookedFileName(_fileName))) {
+		return false;
+	}
+	if (!Validate(_importFlags, sourceTime, sourceSize)) {
+		Debug::LogWarning("Cooked mesh is out of date: " + GetCookedFileName(_fileName));
+		Close();
+		return false;
+	}
+	return true;
+}
+void CookedMesh::Close() {
+	m_file.Close();
+	m_header = nullptr;
+	m_submeshes = nullptr;
+}
+void CookedMesh::Read(IndexedModel& _model, Bounds& _bounds) const {
+	const unsigned char* data = m_file.GetData();
+
+	// Reserve first, MeshData releases its buffers when the vector moves it
+	_model.meshes.reserve(m_header->submeshCount);
+	for (unsigned int i = 0; i < m_header->submeshCount; ++i) {
+		const CookedSubmesh& submesh = m_submeshes[i];
+		_model.meshes.push_back(MeshData());
+		MeshData& mesh = _model.meshes.back();
+
+		mesh.positions.resize(submesh.vertexCount);
+		memcpy(mesh.positions.data(), data + submesh.positionOffset, submesh.vertexCount * sizeof(vec3));
+		mesh.indices.resize(submesh.lods[0].indexCount);
+		memcpy(mesh.indices.data(), data + submesh.sourceIndexOffset, submesh.lods[0].indexCount * sizeof(GLuint));
+		mesh.lods.assign(submesh.lods, submesh.lods + submesh.lodCount);
+	}
+
+	_bounds.SetMinMax(m_header->boundsMin, m_header->boundsMax);
+}
+void CookedMesh::Upload(IndexedModel& _model) const {
+	const unsigned char* data = m_file.GetData();
+	for (unsigned int i = 0; i < m_header->submeshCount; ++i) {
+		const CookedSubmesh& submesh = m_submeshes[i];
+
+		VertexLayout layout;
+		memcpy(layout.elements, submesh.elements, sizeof(layout.elements));
+		layout.stride = submesh.stride;
+
+		unsigned int indexSize = submesh.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+		IndexedModel::Upload(_model.meshes[i], layout,
+			data + submesh.vertexOffset, submesh.vertexCount * submesh.stride,
+			data + submesh.indexOffset, submesh.indexCount * indexSize, submesh.indexType);
+	}
+}
+
+// Private
+bool CookedMesh::Validate(unsigned int _importFlags, unsigned long long _sourceTime, unsigned long long _sourceSize) {
+	const unsigned char* data = m_file.GetData();
+	size_t size = m_file.GetSize();
+
+	if (size < sizeof(CookedMeshHeader)) {
+		return false;
+	}
+	const CookedMeshHeader* header = (const CookedMeshHeader*)data;
+	if (memcmp(header->magic, CookedMeshMagic, sizeof(CookedMeshMagic)) != 0 ||
+		header->version != VERSION ||
+		header->importFlags != _importFlags ||
+		header->sourceTime != _sourceTime ||
+		header->sourceSize != _sourceSize) {
+		return false;
+	}
+
+	const CookedSubmesh* submeshes = (const CookedSubmesh*)(data + sizeof(CookedMeshHeader));
+	if (sizeof(CookedMeshHeader) + header->submeshCount * sizeof(CookedSubmesh) > size) {
+		return false;
+	}
+	for (unsigned int i = 0; i < header->submeshCount; ++i) {
+		const CookedSubmesh& submesh = submeshes[i];
+		unsigned int indexSize = submesh.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+		if (submesh.vertexOffset + submesh.vertexCount * submesh.stride > size ||
+			submesh.indexOffset + submesh.indexCount * indexSize > size ||
+			submesh.positionOffset + submesh.vertexCount * sizeof(vec3) > size ||
+			submesh.lodCount == 0 || submesh.lodCount > MeshSimplifier::MAX_LODS ||
+			submesh.sourceIndexOffset + submesh.lods[0].indexCount * sizeof(GLuint) > size) {
+			return false;
+		}
+		for (unsigned int j = 0; j < submesh.lodCount; ++j) {
+			if (submesh.lods[j].indexOffset + submesh.lods[j].indexCount > submesh.indexCount) {
+				return false;
+			}
+		}
+	}
+
+	m_header = header;
+	m_submeshes = submeshes;
+	return true;
+}
+
+// Static
+bool CookedMesh::Load(const string& _fileName, unsigned int _importFlags, IndexedModel& _model, Bounds& _bounds) {
+	CookedMesh cookedMesh;
+	if (!cookedMesh.Open(_fileName, _importFlags)) {
+		return false;
+	}
+	cookedMesh.Read(_model, _bounds);
+	cookedMesh.Upload(_model);
+	return true;
+}
+bool CookedMesh::Save(const string& _fileName, unsigned int _importFlags, const IndexedModel& _model, const Bounds& _bounds) {
+	if (_model.meshes.empty()) {
+		return false;
+	}
+
+	CookedMeshHeader header;
+	memcpy(header.magic, CookedMeshMagic, sizeof(CookedMeshMagic));
+	header.version = VERSION;
+	header.importFlags = _importFlags;
+	header.submeshCount = _model.meshes.size();
+	header.boundsMin = _bounds.min;
+	header.boundsMax = _bounds.max;
+	if (!MappedFile::GetFileInfo(_fileName, header.sourceTime, header.sourceSize)) {
+		return false;
+	}
+
+	// Pack every submesh again and lay the blobs out after the submesh table
+	vector<CookedSubmesh> submeshes(_model.meshes.size());
+	vector<vector<unsigned char> > vertexData(_model.meshes.size());
+	vector<vector<unsigned char> > indexData(_model.meshes.size());
+	unsigned long long offset = sizeof(CookedMeshHeader) + submeshes.size() * sizeof(CookedSubmesh);
+	for (unsigned int i = 0; i < _model.meshes.size(); ++i) {
+		const MeshData& mesh = _model.meshes[i];
+		CookedSubmesh& submesh = submeshes[i];
+		memset(&submesh, 0, sizeof(CookedSubmesh));
+
+		VertexLayout layout = _model.ChooseLayout(mesh);
+		submesh.indexType = _model.PackVertices(mesh, layout, vertexData[i], indexData[i]);
+		memcpy(submesh.elements, layout.elements, sizeof(layout.elements));
+		submesh.stride = layout.stride;
+		submesh.vertexCount = mesh.positions.size();
+		submesh.indexCount = mesh.indices.size() + mesh.lodIndices.size();
+		submesh.lodCount = mesh.lods.size() < MeshSimplifier::MAX_LODS ? mesh.lods.size() : MeshSimplifier::MAX_LODS;
+		memcpy(submesh.lods, mesh.lods.data(), submesh.lodCount * sizeof(MeshLOD));
+		if (submesh.lodCount == 0) {
+			MeshLOD full = { 0, mesh.indices.size(), 0.0f };
+			submesh.lods[0] = full;
+			submesh.lodCount = 1;
+		}
+
+		submesh.vertexOffset = offset = AlignOffset(offset);
+		offset += vertexData[i].size();
+		submesh.indexOffset = offset = AlignOffset(offset);
+		offset += indexData[i].size();
+		submesh.positionOffset = offset = AlignOffset(offset);
+		offset += mesh.positions.size() * sizeof(vec3);
+		submesh.sourceIndexOffset = offset = AlignOffset(offset);
+		offset += mesh.indices.size() * sizeof(GLuint);
+	}
+
+	std::ofstream file(GetCookedFileName(_fileName).c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		Debug::LogWarning("Unable to write cooked mesh: " + GetCookedFileName(_fileName));
+		return false;
+	}
+
+	const char padding[16] = {};
+	unsigned long long written = 0;
+	// Writes _size bytes at _offset, padding the gap before it
+	auto writeAt = [&](unsigned long long _offset, const void* _data, size_t _size) {
+		file.write(padding, (std::streamsize)(_offset - written));
+		file.write((const char*)_data, _size);
+		written = _offset + _size;
+	};
+
+	writeAt(0, &header, sizeof(CookedMeshHeader));
+	writeAt(written, submeshes.data(), submeshes.size() * sizeof(CookedSubmesh));
+	for (unsigned int i = 0; i < _model.meshes.size(); ++i) {
+		const MeshData& mesh = _model.meshes[i];
+		writeAt(submeshes[i].vertexOffset, vertexData[i].data(), vertexData[i].size());
+		writeAt(submeshes[i].indexOffset, indexData[i].data(), indexData[i].size());
+		writeAt(submeshes[i].positionOffset, mesh.positions.data(), mesh.positions.size() * sizeof(vec3));
+		writeAt(submeshes[i].sourceIndexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(GLuint));
+	}
+	return file.good();
+}
+string CookedMesh::GetCookedFileName(const string& _fileName) {
+	return _fileName + ".cmesh";
+}
\ No newline at end of file
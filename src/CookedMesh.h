@@ -0,0 +1,86 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: CookedMesh.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: Reads and writes .cmesh files, which
+hold a model's final vertex and index buffers
+so it can be loaded without importing it.
+===============================================*/
+
+#ifndef _COOKED_MESH_H_
+#define _COOKED_MESH_H_
+
+// Structs
+#include "Vertex.h"
+#include "Bounds.h"
+
+// Utilities
+#include "MeshSimplifier.h"
+
+// Utilities
+#include "MappedFile.h"
+
+// Other
+#include <string>
+using std::string;
+
+// Forward declaration
+class IndexedModel;
+
+struct CookedMeshHeader {
+	char magic[4];
+	unsigned int version;
+	unsigned int importFlags; //Import settings the file was cooked with
+	unsigned int submeshCount;
+	unsigned long long sourceTime; //Last write time of the source model
+	unsigned long long sourceSize;
+	vec3 boundsMin;
+	vec3 boundsMax;
+};
+
+// Offsets are from the start of the file
+struct CookedSubmesh {
+	VertexElement elements[VERTEX_ATTRIBUTE_COUNT];
+	unsigned int stride;
+	unsigned int vertexCount;
+	unsigned int indexCount; //Every LOD's indices
+	unsigned int lodCount;
+	MeshLOD lods[MeshSimplifier::MAX_LODS];
+	unsigned int indexType;
+	unsigned long long vertexOffset; //Interleaved vertices, uploaded as they are
+	unsigned long long indexOffset; //Indices in indexType, uploaded as they are
+	unsigned long long positionOffset; //vec3 positions kept for physics and bounds
+	unsigned long long sourceIndexOffset; //32-bit indices of the full mesh kept for physics
+};
+
+class CookedMesh {
+public:
+	CookedMesh() : m_header(nullptr), m_submeshes(nullptr) {}
+	// Maps the cooked copy of _fileName, false if there is none or it is out of date
+	bool Open(const string& _fileName, unsigned int _importFlags);
+	void Close();
+	// Adds a submesh per cooked submesh to an empty _model with the positions
+	// and indices the CPU keeps, makes no GL calls so it can run on a worker
+	void Read(IndexedModel& _model, Bounds& _bounds) const;
+	// Creates the GL buffers of the submeshes Read added, straight from the mapping
+	void Upload(IndexedModel& _model) const;
+	inline bool IsOpen() const { return m_header != nullptr; }
+
+	static const unsigned int VERSION = 3; //2: optimized submeshes, 3: LODs
+
+	// Open, Read and Upload in one go
+	static bool Load(const string& _fileName, unsigned int _importFlags, IndexedModel& _model, Bounds& _bounds);
+	static bool Save(const string& _fileName, unsigned int _importFlags, const IndexedModel& _model, const Bounds& _bounds);
+	static string GetCookedFileName(const string& _fileName);
+private:
+	bool Validate(unsigned int _importFlags, unsigned long long _sourceTime, unsigned long long _sourceSize);
+
+	MappedFile m_file;
+	const CookedMeshHeader* m_header;
+	const CookedSubmesh* m_submeshes;
+};
+
+#endif // _COOKED_MESH_H_
@@ -7,6 +7,10 @@
 #include "Gizmos.h"
 #include "Debug.h"
 #include "GUI.h"
+#include "JobSystem.h"
+#include "AssetLoader.h"
+#include "Animator.h"
+#include "ComponentPool.h"
 
 PhysicsEngine* CoreEngine::physics = nullptr;
 
@@ -18,6 +22,7 @@ CoreEngine::CoreEngine(RenderingEngine* _renderer, PhysicsEngine* _physics, Game
 }
 
 bool CoreEngine::Startup() {
+	JobSystem::Create();
 	Time::Create();
 	Input::Create();
 	if (physics->Startup() == false) {
@@ -30,13 +35,18 @@ bool CoreEngine::Startup() {
 }
 
 void CoreEngine::Shutdown() {
+	// Objects remove their components from the physics scene before it goes,
+	// the pools then destroy whatever is left while the GL context still exists
+	game->Shutdown();
+	physics->Shutdown();
+	ComponentPoolBase::DestroyPools();
 	Window::Shutdown();
 	Gizmos::Destroy();
 	Input::Shutdown();
 	Texture::Shutdown();
 	Material::Shutdown();
 	Shader::Shutdown();
-	physics->Shutdown();
+	JobSystem::Shutdown();
 }
 
 bool CoreEngine::Update() {
@@ -52,11 +62,18 @@ bool CoreEngine::Update() {
 	}
 	Gizmos::Clear();
 	Input::Update();
+	// Create the GL objects of assets the workers finished decoding
+	AssetLoader::Update();
 	Transform::UpdateTransformSelection();
 	if (physicsEnabled) {
 		physics->Update();
 	}
 	game->Update();
+	if (physicsEnabled) {
+		physics->LateUpdate();
+	}
+	// Poses are built once every object has moved, so the renderer draws this frame's pose
+	Animator::UpdateAll(Time::deltaTime);
 	return true;
 }
 
@@ -18,34 +18,98 @@
 #include "Gizmos.h"
 #include "Debug.h"
 
+// GUI
+#include "imgui.h"
+
 // Utilities
 #include "Time.h"
+#include "JobSystem.h"
+
+// Other
+#include <algorithm>
+#include <chrono>
 
-float squared(float _n) { return _n * _n; }
-typedef CollisionManifold(*CollisionFunction)(Collider*, Collider*);
+typedef bool(*CollisionFunction)(Collider*, Collider*, Manifold*);
 static CollisionFunction CollisionFunctionTable[] = {
 	0,									CustomPhysicsEngine::PlaneToSphere,		CustomPhysicsEngine::PlaneToBox,
 	CustomPhysicsEngine::SphereToPlane, CustomPhysicsEngine::SphereToSphere,	CustomPhysicsEngine::SphereToBox,
 	CustomPhysicsEngine::BoxToPlane,	CustomPhysicsEngine::BoxToSphere,		CustomPhysicsEngine::BoxToBox
 };
+// Colliders start touching once they are closer than either one's contact offset
+static float GetMargin(const Collider* _first, const Collider* _second) {
+	return glm::max(_first->contactOffset, _second->contactOffset);
+}
+static bool SingleContact(const vec3& _position, const vec3& _normal, float _separation, float _margin, Manifold* _manifold) {
+	_manifold->contactCount = 0;
+	if (_separation > _margin) {
+		return false;
+	}
+	Contact& contact = _manifold->contacts[0];
+	contact.position = _position;
+	contact.penetration = -_separation;
+	contact.fp.key = 0;
+	_manifold->normal = _normal;
+	_manifold->contactCount = 1;
+	return true;
+}
+static bool Flip(bool _colliding, Manifold* _manifold) {
+	_manifold->normal = -_manifold->normal;
+	return _colliding;
+}
 void CustomPhysicsEngine::Shutdown() {
 	actors.clear();
+	m_poses.clear();
+	m_constraints.clear();
+	solver.Clear();
 }
 bool CustomPhysicsEngine::Update() {
-	for (unsigned int actorIndex = 0; 
-		actorIndex < actors.size(); 
-		++actorIndex) {
-		actors[actorIndex]->PhysicsUpdate(Time::deltaTime > 0.033f ? 0.033f : Time::deltaTime);
-	}
+	// Simulate from where the bodies really are, not where they were drawn
+	RestorePoses();
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	int steps = BeginFixedUpdate(Time::deltaTime);
+	for (int step = 0; step < steps; ++step) {
+		StorePreviousPoses();
+		for (unsigned int actorIndex = 0;
+			actorIndex < actors.size();
+			++actorIndex) {
+			actors[actorIndex]->PhysicsUpdate(timeStep);
+		}
 
-	if (collisionEnabled) {
-		CheckForCollisions();
+		GatherBodies();
+		m_constraints.clear();
+		if (collisionEnabled) {
+			CheckForCollisions();
+		}
+		islands.Build(m_bodies, m_constraints);
+		solver.Step(m_bodies, m_constraints, islands, gravity, timeStep);
+		islands.UpdateSleep(m_bodies, timeStep);
+		ApplyBodies();
+		if (allowSleeping) {
+			SleepIslands();
+		}
 	}
+	if (steps > 0) {
+		StoreCurrentPoses();
+	}
+	InterpolatePoses();
+	stepTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
 
 	return true;
 }
+void CustomPhysicsEngine::LateUpdate() {
+	ImGui::Begin("Physics Stats");
+	ImGui::Checkbox("Allow Sleeping", &allowSleeping);
+	ImGui::Text("Bodies: %u awake, %u sleeping", awakeCount, sleepingCount);
+	ImGui::Text("Islands: %u", islands.islands.size());
+	ImGui::Text("Contacts: %u pairs (%u warm started)", m_constraints.size(), solver.warmStartedCount);
+	ImGui::Text("Solver Colours: %u", solver.colourCount);
+	ImGui::Text("Step Time: %.2fms", stepTime);
+	ImGui::End();
+}
 void CustomPhysicsEngine::AddActor(PhysicsObject* _actor) {
 	actors.push_back(_actor);
+	AddPose(_actor->transform);
 }
 bool CustomPhysicsEngine::RemoveActor(PhysicsObject* _actor) {
 	for (unsigned int actorIndex = 0;
@@ -54,148 +118,50 @@ bool CustomPhysicsEngine::RemoveActor(PhysicsObject* _actor) {
 	{
 		if (actors[actorIndex] == _actor) {
 			actors.erase(actors.begin() + actorIndex);
+			RemovePose(_actor->transform);
+			// Note(Manny): GatherBodies only fixes up the bodies still in the scene
+			Rigidbody* rigidbody = dynamic_cast<Rigidbody*>(_actor);
+			if (rigidbody != nullptr) {
+				rigidbody->bodyIndex = 0;
+				vector<Collider*>& colliders = rigidbody->gameObject->colliders;
+				for (unsigned int i = 0; i < colliders.size(); ++i) {
+					if (colliders[i]->attachedRigidbody == rigidbody) {
+						colliders[i]->attachedRigidbody = nullptr;
+					}
+				}
+			}
 			return true;
 		}
 	}
 	return false;
 }
 void CustomPhysicsEngine::CheckForCollisions() {
-	int actorCount = actors.size();
-	//Loop through all actors twice
-	for (int firstActor = 0;
-		firstActor < actorCount - 1;
-		++firstActor) {
-		for (int secondActor = firstActor + 1;
-			secondActor < actorCount;
-			++secondActor) {
-			PhysicsObject* actorA = actors[firstActor];
-			PhysicsObject* actorB = actors[secondActor];
-
-			if (actorA->gameObject->colliders.size() == 0 ||
-				actorB->gameObject->colliders.size() == 0) {
-				continue;
-			}
-
-			Collider* colliderA = actorA->gameObject->colliders[0];
-			Collider* colliderB = actorB->gameObject->colliders[0];
-
-			int shapeId1 = colliderA->shapeId;
-			int shapeId2 = colliderB->shapeId;
-
-			//SHAPE_COUNT - 2 for capsule AND mesh
-			int index = (shapeId1 * (SHAPE_COUNT)) + shapeId2;
-
-			CollisionFunction collisionFunction = CollisionFunctionTable[index];
-			if (collisionFunction != nullptr) {
-				CollisionManifold manifold = collisionFunction(colliderA, colliderB);
-				if (manifold.isColliding) {
-					//Add collision response here
-					Rigidbody* rigidA = colliderA->attachedRigidbody;
-					Rigidbody* rigidB = colliderB->attachedRigidbody;
-
-					if (rigidA == nullptr || rigidB == nullptr) {
-						continue;
-					}
-
-					if (!rigidA->gameObject->isStatic) {
-						rigidA->transform->position += manifold.intersectionA * manifold.normal;
-					}
-
-					if (!rigidB->gameObject->isStatic) {
-						rigidB->transform->position += manifold.intersectionB * manifold.normal;
-					}
-
-					ApplyCollisionResolution(&manifold, rigidA);
-					ApplyCollisionResolution(&manifold, rigidB);
-				}
-			}
+	//Only the pairs whose bounds overlap reach the collision functions
+	broadphase->Update(actors, pairs);
+	WakeTouchedIslands();
+
+	// Note(Manny): Every pair fills its own slot and the touching ones are kept
+	// in pair order, so the constraints do not depend on which thread found them
+	m_pairConstraints.resize(pairs.size());
+	m_pairTouching.assign(pairs.size(), 0);
+	JobSystem::ParallelFor(pairs.size(), PAIR_BATCH_SIZE, [this](unsigned int _begin, unsigned int _end) {
+		for (unsigned int pairIndex = _begin; pairIndex < _end; ++pairIndex) {
+			m_pairTouching[pairIndex] = FindContacts(pairs[pairIndex], m_pairConstraints[pairIndex]) ? 1 : 0;
+		}
+	});
+	for (unsigned int pairIndex = 0;
+		pairIndex < pairs.size();
+		++pairIndex) {
+		if (m_pairTouching[pairIndex] != 0) {
+			m_constraints.push_back(m_pairConstraints[pairIndex]);
 		}
 	}
 }
-void CustomPhysicsEngine::ApplyCollisionResolution(CollisionManifold* _manifold, Rigidbody* _rigid) {
-	//Get Mass
-	float mass = _rigid->mass;
-
-	//Get Moment Of Inertia
-	float moi = _rigid->momentOfInertia;
-
-	//Get Inverse Mass 
-	float invMass = 1.0f / _rigid->mass;
-
-	//Get Inverse Moment Of Inertia
-	float invMOI = 1.0f / _rigid->momentOfInertia;
-	
-	vec3 relativePoint = _manifold->point - _rigid->transform->position;
-	vec3 velocity = _rigid->velocity + _rigid->angularVelocity * relativePoint;
-
-	vec3 rXn = glm::cross(relativePoint, _manifold->normal) * invMOI;
-	
-	float rXnDn = glm::dot(rXn, _manifold->normal);
-	
-	float numerator = -(1.0f + _manifold->restitution) * glm::dot(velocity, _manifold->normal);
-	float denominator = (1.0f * invMass) + rXnDn;
-
-	float j = numerator / denominator;
-	vec3 impulse = _manifold->normal * j;
-	if (!_rigid->gameObject->isStatic) {
-		_rigid->velocity = velocity + impulse * invMass;
-		_rigid->angularVelocity += glm::cross(impulse, relativePoint) * invMOI;
-	}
-
-}
-void CustomPhysicsEngine::ApplyCollisionResolutionTest(CollisionManifold* _manifold, Rigidbody* _rigidA, Rigidbody* _rigidB) {
-	//Get Mass
-	float massA = _rigidA->mass;
-	float massB = _rigidB->mass;
-
-	//Get Moment Of Inertia
-	float moiA = _rigidA->momentOfInertia;
-	float moiB = _rigidB->momentOfInertia;
-
-	//Get Inverse Mass 
-	float invMassA = 1.0f / _rigidA->mass;
-	float invMassB = 1.0f / _rigidB->mass;
-
-	//Get Inverse Moment Of Inertia
-	float invMOIA = 1.0f / _rigidA->momentOfInertia;
-	float invMOIB = 1.0f / _rigidB->momentOfInertia;
-
-	vec3 relativePointA = _manifold->point - _rigidA->transform->position;
-	vec3 relativePointB = _manifold->point - _rigidB->transform->position;
-	
-	vec3 rXn_A = glm::cross(relativePointA, _manifold->normal) / moiA;
-	vec3 rXn_B = glm::cross(relativePointB, _manifold->normal) / moiB;
-
-	vec3 velocityA = _rigidA->velocity + _rigidA->angularVelocity * relativePointA;
-	vec3 velocityB = _rigidB->velocity + _rigidB->angularVelocity * relativePointB;
-
-	vec3 relativeVelocity = velocityA - velocityB;
-
-	float rXnDn_A = glm::dot(rXn_A, _manifold->normal);
-	float rXnDn_B = glm::dot(rXn_B, _manifold->normal);
-
-	float numerator = -(1.0f + _manifold->restitution) * glm::dot(relativeVelocity, _manifold->normal);
-
-	float denominator = glm::dot(_manifold->normal, _manifold->normal * (invMassA + invMassB)) +
-						squared(rXnDn_A) / moiA + 
-						squared(rXnDn_B) / moiB;
-	
-	float j = numerator / denominator;
-
-	vec3 impulse = _manifold->normal * j;
-	if (!_rigidA->gameObject->isStatic) {
-		_rigidA->velocity += (impulse * invMassA);
-		_rigidA->angularVelocity += glm::cross(rXn_A, impulse) / moiA;
-	}
-
-	if (!_rigidB->gameObject->isStatic)	{	
-		_rigidB->velocity += (-impulse * invMassB);
-		_rigidB->angularVelocity += glm::cross(rXn_B, -impulse) / moiB;
-	}
+void CustomPhysicsEngine::SetBroadphase(BroadphaseType _type) {
+	delete broadphase;
+	broadphase = Broadphase::Create(_type);
 }
-CollisionManifold CustomPhysicsEngine::SphereToSphere(Collider* _first, Collider* _second) {
-	CollisionManifold result = {};
-
+bool CustomPhysicsEngine::SphereToSphere(Collider* _first, Collider* _second, Manifold* _manifold) {
 	SphereCollider* firstSphere = (SphereCollider*)_first;
 	SphereCollider* secondSphere = (SphereCollider*)_second;
 
@@ -203,119 +169,278 @@ CollisionManifold CustomPhysicsEngine::SphereToSphere(Collider* _first, Collider
 	vec3 delta = secondSphere->transform->position - firstSphere->transform->position;
 	// The length of the delta is the distance
 	float distance = glm::length(delta);
-	float radiusSum = firstSphere->radius + secondSphere->radius;
-
-	result.colliderA = firstSphere;
-	result.colliderB = secondSphere;
-	result.isColliding = false;
-
-	if (distance <= radiusSum) {
-		// Get the normal of the collision
-		vec3 collisionNormal = glm::normalize(delta);
-		result.intersectionA = -(radiusSum - distance);
-		result.intersectionB = (radiusSum - distance);
-		result.restitution = 0.5f;
-		result.normal = collisionNormal;
-		result.point = firstSphere->transform->position + collisionNormal * firstSphere->radius;
-		result.isColliding = true;
-	}
+	float separation = distance - (firstSphere->radius + secondSphere->radius);
 
-	return result;
+	// Note(Manny): Spheres at the same spot are pushed apart along up
+	vec3 normal = distance > 0.0f ? delta / distance : vec3(0, 1, 0);
+	vec3 point = firstSphere->transform->position + normal * (firstSphere->radius + separation * 0.5f);
+	return SingleContact(point, normal, separation, GetMargin(_first, _second), _manifold);
 }
-CollisionManifold CustomPhysicsEngine::SphereToPlane(Collider* _sphere, Collider* _plane) {
-	CollisionManifold result = {};
-
+bool CustomPhysicsEngine::SphereToPlane(Collider* _sphere, Collider* _plane, Manifold* _manifold) {
 	SphereCollider* sphere = (SphereCollider*)_sphere;
 	PlaneCollider* plane = (PlaneCollider*)_plane;
 
 	float perpDistance = glm::dot(sphere->transform->position, plane->normal) - plane->distance;
+	float separation = perpDistance - sphere->radius;
 
-	result.colliderA = sphere;
-	result.colliderB = plane;
-	result.isColliding = false;
-
-	if (perpDistance <= sphere->radius) {
-		result.isColliding = true;
-		result.intersectionA = sphere->radius - perpDistance;
-		result.restitution = 0.5f;
-		result.normal = plane->normal;
-		result.point = sphere->transform->position - plane->normal * sphere->radius;
-	}
-
-	return result;
+	vec3 point = sphere->transform->position - plane->normal * (sphere->radius + separation * 0.5f);
+	return SingleContact(point, -plane->normal, separation, GetMargin(_sphere, _plane), _manifold);
 }
-CollisionManifold CustomPhysicsEngine::PlaneToSphere(Collider* _plane, Collider* _sphere) {
-	return SphereToPlane(_sphere, _plane);
+bool CustomPhysicsEngine::PlaneToSphere(Collider* _plane, Collider* _sphere, Manifold* _manifold) {
+	return Flip(SphereToPlane(_sphere, _plane, _manifold), _manifold);
 }
-CollisionManifold CustomPhysicsEngine::BoxToBox(Collider* _first, Collider* _second) {
-	CollisionManifold result = {};
-
-	BoxCollider* BoxA = (BoxCollider*)_first;
-	BoxCollider* BoxB = (BoxCollider*)_second;
-
-	result.isColliding = false;
-	result.colliderA = BoxA;
-	result.colliderB = BoxB;
-	result.restitution = 0.5f;
-
-	Manifold manifold;
-	if (BoxA->obb.Intersects(BoxB->obb, &manifold)) {
-		result.isColliding = true;
-		result.intersectionA = manifold.contacts->penetration;
-		result.intersectionB = -manifold.contacts->penetration;
-		result.normal = manifold.normal;
-		
-		return result;
-	}
-
-	return result;
+bool CustomPhysicsEngine::BoxToBox(Collider* _first, Collider* _second, Manifold* _manifold) {
+	BoxCollider* boxA = (BoxCollider*)_first;
+	BoxCollider* boxB = (BoxCollider*)_second;
+
+	// Note(Manny): The colliders' own boxes are a frame old, build them from where the bodies are now
+	OBB obbA, obbB;
+	obbA.SetFrom(boxA->bounds, *boxA->transform);
+	obbB.SetFrom(boxB->bounds, *boxB->transform);
+	return obbA.Intersects(obbB, _manifold, GetMargin(_first, _second));
 }
-CollisionManifold CustomPhysicsEngine::BoxToPlane(Collider* _box, Collider* _plane) {
-	CollisionManifold result = {};
+bool CustomPhysicsEngine::BoxToPlane(Collider* _box, Collider* _plane, Manifold* _manifold) {
+	BoxCollider* box = (BoxCollider*)_box;
+	PlaneCollider* plane = (PlaneCollider*)_plane;
 
-	// Note(Manny): Implement box to plane when possible.
-	
-	return result;
+	OBB obb;
+	obb.SetFrom(box->bounds, *box->transform);
+	return obb.Intersects(plane->normal, plane->distance, _manifold, GetMargin(_box, _plane));
 }
-CollisionManifold CustomPhysicsEngine::PlaneToBox(Collider* _plane, Collider* _box) {
-	return BoxToPlane(_box, _plane);
+bool CustomPhysicsEngine::PlaneToBox(Collider* _plane, Collider* _box, Manifold* _manifold) {
+	return Flip(BoxToPlane(_box, _plane, _manifold), _manifold);
 }
-CollisionManifold CustomPhysicsEngine::SphereToBox(Collider* _sphere, Collider* _box) {
-	return BoxToSphere(_box, _sphere);
+bool CustomPhysicsEngine::SphereToBox(Collider* _sphere, Collider* _box, Manifold* _manifold) {
+	return Flip(BoxToSphere(_box, _sphere, _manifold), _manifold);
 }
-CollisionManifold CustomPhysicsEngine::BoxToSphere(Collider* _box, Collider* _sphere) {
-	CollisionManifold result = {};
-
+bool CustomPhysicsEngine::BoxToSphere(Collider* _box, Collider* _sphere, Manifold* _manifold) {
 	BoxCollider* box = (BoxCollider*)_box;
 	SphereCollider* sphere = (SphereCollider*)_sphere;
 
+	OBB obb;
+	obb.SetFrom(box->bounds, *box->transform);
 	vec3 center = sphere->transform->position;
+	float radius = sphere->radius;
 
-	vec3 min = box->bounds.min;
-	vec3 max = box->bounds.max;
+	// Closest point on the box, in the box's own axes
+	vec3 local = glm::transpose(obb.axes) * (center - obb.center);
+	vec3 closestLocal = glm::clamp(local, -obb.e, obb.e);
+	vec3 closestPoint = obb.center + obb.axes * closestLocal;
+
+	vec3 normal;
+	float separation;
+	if (closestLocal != local) {
+		vec3 delta = center - closestPoint;
+		float distance = glm::length(delta);
+		normal = delta / distance;
+		separation = distance - radius;
+	} else {
+		// The center is inside, leave through the nearest face
+		int axis = 0;
+		float depth = obb.e.x - glm::abs(local.x);
+		for (int i = 1; i < 3; ++i) {
+			float axisDepth = obb.e[i] - glm::abs(local[i]);
+			if (axisDepth < depth) {
+				depth = axisDepth;
+				axis = i;
+			}
+		}
+		normal = obb.axes[axis] * (local[axis] < 0.0f ? -1.0f : 1.0f);
+		separation = -depth - radius;
+		closestPoint = center + normal * depth;
+	}
 
-	float radius = sphere->radius;
+	vec3 point = (closestPoint + center - normal * radius) * 0.5f;
+	return SingleContact(point, normal, separation, GetMargin(_box, _sphere), _manifold);
+}
 
-	result.colliderA = box;
-	result.colliderB = sphere;
-	result.isColliding = false;
+// Private
+void CustomPhysicsEngine::GatherBodies() {
+	SolverBody world = {};
+	world.rotation = quat();
+	m_bodies.assign(1, world);
+	m_rigidbodies.assign(1, nullptr);
+	m_wakeIslands.clear();
+
+	for (unsigned int actorIndex = 0;
+		actorIndex < actors.size();
+		++actorIndex) {
+		// Note(Manny): Character controllers and emitters are actors without a body
+		Rigidbody* rigidbody = dynamic_cast<Rigidbody*>(actors[actorIndex]);
+		if (rigidbody == nullptr) {
+			continue;
+		}
+		rigidbody->bodyIndex = m_bodies.size();
+		vector<Collider*>& colliders = rigidbody->gameObject->colliders;
+		for (unsigned int i = 0; i < colliders.size(); ++i) {
+			colliders[i]->attachedRigidbody = rigidbody;
+		}
 
-	vec3 closestPoint;
-	closestPoint.x = (center.x < min.x) ? min.x : (center.x > max.x) ? max.x : center.x;
-	closestPoint.y = (center.y < min.y) ? min.y : (center.y > max.y) ? max.y : center.y;
-	closestPoint.z = (center.z < min.z) ? min.z : (center.z > max.z) ? max.z : center.z;
-	
-	vec3 direction = glm::normalize(center - closestPoint);
-	float distance = glm::length(center - closestPoint);
+		// A rigidbody woken since the last step takes the rest of its island with it
+		if (rigidbody->isSleeping && !allowSleeping) {
+			rigidbody->WakeUp();
+		}
+		if (!rigidbody->isSleeping && rigidbody->sleepIsland != 0) {
+			m_wakeIslands.push_back(rigidbody->sleepIsland);
+			rigidbody->sleepIsland = 0;
+		}
 
-	if (distance <= radius) {
-		// Collision response goes here
-		result.restitution = 0.75f;
-		result.isColliding = true;
-		result.intersectionB = (radius - distance);
-		result.normal = glm::normalize(center - closestPoint);
-		result.point = closestPoint;
+		SolverBody body;
+		FillBody(rigidbody, body);
+		m_bodies.push_back(body);
+		m_rigidbodies.push_back(rigidbody);
+	}
+	WakeIslands();
+}
+void CustomPhysicsEngine::FillBody(Rigidbody* _rigidbody, SolverBody& _body) const {
+	// Sleeping bodies are static to the solver, so they are neither integrated nor pushed
+	bool dynamic = _rigidbody->enabled && !_rigidbody->isKinematic && !_rigidbody->gameObject->isStatic &&
+		!_rigidbody->isSleeping && _rigidbody->mass > 0.0f;
+	_body = SolverBody();
+	_body.position = _rigidbody->transform->position;
+	_body.rotation = _rigidbody->transform->rotation;
+	_body.velocity = _rigidbody->velocity;
+	_body.angularVelocity = _rigidbody->angularVelocity;
+	_body.force = _rigidbody->totalForce;
+	_body.torque = _rigidbody->totalTorque;
+	if (dynamic) {
+		const vec3& inertia = _rigidbody->inertiaTensor;
+		_body.inverseMass = 1.0f / _rigidbody->mass;
+		_body.localInverseInertia = vec3(
+			inertia.x > 0.0f ? 1.0f / inertia.x : 0.0f,
+			inertia.y > 0.0f ? 1.0f / inertia.y : 0.0f,
+			inertia.z > 0.0f ? 1.0f / inertia.z : 0.0f);
 	}
+	_body.linearDamping = _rigidbody->drag;
+	_body.angularDamping = _rigidbody->angularDrag;
+	_body.sleepTime = _rigidbody->sleepTime;
+	_body.useGravity = _rigidbody->useGravity;
+}
+void CustomPhysicsEngine::ApplyBodies() {
+	awakeCount = 0;
+	sleepingCount = 0;
+	for (unsigned int i = 1; i < m_bodies.size(); ++i) {
+		Rigidbody* rigidbody = m_rigidbodies[i];
+		const SolverBody& body = m_bodies[i];
+		rigidbody->totalForce = vec3(0);
+		rigidbody->totalTorque = vec3(0);
+		if (rigidbody->isSleeping) {
+			sleepingCount++;
+		}
+		if (body.inverseMass == 0.0f) {
+			continue;
+		}
+		rigidbody->transform->position = body.position;
+		rigidbody->transform->rotation = body.rotation;
+		rigidbody->velocity = body.velocity;
+		rigidbody->angularVelocity = body.angularVelocity;
+		rigidbody->sleepTime = body.sleepTime;
+		awakeCount++;
+	}
+}
+void CustomPhysicsEngine::WakeTouchedIslands() {
+	// Note(Manny): Overlapping bounds are enough to wake an island, a moving body
+	// has to reach it before the narrowphase so its contacts are found this step
+	for (unsigned int pairIndex = 0;
+		pairIndex < pairs.size();
+		++pairIndex) {
+		Rigidbody* rigidA = pairs[pairIndex].colliderA->attachedRigidbody;
+		Rigidbody* rigidB = pairs[pairIndex].colliderB->attachedRigidbody;
+		if (rigidA == nullptr || rigidB == nullptr || rigidA->isSleeping == rigidB->isSleeping) {
+			continue;
+		}
+		Rigidbody* sleeper = rigidA->isSleeping ? rigidA : rigidB;
+		Rigidbody* mover = rigidA->isSleeping ? rigidB : rigidA;
+		bool moving = m_bodies[mover->bodyIndex].inverseMass > 0.0f || (mover->isKinematic && mover->velocity != vec3(0));
+		if (!moving) {
+			continue;
+		}
+		sleeper->WakeUp();
+		FillBody(sleeper, m_bodies[sleeper->bodyIndex]);
+		if (sleeper->sleepIsland != 0) {
+			m_wakeIslands.push_back(sleeper->sleepIsland);
+			sleeper->sleepIsland = 0;
+		}
+	}
+	WakeIslands();
+}
+void CustomPhysicsEngine::WakeIslands() {
+	if (m_wakeIslands.empty()) {
+		return;
+	}
+	std::sort(m_wakeIslands.begin(), m_wakeIslands.end());
+	for (unsigned int i = 1; i < m_rigidbodies.size(); ++i) {
+		Rigidbody* rigidbody = m_rigidbodies[i];
+		if (rigidbody->isSleeping && std::binary_search(m_wakeIslands.begin(), m_wakeIslands.end(), rigidbody->sleepIsland)) {
+			rigidbody->WakeUp();
+			rigidbody->sleepIsland = 0;
+			FillBody(rigidbody, m_bodies[i]);
+		}
+	}
+	m_wakeIslands.clear();
+}
+void CustomPhysicsEngine::SleepIslands() {
+	for (unsigned int i = 0; i < islands.islands.size(); ++i) {
+		const Island& island = islands.islands[i];
+		if (!islands.CanSleep(island)) {
+			continue;
+		}
+		unsigned int sleepIsland = m_nextSleepIsland++;
+		if (m_nextSleepIsland == 0) {
+			m_nextSleepIsland = 1;
+		}
+		for (unsigned int j = 0; j < island.bodyCount; ++j) {
+			Rigidbody* rigidbody = m_rigidbodies[islands.bodies[island.firstBody + j]];
+			rigidbody->Sleep();
+			rigidbody->sleepIsland = sleepIsland;
+		}
+		awakeCount -= island.bodyCount;
+		sleepingCount += island.bodyCount;
+	}
+}
+bool CustomPhysicsEngine::FindContacts(const BroadphasePair& _pair, ContactConstraint& _constraint) const {
+	Collider* colliderA = _pair.colliderA;
+	Collider* colliderB = _pair.colliderB;
+	if (colliderA->isTrigger || colliderB->isTrigger) {
+		return false;
+	}
+
+	// Bodies that nothing moves never need to be pushed apart, sleeping ones included
+	unsigned int bodyA = GetBody(colliderA);
+	unsigned int bodyB = GetBody(colliderB);
+	if (bodyA == bodyB || (m_bodies[bodyA].inverseMass == 0.0f && m_bodies[bodyB].inverseMass == 0.0f)) {
+		return false;
+	}
+
+	int shapeId1 = colliderA->shapeId;
+	int shapeId2 = colliderB->shapeId;
+	if (shapeId1 >= SHAPE_COUNT || shapeId2 >= SHAPE_COUNT) {
+		return false;
+	}
+	int index = (shapeId1 * (SHAPE_COUNT)) + shapeId2;
 
-	return result;
+	CollisionFunction collisionFunction = CollisionFunctionTable[index];
+	if (collisionFunction == nullptr || !collisionFunction(colliderA, colliderB, &_constraint.manifold)) {
+		return false;
+	}
+	_constraint.colliderA = colliderA;
+	_constraint.colliderB = colliderB;
+	_constraint.bodyA = bodyA;
+	_constraint.bodyB = bodyB;
+
+	// Colliders without a rigidbody take on the material of the other one
+	Rigidbody* rigidA = colliderA->attachedRigidbody;
+	Rigidbody* rigidB = colliderB->attachedRigidbody;
+	if (rigidA != nullptr && rigidB != nullptr) {
+		_constraint.friction = glm::sqrt(rigidA->dynamicFriction * rigidB->dynamicFriction);
+		_constraint.restitution = glm::max(rigidA->restitution, rigidB->restitution);
+	} else {
+		Rigidbody* rigid = rigidA != nullptr ? rigidA : rigidB;
+		_constraint.friction = rigid->dynamicFriction;
+		_constraint.restitution = rigid->restitution;
+	}
+	return true;
+}
+unsigned int CustomPhysicsEngine::GetBody(const Collider* _collider) const {
+	return _collider->attachedRigidbody != nullptr ? _collider->attachedRigidbody->bodyIndex : 0;
 }
\ No newline at end of file
@@ -16,45 +16,65 @@ engine capabilities.
 // Sub-engines
 #include "PhysicsEngine.h"
 
-struct CollisionManifold {
-	bool isColliding;
-
-	vec3 point;
-	vec3 normal;
-	float restitution;
-
-	float intersectionA;
-	float intersectionB;
-
-	Collider* colliderA;
-	Collider* colliderB;
-};
+// Physics
+#include "Broadphase.h"
+#include "ContactSolver.h"
+#include "IslandBuilder.h"
 
 class Rigidbody;
 class CustomPhysicsEngine : public PhysicsEngine {
 public:
-	CustomPhysicsEngine(){}
-	virtual ~CustomPhysicsEngine(){}
+	CustomPhysicsEngine() : broadphase(Broadphase::Create(BROADPHASE_SWEEP_AND_PRUNE)), allowSleeping(true),
+		awakeCount(0), sleepingCount(0), stepTime(0.0f), m_nextSleepIsland(1) {}
+	virtual ~CustomPhysicsEngine(){ delete broadphase; }
 	void Shutdown();
 	bool Update();
+	void LateUpdate();
 	void AddActor(PhysicsObject* _actor);
 	bool RemoveActor(PhysicsObject* _actor);
 	void AddArticulation(PhysicsObject* _articulation){}
 	bool RemoveArticulation(PhysicsObject* _articulation){}
 	void CheckForCollisions();
-	void ApplyCollisionResolution(CollisionManifold* _manifold, Rigidbody* _rigid);
-	void ApplyCollisionResolutionTest(CollisionManifold* _manifold, Rigidbody* _rigidA, Rigidbody* _rigidB);
-	static CollisionManifold SphereToSphere(Collider* _first, Collider* _second);
-	static CollisionManifold SphereToPlane(Collider* _sphere, Collider* _plane);
-	static CollisionManifold PlaneToSphere(Collider* _plane, Collider* _sphere);
-	static CollisionManifold BoxToBox(Collider* _first, Collider* _second);
-	static CollisionManifold BoxToPlane(Collider* _box, Collider* _plane);
-	static CollisionManifold PlaneToBox(Collider* _plane, Collider* _box);
-	static CollisionManifold SphereToBox(Collider* _sphere, Collider* _box);
-	static CollisionManifold BoxToSphere(Collider* _box, Collider* _sphere);
+	void SetBroadphase(BroadphaseType _type);
+	// Each fills the manifold with the normal pointing from the first collider to the second
+	static bool SphereToSphere(Collider* _first, Collider* _second, Manifold* _manifold);
+	static bool SphereToPlane(Collider* _sphere, Collider* _plane, Manifold* _manifold);
+	static bool PlaneToSphere(Collider* _plane, Collider* _sphere, Manifold* _manifold);
+	static bool BoxToBox(Collider* _first, Collider* _second, Manifold* _manifold);
+	static bool BoxToPlane(Collider* _box, Collider* _plane, Manifold* _manifold);
+	static bool PlaneToBox(Collider* _plane, Collider* _box, Manifold* _manifold);
+	static bool SphereToBox(Collider* _sphere, Collider* _box, Manifold* _manifold);
+	static bool BoxToSphere(Collider* _box, Collider* _sphere, Manifold* _manifold);
 	
 	vector<PhysicsObject*> actors;
 	vector<PhysicsObject*> articulations;
+	Broadphase* broadphase;
+	vector<BroadphasePair> pairs; //Overlapping pairs found this step
+	ContactSolver solver;
+	IslandBuilder islands;
+	bool allowSleeping; //Resting islands stop being simulated until something touches them
+	unsigned int awakeCount; //Bodies simulated in the last step
+	unsigned int sleepingCount;
+	float stepTime; //Milliseconds spent simulating last frame
+
+	static const unsigned int PAIR_BATCH_SIZE = 128; //Broadphase pairs tested per narrowphase job
+private:
+	void GatherBodies();
+	void FillBody(Rigidbody* _rigidbody, SolverBody& _body) const;
+	void ApplyBodies();
+	void WakeTouchedIslands();
+	void WakeIslands();
+	void SleepIslands();
+	bool FindContacts(const BroadphasePair& _pair, ContactConstraint& _constraint) const;
+	unsigned int GetBody(const Collider* _collider) const;
+
+	vector<SolverBody> m_bodies; //The first is the static world, which colliders without a rigidbody belong to
+	vector<Rigidbody*> m_rigidbodies; //Rigidbody of each body
+	vector<ContactConstraint> m_constraints; //Touching pairs found this step
+	vector<ContactConstraint> m_pairConstraints; //Narrowphase result of each broadphase pair
+	vector<unsigned char> m_pairTouching;
+	vector<unsigned int> m_wakeIslands; //Sleep islands to wake before the step
+	unsigned int m_nextSleepIsland;
 };
 
 #endif // _CUSTOM_PHYSICS_ENGINE_H_
\ No newline at end of file
@@ -20,6 +20,32 @@
 #include "GLFW_Header.h"
 #include "Time.h"
 #include "Input.h"
+#include "JobSystem.h"
+#include "SpatialIndex.h"
+
+// Other
+#include <xmmintrin.h>
+
+bool Fluid::useSIMD = true;
+
+// Runs _cell on the two edge columns, where the neighbours are clamped to the
+// row, and _cells4 four at a time across the interior where they never are
+template<typename Cell, typename Cells4>
+static void ForEachCellInRow(int _width, const Cell& _cell, const Cells4& _cells4) {
+	_cell(0, 0, _width > 1 ? 1 : 0);
+	int x = 1;
+	if (Fluid::useSIMD) {
+		for (; x + 4 <= _width - 1; x += 4) {
+			_cells4(x);
+		}
+	}
+	for (; x < _width - 1; ++x) {
+		_cell(x, x - 1, x + 1);
+	}
+	if (_width > 1) {
+		_cell(_width - 1, _width - 2, _width - 1);
+	}
+}
 
 Fluid::Fluid(int _width, int _height, float _viscocity, float _cellDist) {
 	width = _width;
@@ -27,85 +53,58 @@ Fluid::Fluid(int _width, int _height, float _viscocity, float _cellDist) {
 	viscocity = _viscocity;
 	cellDist = _cellDist;
 	cellCount = _width * _height;
+	m_dyeTexture = nullptr;
 }
 Fluid::~Fluid(){}
 bool Fluid::Startup() {
-	frontCells.velocity = new glm::vec2[cellCount];
-	frontCells.dyeColor = new glm::vec3[cellCount];
-	frontCells.pressure = new float[cellCount];
-	backCells.velocity = new glm::vec2[cellCount];
-	backCells.dyeColor = new glm::vec3[cellCount];
-	backCells.pressure = new float[cellCount];
+	FluidCell* cells[2] = { &frontCells, &backCells };
+	for (unsigned int i = 0; i < 2; ++i) {
+		cells[i]->pressure = new float[cellCount];
+		cells[i]->velocityX = new float[cellCount];
+		cells[i]->velocityY = new float[cellCount];
+		cells[i]->dyeR = new float[cellCount];
+		cells[i]->dyeG = new float[cellCount];
+		cells[i]->dyeB = new float[cellCount];
+		ZeroCells(*cells[i]);
+	}
 	divergence = new float[cellCount];
-
-	memset(frontCells.velocity, 0, sizeof(glm::vec2) * cellCount);
-	memset(frontCells.dyeColor, 0, sizeof(glm::vec3) * cellCount);
-	memset(frontCells.pressure, 0, sizeof(float)* cellCount);
-
-	memset(backCells.velocity, 0, sizeof(glm::vec2) * cellCount);
-	memset(backCells.dyeColor, 0, sizeof(glm::vec3) * cellCount);
-	memset(backCells.pressure, 0, sizeof(float)* cellCount);
-
 	memset(divergence, 0, sizeof(float)* cellCount);
 
 	for (int i = 0; i < cellCount; ++i) {
-		frontCells.dyeColor[i] = glm::vec3(100, 20, 50);
-		float x = (float)(i % width);
-		float y = (float)(i / width);
-		frontCells.dyeColor[i] = glm::vec3(x, y, 0);
+		frontCells.dyeR[i] = (float)(i % width);
+		frontCells.dyeG[i] = (float)(i / width);
+		frontCells.dyeB[i] = 0.0f;
 		frontCells.pressure[i] = 1;
 	}
 
 	return true;
 }
 void Fluid::Shutdown() {
-	//Front Cells
-	delete[] frontCells.velocity;
-	delete[] frontCells.dyeColor;
-	delete[] frontCells.pressure;
-	//Back Cells
-	delete[] backCells.velocity;
-	delete[] backCells.dyeColor;
-	delete[] backCells.pressure;
+	FluidCell* cells[2] = { &frontCells, &backCells };
+	for (unsigned int i = 0; i < 2; ++i) {
+		delete[] cells[i]->pressure;
+		delete[] cells[i]->velocityX;
+		delete[] cells[i]->velocityY;
+		delete[] cells[i]->dyeR;
+		delete[] cells[i]->dyeG;
+		delete[] cells[i]->dyeB;
+	}
 	//Divergence
 	delete[] divergence;
+	//Texture handle, the texture data itself belongs to Texture
+	delete m_dyeTexture;
+	m_dyeTexture = nullptr;
 }
 bool Fluid::Update() {
-	Advect(Time::deltaTime);
-	SwapVelocities();
-	SwapColors();
-
-	for (int diffuseStep = 0; diffuseStep < 50; ++diffuseStep) {
-		Diffuse(Time::deltaTime);
-		SwapVelocities();
-	}
-	Divergence(Time::deltaTime);
-	for (int pressureStep = 0; pressureStep < 60; ++pressureStep) {
-		UpdatePressure(Time::deltaTime);
-		SwapPressures();
-	}
-
-	ApplyPressure(Time::deltaTime);
-	SwapVelocities();
-
-	UpdateBoundary();
-
-	int boxSize = 10;
-	int halfBoxSize = boxSize / 2;
-
-	for (int x = width / 2 - halfBoxSize; x < width / 2 + halfBoxSize; ++x) {
-		for (int y = 5; y < 5 + boxSize; ++y) {
-			int cellIndex = x + y * width;
-			frontCells.velocity[cellIndex].y += 10 * Time::deltaTime;
-		}
-	}
+	Simulate(Time::deltaTime);
 
 	if (Input::GetMouseButton(GLFW_MOUSE_BUTTON_1)) {
 		MeshRenderer* meshRenderer = gameObject->GetComponent<MeshRenderer>();
 		if (meshRenderer != nullptr) {
+			// Only dye the fluid when nothing else is in front of it
 			Ray mouseRay = Camera::current->ScreenPointToRay(Input::GetMousePosition());
 			RaycastHit hit;
-			if (meshRenderer->bounds.RayCast(mouseRay, &hit, 1000.0f)) {
+			if (SpatialIndex::Raycast(mouseRay, hit, 1000.0f) && hit.transform == transform) {
 				vec3 bottomCorner = transform->position - meshRenderer->bounds.size;
 				vec2 relativePos = vec2(hit.point.x - bottomCorner.x,
 					hit.point.z - bottomCorner.z);
@@ -119,44 +118,74 @@ bool Fluid::Update() {
 				int y = (int)point.y;
 
 				int cellIndex = x + y * width;
-				frontCells.dyeColor[cellIndex] = vec3(0, 255, 0);
+				frontCells.dyeR[cellIndex] = 0;
+				frontCells.dyeG[cellIndex] = 255;
+				frontCells.dyeB[cellIndex] = 0;
 			}
 		}
 	}
 
 	return true;
 }
-void Fluid::Draw(RenderingEngine& _renderer) {
-	//Allocate space for texture data
-	unsigned char* texData = new unsigned char[(width * height) * 3];
-
-	//Fill texture data with dye colors
-	for (int i = 0; i < width * height; ++i) {
-		texData[i * 3 + 0] = (unsigned char)frontCells.dyeColor[i].r;
-		texData[i * 3 + 1] = (unsigned char)frontCells.dyeColor[i].g;
-		texData[i * 3 + 2] = (unsigned char)frontCells.dyeColor[i].b;
+void Fluid::Simulate(float _deltaTime) {
+	Advect(_deltaTime);
+	SwapVelocities();
+	SwapColors();
+
+	for (int diffuseStep = 0; diffuseStep < 50; ++diffuseStep) {
+		Diffuse(_deltaTime);
+		SwapVelocities();
+	}
+	Divergence(_deltaTime);
+	for (int pressureStep = 0; pressureStep < 60; ++pressureStep) {
+		UpdatePressure(_deltaTime);
+		SwapPressures();
 	}
 
-	Texture::RemoveTexture("fluidTexture");
-	Texture newTexture = Texture(width, height, texData, "fluidTexture",
-		GL_TEXTURE_2D, GL_NEAREST, GL_RGB, GL_RGB);
+	ApplyPressure(_deltaTime);
+	SwapVelocities();
 
-	//Render texture using OpenGL
-	MeshRenderer* meshRenderer = gameObject->GetComponent<MeshRenderer>();
-	if (meshRenderer != nullptr) {
-		meshRenderer->materials.front().SetTexture("diffuse", newTexture);
+	UpdateBoundary();
+
+	int boxSize = 10;
+	int halfBoxSize = boxSize / 2;
+
+	for (int x = width / 2 - halfBoxSize; x < width / 2 + halfBoxSize; ++x) {
+		for (int y = 5; y < 5 + boxSize; ++y) {
+			int cellIndex = x + y * width;
+			frontCells.velocityY[cellIndex] += 10 * _deltaTime;
+		}
+	}
+}
+void Fluid::Draw(RenderingEngine& _renderer) {
+	if (m_dyeTexture == nullptr) {
+		MeshRenderer* meshRenderer = gameObject->GetComponent<MeshRenderer>();
+		if (meshRenderer == nullptr) {
+			return;
+		}
+		Texture::RemoveTexture("fluidTexture");
+		m_dyeTexture = new Texture(width, height, nullptr, "fluidTexture",
+			GL_TEXTURE_2D, GL_NEAREST, GL_RGB, GL_RGB);
+		meshRenderer->materials.front().SetTexture("diffuse", *m_dyeTexture);
 	}
 
-	//Delete texture
-	delete[] texData;
+	//Quantize the dye colors straight into the mapped upload buffer
+	unsigned char* texData = m_dyeTexture->BeginUpdate();
+	ForEachRow([&](int y) {
+		for (int i = y * width; i < (y + 1) * width; ++i) {
+			texData[i * 3 + 0] = (unsigned char)glm::clamp(frontCells.dyeR[i], 0.0f, 255.0f);
+			texData[i * 3 + 1] = (unsigned char)glm::clamp(frontCells.dyeG[i], 0.0f, 255.0f);
+			texData[i * 3 + 2] = (unsigned char)glm::clamp(frontCells.dyeB[i], 0.0f, 255.0f);
+		}
+	});
+	m_dyeTexture->EndUpdate();
 }
 void Fluid::Advect(float _deltaTime) {
-	//Loop over every cell
-	for (int y = 0; y < height; ++y) {
+	ForEachRow([&](int y) {
 		for (int x = 0; x < width; ++x) {
 			//Find the point to sample for this cell
 			int cellIndex = x + y * width;
-			vec2 vel = frontCells.velocity[cellIndex] * _deltaTime;
+			vec2 vel = vec2(frontCells.velocityX[cellIndex], frontCells.velocityY[cellIndex]) * _deltaTime;
 			vec2 samplePoint = glm::vec2((float)x - vel.x / cellDist,
 				(float)y - vel.y / cellDist);
 
@@ -165,225 +194,197 @@ void Fluid::Advect(float _deltaTime) {
 
 			//Compute bilerp for the point
 			vec2 bl = glm::floor(samplePoint);
-			vec2 br = bl + vec2(1, 0);
-			vec2 tl = bl + vec2(0, 1);
-			vec2 tr = bl + vec2(1, 1);
 
 			//Bottom left Index
 			int bli = (int)bl.x + width * (int)bl.y;
-			int bri = (int)br.x + width * (int)br.y;
-			int tli = (int)tl.x + width * (int)tl.y;
-			int tri = (int)tr.x + width * (int)tr.y;
+			int bri = bli + 1;
+			int tli = bli + width;
+			int tri = tli + 1;
 
 			vec2 sampleFract = samplePoint - bl;
 
-			//Actually advecting
-			//Color 
-			vec3 dyeB = glm::mix(frontCells.dyeColor[bli],
-				frontCells.dyeColor[bri],
-				sampleFract.x);
-			vec3 dyeT = glm::mix(frontCells.dyeColor[tli],
-				frontCells.dyeColor[tri],
-				sampleFract.x);
-
-			vec3 newDye = glm::mix(dyeB, dyeT, sampleFract.y);
-			backCells.dyeColor[cellIndex] = newDye;
-
-			//Velocity
-			vec2 velB = glm::mix(frontCells.velocity[bli],
-				frontCells.velocity[bri],
-				sampleFract.x);
-			vec2 velT = glm::mix(frontCells.velocity[tli],
-				frontCells.velocity[tri],
-				sampleFract.x);
-
-			vec2 newVel = glm::mix(velB, velT, sampleFract.y);
-			backCells.velocity[cellIndex] = newVel;
+			//Actually advecting, each plane is blended on its own
+			const float* sources[5] = { frontCells.dyeR, frontCells.dyeG, frontCells.dyeB,
+				frontCells.velocityX, frontCells.velocityY };
+			float* targets[5] = { backCells.dyeR, backCells.dyeG, backCells.dyeB,
+				backCells.velocityX, backCells.velocityY };
+			for (unsigned int i = 0; i < 5; ++i) {
+				const float* source = sources[i];
+				float bottom = glm::mix(source[bli], source[bri], sampleFract.x);
+				float top = glm::mix(source[tli], source[tri], sampleFract.x);
+				targets[i][cellIndex] = glm::mix(bottom, top, sampleFract.y);
+			}
 		}
-	}
+	});
 }
 void Fluid::Diffuse(float _deltaTime) {
 	float invViscosityDeltaTime = 1.0f / (viscocity * _deltaTime);
-	for (int y = 0; y < height; ++y) {
-		for (int x = 0; x < width; ++x) {
-			int cellIndex = x + y * width;
-			// Gather the 4 velocities around us
-				
-			// x plus 1
-			// x minus 1
-			int xp1 = glm::clamp(x + 1, 0, width - 1);
-			int xm1 = glm::clamp(x - 1, 0, width - 1);
-			int yp1 = glm::clamp(y + 1, 0, height - 1);
-			int ym1 = glm::clamp(y - 1, 0, height - 1);
-
-			int up = x + yp1 * width;
-			int down = x + ym1 * width;
-			int right = xp1 + y * width;
-			int left = xm1 + y * width;
-
-			vec2 velUp = frontCells.velocity[up];
-			vec2 velDown = frontCells.velocity[down];
-			vec2 velLeft = frontCells.velocity[left];
-			vec2 velRight = frontCells.velocity[right];
-
-			vec2 velCenter = frontCells.velocity[cellIndex];
-
-			// Put in equation
-			float denom = 1.0f / (4 + invViscosityDeltaTime);
-
-			vec2 diffusedVel = (velUp + velRight + velDown +
-				velLeft + velCenter * invViscosityDeltaTime) * denom;
-
-			backCells.velocity[cellIndex] = diffusedVel;
+	float denom = 1.0f / (4 + invViscosityDeltaTime);
+	const __m128 invViscosityDeltaTime4 = _mm_set1_ps(invViscosityDeltaTime);
+	const __m128 denom4 = _mm_set1_ps(denom);
+
+	ForEachRow([&](int y) {
+		int row = y * width;
+		int up = glm::min(y + 1, height - 1) * width;
+		int down = glm::max(y - 1, 0) * width;
+
+		// Both velocity components use the same stencil
+		const float* sources[2] = { frontCells.velocityX, frontCells.velocityY };
+		float* targets[2] = { backCells.velocityX, backCells.velocityY };
+		for (unsigned int i = 0; i < 2; ++i) {
+			const float* v = sources[i];
+			float* target = targets[i];
+			ForEachCellInRow(width, [&](int x, int left, int right) {
+				target[row + x] = (v[up + x] + v[row + right] + v[down + x] +
+					v[row + left] + v[row + x] * invViscosityDeltaTime) * denom;
+			}, [&](int x) {
+				__m128 sum = _mm_add_ps(_mm_loadu_ps(v + up + x), _mm_loadu_ps(v + row + x + 1));
+				sum = _mm_add_ps(sum, _mm_loadu_ps(v + down + x));
+				sum = _mm_add_ps(sum, _mm_loadu_ps(v + row + x - 1));
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(v + row + x), invViscosityDeltaTime4));
+				_mm_storeu_ps(target + row + x, _mm_mul_ps(sum, denom4));
+			});
 		}
-	}
+	});
 }
 void Fluid::Divergence(float _deltaTime) {
 	float invCellDist = 1.0f / (2.0f * cellDist);
-
-	for (int y = 0; y < height; ++y) {
-		for (int x = 0; x < width; ++x) {
-			int cellIndex = x + y * width;
-
-			// x minus 1
-			int xp1 = glm::clamp(x + 1, 0, width - 1);
-			int xm1 = glm::clamp(x - 1, 0, width - 1);
-			int yp1 = glm::clamp(y + 1, 0, height - 1);
-			int ym1 = glm::clamp(y - 1, 0, height - 1);
-
-			int up = x + yp1 * width;
-			int down = x + ym1 * width;
-			int right = xp1 + y * width;
-			int left = xm1 + y * width;
-
-			float velUp = frontCells.velocity[up].y;
-			float velDown = frontCells.velocity[down].y;
-			float velLeft = frontCells.velocity[left].x;
-			float velRight = frontCells.velocity[right].x;
-
-			float divergence = ((velRight - velLeft) + (velUp - velDown)) * invCellDist;
-
-			this->divergence[cellIndex] = divergence;
-		}
-	}
+	const __m128 invCellDist4 = _mm_set1_ps(invCellDist);
+	const float* vx = frontCells.velocityX;
+	const float* vy = frontCells.velocityY;
+
+	ForEachRow([&](int y) {
+		int row = y * width;
+		int up = glm::min(y + 1, height - 1) * width;
+		int down = glm::max(y - 1, 0) * width;
+
+		ForEachCellInRow(width, [&](int x, int left, int right) {
+			divergence[row + x] = ((vx[row + right] - vx[row + left]) +
+				(vy[up + x] - vy[down + x])) * invCellDist;
+		}, [&](int x) {
+			__m128 horizontal = _mm_sub_ps(_mm_loadu_ps(vx + row + x + 1), _mm_loadu_ps(vx + row + x - 1));
+			__m128 vertical = _mm_sub_ps(_mm_loadu_ps(vy + up + x), _mm_loadu_ps(vy + down + x));
+			_mm_storeu_ps(divergence + row + x, _mm_mul_ps(_mm_add_ps(horizontal, vertical), invCellDist4));
+		});
+	});
 }
 void Fluid::UpdatePressure(float _deltaTime) {
-	for (int y = 0; y < height; ++y) {
-		for (int x = 0; x < width; ++x) {
-			int cellIndex = x + y * width;
-			// x plus 1
-			// x minus 1
-			int xp1 = glm::clamp(x + 1, 0, width - 1);
-			int xm1 = glm::clamp(x - 1, 0, width - 1);
-			int yp1 = glm::clamp(y + 1, 0, height - 1);
-			int ym1 = glm::clamp(y - 1, 0, height - 1);
-
-			int up = x + yp1 * width;
-			int down = x + ym1 * width;
-			int right = xp1 + y * width;
-			int left = xm1 + y * width;
-
-			float pUp = frontCells.pressure[up];
-			float pDown = frontCells.pressure[down];
-			float pLeft = frontCells.pressure[left];
-			float pRight = frontCells.pressure[right];
-
-			float d = divergence[cellIndex];
-
-			float newPressure = (pUp + pDown + pLeft + pRight -
-				d * cellDist * cellDist) * 0.25f;
-
-			backCells.pressure[cellIndex] = newPressure;
-		}
-	}
+	float cellDistSqr = cellDist * cellDist;
+	const __m128 cellDistSqr4 = _mm_set1_ps(cellDistSqr);
+	const __m128 quarter4 = _mm_set1_ps(0.25f);
+	const float* p = frontCells.pressure;
+	float* target = backCells.pressure;
+
+	ForEachRow([&](int y) {
+		int row = y * width;
+		int up = glm::min(y + 1, height - 1) * width;
+		int down = glm::max(y - 1, 0) * width;
+
+		ForEachCellInRow(width, [&](int x, int left, int right) {
+			target[row + x] = (p[up + x] + p[down + x] + p[row + left] + p[row + right] -
+				divergence[row + x] * cellDistSqr) * 0.25f;
+		}, [&](int x) {
+			__m128 sum = _mm_add_ps(_mm_loadu_ps(p + up + x), _mm_loadu_ps(p + down + x));
+			sum = _mm_add_ps(sum, _mm_loadu_ps(p + row + x - 1));
+			sum = _mm_add_ps(sum, _mm_loadu_ps(p + row + x + 1));
+			sum = _mm_sub_ps(sum, _mm_mul_ps(_mm_loadu_ps(divergence + row + x), cellDistSqr4));
+			_mm_storeu_ps(target + row + x, _mm_mul_ps(sum, quarter4));
+		});
+	});
 }
 void Fluid::ApplyPressure(float _deltaTime) {
 	float invCellDist = 1.0f / (2.0f * cellDist);
-
-	for (int y = 0; y < height; ++y) {
-		for (int x = 0; x < width; ++x) {
-			int cellIndex = x + y * width;
-
-			// x plus 1
-			// x minus 1
-			int xp1 = glm::clamp(x + 1, 0, width - 1);
-			int xm1 = glm::clamp(x - 1, 0, width - 1);
-			int yp1 = glm::clamp(y + 1, 0, height - 1);
-			int ym1 = glm::clamp(y - 1, 0, height - 1);
-
-			int up = x + yp1 * width;
-			int down = x + ym1 * width;
-			int left = xm1 + y * width;
-			int right = xp1 + y * width;
-
-			float pUp = frontCells.pressure[up];
-			float pDown = frontCells.pressure[down];
-			float pLeft = frontCells.pressure[left];
-			float pRight = frontCells.pressure[right];
-
-			vec2 deltaV = -vec2(pRight - pLeft, pUp - pDown) * invCellDist;
-
-			backCells.velocity[cellIndex] =
-				frontCells.velocity[cellIndex] + deltaV;
-		}
-	}
+	const __m128 invCellDist4 = _mm_set1_ps(invCellDist);
+	const float* p = frontCells.pressure;
+
+	ForEachRow([&](int y) {
+		int row = y * width;
+		int up = glm::min(y + 1, height - 1) * width;
+		int down = glm::max(y - 1, 0) * width;
+
+		ForEachCellInRow(width, [&](int x, int left, int right) {
+			backCells.velocityX[row + x] = frontCells.velocityX[row + x] -
+				(p[row + right] - p[row + left]) * invCellDist;
+			backCells.velocityY[row + x] = frontCells.velocityY[row + x] -
+				(p[up + x] - p[down + x]) * invCellDist;
+		}, [&](int x) {
+			__m128 gradientX = _mm_sub_ps(_mm_loadu_ps(p + row + x + 1), _mm_loadu_ps(p + row + x - 1));
+			__m128 gradientY = _mm_sub_ps(_mm_loadu_ps(p + up + x), _mm_loadu_ps(p + down + x));
+			_mm_storeu_ps(backCells.velocityX + row + x, _mm_sub_ps(_mm_loadu_ps(frontCells.velocityX + row + x),
+				_mm_mul_ps(gradientX, invCellDist4)));
+			_mm_storeu_ps(backCells.velocityY + row + x, _mm_sub_ps(_mm_loadu_ps(frontCells.velocityY + row + x),
+				_mm_mul_ps(gradientY, invCellDist4)));
+		});
+	});
 }
 void Fluid::UpdateBoundary() {
+	//p = pressure
+	//v = velocity
+	float* p = frontCells.pressure;
+	float* vx = frontCells.velocityX;
+	float* vy = frontCells.velocityY;
+
 	for (int x = 0; x < width; ++x) {
 		int first_row_index = x;
 		int second_row_index = x + width;
 
-		//p = pressure
-		//v = velocity
-
-		float* p = frontCells.pressure;
-		glm::vec2* v = frontCells.velocity;
-
 		p[first_row_index] = p[second_row_index];
-		v[first_row_index].x = v[second_row_index].x;
-		v[first_row_index].y = -v[second_row_index].y;
+		vx[first_row_index] = vx[second_row_index];
+		vy[first_row_index] = -vy[second_row_index];
 
 		int last_row_index = x + (height - 1) * width;
 		int second_last_row_index = x + (height - 2) * width;
 
 		p[last_row_index] = p[second_last_row_index];
-		v[last_row_index].x = v[second_last_row_index].x;
-		v[last_row_index].y = -v[second_last_row_index].y;
+		vx[last_row_index] = vx[second_last_row_index];
+		vy[last_row_index] = -vy[second_last_row_index];
 	}
 
 	for (int y = 0; y < height; ++y) {
 		int first_col_index = 0 + y * width;
 		int second_col_index = 1 + y * width;
 
-		//p = pressure
-		//v = velocity
-		float* p = frontCells.pressure;
-		glm::vec2* v = frontCells.velocity;
-
 		p[first_col_index] = p[second_col_index];
-		v[first_col_index].x = -v[second_col_index].x;
-		v[first_col_index].y = v[second_col_index].y;
+		vx[first_col_index] = -vx[second_col_index];
+		vy[first_col_index] = vy[second_col_index];
 
 		int last_col_index = (width - 1) + y * width;
 		int second_last_col_index = (width - 2) + y * width;
 
 		p[last_col_index] = p[second_last_col_index];
-		v[last_col_index].x = -v[second_last_col_index].x;
-		v[last_col_index].y = v[second_last_col_index].y;
+		vx[last_col_index] = -vx[second_last_col_index];
+		vy[last_col_index] = vy[second_last_col_index];
 	}
 }
 void Fluid::SwapVelocities() {
-	glm::vec2* temp = frontCells.velocity;
-	frontCells.velocity = backCells.velocity;
-	backCells.velocity = temp;
+	std::swap(frontCells.velocityX, backCells.velocityX);
+	std::swap(frontCells.velocityY, backCells.velocityY);
 }
 void Fluid::SwapColors() {
-	glm::vec3* temp = frontCells.dyeColor;
-	frontCells.dyeColor = backCells.dyeColor;
-	backCells.dyeColor = temp;
+	std::swap(frontCells.dyeR, backCells.dyeR);
+	std::swap(frontCells.dyeG, backCells.dyeG);
+	std::swap(frontCells.dyeB, backCells.dyeB);
 }
 void Fluid::SwapPressures() {
-	float* temp = frontCells.pressure;
-	frontCells.pressure = backCells.pressure;
-	backCells.pressure = temp;
+	std::swap(frontCells.pressure, backCells.pressure);
+}
+
+// Private
+void Fluid::ForEachRow(const std::function<void(int _y)>& _row) {
+	// Note(Manny): Rows only read the front planes and write their own cells of
+	// the back planes, so bands of rows can be solved on any thread
+	int rowsPerBand = glm::max(ROW_BAND_CELLS / glm::max(width, 1), 1);
+	JobSystem::ParallelFor(height, rowsPerBand, [&](unsigned int _begin, unsigned int _end) {
+		for (unsigned int y = _begin; y < _end; ++y) {
+			_row(y);
+		}
+	});
 }
+void Fluid::ZeroCells(FluidCell& _cells) {
+	memset(_cells.pressure, 0, sizeof(float)* cellCount);
+	memset(_cells.velocityX, 0, sizeof(float)* cellCount);
+	memset(_cells.velocityY, 0, sizeof(float)* cellCount);
+	memset(_cells.dyeR, 0, sizeof(float)* cellCount);
+	memset(_cells.dyeG, 0, sizeof(float)* cellCount);
+	memset(_cells.dyeB, 0, sizeof(float)* cellCount);
+}
\ No newline at end of file
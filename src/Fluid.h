@@ -21,13 +21,22 @@ Copyright (c) 2015 Emmanuel Vaccaro
 // Utilities
 #include "GLM_Header.h"
 
+// Other
+#include <functional>
+
+// Every quantity is stored in its own plane of floats so the
+// solver can process four neighbouring cells at once
 struct FluidCell {
 	float* pressure;
-	vec2* velocity;
-	vec3* dyeColor;
+	float* velocityX;
+	float* velocityY;
+	float* dyeR;
+	float* dyeG;
+	float* dyeB;
 };
 
 class RenderingEngine;
+class Texture;
 class Fluid : public Component {
 public:
 	Fluid(int _width = 64, int _height = 64,
@@ -37,6 +46,7 @@ public:
 	void Shutdown();
 	bool Update();
 	void Draw(RenderingEngine& _renderer);
+	void Simulate(float _deltaTime); //One step of the solver, everything Update does besides the mouse input
 	void Advect(float _deltaTime);
 	void Diffuse(float _deltaTime);
 	void Divergence(float _deltaTime);
@@ -55,6 +65,15 @@ public:
 	int cellCount;
 
 	float* divergence;
+
+	static bool useSIMD; //Solve the interior cells with SSE
+private:
+	static const int ROW_BAND_CELLS = 4096; //Roughly how many cells each job solves
+
+	void ForEachRow(const std::function<void(int _y)>& _row);
+	void ZeroCells(FluidCell& _cells);
+
+	Texture* m_dyeTexture; //Created on the first draw and streamed to afterwards
 };
 
 #endif // _FLUID_H_
\ No newline at end of file
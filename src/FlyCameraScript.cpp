@@ -11,13 +11,17 @@
 // GUI
 #include "imgui.h"
 
+// Utilities
+#include "SpatialIndex.h"
+
 // Other
 #include "Input.h"
 #include "Time.h"
 
 FlyCameraScript::FlyCameraScript() :
 	mouseSensitivity(20.0f),
-	movementSpeed(20.0f) {}
+	movementSpeed(20.0f),
+	focusDistance(10.0f) {}
 bool FlyCameraScript::Startup(){ return true; }
 void FlyCameraScript::Shutdown(){}
 bool FlyCameraScript::Update() {	
@@ -40,6 +44,14 @@ bool FlyCameraScript::Update() {
 			transform->position += transform->right * movementSpeed * Time::deltaTime;
 		}
 
+		// Moves up to whatever is under the cursor, keeping the current view direction
+		if (Input::GetKeyDown(GLFW_KEY_F)) {
+			RaycastHit hit;
+			if (SpatialIndex::Raycast(Camera::current->ScreenPointToRay(Input::GetMousePosition()), hit, 10000.0f)) {
+				transform->position = hit.point + transform->forward * focusDistance;
+			}
+		}
+
 		if (Input::GetMouseButtonDown(GLFW_MOUSE_BUTTON_RIGHT)) {
 			glfwGetCursorPos(Window::window, &oldMouseX, &oldMouseY);
 			glfwSetCursorPos(Window::window, Window::width * 0.5f, Window::height* 0.5f);
@@ -87,6 +99,7 @@ void FlyCameraScript::Inspector() {
 		// Settings go here
 		ImGui::DragFloat("Mouse Sensitivity", &mouseSensitivity, 0.1f);
 		ImGui::DragFloat("Movement Speed", &movementSpeed);
+		ImGui::DragFloat("Focus Distance", &focusDistance);
 		ImGui::TreePop();
 	}
 	ImGui::EndChild();
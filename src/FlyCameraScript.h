@@ -28,6 +28,7 @@ public:
 
 	float mouseSensitivity;
 	float movementSpeed;
+	float focusDistance; //How far from an object F leaves the camera
 	mutable double oldMouseX;
 	mutable double oldMouseY;
 };
@@ -0,0 +1,99 @@
+#include "Frustum.h"
+
+// Other
+#include <xmmintrin.h>
+
+// Public
+Frustum::Frustum() {}
+Frustum::Frustum(const mat4& _viewProjection) {
+	ExtractPlanes(_viewProjection);
+}
+void Frustum::ExtractPlanes(const mat4& _viewProjection) {
+	// Note(Manny): Gribb/Hartmann plane extraction, glm matrices are column major
+	vec4 rowX(_viewProjection[0][0], _viewProjection[1][0], _viewProjection[2][0], _viewProjection[3][0]);
+	vec4 rowY(_viewProjection[0][1], _viewProjection[1][1], _viewProjection[2][1], _viewProjection[3][1]);
+	vec4 rowZ(_viewProjection[0][2], _viewProjection[1][2], _viewProjection[2][2], _viewProjection[3][2]);
+	vec4 rowW(_viewProjection[0][3], _viewProjection[1][3], _viewProjection[2][3], _viewProjection[3][3]);
+
+	planes[FRUSTUM_LEFT] = rowW + rowX;
+	planes[FRUSTUM_RIGHT] = rowW - rowX;
+	planes[FRUSTUM_BOTTOM] = rowW + rowY;
+	planes[FRUSTUM_TOP] = rowW - rowY;
+	planes[FRUSTUM_NEAR] = rowW + rowZ;
+	planes[FRUSTUM_FAR] = rowW - rowZ;
+
+	for (unsigned int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+		float length = glm::length(vec3(planes[i].x, planes[i].y, planes[i].z));
+		if (length > 0.0f) {
+			planes[i] /= length;
+		}
+	}
+}
+bool Frustum::Intersects(const Bounds& _bounds) const {
+	return Intersects(_bounds.center, _bounds.size);
+}
+bool Frustum::Intersects(const vec3& _center, const vec3& _halfSize) const {
+	for (unsigned int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+		const vec4& plane = planes[i];
+		float distance = plane.x * _center.x + plane.y * _center.y + plane.z * _center.z + plane.w;
+		float radius = fabsf(plane.x) * _halfSize.x + fabsf(plane.y) * _halfSize.y + fabsf(plane.z) * _halfSize.z;
+		if (distance + radius < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+void Frustum::IntersectsAABBs(const float* _centerX, const float* _centerY, const float* _centerZ,
+	const float* _sizeX, const float* _sizeY, const float* _sizeZ,
+	unsigned int _count, unsigned char* _visible) const {
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	__m128 planeX[FRUSTUM_PLANE_COUNT];
+	__m128 planeY[FRUSTUM_PLANE_COUNT];
+	__m128 planeZ[FRUSTUM_PLANE_COUNT];
+	__m128 planeW[FRUSTUM_PLANE_COUNT];
+	__m128 absPlaneX[FRUSTUM_PLANE_COUNT];
+	__m128 absPlaneY[FRUSTUM_PLANE_COUNT];
+	__m128 absPlaneZ[FRUSTUM_PLANE_COUNT];
+	for (unsigned int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+		planeX[i] = _mm_set1_ps(planes[i].x);
+		planeY[i] = _mm_set1_ps(planes[i].y);
+		planeZ[i] = _mm_set1_ps(planes[i].z);
+		planeW[i] = _mm_set1_ps(planes[i].w);
+		absPlaneX[i] = _mm_andnot_ps(signMask, planeX[i]);
+		absPlaneY[i] = _mm_andnot_ps(signMask, planeY[i]);
+		absPlaneZ[i] = _mm_andnot_ps(signMask, planeZ[i]);
+	}
+
+	unsigned int i = 0;
+	for (; i + 4 <= _count; i += 4) {
+		__m128 centerX = _mm_loadu_ps(_centerX + i);
+		__m128 centerY = _mm_loadu_ps(_centerY + i);
+		__m128 centerZ = _mm_loadu_ps(_centerZ + i);
+		__m128 sizeX = _mm_loadu_ps(_sizeX + i);
+		__m128 sizeY = _mm_loadu_ps(_sizeY + i);
+		__m128 sizeZ = _mm_loadu_ps(_sizeZ + i);
+
+		// A box is outside if it is fully behind any one plane
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+		for (unsigned int j = 0; j < FRUSTUM_PLANE_COUNT; ++j) {
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[j], centerX), _mm_mul_ps(planeY[j], centerY)),
+				_mm_add_ps(_mm_mul_ps(planeZ[j], centerZ), planeW[j]));
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absPlaneX[j], sizeX), _mm_mul_ps(absPlaneY[j], sizeY)),
+				_mm_mul_ps(absPlaneZ[j], sizeZ));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (unsigned int j = 0; j < 4; ++j) {
+			_visible[i + j] = (mask >> j) & 1;
+		}
+	}
+
+	// Note(Manny): Runs of commands can start and end anywhere in the arrays, so
+	// the last few boxes are tested alone rather than loaded past the end
+	for (; i < _count; ++i) {
+		_visible[i] = Intersects(vec3(_centerX[i], _centerY[i], _centerZ[i]), vec3(_sizeX[i], _sizeY[i], _sizeZ[i])) ? 1 : 0;
+	}
+}
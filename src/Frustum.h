@@ -0,0 +1,49 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: Frustum.h
+@date: 14/08/2015
+@author: Emmanuel Vaccaro
+@brief: The six planes of a camera's view
+volume, used to cull bounding boxes.
+===============================================*/
+
+#ifndef _FRUSTUM_H_
+#define _FRUSTUM_H_
+
+// Utilities
+#include "GLM_Header.h"
+
+// Structs
+#include "Bounds.h"
+
+enum FrustumPlane {
+	FRUSTUM_LEFT,
+	FRUSTUM_RIGHT,
+	FRUSTUM_BOTTOM,
+	FRUSTUM_TOP,
+	FRUSTUM_NEAR,
+	FRUSTUM_FAR,
+	FRUSTUM_PLANE_COUNT
+};
+
+class Frustum {
+public:
+	Frustum();
+	Frustum(const mat4& _viewProjection);
+	void ExtractPlanes(const mat4& _viewProjection);
+	bool Intersects(const Bounds& _bounds) const;
+	bool Intersects(const vec3& _center, const vec3& _halfSize) const;
+	// Tests boxes stored as separate center and half size arrays, four at a time
+	// and the last few one by one, so nothing past _count is read or written.
+	// Writes 1 to _visible for each box that is inside or intersecting the
+	// frustum, 0 otherwise.
+	void IntersectsAABBs(const float* _centerX, const float* _centerY, const float* _centerZ,
+		const float* _sizeX, const float* _sizeY, const float* _sizeZ,
+		unsigned int _count, unsigned char* _visible) const;
+
+	vec4 planes[FRUSTUM_PLANE_COUNT]; //xyz = normal, w = distance
+};
+
+#endif // _FRUSTUM_H_
\ No newline at end of file
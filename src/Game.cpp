@@ -2,6 +2,13 @@
 
 // Components
 #include "MeshRenderer.h"
+#include "Animator.h"
+#include "PlaneCollider.h"
+#include "BoxCollider.h"
+#include "Rigidbody.h"
+
+// Physics
+#include "ParticleEmitter.h"
 
 // Structs
 #include "Mesh.h"
@@ -11,13 +18,29 @@
 #include "imgui.h"
 #include "Explorer.h"
 
+// Debugging
+#include "Debug.h"
+
 bool Game::Update() {
 	UpdateGUIElements();
 	UpdateHierarchy();
 	return true;
 }
+void Game::Shutdown() {
+	// Components leave the physics scene and return to their pools here,
+	// while both still exist
+	for (unsigned int i = 0; i < objects.size(); ++i) {
+		objects[i]->Shutdown();
+		delete objects[i];
+	}
+	objects.clear();
+}
 
 void Game::UpdateHierarchy() {
+	transformHierarchy.Update(objects);
+	// Scripts updated below already see this frame's renderer bounds
+	MeshRenderer::UpdateAll();
+
 	ImGui::Begin("Hierarchy");
 
 	for (unsigned int i = 0; i < objects.size(); ++i) {
@@ -29,7 +52,7 @@ void Game::UpdateHierarchy() {
 				Transform::DeselectAllTransforms();
 				objects[i]->transform.isSelected = true;
 			}
-			transform->Update();
+			if (transform->isSelected) { transform->Inspector(); }
 			gameObject->Update();
 			UpdateChildren(transform);
 		}
@@ -50,12 +73,7 @@ void Game::UpdateChildren(Transform* _transform) {
 			transform->isSelected = true;
 		}
 
-		transform->Update();
-
-		if (transform->parent) {
-			transform->worldMatrix = transform->parent->worldMatrix * transform->worldMatrix;
-		}
-
+		if (transform->isSelected) { transform->Inspector(); }
 		gameObject->Update();
 		
 		if (transform->children.size() > 0) {
@@ -72,7 +90,7 @@ void Game::UpdateGUIElements() {
 				string fileToOpen = Explorer::OpenFileDialog();
 				if (fileToOpen.size() > 0) {
 					GameObject* newMesh = new GameObject();
-					newMesh->AddComponent<MeshRenderer>(MeshRenderer(Mesh(fileToOpen, false), Material("default_texture")));
+					newMesh->AddComponent<MeshRenderer>(MeshRenderer(Mesh(fileToOpen, false, true), Material("default_texture")));
 					AddToScene(newMesh);
 				}
 			}
@@ -81,27 +99,120 @@ void Game::UpdateGUIElements() {
 		if (ImGui::BeginMenu("Create")) {
 			if (ImGui::MenuItem("Sphere")) {
 				GameObject* sphere = new GameObject("Sphere");
-				sphere->AddComponent<MeshRenderer>(MeshRenderer(Mesh("sphere.obj"), Material("default_texture")));
+				sphere->AddComponent<MeshRenderer>(MeshRenderer(Mesh("sphere.obj", true, true), Material("default_texture")));
 				AddToScene(sphere);
 				Transform::SetSelectedTransform(&sphere->transform);
 			}
 			if (ImGui::MenuItem("Plane")) {
 				GameObject* plane = new GameObject("Plane");
-				plane->AddComponent<MeshRenderer>(MeshRenderer(Mesh("plane.obj"), Material("default_texture")));
+				plane->AddComponent<MeshRenderer>(MeshRenderer(Mesh("plane.obj", true, true), Material("default_texture")));
 				AddToScene(plane);
 				Transform::SetSelectedTransform(&plane->transform);
 			}
 			if (ImGui::MenuItem("Cube")) {
 				GameObject* cube = new GameObject("Cube");
-				cube->AddComponent<MeshRenderer>(MeshRenderer(Mesh("cube.obj"), Material("default_texture")));
+				cube->AddComponent<MeshRenderer>(MeshRenderer(Mesh("cube.obj", true, true), Material("default_texture")));
 				AddToScene(cube);
 				Transform::SetSelectedTransform(&cube->transform);
 			}
 			ImGui::EndMenu();
 		}
+		if (ImGui::BeginMenu("Debug")) {
+			ImGui::MenuItem("GPU Instancing", NULL, &RenderingEngine::instancingEnabled);
+			if (ImGui::MenuItem("Instancing Stress Test (50k Cubes)")) {
+				CreateStressTest(224);
+			}
+			ImGui::MenuItem("Draw Bones", NULL, &Animator::drawBones);
+			if (ImGui::MenuItem("Animation Stress Test (500 Skeletons)...")) {
+				string fileToOpen = Explorer::OpenFileDialog();
+				if (fileToOpen.size() > 0) {
+					CreateAnimationStressTest(fileToOpen, 500);
+				}
+			}
+			if (ImGui::MenuItem("Particle Stress Test (1M Particles)")) {
+				CreateParticleStressTest(1000000);
+			}
+			if (ImGui::MenuItem("Stacking Stress Test (210 Boxes)")) {
+				CreateStackingStressTest(20);
+			}
+			ImGui::EndMenu();
+		}
 		ImGui::EndMainMenuBar();
 	}
 }
+void Game::CreateStressTest(unsigned int _gridSize) {
+	// Every cube shares one mesh and material, compare the render stats with instancing on and off
+	Mesh cubeMesh("cube.obj", true, true);
+	Material cubeMaterial("default_texture");
+	float offset = (_gridSize - 1) * 0.5f;
+	for (unsigned int x = 0; x < _gridSize; ++x) {
+		for (unsigned int z = 0; z < _gridSize; ++z) {
+			GameObject* cube = new GameObject("Cube");
+			cube->transform.position = vec3(x - offset, 0.5f, z - offset) * 2.0f;
+			cube->AddComponent<MeshRenderer>(MeshRenderer(cubeMesh, cubeMaterial));
+			AddToScene(cube);
+		}
+	}
+	Debug::Log("Created " + std::to_string(_gridSize * _gridSize) + " cubes");
+}
+void Game::CreateAnimationStressTest(const string& _fileName, unsigned int _count) {
+	// Every character shares one skinned model, each plays from its own point in the clip
+	Mesh skinnedMesh(_fileName, Shader("default-forward-lighting-animation"), false);
+	unsigned int columns = (unsigned int)ceilf(sqrtf((float)_count));
+	for (unsigned int i = 0; i < _count; ++i) {
+		GameObject* character = new GameObject("Character");
+		character->transform.position = vec3((float)(i % columns), 0.0f, (float)(i / columns)) * 2.0f;
+		character->transform.scale = vec3(0.01f);
+		character->AddComponent<MeshRenderer>(MeshRenderer(skinnedMesh));
+		Animator* animator = character->AddComponent<Animator>(Animator());
+		animator->time = (float)i * 0.137f;
+		AddToScene(character);
+	}
+	Debug::Log("Created " + std::to_string(_count) + " animated characters");
+}
+void Game::CreateParticleStressTest(unsigned int _count) {
+	// Every particle is released at once and falls onto the ground plane. The
+	// emitter's inspector shows the simulation time, Render Stats the upload time
+	GameObject* ground = new GameObject("Particle Ground");
+	ground->AddComponent<PlaneCollider>(PlaneCollider());
+	AddToScene(ground);
+
+	GameObject* emitterObject = new GameObject("Particle Emitter");
+	emitterObject->transform.position = vec3(0, 20, 0);
+	ParticleEmitter* emitter = emitterObject->AddComponent<ParticleEmitter>(ParticleEmitter(_count));
+	emitter->particleMaxAge = 30.0f;
+	emitter->restitution = 0.3f;
+	AddToScene(emitterObject);
+	emitter->Emit(_count);
+	Debug::Log("Created " + std::to_string(_count) + " particles");
+}
+void Game::CreateStackingStressTest(unsigned int _baseSize) {
+	// A pyramid of touching boxes on a static ground. It should settle and stay
+	// standing, any slow drift or collapse shows the contact solver is not converging
+	GameObject* ground = new GameObject("Stacking Ground");
+	ground->isStatic = true;
+	ground->AddComponent<Rigidbody>(Rigidbody());
+	ground->AddComponent<PlaneCollider>(PlaneCollider());
+	AddToScene(ground);
+
+	Mesh cubeMesh("cube.obj", true, true);
+	Material cubeMaterial("default_texture");
+	unsigned int count = 0;
+	for (unsigned int row = 0; row < _baseSize; ++row) {
+		unsigned int rowSize = _baseSize - row;
+		for (unsigned int i = 0; i < rowSize; ++i) {
+			GameObject* box = new GameObject("Box");
+			box->transform.position = vec3(i - (rowSize - 1) * 0.5f, row + 0.5f, 0.0f) * 2.0f;
+			box->AddComponent<MeshRenderer>(MeshRenderer(cubeMesh, cubeMaterial));
+			Rigidbody* rigidbody = box->AddComponent<Rigidbody>(Rigidbody());
+			rigidbody->useGravity = true;
+			box->AddComponent<BoxCollider>(BoxCollider());
+			AddToScene(box);
+			count++;
+		}
+	}
+	Debug::Log("Created " + std::to_string(count) + " stacked boxes");
+}
 void Game::AddToScene(GameObject* _gameObject) {
 	// Starts up all of the game object components
 	for (unsigned int i = 0; i < _gameObject->components.size(); ++i) {
@@ -19,6 +19,9 @@ with a new scene.
 // Objects
 #include "GameObject.h"
 
+// Utilities
+#include "TransformHierarchy.h"
+
 // Other
 #include <vector>
 using std::vector;
@@ -29,14 +32,20 @@ public:
 	virtual ~Game(){}
 	virtual void Init(CoreEngine* _engine) = 0;
 	virtual bool Update();
+	virtual void Shutdown();
 	void UpdateHierarchy();
 	void UpdateChildren(Transform* _transform);
 	void UpdateGUIElements();
+	void CreateStressTest(unsigned int _gridSize);
+	void CreateAnimationStressTest(const string& _fileName, unsigned int _count);
+	void CreateParticleStressTest(unsigned int _count);
+	void CreateStackingStressTest(unsigned int _baseSize);
 	virtual void Draw(RenderingEngine* _renderer) = 0;
 	void AddToScene(GameObject* _gameObject);
 
 	RenderingEngine* renderer;
 	vector<GameObject*> objects;
+	TransformHierarchy transformHierarchy;
 };
 
 #endif // _GAME_H_
\ No newline at end of file
@@ -21,12 +21,45 @@
 // Other
 using std::to_string;
 
+// Note(Manny): No initializer, so the counter is zero before any dynamic
+// initialization registers a type
+std::atomic<unsigned int> ComponentTypeCounter::typeCount;
+
+unsigned int ComponentTypeCounter::Register(IsTypeFunction _isType) {
+	unsigned int id = typeCount++;
+	vector<IsTypeFunction>& types = Types();
+	if (id >= types.size()) {
+		types.resize(id + 1, nullptr);
+	}
+	types[id] = _isType;
+	return id;
+}
+const vector<ComponentTypeCounter::IsTypeFunction>& ComponentTypeCounter::GetTypes() {
+	return Types();
+}
+vector<ComponentTypeCounter::IsTypeFunction>& ComponentTypeCounter::Types() {
+	static vector<IsTypeFunction> types;
+	return types;
+}
+
+void ComponentPoolBase::DestroyPools() {
+	vector<ComponentPoolBase*>& pools = GetPools();
+	for (unsigned int i = 0; i < pools.size(); ++i) {
+		pools[i]->DestroyAll();
+	}
+}
+vector<ComponentPoolBase*>& ComponentPoolBase::GetPools() {
+	static vector<ComponentPoolBase*> pools;
+	return pools;
+}
+
 GameObject::GameObject(string _name) {
 	if (_name == "GameObject") {
 		_name = "GameObject " + to_string(instanceID);
 	}
 	name = _name;
 	isVisible = true;
+	isStatic = false;
 	transform.gameObject = this;
 }
 bool GameObject::Startup() {
@@ -34,9 +67,11 @@ bool GameObject::Startup() {
 }
 void GameObject::Shutdown() {
 	for (unsigned int i = 0; i < components.size(); ++i) {
-		delete components[i];
+		components[i]->Shutdown();
+		components[i]->pool->Destroy(components[i]);
 	}
 	components.clear();
+	m_componentLookup.clear();
 }
 bool GameObject::Update() {
 	for (unsigned int componentIndex = 0;
@@ -56,4 +91,19 @@ void GameObject::Draw(RenderingEngine& _renderer) {
 Collider* GameObject::AddCollider(Collider* _collider) {
 	colliders.push_back(_collider);
 	return _collider;
+}
+
+// Private
+void GameObject::UpdateComponentLookup() {
+	// Every registered type is resolved, base types such as Collider included
+	const vector<ComponentTypeCounter::IsTypeFunction>& types = ComponentTypeCounter::GetTypes();
+	m_componentLookup.assign(types.size(), nullptr);
+	for (unsigned int typeId = 0; typeId < types.size(); ++typeId) {
+		for (unsigned int i = 0; i < components.size(); ++i) {
+			if (types[typeId](components[i])) {
+				m_componentLookup[typeId] = components[i];
+				break;
+			}
+		}
+	}
 }
\ No newline at end of file
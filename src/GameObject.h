@@ -22,6 +22,7 @@ of rendering within the game engine
 #include "Transform.h"
 #include "MeshRenderer.h"
 #include "Collider.h"
+#include "ComponentPool.h"
 
 // Other
 #include <iostream>
@@ -51,39 +52,40 @@ public:
 	Transform transform; 
 	bool isStatic;
 private:
+	void UpdateComponentLookup();
+
 	bool isVisible; //Is the object visible in the scene?
+	// First component of every type, indexed by ComponentType<T>::GetId()
+	vector<Component*> m_componentLookup;
 };
 template<typename T>
 T* GameObject::AddComponent(Component& _component) {
-	T* componentCheck;
 	Collider* colliderCheck = dynamic_cast<Collider*>(&_component);
-	if (colliderCheck == nullptr) {
-		for (unsigned int i = 0; i < components.size(); ++i) {
-			componentCheck = dynamic_cast<T*>(components[i]);
-			if (componentCheck != nullptr) {
-				std::cout << "Error: Cannot attach multiples of the same " <<
-					"component to the same GameObject! GameObject Name: " <<
-					this->name << std::endl;
-				return nullptr;
-			}
-		}
+	if (colliderCheck == nullptr && GetComponent<T>() != nullptr) {
+		std::cout << "Error: Cannot attach multiples of the same " <<
+			"component to the same GameObject! GameObject Name: " <<
+			this->name << std::endl;
+		return nullptr;
 	}
-	T* newComponent = new T(dynamic_cast<T&>(_component));
+	T* newComponent = ComponentPool<T>::Get().Create(dynamic_cast<T&>(_component));
 	newComponent->gameObject = this;
 	newComponent->transform = &transform;
 	newComponent->transform->gameObject = this;
 	components.push_back(newComponent);
+
+	// Any lookup, including base types, may now resolve differently
+	UpdateComponentLookup();
 	return newComponent;
 }
 template<typename T>
 T* GameObject::GetComponent() {
-	for (unsigned int i = 0; i < components.size(); ++i) {
-		T* component = dynamic_cast<T*>(components[i]);
-		if (component != nullptr) {
-			return component;
-		}
+	// Note(Manny): Only reads, the lookup is filled in when components are
+	// added so workers can call this at the same time
+	unsigned int typeId = ComponentType<T>::GetId();
+	if (typeId >= m_componentLookup.size()) {
+		return nullptr;
 	}
-	return nullptr;
+	return static_cast<T*>(m_componentLookup[typeId]);
 }
 
 #endif // _GAMEOBJECT_H_
\ No newline at end of file
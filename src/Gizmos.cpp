@@ -1,29 +1,17 @@
 #include "Gizmos.h"
 #include "gl_core_4_4.h"
+#include "JobSystem.h"
 
 #define GLM_SWIZZLE
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
+#include <algorithm>
+#include <cstring>
 
 Gizmos* Gizmos::sm_instance = nullptr;
 
-Gizmos::Gizmos(unsigned int _maxLines, 
-	unsigned int _maxTris,
-	unsigned int _max2DLines, 
-	unsigned int _max2DTris) : m_maxLines(_maxLines),
-	m_lineCount(0),
-	m_lines(new Line[_maxLines]),
-	m_maxTris(_maxTris),
-	m_triCount(0),
-	m_tris(new Tri[_maxTris]),
-	m_transparentTriCount(0),
-	m_transparentTris(new Tri[_maxTris]),
-	m_max2DLines(_max2DLines),
-	m_2DlineCount(0),
-	m_2Dlines(new Line[_max2DLines]),
-	m_max2DTris(_max2DTris),
-	m_2DtriCount(0),
-	m_2Dtris(new Tri[_max2DTris]) {
+Gizmos::Gizmos() : m_streamVBO(0),
+	m_streamData(nullptr) {
 
 	// Create shaders
 	const char* vsSource = "#version 150\n \
@@ -71,96 +59,35 @@ Gizmos::Gizmos(unsigned int _maxLines,
 	glDeleteShader(vs);
 	glDeleteShader(fs);
     
-    // create VBOs
-	glGenBuffers( 1, &m_lineVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_lineVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_maxLines * sizeof(Line), m_lines, GL_DYNAMIC_DRAW);
-
-	glGenBuffers( 1, &m_triVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_triVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_maxTris * sizeof(Tri), m_tris, GL_DYNAMIC_DRAW);
-
-	glGenBuffers( 1, &m_transparentTriVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_transparentTriVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_maxTris * sizeof(Tri), m_transparentTris, GL_DYNAMIC_DRAW);
-
-	glGenBuffers( 1, &m_2DlineVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_2DlineVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_max2DLines * sizeof(Line), m_2Dlines, GL_DYNAMIC_DRAW);
-
-	glGenBuffers( 1, &m_2DtriVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_2DtriVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_max2DTris * sizeof(Tri), m_2Dtris, GL_DYNAMIC_DRAW);
-
-	glGenVertexArrays(1, &m_lineVAO);
-	glBindVertexArray(m_lineVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_lineVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(Vertex), ((char*)0) + 16);
+	m_projectionViewUniform = glGetUniformLocation(m_shader, "ProjectionView");
 
-	glGenVertexArrays(1, &m_triVAO);
-	glBindVertexArray(m_triVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_triVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(Vertex), ((char*)0) + 16);
-
-	glGenVertexArrays(1, &m_transparentTriVAO);
-	glBindVertexArray(m_transparentTriVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_transparentTriVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(Vertex), ((char*)0) + 16);
-
-	glGenVertexArrays(1, &m_2DlineVAO);
-	glBindVertexArray(m_2DlineVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_2DlineVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(Vertex), ((char*)0) + 16);
-
-	glGenVertexArrays(1, &m_2DtriVAO);
-	glBindVertexArray(m_2DtriVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_2DtriVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(Vertex), ((char*)0) + 16);
+	// One buffer per thread that can add gizmos
+	unsigned int threadCount = JobSystem::GetThreadCount();
+	for (unsigned int i = 0; i < threadCount; ++i) {
+		m_threadBuffers.push_back(new Buffer());
+		m_layerTargets.push_back(nullptr);
+	}
 
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	// Note(Manny): The stream buffer starts small and grows to fit the busiest frame
+	CreateStreamBuffer(MIN_SECTION_SIZE);
 }
 
 Gizmos::~Gizmos() {
-	delete[] m_lines;
-	delete[] m_tris;
-	delete[] m_transparentTris;
-	glDeleteBuffers( 1, &m_lineVBO );
-	glDeleteBuffers( 1, &m_triVBO );
-	glDeleteBuffers( 1, &m_transparentTriVBO );
-	glDeleteVertexArrays( 1, &m_lineVAO );
-	glDeleteVertexArrays( 1, &m_triVAO );
-	glDeleteVertexArrays( 1, &m_transparentTriVAO );
-	delete[] m_2Dlines;
-	delete[] m_2Dtris;
-	glDeleteBuffers( 1, &m_2DlineVBO );
-	glDeleteBuffers( 1, &m_2DtriVBO );
-	glDeleteVertexArrays( 1, &m_2DlineVAO );
-	glDeleteVertexArrays( 1, &m_2DtriVAO );
+	for (unsigned int i = 0; i < m_threadBuffers.size(); ++i) {
+		delete m_threadBuffers[i];
+	}
+	for (unsigned int i = 0; i < m_layers.size(); ++i) {
+		if (m_layers[i] != nullptr) {
+			DestroyLayer(i + 1);
+		}
+	}
+	DestroyStreamBuffer();
 	glDeleteProgram(m_shader);
 }
 
-void Gizmos::Create(unsigned int _maxLines,
-	unsigned int _maxTris,
-	unsigned int _max2DLines, 
-	unsigned int _max2DTris) {
+void Gizmos::Create() {
 	if (sm_instance == nullptr) {
-		sm_instance = new Gizmos(_maxLines, _maxTris, _max2DLines, _max2DTris);
+		sm_instance = new Gizmos();
 	}
 }
 
@@ -170,11 +97,112 @@ void Gizmos::Destroy() {
 }
 
 void Gizmos::Clear() {
-	sm_instance->m_lineCount = 0;
-	sm_instance->m_triCount = 0;
-	sm_instance->m_transparentTriCount = 0;
-	sm_instance->m_2DlineCount = 0;
-	sm_instance->m_2DtriCount = 0;
+	for (unsigned int i = 0; i < sm_instance->m_threadBuffers.size(); ++i) {
+		sm_instance->m_threadBuffers[i]->Clear();
+	}
+
+	// Fence the section last frame streamed into, then move on to the oldest one
+	Gizmos& gizmos = *sm_instance;
+	if (gizmos.m_sectionOffset > 0) {
+		gizmos.m_sectionFences[gizmos.m_section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	gizmos.m_section = (gizmos.m_section + 1) % STREAM_SECTIONS;
+	gizmos.m_sectionOffset = 0;
+	__GLsync* fence = gizmos.m_sectionFences[gizmos.m_section];
+	if (fence != nullptr) {
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+		glDeleteSync(fence);
+		gizmos.m_sectionFences[gizmos.m_section] = nullptr;
+	}
+}
+
+unsigned int Gizmos::CreateLayer() {
+	Layer* layer = new Layer();
+	glGenBuffers(1, &layer->vbo);
+	layer->vao = sm_instance->CreateVertexArray(layer->vbo);
+	layer->lineCount = 0;
+	layer->triCount = 0;
+	layer->transparentTriCount = 0;
+	layer->visible = true;
+
+	// Reuse the slot of a destroyed layer if there is one
+	vector<Layer*>& layers = sm_instance->m_layers;
+	for (unsigned int i = 0; i < layers.size(); ++i) {
+		if (layers[i] == nullptr) {
+			layers[i] = layer;
+			return i + 1;
+		}
+	}
+	layers.push_back(layer);
+	return layers.size();
+}
+
+void Gizmos::DestroyLayer(unsigned int _layer) {
+	if (sm_instance == nullptr || _layer == 0 || _layer > sm_instance->m_layers.size()) {
+		return;
+	}
+	Layer*& layer = sm_instance->m_layers[_layer - 1];
+	if (layer != nullptr) {
+		glDeleteBuffers(1, &layer->vbo);
+		glDeleteVertexArrays(1, &layer->vao);
+		delete layer;
+		layer = nullptr;
+	}
+}
+
+void Gizmos::BeginLayer(unsigned int _layer) {
+	Layer* layer = sm_instance->m_layers[_layer - 1];
+	layer->buffer.Clear();
+	unsigned int thread = JobSystem::GetThreadIndex();
+	sm_instance->m_layerTargets[thread < sm_instance->m_layerTargets.size() ? thread : 0] = &layer->buffer;
+}
+
+void Gizmos::EndLayer() {
+	unsigned int thread = JobSystem::GetThreadIndex();
+	Buffer*& target = sm_instance->m_layerTargets[thread < sm_instance->m_layerTargets.size() ? thread : 0];
+	if (target == nullptr) {
+		return;
+	}
+
+	// Find the layer that owns the buffer and upload it once, lines first
+	for (unsigned int i = 0; i < sm_instance->m_layers.size(); ++i) {
+		Layer* layer = sm_instance->m_layers[i];
+		if (layer == nullptr || &layer->buffer != target) {
+			continue;
+		}
+		Buffer& buffer = layer->buffer;
+		layer->lineCount = buffer.lines.size();
+		layer->triCount = buffer.tris.size();
+		layer->transparentTriCount = buffer.transparentTris.size();
+		unsigned int lineBytes = layer->lineCount * sizeof(Line);
+		unsigned int triBytes = layer->triCount * sizeof(Tri);
+		unsigned int transparentTriBytes = layer->transparentTriCount * sizeof(Tri);
+
+		glBindBuffer(GL_ARRAY_BUFFER, layer->vbo);
+		glBufferData(GL_ARRAY_BUFFER, lineBytes + triBytes + transparentTriBytes, NULL, GL_STATIC_DRAW);
+		if (lineBytes > 0) {
+			glBufferSubData(GL_ARRAY_BUFFER, 0, lineBytes, &buffer.lines[0]);
+		}
+		if (triBytes > 0) {
+			glBufferSubData(GL_ARRAY_BUFFER, lineBytes, triBytes, &buffer.tris[0]);
+		}
+		if (transparentTriBytes > 0) {
+			glBufferSubData(GL_ARRAY_BUFFER, lineBytes + triBytes, transparentTriBytes, &buffer.transparentTris[0]);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		// The GPU has its own copy now
+		buffer.Clear();
+		buffer.lines.shrink_to_fit();
+		buffer.tris.shrink_to_fit();
+		buffer.transparentTris.shrink_to_fit();
+		break;
+	}
+	target = nullptr;
+}
+
+void Gizmos::SetLayerVisible(unsigned int _layer, bool _visible) {
+	sm_instance->m_layers[_layer - 1]->visible = _visible;
 }
 
 // Adds 3 unit-length lines (red,green,blue) representing the 3 axis of a transform, 
@@ -349,15 +377,17 @@ void Gizmos::AddCylinderFilled(const glm::vec3& _center,
 	const glm::mat4* _transform) {
 	glm::vec4 white(1,1,1,1);
 
-	float segmentSize = (2 * glm::pi<float>()) / _segments;
+	const vector<glm::vec2>& circle = GetUnitCircle(_segments);
 
 	for ( unsigned int i = 0 ; i < _segments ; ++i ) {
+		glm::vec2 v1 = circle[i] * _radius;
+		glm::vec2 v2 = circle[i + 1] * _radius;
 		glm::vec3 v0top(0,_fHalfLength,0);
-		glm::vec3 v1top( sinf( i * segmentSize ) * _radius, _fHalfLength, cosf( i * segmentSize ) * _radius);
-		glm::vec3 v2top( sinf( (i+1) * segmentSize ) * _radius, _fHalfLength, cosf( (i+1) * segmentSize ) * _radius);
+		glm::vec3 v1top(v1.x, _fHalfLength, v1.y);
+		glm::vec3 v2top(v2.x, _fHalfLength, v2.y);
 		glm::vec3 v0bottom(0,-_fHalfLength,0);
-		glm::vec3 v1bottom( sinf( i * segmentSize ) * _radius, -_fHalfLength, cosf( i * segmentSize ) * _radius);
-		glm::vec3 v2bottom( sinf( (i+1) * segmentSize ) * _radius, -_fHalfLength, cosf( (i+1) * segmentSize ) * _radius);
+		glm::vec3 v1bottom(v1.x, -_fHalfLength, v1.y);
+		glm::vec3 v2bottom(v2.x, -_fHalfLength, v2.y);
 
 		if (_transform != nullptr) {
 			v0top = (*_transform * glm::vec4(v0top, 0)).xyz();
@@ -390,13 +420,13 @@ void Gizmos::AddRing(const glm::vec3& _center,
 	glm::vec4 vSolid = _fillColour;
 	vSolid.w = 1;
 
-	float fSegmentSize = (2 * glm::pi<float>()) / _segments;
+	const vector<glm::vec2>& circle = GetUnitCircle(_segments);
 
 	for ( unsigned int i = 0 ; i < _segments ; ++i ) {
-		glm::vec3 v1outer( sinf( i * fSegmentSize ) * _outerRadius, 0, cosf( i * fSegmentSize ) * _outerRadius );
-		glm::vec3 v2outer( sinf( (i+1) * fSegmentSize ) * _outerRadius, 0, cosf( (i+1) * fSegmentSize ) * _outerRadius );
-		glm::vec3 v1inner( sinf( i * fSegmentSize ) * _innerRadius, 0, cosf( i * fSegmentSize ) * _innerRadius );
-		glm::vec3 v2inner( sinf( (i+1) * fSegmentSize ) * _innerRadius, 0, cosf( (i+1) * fSegmentSize ) * _innerRadius );
+		glm::vec3 v1outer( circle[i].x * _outerRadius, 0, circle[i].y * _outerRadius );
+		glm::vec3 v2outer( circle[i + 1].x * _outerRadius, 0, circle[i + 1].y * _outerRadius );
+		glm::vec3 v1inner( circle[i].x * _innerRadius, 0, circle[i].y * _innerRadius );
+		glm::vec3 v2inner( circle[i + 1].x * _innerRadius, 0, circle[i + 1].y * _innerRadius );
 
 		if (_transform != nullptr) {
 			v1outer = (*_transform * glm::vec4(v1outer, 0)).xyz();
@@ -413,8 +443,8 @@ void Gizmos::AddRing(const glm::vec3& _center,
 			AddTri(_center + v2outer, _center + v2inner, _center + v1inner, _fillColour);
 		} else {
 			// line
-			AddLine(_center + v1inner + _center, _center + v2inner + _center, vSolid, vSolid);
-			AddLine(_center + v1outer + _center, _center + v2outer + _center, vSolid, vSolid);
+			AddLine(_center + v1inner, _center + v2inner, vSolid, vSolid);
+			AddLine(_center + v1outer, _center + v2outer, vSolid, vSolid);
 		}
 	}
 }
@@ -427,11 +457,11 @@ void Gizmos::AddDisk(const glm::vec3& _center,
 	glm::vec4 vSolid = _fillColour;
 	vSolid.w = 1;
 
-	float fSegmentSize = (2 * glm::pi<float>()) / _segments;
+	const vector<glm::vec2>& circle = GetUnitCircle(_segments);
 
 	for ( unsigned int i = 0 ; i < _segments ; ++i ) {
-		glm::vec3 v1outer( sinf( i * fSegmentSize ) * _radius, 0, cosf( i * fSegmentSize ) * _radius );
-		glm::vec3 v2outer( sinf( (i+1) * fSegmentSize ) * _radius, 0, cosf( (i+1) * fSegmentSize ) * _radius );
+		glm::vec3 v1outer( circle[i].x * _radius, 0, circle[i].y * _radius );
+		glm::vec3 v2outer( circle[i + 1].x * _radius, 0, circle[i + 1].y * _radius );
 
 		if (_transform != nullptr) {
 			v1outer = (*_transform * glm::vec4(v1outer, 0)).xyz();
@@ -563,43 +593,9 @@ void Gizmos::AddSphereFilled(const glm::vec3& _center,
 	float _latMin, 
 	float _latMax) {
 
-	float inverseRadius = 1/_radius;
-	//Invert these first as the multiply is slightly quicker
-	float invColumns = 1.0f/float(_columns);
-	float invRows = 1.0f/float(_rows);
+	float longitudinalRange = (_longMax - _longMin) * glm::pi<float>() / 180.0f;
+	const glm::vec3* points = GetSpherePoints(_radius, _rows, _columns, _transform, _longMin, _longMax, _latMin, _latMax);
 
-	float DEG_2_RAD = glm::pi<float>() / 180.0f;
-
-	//Lets put everything in radians first
-	float latitiudinalRange = (_latMax - _latMin) * DEG_2_RAD;
-	float longitudinalRange = (_longMax - _longMin) * DEG_2_RAD;
-
-	// for each row of the mesh
-	glm::vec3* points = new glm::vec3[_rows*_columns + _columns];
-
-	for (int row = 0; row <= _rows; ++row) {
-		// y ordinates this may be a little confusing but here we are navigating around the xAxis in GL
-		float ratioAroundXAxis = float(row) * invRows;
-		float radiansAboutXAxis = ratioAroundXAxis * latitiudinalRange + (_latMin * DEG_2_RAD);
-		float y  =  _radius * sin(radiansAboutXAxis);
-		float z  =  _radius * cos(radiansAboutXAxis);
-		
-		for ( int col = 0; col <= _columns; ++col ) {
-			float ratioAroundYAxis   = float(col) * invColumns;
-			float theta = ratioAroundYAxis * longitudinalRange + (_longMin * DEG_2_RAD);
-			glm::vec3 point( -z * sinf(theta), y, -z * cosf(theta) );
-			glm::vec3 normal(inverseRadius * point.x, inverseRadius * point.y, inverseRadius * point.z);
-
-			if (_transform != nullptr) {
-				point = (*_transform * glm::vec4(point, 0)).xyz();
-				normal = (*_transform * glm::vec4(normal, 0)).xyz();
-			}
-
-			int index = row * _columns + (col % _columns);
-			points[index] = point;
-		}
-	}
-	
 	for (int face = 0; face < (_rows * _columns); ++face ) {
 		int nextFace = face + 1;		
 		
@@ -623,8 +619,6 @@ void Gizmos::AddSphereFilled(const glm::vec3& _center,
 		AddTri(v1Next, v0, v0Next, _fillColour);
 		AddTri(v1Next, v1, v0, _fillColour);
 	}
-
-	delete[] points;
 }
 
 void Gizmos::AddSphere(const glm::vec3& _center, 
@@ -639,42 +633,8 @@ void Gizmos::AddSphere(const glm::vec3& _center,
 	float _latMax) {
 
 
-	float inverseRadius = 1 / _radius;
-	//Invert these first as the multiply is slightly quicker
-	float invColumns = 1.0f / float(_columns);
-	float invRows = 1.0f / float(_rows);
-
-	float DEG_2_RAD = glm::pi<float>() / 180.0f;
-
-	//Lets put everything in radians first
-	float latitiudinalRange = (_latMax - _latMin) * DEG_2_RAD;
-	float longitudinalRange = (_longMax - _longMin) * DEG_2_RAD;
-
-	// for each row of the mesh
-	glm::vec3* points = new glm::vec3[_rows*_columns + _columns];
-
-	for (int row = 0; row <= _rows; ++row) {
-		// y ordinates this may be a little confusing but here we are navigating around the xAxis in GL
-		float ratioAroundXAxis = float(row) * invRows;
-		float radiansAboutXAxis = ratioAroundXAxis * latitiudinalRange + (_latMin * DEG_2_RAD);
-		float y = _radius * sin(radiansAboutXAxis);
-		float z = _radius * cos(radiansAboutXAxis);
-
-		for (int col = 0; col <= _columns; ++col) {
-			float ratioAroundYAxis = float(col) * invColumns;
-			float theta = ratioAroundYAxis * longitudinalRange + (_longMin * DEG_2_RAD);
-			glm::vec3 point(-z * sinf(theta), y, -z * cosf(theta));
-			glm::vec3 normal(inverseRadius * point.x, inverseRadius * point.y, inverseRadius * point.z);
-
-			if (_transform != nullptr) {
-				point = (*_transform * glm::vec4(point, 0)).xyz();
-				normal = (*_transform * glm::vec4(normal, 0)).xyz();
-			}
-
-			int index = row * _columns + (col % _columns);
-			points[index] = point;
-		}
-	}
+	float longitudinalRange = (_longMax - _longMin) * glm::pi<float>() / 180.0f;
+	const glm::vec3* points = GetSpherePoints(_radius, _rows, _columns, _transform, _longMin, _longMax, _latMin, _latMax);
 
 	for (int face = 0; face < (_rows * _columns); ++face) {
 		int nextFace = face + 1;
@@ -697,8 +657,6 @@ void Gizmos::AddSphere(const glm::vec3& _center,
 		}
 
 	}
-
-    delete[] points;
 }
 void Gizmos::AddHermiteSpline(const glm::vec3& _start, 
 	const glm::vec3& _end,
@@ -736,29 +694,12 @@ void Gizmos::AddLine(const glm::vec3& _rv0,
 	const glm::vec3& _rv1,
 	const glm::vec4& _colour0, 
 	const glm::vec4& _colour1) {
-	if (sm_instance != nullptr && sm_instance->m_lineCount < sm_instance->m_maxLines) {
-		Line& currentLine = sm_instance->m_lines[sm_instance->m_lineCount];
-		// v0
-		currentLine.v0.x = _rv0.x;
-		currentLine.v0.y = _rv0.y;
-		currentLine.v0.z = _rv0.z;
-		currentLine.v0.w = 1;
-		currentLine.v0.r = _colour0.r;
-		currentLine.v0.g = _colour0.g;
-		currentLine.v0.b = _colour0.b;
-		currentLine.v0.a = _colour0.a;
-
-		// v1
-		currentLine.v1.x = _rv1.x;
-		currentLine.v1.y = _rv1.y;
-		currentLine.v1.z = _rv1.z;
-		currentLine.v1.w = 1;
-		currentLine.v1.r = _colour1.r;
-		currentLine.v1.g = _colour1.g;
-		currentLine.v1.b = _colour1.b;
-		currentLine.v1.a = _colour1.a;
-
-		sm_instance->m_lineCount++;
+	if (sm_instance != nullptr) {
+		Buffer& buffer = GetBuffer();
+		buffer.lines.push_back(Line());
+		Line& currentLine = buffer.lines.back();
+		SetVertex(currentLine.v0, _rv0, _colour0);
+		SetVertex(currentLine.v1, _rv1, _colour1);
 	}
 }
 
@@ -767,69 +708,13 @@ void Gizmos::AddTri(const glm::vec3& _rv0,
 	const glm::vec3& _rv2, 
 	const glm::vec4& _colour) {
 	if (sm_instance != nullptr) {
-		if (_colour.w == 1) {
-			if (sm_instance->m_triCount < sm_instance->m_maxTris) {
-				Tri& currentTri = sm_instance->m_tris[sm_instance->m_triCount];
-				currentTri.v0.x = _rv0.x;
-				currentTri.v0.y = _rv0.y;
-				currentTri.v0.z = _rv0.z;
-				currentTri.v0.w = 1;
-				currentTri.v1.x = _rv1.x;
-				currentTri.v1.y = _rv1.y;
-				currentTri.v1.z = _rv1.z;
-				currentTri.v1.w = 1;
-				currentTri.v2.x = _rv2.x;
-				currentTri.v2.y = _rv2.y;
-				currentTri.v2.z = _rv2.z;
-				currentTri.v2.w = 1;
-
-				currentTri.v0.r = _colour.r;
-				currentTri.v0.g = _colour.g;
-				currentTri.v0.b = _colour.b;
-				currentTri.v0.w = _colour.a;
-				currentTri.v1.r = _colour.r;
-				currentTri.v1.g = _colour.g;
-				currentTri.v1.b = _colour.b;
-				currentTri.v1.w = _colour.a;
-				currentTri.v2.r = _colour.r;
-				currentTri.v2.g = _colour.g;
-				currentTri.v2.b = _colour.b;
-				currentTri.v2.w = _colour.a;
-
-				sm_instance->m_triCount++;
-			}
-		} else {
-			if (sm_instance->m_transparentTriCount < sm_instance->m_maxTris) {
-				Tri& currentTri = sm_instance->m_transparentTris[sm_instance->m_transparentTriCount];
-				currentTri.v0.x = _rv0.x;
-				currentTri.v0.y = _rv0.y;
-				currentTri.v0.z = _rv0.z;
-				currentTri.v0.w = 1;
-				currentTri.v1.x = _rv1.x;
-				currentTri.v1.y = _rv1.y;
-				currentTri.v1.z = _rv1.z;
-				currentTri.v1.w = 1;
-				currentTri.v2.x = _rv2.x;
-				currentTri.v2.y = _rv2.y;
-				currentTri.v2.z = _rv2.z;
-				currentTri.v2.w = 1;
-
-				currentTri.v0.r = _colour.r;
-				currentTri.v0.g = _colour.g;
-				currentTri.v0.b = _colour.b;
-				currentTri.v0.w = _colour.a;
-				currentTri.v1.r = _colour.r;
-				currentTri.v1.g = _colour.g;
-				currentTri.v1.b = _colour.b;
-				currentTri.v1.w = _colour.a;
-				currentTri.v2.r = _colour.r;
-				currentTri.v2.g = _colour.g;
-				currentTri.v2.b = _colour.b;
-				currentTri.v2.w = _colour.a;
-
-				sm_instance->m_transparentTriCount++;
-			}
-		}
+		Buffer& buffer = GetBuffer();
+		vector<Tri>& tris = _colour.w == 1 ? buffer.tris : buffer.transparentTris;
+		tris.push_back(Tri());
+		Tri& currentTri = tris.back();
+		SetVertex(currentTri.v0, _rv0, _colour);
+		SetVertex(currentTri.v1, _rv1, _colour);
+		SetVertex(currentTri.v2, _rv2, _colour);
 	}
 }
 
@@ -889,11 +774,11 @@ void Gizmos::Add2DCircle(const glm::vec2& _center,
 	glm::vec4 solidColour = _colour;
 	solidColour.w = 1;
 
-	float segmentSize = (2 * glm::pi<float>()) / _segments;
+	const vector<glm::vec2>& circle = GetUnitCircle(_segments);
 
 	for ( unsigned int i = 0 ; i < _segments ; ++i ) {
-		glm::vec2 v1outer( sinf( i * segmentSize ) * _radius, cosf( i * segmentSize ) * _radius );
-		glm::vec2 v2outer( sinf( (i+1) * segmentSize ) * _radius, cosf( (i+1) * segmentSize ) * _radius );
+		glm::vec2 v1outer = circle[i] * _radius;
+		glm::vec2 v2outer = circle[i + 1] * _radius;
 
 		if (_transform != nullptr) {
 			v1outer = (*_transform * glm::vec4(v1outer,0,0)).xy();
@@ -920,25 +805,12 @@ void Gizmos::Add2DLine(const glm::vec2& _rv0,
 	const glm::vec2& _rv1, 
 	const glm::vec4& _colour0, 
 	const glm::vec4& _colour1) {
-	if (sm_instance != nullptr && sm_instance->m_2DlineCount < sm_instance->m_max2DLines) {
-		Line& currentLine = sm_instance->m_2Dlines[sm_instance->m_2DlineCount];
-		currentLine.v0.x = _rv0.x;
-		currentLine.v0.y = _rv0.y;
-		currentLine.v0.z = 1;
-		currentLine.v0.w = 1;
-		currentLine.v0.r = _colour0.r;
-		currentLine.v0.g = _colour0.g;
-		currentLine.v0.b = _colour0.b;
-		currentLine.v0.a = _colour0.a;
-		currentLine.v1.x = _rv1.x;
-		currentLine.v1.y = _rv1.y;
-		currentLine.v1.z = 1;
-		currentLine.v1.w = 1;
-		currentLine.v1.r = _colour1.r;
-		currentLine.v1.g = _colour1.g;
-		currentLine.v1.b = _colour1.b;
-		currentLine.v1.a = _colour1.a;
-		sm_instance->m_2DlineCount++;
+	if (sm_instance != nullptr) {
+		Buffer& buffer = GetBuffer();
+		buffer.lines2D.push_back(Line());
+		Line& currentLine = buffer.lines2D.back();
+		SetVertex(currentLine.v0, glm::vec3(_rv0, 1), _colour0);
+		SetVertex(currentLine.v1, glm::vec3(_rv1, 1), _colour1);
 	}
 }
 
@@ -947,35 +819,12 @@ void Gizmos::Add2DTri(const glm::vec2& _rv0,
 	const glm::vec2& _rv2, 
 	const glm::vec4& _colour) {
 	if (sm_instance != nullptr) {
-		if (sm_instance->m_2DtriCount < sm_instance->m_max2DTris) {
-			Tri& currentTri = sm_instance->m_2Dtris[sm_instance->m_2DtriCount];
-			currentTri.v0.x = _rv0.x;
-			currentTri.v0.y = _rv0.y;
-			currentTri.v0.z = 1;
-			currentTri.v0.w = 1;
-			currentTri.v1.x = _rv1.x;
-			currentTri.v1.y = _rv1.y;
-			currentTri.v1.z = 1;
-			currentTri.v1.w = 1;
-			currentTri.v2.x = _rv2.x;
-			currentTri.v2.y = _rv2.y;
-			currentTri.v2.z = 1;
-			currentTri.v2.w = 1;
-			currentTri.v0.r = _colour.r;
-			currentTri.v0.g = _colour.g;
-			currentTri.v0.b = _colour.b;
-			currentTri.v0.a = _colour.a;
-			currentTri.v1.r = _colour.r;
-			currentTri.v1.g = _colour.g;
-			currentTri.v1.b = _colour.b;
-			currentTri.v1.a = _colour.a;
-			currentTri.v2.r = _colour.r;
-			currentTri.v2.g = _colour.g;
-			currentTri.v2.b = _colour.b;
-			currentTri.v2.a = _colour.a;
-
-			sm_instance->m_2DtriCount++;
-		}
+		Buffer& buffer = GetBuffer();
+		buffer.tris2D.push_back(Tri());
+		Tri& currentTri = buffer.tris2D.back();
+		SetVertex(currentTri.v0, glm::vec3(_rv0, 1), _colour);
+		SetVertex(currentTri.v1, glm::vec3(_rv1, 1), _colour);
+		SetVertex(currentTri.v2, glm::vec3(_rv2, 1), _colour);
 	}
 }
 
@@ -985,116 +834,348 @@ void Gizmos::Draw(const glm::mat4& _projection,
 }
 
 void Gizmos::Draw(const glm::mat4& _projectionView) {
-	if (sm_instance != nullptr && (sm_instance->m_lineCount > 0 || sm_instance->m_triCount > 0 || sm_instance->m_transparentTriCount > 0)) {
-		int shader = 0;
-		glGetIntegerv(GL_CURRENT_PROGRAM, &shader);
-
-		glUseProgram(sm_instance->m_shader);
-
-		unsigned int projectionViewUniform = glGetUniformLocation(sm_instance->m_shader, "ProjectionView");
-		glUniformMatrix4fv(projectionViewUniform, 1, false, glm::value_ptr(_projectionView));
+	if (sm_instance == nullptr) {
+		return;
+	}
+	Gizmos& gizmos = *sm_instance;
 
-		if (sm_instance->m_lineCount > 0) {
-			glBindBuffer(GL_ARRAY_BUFFER, sm_instance->m_lineVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_instance->m_lineCount * sizeof(Line), sm_instance->m_lines);
+	int shader = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &shader);
+	glUseProgram(gizmos.m_shader);
+	glUniformMatrix4fv(gizmos.m_projectionViewUniform, 1, false, glm::value_ptr(_projectionView));
 
-			glBindVertexArray(sm_instance->m_lineVAO);
-			glDrawArrays(GL_LINES, 0, sm_instance->m_lineCount * 2);
+	// Retained layers are already on the GPU
+	for (unsigned int i = 0; i < gizmos.m_layers.size(); ++i) {
+		Layer* layer = gizmos.m_layers[i];
+		if (layer == nullptr || !layer->visible) {
+			continue;
 		}
+		glBindVertexArray(layer->vao);
+		if (layer->lineCount > 0) {
+			glDrawArrays(GL_LINES, 0, layer->lineCount * 2);
+		}
+		unsigned int triStart = layer->lineCount * 2;
+		gizmos.DrawTriangles(layer->vao, triStart, layer->triCount * 3, false);
+		gizmos.DrawTriangles(layer->vao, triStart + layer->triCount * 3, layer->transparentTriCount * 3, true);
+	}
 
-		if (sm_instance->m_triCount > 0) {
-			glBindBuffer(GL_ARRAY_BUFFER, sm_instance->m_triVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_instance->m_triCount * sizeof(Tri), sm_instance->m_tris);
-
-			glBindVertexArray(sm_instance->m_triVAO);
-			glDrawArrays(GL_TRIANGLES, 0, sm_instance->m_triCount * 3);
+	// Immediate gizmos are streamed in, only the used range is written
+	unsigned int lineCount = 0;
+	unsigned int triCount = 0;
+	unsigned int transparentTriCount = 0;
+	for (unsigned int i = 0; i < gizmos.m_threadBuffers.size(); ++i) {
+		lineCount += gizmos.m_threadBuffers[i]->lines.size();
+		triCount += gizmos.m_threadBuffers[i]->tris.size();
+		transparentTriCount += gizmos.m_threadBuffers[i]->transparentTris.size();
+	}
+	unsigned int vertexCount = lineCount * 2 + triCount * 3 + transparentTriCount * 3;
+
+	if (vertexCount > 0) {
+		unsigned int firstVertex = 0;
+		Vertex* vertices = gizmos.Allocate(vertexCount, firstVertex);
+		gizmos.Gather(&Buffer::lines, lineCount, vertices);
+		gizmos.Gather(&Buffer::tris, triCount, vertices);
+		gizmos.Gather(&Buffer::transparentTris, transparentTriCount, vertices);
+		gizmos.Commit();
+
+		glBindVertexArray(gizmos.m_streamVAO);
+		if (lineCount > 0) {
+			glDrawArrays(GL_LINES, firstVertex, lineCount * 2);
 		}
+		unsigned int triStart = firstVertex + lineCount * 2;
+		gizmos.DrawTriangles(gizmos.m_streamVAO, triStart, triCount * 3, false);
+		gizmos.DrawTriangles(gizmos.m_streamVAO, triStart + triCount * 3, transparentTriCount * 3, true);
+	}
 
-		if (sm_instance->m_transparentTriCount > 0) {
-			// not ideal to store these, but Gizmos must work stand-alone
-			GLboolean blendEnabled = glIsEnabled(GL_BLEND);
-			GLboolean depthMask = GL_TRUE;
-			glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
-			int src, dst;
-			glGetIntegerv(GL_BLEND_SRC, &src);
-			glGetIntegerv(GL_BLEND_DST, &dst);
-
-			// Setup blend states
-			if (blendEnabled == GL_FALSE) {
-				glEnable(GL_BLEND);
-			}
+	glBindVertexArray(0);
+	glUseProgram(shader);
+}
 
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-			glDepthMask(GL_FALSE);
+void Gizmos::Draw2D(const glm::mat4& _projection) {
+	if (sm_instance == nullptr) {
+		return;
+	}
+	Gizmos& gizmos = *sm_instance;
 
-			glBindBuffer(GL_ARRAY_BUFFER, sm_instance->m_transparentTriVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_instance->m_transparentTriCount * sizeof(Tri), sm_instance->m_transparentTris);
+	unsigned int lineCount = 0;
+	unsigned int triCount = 0;
+	for (unsigned int i = 0; i < gizmos.m_threadBuffers.size(); ++i) {
+		lineCount += gizmos.m_threadBuffers[i]->lines2D.size();
+		triCount += gizmos.m_threadBuffers[i]->tris2D.size();
+	}
+	unsigned int vertexCount = lineCount * 2 + triCount * 3;
+	if (vertexCount == 0) {
+		return;
+	}
 
-			glBindVertexArray(sm_instance->m_transparentTriVAO);
-			glDrawArrays(GL_TRIANGLES, 0, sm_instance->m_transparentTriCount * 3);
+	int shader = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &shader);
+	glUseProgram(gizmos.m_shader);
+	glUniformMatrix4fv(gizmos.m_projectionViewUniform, 1, false, glm::value_ptr(_projection));
 
-			// Reset state
-			glDepthMask(depthMask);
-			glBlendFunc(src, dst);
-			if (blendEnabled == GL_FALSE) {
-				glDisable(GL_BLEND);
-			}
-		}
+	unsigned int firstVertex = 0;
+	Vertex* vertices = gizmos.Allocate(vertexCount, firstVertex);
+	gizmos.Gather(&Buffer::lines2D, lineCount, vertices);
+	gizmos.Gather(&Buffer::tris2D, triCount, vertices);
+	gizmos.Commit();
 
-		glUseProgram(shader);
+	glBindVertexArray(gizmos.m_streamVAO);
+	if (lineCount > 0) {
+		glDrawArrays(GL_LINES, firstVertex, lineCount * 2);
 	}
+	gizmos.DrawTriangles(gizmos.m_streamVAO, firstVertex + lineCount * 2, triCount * 3, true);
+
+	glBindVertexArray(0);
+	glUseProgram(shader);
 }
 
-void Gizmos::Draw2D(const glm::mat4& _projection) {
-	if (sm_instance != nullptr && (sm_instance->m_2DlineCount > 0 || sm_instance->m_2DtriCount > 0)) {
-		int shader = 0;
-		glGetIntegerv(GL_CURRENT_PROGRAM, &shader);
-		glUseProgram(sm_instance->m_shader);
+// Private
+void Gizmos::Buffer::Clear() {
+	lines.clear();
+	tris.clear();
+	transparentTris.clear();
+	lines2D.clear();
+	tris2D.clear();
+}
 
-		unsigned int projectionViewUniform = glGetUniformLocation(sm_instance->m_shader, "ProjectionView");
-		glUniformMatrix4fv(projectionViewUniform, 1, false, glm::value_ptr(_projection));
+Gizmos::Buffer& Gizmos::GetBuffer() {
+	// Note(Manny): Threads the job system doesn't know about share the main thread's buffer
+	unsigned int thread = JobSystem::GetThreadIndex();
+	if (thread >= sm_instance->m_threadBuffers.size()) {
+		thread = 0;
+	}
+	Buffer* layer = sm_instance->m_layerTargets[thread];
+	return layer != nullptr ? *layer : *sm_instance->m_threadBuffers[thread];
+}
 
-		if (sm_instance->m_2DlineCount > 0) {
-			glBindBuffer(GL_ARRAY_BUFFER, sm_instance->m_2DlineVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_instance->m_2DlineCount * sizeof(Line), sm_instance->m_2Dlines);
+void Gizmos::SetVertex(Vertex& _vertex, const glm::vec3& _position, const glm::vec4& _colour) {
+	_vertex.x = _position.x;
+	_vertex.y = _position.y;
+	_vertex.z = _position.z;
+	_vertex.w = 1;
+	_vertex.r = _colour.r;
+	_vertex.g = _colour.g;
+	_vertex.b = _colour.b;
+	_vertex.a = _colour.a;
+}
 
-			glBindVertexArray(sm_instance->m_2DlineVAO);
-			glDrawArrays(GL_LINES, 0, sm_instance->m_2DlineCount * 2);
+const vector<glm::vec2>& Gizmos::GetUnitCircle(unsigned int _segments) {
+	// Tables never move once built, so only the lookup is locked
+	std::lock_guard<std::mutex> lock(sm_instance->m_tableMutex);
+	vector<glm::vec2>& table = sm_instance->m_circleTables[_segments];
+	if (table.empty()) {
+		// (sin, cos) of every segment edge, the last one closes the circle
+		float segmentSize = (2 * glm::pi<float>()) / _segments;
+		table.resize(_segments + 1);
+		for (unsigned int i = 0; i <= _segments; ++i) {
+			table[i] = glm::vec2(sinf(i * segmentSize), cosf(i * segmentSize));
 		}
+	}
+	return table;
+}
 
-		if (sm_instance->m_2DtriCount > 0) {
-			GLboolean blendEnabled = glIsEnabled(GL_BLEND);
+const vector<glm::vec3>& Gizmos::GetUnitSphere(int _rows, int _columns) {
+	std::lock_guard<std::mutex> lock(sm_instance->m_tableMutex);
+	vector<glm::vec3>& table = sm_instance->m_sphereTables[pair<int, int>(_rows, _columns)];
+	if (table.empty()) {
+		// Laid out like the points of AddSphere, a full sphere of radius one
+		float invColumns = 1.0f / float(_columns);
+		float invRows = 1.0f / float(_rows);
+		float latitudinalRange = glm::pi<float>();
+		float longitudinalRange = 2 * glm::pi<float>();
+		table.resize(_rows * _columns + _columns);
+		for (int row = 0; row <= _rows; ++row) {
+			float radiansAboutXAxis = float(row) * invRows * latitudinalRange - glm::half_pi<float>();
+			float y = sinf(radiansAboutXAxis);
+			float z = cosf(radiansAboutXAxis);
+			for (int col = 0; col < _columns; ++col) {
+				float theta = float(col) * invColumns * longitudinalRange;
+				table[row * _columns + col] = glm::vec3(-z * sinf(theta), y, -z * cosf(theta));
+			}
+		}
+	}
+	return table;
+}
 
-			GLboolean depthMask = GL_TRUE;
-			glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+const glm::vec3* Gizmos::GetSpherePoints(float _radius, 
+	int _rows, 
+	int _columns, 
+	const glm::mat4* _transform,
+	float _longMin, 
+	float _longMax, 
+	float _latMin, 
+	float _latMax) {
+	vector<glm::vec3>& points = GetBuffer().points;
+	points.resize(_rows * _columns + _columns);
+
+	if (_longMin == 0 && _longMax == 360 && _latMin == -90 && _latMax == 90) {
+		// Full spheres scale the cached unit sphere instead of calling sin and cos again
+		const vector<glm::vec3>& unitSphere = GetUnitSphere(_rows, _columns);
+		for (unsigned int i = 0; i < points.size(); ++i) {
+			points[i] = unitSphere[i] * _radius;
+		}
+	} else {
+		//Invert these first as the multiply is slightly quicker
+		float invColumns = 1.0f / float(_columns);
+		float invRows = 1.0f / float(_rows);
+
+		float DEG_2_RAD = glm::pi<float>() / 180.0f;
+
+		//Lets put everything in radians first
+		float latitiudinalRange = (_latMax - _latMin) * DEG_2_RAD;
+		float longitudinalRange = (_longMax - _longMin) * DEG_2_RAD;
+
+		for (int row = 0; row <= _rows; ++row) {
+			float ratioAroundXAxis = float(row) * invRows;
+			float radiansAboutXAxis = ratioAroundXAxis * latitiudinalRange + (_latMin * DEG_2_RAD);
+			float y = _radius * sin(radiansAboutXAxis);
+			float z = _radius * cos(radiansAboutXAxis);
+
+			for (int col = 0; col <= _columns; ++col) {
+				float ratioAroundYAxis = float(col) * invColumns;
+				float theta = ratioAroundYAxis * longitudinalRange + (_longMin * DEG_2_RAD);
+				points[row * _columns + (col % _columns)] = glm::vec3(-z * sinf(theta), y, -z * cosf(theta));
+			}
+		}
+	}
 
-			int src, dst;
-			glGetIntegerv(GL_BLEND_SRC, &src);
-			glGetIntegerv(GL_BLEND_DST, &dst);
+	if (_transform != nullptr) {
+		for (unsigned int i = 0; i < points.size(); ++i) {
+			points[i] = (*_transform * glm::vec4(points[i], 0)).xyz();
+		}
+	}
+	return &points[0];
+}
 
-			if (blendEnabled == GL_FALSE) {
-				glEnable(GL_BLEND);
-			}
+unsigned int Gizmos::CreateVertexArray(unsigned int _vbo) {
+	unsigned int vao = 0;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_TRUE, sizeof(Vertex), ((char*)0) + 16);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return vao;
+}
 
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+template<typename T>
+unsigned int Gizmos::Gather(vector<T> Buffer::* _member, unsigned int _max, Vertex*& _destination) {
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < m_threadBuffers.size() && count < _max; ++i) {
+		const vector<T>& source = m_threadBuffers[i]->*_member;
+		unsigned int copyCount = std::min((unsigned int)source.size(), _max - count);
+		if (copyCount > 0) {
+			memcpy(_destination, &source[0], copyCount * sizeof(T));
+			_destination += copyCount * (sizeof(T) / sizeof(Vertex));
+			count += copyCount;
+		}
+	}
+	return count;
+}
 
-			glDepthMask(GL_FALSE);
+Gizmos::Vertex* Gizmos::Allocate(unsigned int _vertexCount, unsigned int& _firstVertex) {
+	if (m_sectionOffset + _vertexCount > m_sectionSize) {
+		// Note(Manny): The old buffer stays alive until the GPU is done with it
+		unsigned int sectionSize = m_sectionSize;
+		while (sectionSize < m_sectionOffset + _vertexCount) {
+			sectionSize *= 2;
+		}
+		DestroyStreamBuffer();
+		CreateStreamBuffer(sectionSize);
+	}
 
-			glBindBuffer(GL_ARRAY_BUFFER, sm_instance->m_2DtriVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_instance->m_2DtriCount * sizeof(Tri), sm_instance->m_2Dtris);
+	_firstVertex = m_section * m_sectionSize + m_sectionOffset;
+	m_sectionOffset += _vertexCount;
+	if (m_streamData != nullptr) {
+		return m_streamData + _firstVertex;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, m_streamVBO);
+	return (Vertex*)glMapBufferRange(GL_ARRAY_BUFFER, _firstVertex * sizeof(Vertex), _vertexCount * sizeof(Vertex),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
 
-			glBindVertexArray(sm_instance->m_2DtriVAO);
-			glDrawArrays(GL_TRIANGLES, 0, sm_instance->m_2DtriCount * 3);
+void Gizmos::Commit() {
+	// Coherent persistent mappings are visible to the GPU as they are written
+	if (m_streamData == nullptr) {
+		glBindBuffer(GL_ARRAY_BUFFER, m_streamVBO);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-			glDepthMask(depthMask);
+void Gizmos::CreateStreamBuffer(unsigned int _sectionSize) {
+	m_sectionSize = _sectionSize;
+	m_section = 0;
+	m_sectionOffset = 0;
+	for (unsigned int i = 0; i < STREAM_SECTIONS; ++i) {
+		m_sectionFences[i] = nullptr;
+	}
 
-			glBlendFunc(src, dst);
+	unsigned int size = m_sectionSize * STREAM_SECTIONS * sizeof(Vertex);
+	glGenBuffers(1, &m_streamVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_streamVBO);
+	if (glBufferStorage != nullptr) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+		m_streamData = (Vertex*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+	} else {
+		glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+		m_streamData = nullptr;
+	}
+	m_streamVAO = CreateVertexArray(m_streamVBO);
+}
 
-			if (blendEnabled == GL_FALSE) {
-				glDisable(GL_BLEND);
-			}
+void Gizmos::DestroyStreamBuffer() {
+	for (unsigned int i = 0; i < STREAM_SECTIONS; ++i) {
+		if (m_sectionFences[i] != nullptr) {
+			glDeleteSync(m_sectionFences[i]);
 		}
+	}
+	if (m_streamData != nullptr) {
+		glBindBuffer(GL_ARRAY_BUFFER, m_streamVBO);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_streamData = nullptr;
+	}
+	glDeleteBuffers(1, &m_streamVBO);
+	glDeleteVertexArrays(1, &m_streamVAO);
+}
+
+void Gizmos::DrawTriangles(unsigned int _vao, unsigned int _first, unsigned int _count, bool _transparent) {
+	if (_count == 0) {
+		return;
+	}
+	glBindVertexArray(_vao);
+	if (!_transparent) {
+		glDrawArrays(GL_TRIANGLES, _first, _count);
+		return;
+	}
+
+	// not ideal to store these, but Gizmos must work stand-alone
+	GLboolean blendEnabled = glIsEnabled(GL_BLEND);
+	GLboolean depthMask = GL_TRUE;
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+	int src, dst;
+	glGetIntegerv(GL_BLEND_SRC, &src);
+	glGetIntegerv(GL_BLEND_DST, &dst);
+
+	// Setup blend states
+	if (blendEnabled == GL_FALSE) {
+		glEnable(GL_BLEND);
+	}
+
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+
+	glDrawArrays(GL_TRIANGLES, _first, _count);
 
-		glUseProgram(shader);
+	// Reset state
+	glDepthMask(depthMask);
+	glBlendFunc(src, dst);
+	if (blendEnabled == GL_FALSE) {
+		glDisable(GL_BLEND);
 	}
 }
\ No newline at end of file
@@ -13,18 +13,36 @@ Copyright (c) 2015 Emmanuel Vaccaro
 
 #include <glm/fwd.hpp>
 
+// Other
+#include <vector>
+using std::vector;
+#include <map>
+using std::map;
+using std::pair;
+#include <mutex>
+
+// Forward declaration
+struct __GLsync;
+
 class Gizmos {
 public:
 
-	static void	Create(unsigned int _maxLines = 0xffff, 
-		unsigned int _maxTris = 0xffff,
-		unsigned int _max2DLines = 0xff, 
-		unsigned int _max2DTris = 0xff);
+	// Nothing is ever dropped, the stream buffer grows to fit the busiest frame
+	static void	Create();
 	static void	Destroy();
 
-	// Removes all Gizmos
+	// Removes all immediate Gizmos, retained layers are kept
 	static void	Clear();
 
+	// Retained layers record Gizmos once and redraw them every frame without
+	// building or uploading them again. Create and destroy layers on the main thread.
+	static unsigned int CreateLayer();
+	static void DestroyLayer(unsigned int _layer);
+	// Gizmos added on this thread between Begin and End replace the layer's contents
+	static void BeginLayer(unsigned int _layer);
+	static void EndLayer();
+	static void SetLayerVisible(unsigned int _layer, bool _visible);
+
 	// Draws current Gizmo buffers, either using a combined (projection * view) matrix, or separate matrices
 	static void	Draw(const glm::mat4& _projectionView);
 	static void	Draw(const glm::mat4& _projection, const glm::mat4& _view);
@@ -105,8 +123,7 @@ public:
 
 private:
 
-	Gizmos(unsigned int _maxLines, unsigned int _maxTris,
-		unsigned int _max2DLines, unsigned int _max2DTris);
+	Gizmos();
 	~Gizmos();
 
 	struct Vertex {
@@ -125,42 +142,74 @@ private:
 		Vertex v2;
 	};
 
+	// Gizmos added by one thread, or recorded into one layer
+	struct Buffer {
+		vector<Line> lines;
+		vector<Tri> tris;
+		vector<Tri> transparentTris;
+		vector<Line> lines2D;
+		vector<Tri> tris2D;
+		vector<glm::vec3> points; //Scratch space for shapes built from a table
+		void Clear();
+	};
+
+	struct Layer {
+		Buffer buffer;
+		unsigned int vao;
+		unsigned int vbo;
+		unsigned int lineCount;
+		unsigned int triCount;
+		unsigned int transparentTriCount;
+		bool visible;
+	};
+
+	// Each thread adds to its own buffer, so workers never wait on each other
+	static Buffer& GetBuffer();
+	static void SetVertex(Vertex& _vertex, const glm::vec3& _position, const glm::vec4& _colour);
+	static const vector<glm::vec2>& GetUnitCircle(unsigned int _segments);
+	static const vector<glm::vec3>& GetUnitSphere(int _rows, int _columns);
+	// Points of a sphere relative to its center, in the calling thread's scratch space
+	static const glm::vec3* GetSpherePoints(float _radius, int _rows, int _columns, const glm::mat4* _transform,
+		float _longMin, float _longMax, float _latMin, float _latMax);
+	unsigned int CreateVertexArray(unsigned int _vbo);
+	// Copies every thread's gizmos of one kind into the stream buffer, returns how many were copied
+	template<typename T>
+	unsigned int Gather(vector<T> Buffer::* _member, unsigned int _max, Vertex*& _destination);
+	Vertex* Allocate(unsigned int _vertexCount, unsigned int& _firstVertex);
+	void Commit();
+	void CreateStreamBuffer(unsigned int _sectionSize);
+	void DestroyStreamBuffer();
+	void DrawTriangles(unsigned int _vao, unsigned int _first, unsigned int _count, bool _transparent);
+
+	// Streamed vertices go into one of several sections of a persistently
+	// mapped buffer. A section is only reused once the GPU has finished with it.
+	static const unsigned int STREAM_SECTIONS = 3;
+	static const unsigned int MIN_SECTION_SIZE = 0x10000; //Vertices
+
 	// Shader
 	unsigned int m_shader;
-
-	// Line data
-	unsigned int m_maxLines;
-	unsigned int m_lineCount;
-	unsigned int m_lineVAO;
-	unsigned int m_lineVBO;
-	Line* m_lines;
-
-	// Triangle data
-	unsigned int m_maxTris;
-	unsigned int m_triCount;
-	unsigned int m_triVAO;
-	unsigned int m_triVBO;
-	Tri* m_tris;
-
-	// Transparent triangle data
-	unsigned int m_transparentTriCount;
-	unsigned int m_transparentTriVAO;
-	unsigned int m_transparentTriVBO;
-	Tri* m_transparentTris;
-
-	// 2D line data
-	unsigned int m_max2DLines;
-	unsigned int m_2DlineCount;
-	unsigned int m_2DlineVAO;
-	unsigned int m_2DlineVBO;
-	Line* m_2Dlines;
-
-	// 2D triangle data
-	unsigned int m_max2DTris;
-	unsigned int m_2DtriCount;
-	unsigned int m_2DtriVAO;
-	unsigned int m_2DtriVBO;
-	Tri* m_2Dtris;
+	int m_projectionViewUniform;
+
+	// Immediate gizmos, indexed by job system thread
+	vector<Buffer*> m_threadBuffers;
+	vector<Buffer*> m_layerTargets; //Layer each thread is recording, if any
+
+	// Retained gizmos, layer handles are indices plus one
+	vector<Layer*> m_layers;
+
+	// Stream buffer
+	unsigned int m_streamVAO;
+	unsigned int m_streamVBO;
+	Vertex* m_streamData; //Persistent mapping, null if the driver lacks buffer storage
+	unsigned int m_sectionSize; //Vertices
+	unsigned int m_section;
+	unsigned int m_sectionOffset; //Vertices used in the current section
+	__GLsync* m_sectionFences[STREAM_SECTIONS];
+
+	// Unit shapes, built the first time a segment count is used
+	map<unsigned int, vector<glm::vec2>> m_circleTables;
+	map<pair<int, int>, vector<glm::vec3>> m_sphereTables;
+	std::mutex m_tableMutex;
 
 	// Singleton instance
 	static Gizmos* sm_instance;
@@ -0,0 +1,109 @@
+#include "IslandBuilder.h"
+
+// Other
+#include <cfloat>
+
+static const unsigned int NO_ISLAND = 0xFFFFFFFF;
+
+IslandBuilder::IslandBuilder() :
+	linearSleepTolerance(0.05f),
+	angularSleepTolerance(0.05f),
+	timeToSleep(0.5f) {}
+
+// Public
+void IslandBuilder::Build(const vector<SolverBody>& _bodies, const vector<ContactConstraint>& _constraints) {
+	m_parents.resize(_bodies.size());
+	for (unsigned int i = 0; i < _bodies.size(); ++i) {
+		m_parents[i] = i;
+	}
+	for (unsigned int i = 0; i < _constraints.size(); ++i) {
+		const ContactConstraint& constraint = _constraints[i];
+		if (_bodies[constraint.bodyA].inverseMass > 0.0f && _bodies[constraint.bodyB].inverseMass > 0.0f) {
+			Join(constraint.bodyA, constraint.bodyB);
+		}
+	}
+
+	// Number the islands and count what goes in each
+	islands.clear();
+	m_islandOf.assign(_bodies.size(), NO_ISLAND);
+	for (unsigned int i = 0; i < _bodies.size(); ++i) {
+		if (_bodies[i].inverseMass == 0.0f) {
+			continue;
+		}
+		unsigned int root = Find(i);
+		if (m_islandOf[root] == NO_ISLAND) {
+			m_islandOf[root] = islands.size();
+			Island island = {};
+			islands.push_back(island);
+		}
+		m_islandOf[i] = m_islandOf[root];
+		islands[m_islandOf[i]].bodyCount++;
+	}
+	for (unsigned int i = 0; i < _constraints.size(); ++i) {
+		unsigned int body = _bodies[_constraints[i].bodyA].inverseMass > 0.0f ? _constraints[i].bodyA : _constraints[i].bodyB;
+		islands[m_islandOf[body]].constraintCount++;
+	}
+
+	// Then place everything after the islands before it, keeping the original order
+	unsigned int bodyCount = 0;
+	unsigned int constraintCount = 0;
+	for (unsigned int i = 0; i < islands.size(); ++i) {
+		islands[i].firstBody = bodyCount;
+		islands[i].firstConstraint = constraintCount;
+		bodyCount += islands[i].bodyCount;
+		constraintCount += islands[i].constraintCount;
+		islands[i].bodyCount = 0;
+		islands[i].constraintCount = 0;
+	}
+	bodies.resize(bodyCount);
+	constraints.resize(constraintCount);
+	for (unsigned int i = 0; i < _bodies.size(); ++i) {
+		if (m_islandOf[i] != NO_ISLAND) {
+			Island& island = islands[m_islandOf[i]];
+			bodies[island.firstBody + island.bodyCount++] = i;
+		}
+	}
+	for (unsigned int i = 0; i < _constraints.size(); ++i) {
+		unsigned int body = _bodies[_constraints[i].bodyA].inverseMass > 0.0f ? _constraints[i].bodyA : _constraints[i].bodyB;
+		Island& island = islands[m_islandOf[body]];
+		constraints[island.firstConstraint + island.constraintCount++] = i;
+	}
+}
+void IslandBuilder::UpdateSleep(vector<SolverBody>& _bodies, float _timeStep) {
+	float linearTolerance = linearSleepTolerance * linearSleepTolerance;
+	float angularTolerance = angularSleepTolerance * angularSleepTolerance;
+	for (unsigned int i = 0; i < islands.size(); ++i) {
+		Island& island = islands[i];
+		island.sleepTime = FLT_MAX;
+		for (unsigned int j = 0; j < island.bodyCount; ++j) {
+			SolverBody& body = _bodies[bodies[island.firstBody + j]];
+			if (glm::dot(body.velocity, body.velocity) > linearTolerance ||
+				glm::dot(body.angularVelocity, body.angularVelocity) > angularTolerance) {
+				body.sleepTime = 0.0f;
+			} else {
+				body.sleepTime += _timeStep;
+			}
+			island.sleepTime = glm::min(island.sleepTime, body.sleepTime);
+		}
+	}
+}
+
+// Private
+unsigned int IslandBuilder::Find(unsigned int _body) {
+	// Path halving, every other body on the way points at its grandparent
+	while (m_parents[_body] != _body) {
+		m_parents[_body] = m_parents[m_parents[_body]];
+		_body = m_parents[_body];
+	}
+	return _body;
+}
+void IslandBuilder::Join(unsigned int _bodyA, unsigned int _bodyB) {
+	// Note(Manny): The lower root always wins, so the islands only depend on the contacts and not their order
+	unsigned int rootA = Find(_bodyA);
+	unsigned int rootB = Find(_bodyB);
+	if (rootA < rootB) {
+		m_parents[rootB] = rootA;
+	} else if (rootB < rootA) {
+		m_parents[rootA] = rootB;
+	}
+}
\ No newline at end of file
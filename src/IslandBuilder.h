@@ -0,0 +1,56 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: IslandBuilder.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: Groups the bodies that touch into
+islands, which are put to sleep and woken up
+as a whole.
+===============================================*/
+
+#ifndef _ISLAND_BUILDER_H_
+#define _ISLAND_BUILDER_H_
+
+// Physics
+#include "ContactSolver.h"
+
+// Other
+#include <vector>
+using std::vector;
+
+struct Island {
+	unsigned int firstBody; //Into IslandBuilder::bodies
+	unsigned int bodyCount;
+	unsigned int firstConstraint; //Into IslandBuilder::constraints
+	unsigned int constraintCount;
+	float sleepTime; //Shortest sleep time of its bodies
+};
+
+// Bodies that can move are joined by the contacts between them with a
+// union-find. Bodies that nothing moves never join two islands, so every box
+// resting on the same floor is still an island of its own.
+class IslandBuilder {
+public:
+	IslandBuilder();
+	void Build(const vector<SolverBody>& _bodies, const vector<ContactConstraint>& _constraints);
+	// Advances the sleep time of resting bodies and restarts it for moving ones
+	void UpdateSleep(vector<SolverBody>& _bodies, float _timeStep);
+	inline bool CanSleep(const Island& _island) const { return _island.sleepTime >= timeToSleep; }
+
+	vector<Island> islands; //In order of their lowest body
+	vector<unsigned int> bodies; //Body indices, grouped by island
+	vector<unsigned int> constraints; //Constraint indices, grouped by island
+	float linearSleepTolerance; //Speed below which a body is resting
+	float angularSleepTolerance; //Angular speed below which a body is resting, in radians
+	float timeToSleep; //Seconds every body of an island has to rest before it sleeps
+private:
+	unsigned int Find(unsigned int _body);
+	void Join(unsigned int _bodyA, unsigned int _bodyB);
+
+	vector<unsigned int> m_parents;
+	vector<unsigned int> m_islandOf; //Island of each root body, scratch space
+};
+
+#endif // _ISLAND_BUILDER_H_
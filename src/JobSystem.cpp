@@ -0,0 +1,229 @@
+#include "JobSystem.h"
+
+JobSystem* JobSystem::instance = nullptr;
+JOB_THREAD_LOCAL unsigned int JobSystem::sm_threadIndex = 0;
+
+// Static
+void JobSystem::Create(unsigned int _workerCount) {
+	if (instance == nullptr) {
+		if (_workerCount == 0) {
+			// Leave one core for the main thread, which also runs jobs while waiting
+			unsigned int coreCount = std::thread::hardware_concurrency();
+			_workerCount = coreCount > 1 ? coreCount - 1 : 1;
+		}
+		instance = new JobSystem(_workerCount);
+	}
+}
+void JobSystem::Shutdown() {
+	delete instance;
+	instance = nullptr;
+}
+void JobSystem::Run(const std::function<void()>& _function, JobCounter* _counter, JobCounter* _dependency) {
+	if (instance == nullptr) {
+		// Note(Manny): Without workers jobs run immediately on the calling thread
+		if (_dependency != nullptr) {
+			while (!_dependency->IsDone()) { std::this_thread::yield(); }
+		}
+		_function();
+		return;
+	}
+
+	if (_counter != nullptr) {
+		_counter->count++;
+	}
+	Job job(_function, _counter, _dependency);
+	if (_dependency != nullptr) {
+		// Note(Manny): Blocked jobs stay out of the queues so idle workers
+		// only wake up for jobs they can actually run
+		std::lock_guard<std::mutex> lock(instance->m_blockedMutex);
+		if (!_dependency->IsDone()) {
+			instance->m_blockedJobs.push_back(job);
+			return;
+		}
+	}
+	instance->Push(instance->m_queues[sm_threadIndex], job);
+}
+void JobSystem::RunBackground(const std::function<void()>& _function, JobCounter* _counter) {
+	if (instance == nullptr) {
+		_function();
+		return;
+	}
+
+	if (_counter != nullptr) {
+		_counter->count++;
+	}
+	instance->Push(&instance->m_backgroundQueue, Job(_function, _counter, nullptr));
+}
+void JobSystem::Wait(JobCounter& _counter) {
+	while (!_counter.IsDone()) {
+		if (instance == nullptr) {
+			std::this_thread::yield();
+			continue;
+		}
+		// Only help with our own jobs, anything else could take far longer than the wait
+		if (instance->RunNextJob(sm_threadIndex, &_counter)) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(instance->m_sleepMutex);
+		instance->m_doneCondition.wait(lock, [&_counter]() { return _counter.IsDone(); });
+	}
+}
+bool JobSystem::RunPendingJob() {
+	return instance != nullptr && instance->RunNextJob(sm_threadIndex);
+}
+void JobSystem::ParallelFor(unsigned int _count, unsigned int _batchSize,
+	const std::function<void(unsigned int _begin, unsigned int _end)>& _function) {
+	if (_batchSize == 0) {
+		_batchSize = 1;
+	}
+	if (instance == nullptr || _count <= _batchSize) {
+		_function(0, _count);
+		return;
+	}
+
+	JobCounter counter;
+	for (unsigned int begin = 0; begin < _count; begin += _batchSize) {
+		unsigned int end = begin + _batchSize < _count ? begin + _batchSize : _count;
+		Run([&_function, begin, end]() { _function(begin, end); }, &counter);
+	}
+	Wait(counter);
+}
+unsigned int JobSystem::GetWorkerCount() {
+	return instance != nullptr ? instance->m_workers.size() : 0;
+}
+unsigned int JobSystem::GetThreadCount() {
+	return GetWorkerCount() + 1;
+}
+unsigned int JobSystem::GetThreadIndex() {
+	return sm_threadIndex;
+}
+
+// Private
+JobSystem::JobSystem(unsigned int _workerCount) :
+	m_pendingJobs(0),
+	m_running(true) {
+	for (unsigned int i = 0; i < _workerCount + 1; ++i) {
+		m_queues.push_back(new WorkQueue());
+	}
+	for (unsigned int i = 0; i < _workerCount; ++i) {
+		m_workers.push_back(std::thread(&JobSystem::WorkerLoop, this, i + 1));
+	}
+}
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_running = false;
+	}
+	m_wakeCondition.notify_all();
+	for (unsigned int i = 0; i < m_workers.size(); ++i) {
+		m_workers[i].join();
+	}
+	for (unsigned int i = 0; i < m_queues.size(); ++i) {
+		delete m_queues[i];
+	}
+}
+void JobSystem::Push(WorkQueue* _queue, const Job& _job) {
+	{
+		std::lock_guard<std::mutex> lock(_queue->mutex);
+		_queue->jobs.push_back(_job);
+	}
+	m_pendingJobs++;
+	// Taking the sleep mutex makes sure a worker that just found nothing to do
+	// is already waiting, otherwise the notify could be missed
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_wakeCondition.notify_one();
+}
+void JobSystem::WorkerLoop(unsigned int _threadIndex) {
+	sm_threadIndex = _threadIndex;
+	while (m_running) {
+		if (!RunNextJob(_threadIndex)) {
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_wakeCondition.wait(lock, [this]() {
+				return m_pendingJobs.load() > 0 || !m_running;
+			});
+		}
+	}
+}
+bool JobSystem::RunNextJob(unsigned int _threadIndex, JobCounter* _counter) {
+	Job job;
+	if (!PopJob(_threadIndex, _counter, job) && !StealJob(_threadIndex, _counter, job)) {
+		// Background jobs are left to the workers when they have nothing else to do
+		if (_threadIndex == 0 || _counter != nullptr || !PopBackgroundJob(job)) {
+			return false;
+		}
+	}
+	m_pendingJobs--;
+
+	job.function();
+	FinishJob(job);
+	return true;
+}
+bool JobSystem::PopJob(unsigned int _threadIndex, JobCounter* _counter, Job& _job) {
+	// The owner takes its newest job, which is most likely still in cache
+	WorkQueue* queue = m_queues[_threadIndex];
+	std::lock_guard<std::mutex> lock(queue->mutex);
+	for (unsigned int i = queue->jobs.size(); i-- > 0;) {
+		if (_counter == nullptr || queue->jobs[i].counter == _counter) {
+			_job = queue->jobs[i];
+			queue->jobs.erase(queue->jobs.begin() + i);
+			return true;
+		}
+	}
+	return false;
+}
+bool JobSystem::StealJob(unsigned int _threadIndex, JobCounter* _counter, Job& _job) {
+	// Thieves take the oldest job from the other end of a queue
+	for (unsigned int i = 1; i < m_queues.size(); ++i) {
+		WorkQueue* queue = m_queues[(_threadIndex + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		for (unsigned int j = 0; j < queue->jobs.size(); ++j) {
+			if (_counter == nullptr || queue->jobs[j].counter == _counter) {
+				_job = queue->jobs[j];
+				queue->jobs.erase(queue->jobs.begin() + j);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+bool JobSystem::PopBackgroundJob(Job& _job) {
+	std::lock_guard<std::mutex> lock(m_backgroundQueue.mutex);
+	if (m_backgroundQueue.jobs.empty()) {
+		return false;
+	}
+	_job = m_backgroundQueue.jobs.front();
+	m_backgroundQueue.jobs.pop_front();
+	return true;
+}
+void JobSystem::FinishJob(const Job& _job) {
+	// Note(Manny): The counter may be destroyed by its waiter as soon as it
+	// reaches zero, so it is not touched after the decrement
+	if (_job.counter == nullptr || --_job.counter->count > 0) {
+		return;
+	}
+
+	// Queue the blocked jobs whose dependency just finished
+	vector<Job> readyJobs;
+	{
+		std::lock_guard<std::mutex> lock(m_blockedMutex);
+		for (unsigned int i = 0; i < m_blockedJobs.size();) {
+			if (m_blockedJobs[i].dependency->IsDone()) {
+				readyJobs.push_back(m_blockedJobs[i]);
+				m_blockedJobs[i] = m_blockedJobs.back();
+				m_blockedJobs.pop_back();
+			} else {
+				++i;
+			}
+		}
+	}
+	for (unsigned int i = 0; i < readyJobs.size(); ++i) {
+		Push(m_queues[sm_threadIndex], readyJobs[i]);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_doneCondition.notify_all();
+}
\ No newline at end of file
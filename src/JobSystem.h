@@ -0,0 +1,101 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: JobSystem.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: A pool of worker threads that run jobs
+pushed by the engine. Every thread owns a
+queue and steals from the others when idle.
+===============================================*/
+
+#ifndef _JOB_SYSTEM_H_
+#define _JOB_SYSTEM_H_
+
+// Other
+#include <vector>
+using std::vector;
+#include <deque>
+using std::deque;
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#if defined(_MSC_VER)
+#define JOB_THREAD_LOCAL __declspec(thread)
+#else
+#define JOB_THREAD_LOCAL thread_local
+#endif
+
+// Counts the jobs that are still running, jobs can wait on a counter
+// before they start to express a dependency
+struct JobCounter {
+	JobCounter() : count(0) {}
+	inline bool IsDone() const { return count.load() == 0; }
+	std::atomic<int> count;
+};
+
+struct Job {
+	Job() : counter(nullptr), dependency(nullptr) {}
+	Job(const std::function<void()>& _function, JobCounter* _counter, JobCounter* _dependency) :
+		function(_function),
+		counter(_counter),
+		dependency(_dependency) {}
+	std::function<void()> function;
+	JobCounter* counter; //Decremented once the job has run
+	JobCounter* dependency; //Job waits until this counter reaches zero
+};
+
+class JobSystem {
+public:
+	static void Create(unsigned int _workerCount = 0);
+	static void Shutdown();
+	static void Run(const std::function<void()>& _function, JobCounter* _counter = nullptr, JobCounter* _dependency = nullptr);
+	// For long jobs such as asset imports, only workers run these so the main
+	// thread never picks one up while it waits or helps
+	static void RunBackground(const std::function<void()>& _function, JobCounter* _counter = nullptr);
+	static void Wait(JobCounter& _counter); //Only helps with jobs of _counter, sleeps otherwise
+	static bool RunPendingJob(); //Lets the calling thread help, false if nothing ran
+	// Splits [0, _count) into batches and runs them across all threads,
+	// returns once every batch has finished
+	static void ParallelFor(unsigned int _count, unsigned int _batchSize,
+		const std::function<void(unsigned int _begin, unsigned int _end)>& _function);
+	static unsigned int GetWorkerCount();
+	static unsigned int GetThreadCount(); //Workers plus the main thread
+	static unsigned int GetThreadIndex(); //0 on the main thread, unique for each worker
+
+	static JobSystem* instance;
+private:
+	struct WorkQueue {
+		deque<Job> jobs;
+		std::mutex mutex;
+	};
+
+	JobSystem(unsigned int _workerCount);
+	~JobSystem();
+	void Push(WorkQueue* _queue, const Job& _job);
+	void WorkerLoop(unsigned int _threadIndex);
+	bool RunNextJob(unsigned int _threadIndex, JobCounter* _counter = nullptr);
+	bool PopJob(unsigned int _threadIndex, JobCounter* _counter, Job& _job);
+	bool StealJob(unsigned int _threadIndex, JobCounter* _counter, Job& _job);
+	bool PopBackgroundJob(Job& _job);
+	void FinishJob(const Job& _job);
+
+	vector<std::thread> m_workers;
+	vector<WorkQueue*> m_queues; //Index 0 belongs to the main thread
+	WorkQueue m_backgroundQueue; //Long jobs, never run by the main thread
+	std::mutex m_blockedMutex;
+	vector<Job> m_blockedJobs; //Queued once their dependency reaches zero
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeCondition; //Workers sleep until a job is queued
+	std::condition_variable m_doneCondition; //Wait sleeps until a counter reaches zero
+	std::atomic<int> m_pendingJobs; //Jobs in the queues, blocked jobs are not counted
+	std::atomic<bool> m_running;
+
+	static JOB_THREAD_LOCAL unsigned int sm_threadIndex;
+};
+
+#endif // _JOB_SYSTEM_H_
\ No newline at end of file
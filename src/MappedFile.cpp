@@ -0,0 +1,106 @@
+#include "MappedFile.h"
+
+// Other
+#include <sys/stat.h>
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Public
+MappedFile::MappedFile() :
+	m_data(nullptr),
+	m_size(0),
+	m_file(nullptr),
+	m_mapping(nullptr) {}
+MappedFile::~MappedFile() {
+	Close();
+}
+bool MappedFile::Open(const string& _fileName) {
+	Close();
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(_fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		CloseHandle(file);
+		return false;
+	}
+	m_file = file;
+	m_mapping = mapping;
+	m_size = (size_t)size.QuadPart;
+	m_data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	int file = open(_fileName.c_str(), O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0) {
+		close(file);
+		return false;
+	}
+	void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	m_size = (size_t)info.st_size;
+	m_data = (const unsigned char*)data;
+#endif
+	if (m_data == nullptr) {
+		Close();
+		return false;
+	}
+	return true;
+}
+void MappedFile::Close() {
+#if defined(_WIN32)
+	if (m_data != nullptr) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping != nullptr) {
+		CloseHandle((HANDLE)m_mapping);
+	}
+	if (m_file != nullptr) {
+		CloseHandle((HANDLE)m_file);
+	}
+#else
+	if (m_data != nullptr) {
+		munmap((void*)m_data, m_size);
+	}
+#endif
+	m_data = nullptr;
+	m_size = 0;
+	m_file = nullptr;
+	m_mapping = nullptr;
+}
+
+// Static
+bool MappedFile::GetFileInfo(const string& _fileName, unsigned long long& _modifiedTime, unsigned long long& _size) {
+#if defined(_WIN32)
+	struct _stat64 info;
+	if (_stat64(_fileName.c_str(), &info) != 0) {
+		return false;
+	}
+#else
+	struct stat info;
+	if (stat(_fileName.c_str(), &info) != 0) {
+		return false;
+	}
+#endif
+	_modifiedTime = (unsigned long long)info.st_mtime;
+	_size = (unsigned long long)info.st_size;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: MappedFile.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: Maps a file into memory so that it can
+be read without copying it first.
+===============================================*/
+
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+// Other
+#include <string>
+using std::string;
+
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+	bool Open(const string& _fileName);
+	void Close();
+	inline const unsigned char* GetData() const { return m_data; }
+	inline size_t GetSize() const { return m_size; }
+	// Last write time and size of a file, false if it doesn't exist
+	static bool GetFileInfo(const string& _fileName, unsigned long long& _modifiedTime, unsigned long long& _size);
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+	const unsigned char* m_data;
+	size_t m_size;
+	void* m_file;
+	void* m_mapping;
+};
+
+#endif // _MAPPED_FILE_H_
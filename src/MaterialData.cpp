@@ -1,25 +1,41 @@
 #include "MaterialData.h"
 
-const vec3* MaterialData::GetVector3(const string& _name) const {
-	map<string, vec3>::const_iterator it = m_vec3Map.find(_name);
+std::atomic<unsigned int> MaterialData::sm_materialCount(0);
+map<string, unsigned int> MaterialData::sm_propertyIds;
+std::mutex MaterialData::sm_propertyMutex;
+
+const vec3* MaterialData::GetVector3(unsigned int _propertyId) const {
+	map<unsigned int, vec3>::const_iterator it = m_vec3Map.find(_propertyId);
 	if (it != m_vec3Map.end()) {
 		return &it->second;
 	}
 	return &m_defaultVec3;
 }
 
-float* MaterialData::GetFloat(const string& name) const {
-	map<string, float>::const_iterator it = m_floatMap.find(name);
+float* MaterialData::GetFloat(unsigned int _propertyId) const {
+	map<unsigned int, float>::const_iterator it = m_floatMap.find(_propertyId);
 	if (it != m_floatMap.end()) {
 		return (float*)&it->second;
 	}
 	return 0;
 }
 
-const Texture* MaterialData::GetTexture(const string& name) const {
-	map<string, Texture>::const_iterator it = m_textureMap.find(name);
+const Texture* MaterialData::GetTexture(unsigned int _propertyId) const {
+	map<unsigned int, Texture>::const_iterator it = m_textureMap.find(_propertyId);
 	if (it != m_textureMap.end()) {
 		return &it->second;
 	}
 	return &m_defaultTexture;
 }
+
+// Static
+unsigned int MaterialData::GetPropertyId(const string& _name) {
+	std::lock_guard<std::mutex> lock(sm_propertyMutex);
+	map<string, unsigned int>::const_iterator it = sm_propertyIds.find(_name);
+	if (it != sm_propertyIds.end()) {
+		return it->second;
+	}
+	unsigned int propertyId = sm_propertyIds.size();
+	sm_propertyIds.insert(std::pair<string, unsigned int>(_name, propertyId));
+	return propertyId;
+}
@@ -17,23 +17,40 @@ Copyright (c) 2015 Emmanuel Vaccaro
 // Utilities
 #include "GLM_Header.h"
 
+// Other
+#include <atomic>
+#include <mutex>
+
 class MaterialData
 {
 public:
 	MaterialData() :
+		materialId(sm_materialCount++),
 		m_defaultTexture(Texture("default_texture.png")),
 		m_defaultVec3(vec3(0, 0, 0)) {}
-	inline void SetVector3(const string& _name, const vec3& _value)	{ m_vec3Map[_name] = _value; }
-	inline void SetFloat(const string& _name, float _value) { m_floatMap[_name] = _value; }
-	inline void SetTexture(const string& _name, const Texture& _value) { m_textureMap[_name] = _value; }
-	const vec3* GetVector3(const string& _name)  const;
-	float* GetFloat(const string& _name) const;
-	const Texture* GetTexture(const string& _name) const;
+	inline void SetVector3(const string& _name, const vec3& _value)	{ SetVector3(GetPropertyId(_name), _value); }
+	inline void SetFloat(const string& _name, float _value) { SetFloat(GetPropertyId(_name), _value); }
+	inline void SetTexture(const string& _name, const Texture& _value) { SetTexture(GetPropertyId(_name), _value); }
+	inline void SetVector3(unsigned int _propertyId, const vec3& _value) { m_vec3Map[_propertyId] = _value; }
+	inline void SetFloat(unsigned int _propertyId, float _value) { m_floatMap[_propertyId] = _value; }
+	inline void SetTexture(unsigned int _propertyId, const Texture& _value) { m_textureMap[_propertyId] = _value; }
+	inline const vec3* GetVector3(const string& _name) const { return GetVector3(GetPropertyId(_name)); }
+	inline float* GetFloat(const string& _name) const { return GetFloat(GetPropertyId(_name)); }
+	inline const Texture* GetTexture(const string& _name) const { return GetTexture(GetPropertyId(_name)); }
+	const vec3* GetVector3(unsigned int _propertyId) const;
+	float* GetFloat(unsigned int _propertyId) const;
+	const Texture* GetTexture(unsigned int _propertyId) const;
+	// Interns a property name, callers that set or read a property every frame keep the id
+	static unsigned int GetPropertyId(const string& _name);
 
+	unsigned int materialId; //Unique id used when sorting the render queue
 private:
-	map<string, vec3> m_vec3Map;
-	map<string, float> m_floatMap;
-	map<string, Texture> m_textureMap;
+	static std::atomic<unsigned int> sm_materialCount; //Materials may be created by loading workers
+	static map<string, unsigned int> sm_propertyIds;
+	static std::mutex sm_propertyMutex; //Guards the property ids
+	map<unsigned int, vec3> m_vec3Map;
+	map<unsigned int, float> m_floatMap;
+	map<unsigned int, Texture> m_textureMap;
 
 	Texture m_defaultTexture;
 	vec3 m_defaultVec3;
@@ -4,21 +4,42 @@
 #include "imgui.h"
 #include "Gizmos.h"
 #include "Time.h"
+#include "CookedMesh.h"
+#include "AssetLoader.h"
+#include "JobSystem.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <iostream>
+#include <memory>
 
 // Static resource map
 map<string, IndexedModel*> Mesh::sm_resourceMap;
+std::mutex Mesh::sm_resourceMutex;
+IndexedModel* Mesh::sm_placeholder = nullptr;
+const string Mesh::PLACEHOLDER_MESH = "cube.obj";
+const float IndexedModel::MAX_HALF_TEXCOORD = 2.0f;
+
+const unsigned int Mesh::OBJ_IMPORT_FLAGS =
+	aiProcess_Triangulate |
+	aiProcess_GenSmoothNormals |
+	aiProcess_FlipUVs |
+	aiProcess_CalcTangentSpace;
 
 // MeshData 
 
 MeshData::~MeshData() {
-	glDeleteVertexArrays(1, &glData.VAO);
-	glDeleteBuffers(1, &glData.VBO);
-	glDeleteBuffers(1, &glData.IBO);
+	// Note(Manny): Meshes imported on a worker are destroyed there, away from the GL context
+	if (glData.VAO) {
+		glDeleteVertexArrays(1, &glData.VAO);
+	}
+	if (glData.VBO) {
+		glDeleteBuffers(1, &glData.VBO);
+	}
+	if (glData.IBO) {
+		glDeleteBuffers(1, &glData.IBO);
+	}
 }
 
 bool MeshData::IsValid() const {
@@ -182,125 +203,237 @@ void IndexedModel::Init() {
 			return;
 		}
 
-		glGenVertexArrays(1, &currMesh.glData.VAO);
-		glGenBuffers(1, &currMesh.glData.VBO);
-		glGenBuffers(1, &currMesh.glData.IBO);
-		
-		vector<float> vertexData;
+		VertexLayout layout = ChooseLayout(currMesh);
+		vector<unsigned char> vertexData;
+		vector<unsigned char> indexData;
+		GLenum indexType = PackVertices(currMesh, layout, vertexData, indexData);
+		Upload(currMesh, layout, vertexData.data(), vertexData.size(), indexData.data(), indexData.size(), indexType);
+	}
+}
 
-		// Positions
-		for (unsigned int i = 0; i < currMesh.positions.size(); ++i) {
-			vertexData.push_back(currMesh.positions[i].x);
-			vertexData.push_back(currMesh.positions[i].y);
-			vertexData.push_back(currMesh.positions[i].z);
-		}
+void IndexedModel::Draw(RenderingEngine& _renderer) {
+	for (unsigned int i = 0; i < meshes.size(); ++i) {
+		glBindVertexArray(meshes[i].glData.VAO);
+		glDrawElements(GL_TRIANGLES, meshes[i].lods[0].indexCount, meshes[i].glData.indexType, 0);
+	}
+}
 
-		// TexCoords
-		for (unsigned int i = 0; i < currMesh.texCoords.size(); ++i) {
-			vertexData.push_back(currMesh.texCoords[i].x);
-			vertexData.push_back(currMesh.texCoords[i].y);
-		}
-		
-		// Bone Indices
-		for (unsigned int i = 0; i < currMesh.boneIndices.size(); ++i) {
-			vertexData.push_back(currMesh.boneIndices[i].x);
-			vertexData.push_back(currMesh.boneIndices[i].y);
-			vertexData.push_back(currMesh.boneIndices[i].z);
-			vertexData.push_back(currMesh.boneIndices[i].w);
-		}
+void IndexedModel::Finalize() {
+	// Note(Manny): Reports what packing saves over storing every attribute as floats
+	const unsigned int unpackedVertexSize = sizeof(vec3) * 3 + sizeof(vec2) + sizeof(vec4) * 2;
+	unsigned int vertexCount = 0;
+	unsigned int packedVertexBytes = 0;
+	unsigned int packedBytes = 0;
+	unsigned int unpackedBytes = 0;
+	for (unsigned int i = 0; i < meshes.size(); ++i) {
+		MeshData& currMesh = meshes[i];
+		currMesh.Finalize();
+
+		unsigned int meshVertexCount = currMesh.positions.size();
+		unsigned int indexSize = meshVertexCount <= 0xFFFF + 1 ? sizeof(GLushort) : sizeof(GLuint);
+		unsigned int vertexBytes = ChooseLayout(currMesh).stride * meshVertexCount;
+		vertexCount += meshVertexCount;
+		packedVertexBytes += vertexBytes;
+		packedBytes += vertexBytes + indexSize * currMesh.indices.size();
+		unpackedBytes += unpackedVertexSize * meshVertexCount + sizeof(GLuint) * currMesh.indices.size();
+	}
+	if (vertexCount > 0) {
+		std::cout << "Mesh: " << vertexCount << " vertices in " << meshes.size() << " submeshes, "
+			<< (float)packedVertexBytes / vertexCount << " bytes per vertex (" << unpackedVertexSize << " unpacked), "
+			<< packedBytes / 1024 << " KB with indices (" << unpackedBytes / 1024 << " KB unpacked)" << std::endl;
+	}
+}
 
-		// Bone Weights
-		for (unsigned int i = 0; i < currMesh.boneWeights.size(); ++i) {
-			vertexData.push_back(currMesh.boneWeights[i].x);
-			vertexData.push_back(currMesh.boneWeights[i].y);
-			vertexData.push_back(currMesh.boneWeights[i].z);
-			vertexData.push_back(currMesh.boneWeights[i].w);
+
+void IndexedModel::Optimize() {
+	JobSystem::ParallelFor(meshes.size(), 1, [this](unsigned int _begin, unsigned int _end) {
+		for (unsigned int i = _begin; i < _end; ++i) {
+			MeshOptimizer::Optimize(meshes[i]);
+			MeshSimplifier::GenerateLODs(meshes[i]);
 		}
+	});
+}
+
+unsigned int IndexedModel::GetLODCount() const {
+	unsigned int lodCount = 1;
+	for (unsigned int i = 0; i < meshes.size(); ++i) {
+		lodCount = std::max(lodCount, (unsigned int)meshes[i].lods.size());
+	}
+	return lodCount;
+}
 
-		// Normals
-		for (unsigned int i = 0; i < currMesh.normals.size(); ++i) {
-			vertexData.push_back(currMesh.normals[i].x);
-			vertexData.push_back(currMesh.normals[i].y);
-			vertexData.push_back(currMesh.normals[i].z);
+float IndexedModel::GetLODError(unsigned int _lod) const {
+	float error = 0.0f;
+	for (unsigned int i = 0; i < meshes.size(); ++i) {
+		const vector<MeshLOD>& lods = meshes[i].lods;
+		if (lods.size() > 0) {
+			error = std::max(error, lods[std::min(_lod, (unsigned int)lods.size() - 1)].error);
 		}
+	}
+	return error;
+}
 
-		// Tangents
-		for (unsigned int i = 0; i < currMesh.tangents.size(); ++i) {
-			vertexData.push_back(currMesh.tangents[i].x);
-			vertexData.push_back(currMesh.tangents[i].y);
-			vertexData.push_back(currMesh.tangents[i].z);
+AnimationRig* IndexedModel::GetRig() {
+	if (!rig && !skeletons.empty()) {
+		rig = std::make_shared<AnimationRig>(*skeletons[0], animations);
+	}
+	return rig.get();
+}
+
+TriangleTree* IndexedModel::GetTriangleTree() {
+	if (!triangleTree) {
+		triangleTree = std::make_shared<TriangleTree>();
+		for (unsigned int i = 0; i < meshes.size(); ++i) {
+			triangleTree->AddMesh(meshes[i].positions, meshes[i].indices);
 		}
+		triangleTree->Build();
+	}
+	return triangleTree->GetTriangleCount() > 0 ? triangleTree.get() : nullptr;
+}
 
-		currMesh.glData.indexCount = currMesh.indices.size();
+void IndexedModel::AddSkeleton(FBXSkeleton* _skeleton) {
+	skeletons.push_back(_skeleton);
+}
 
-		glBindVertexArray(currMesh.glData.VAO);
-		glBindBuffer(GL_ARRAY_BUFFER, currMesh.glData.VBO);
-		glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STATIC_DRAW);
+void IndexedModel::AddAnimation(FBXAnimation* _animation) {
+	animations.push_back(_animation);
+}
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, currMesh.glData.IBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, currMesh.indices.size() * sizeof(GLuint), &currMesh.indices[0], GL_STATIC_DRAW);
+Bounds IndexedModel::CalculateBounds() {
+	if (meshes.size() > 0) {
+		vec3 min = vec3(FLT_MAX);
+		vec3 max = vec3(FLT_MIN);
+		vector<vec3>& positions = meshes[0].positions; //Note(Manny): Loop through all the meshes and calculate bounds for each
+		for (unsigned int i = 0; i < positions.size(); ++i) {
+			if (positions[i].x < min.x) min.x = positions[i].x;
+			if (positions[i].y < min.y) min.y = positions[i].y;
+			if (positions[i].z < min.z) min.z = positions[i].z;
 
-		glEnableVertexAttribArray(0); // Positions
-		glEnableVertexAttribArray(1); // TexCoords
-		
-		glEnableVertexAttribArray(2); // Bone Indices
-		glEnableVertexAttribArray(3); // Bone Weights
+			if (positions[i].x > max.x) max.x = positions[i].x;
+			if (positions[i].y > max.y) max.y = positions[i].y;
+			if (positions[i].z > max.z) max.z = positions[i].z;
+		}
+		bounds.SetMinMax(min, max);
+	}
+	return bounds;
+}
 
-		glEnableVertexAttribArray(4); // Normals
-		glEnableVertexAttribArray(5); // Tangents
+VertexLayout IndexedModel::ChooseLayout(const MeshData& _mesh) const {
+	// Directions fit in 10 bits a component, texture coordinates in half
+	// floats as long as they stay close to the [0, 1] range
+	bool halfTexCoords = true;
+	for (unsigned int i = 0; i < _mesh.texCoords.size() && halfTexCoords; ++i) {
+		halfTexCoords = glm::abs(_mesh.texCoords[i].x) <= MAX_HALF_TEXCOORD &&
+			glm::abs(_mesh.texCoords[i].y) <= MAX_HALF_TEXCOORD;
+	}
 
-		unsigned int positionsOffset = sizeof(vec3) * currMesh.positions.size();
-		unsigned int texCoordsOffset = sizeof(vec2) * currMesh.tangents.size();
-		
-		unsigned int boneIndicesOffset = sizeof(vec4) * currMesh.boneIndices.size();
-		unsigned int boneWeightsOffset = sizeof(vec4) * currMesh.boneWeights.size();
+	VertexLayout layout;
+	layout.Add(VERTEX_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(vec3));
+	layout.Add(VERTEX_NORMAL, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(GLuint));
+	layout.Add(VERTEX_TANGENT, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(GLuint));
+	if (halfTexCoords) {
+		layout.Add(VERTEX_TEXCOORD, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(GLushort) * 2);
+	} else {
+		layout.Add(VERTEX_TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(vec2));
+	}
+	// Note(Manny): Only skinned models read the bone streams
+	if (!skeletons.empty()) {
+		layout.Add(VERTEX_BONE_INDICES, 4, GL_UNSIGNED_BYTE, GL_FALSE, 4);
+		layout.Add(VERTEX_BONE_WEIGHTS, 4, GL_UNSIGNED_BYTE, GL_TRUE, 4);
+	}
+	return layout;
+}
 
-		unsigned int normalsOffset = sizeof(vec3) * currMesh.normals.size();
-		unsigned int tangentsOffset = sizeof(vec3) * currMesh.tangents.size();
+GLenum IndexedModel::PackVertices(const MeshData& _mesh, const VertexLayout& _layout,
+	vector<unsigned char>& _vertexData, vector<unsigned char>& _indexData) const {
+	const VertexElement* elements = _layout.elements;
+	_vertexData.resize(_layout.stride * _mesh.positions.size());
+	for (unsigned int i = 0; i < _mesh.positions.size(); ++i) {
+		unsigned char* vertex = &_vertexData[i * _layout.stride];
 
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)(positionsOffset));
+		memcpy(vertex + elements[VERTEX_POSITION].offset, &_mesh.positions[i], sizeof(vec3));
 
-		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 0, (void*)(positionsOffset + texCoordsOffset));
-		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 0, (void*)(positionsOffset + texCoordsOffset + boneIndicesOffset));
+		GLuint normal = glm::packSnorm3x10_1x2(vec4(_mesh.normals[i], 0.0f));
+		GLuint tangent = glm::packSnorm3x10_1x2(vec4(_mesh.tangents[i], 0.0f));
+		memcpy(vertex + elements[VERTEX_NORMAL].offset, &normal, sizeof(GLuint));
+		memcpy(vertex + elements[VERTEX_TANGENT].offset, &tangent, sizeof(GLuint));
 
-		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 0, (void*)(positionsOffset + texCoordsOffset + boneIndicesOffset + boneWeightsOffset));
-		glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, 0, (void*)(positionsOffset + texCoordsOffset + boneIndicesOffset + boneWeightsOffset + normalsOffset));
+		if (elements[VERTEX_TEXCOORD].type == GL_HALF_FLOAT) {
+			GLushort texCoord[2] = { glm::packHalf1x16(_mesh.texCoords[i].x), glm::packHalf1x16(_mesh.texCoords[i].y) };
+			memcpy(vertex + elements[VERTEX_TEXCOORD].offset, texCoord, sizeof(texCoord));
+		} else {
+			memcpy(vertex + elements[VERTEX_TEXCOORD].offset, &_mesh.texCoords[i], sizeof(vec2));
+		}
 
-		glBindVertexArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		if (elements[VERTEX_BONE_INDICES].enabled) {
+			unsigned char* boneIndices = vertex + elements[VERTEX_BONE_INDICES].offset;
+			unsigned char* boneWeights = vertex + elements[VERTEX_BONE_WEIGHTS].offset;
+			for (int j = 0; j < 4; ++j) {
+				boneIndices[j] = (unsigned char)glm::clamp(_mesh.boneIndices[i][j], 0.0f, 255.0f);
+				boneWeights[j] = (unsigned char)(glm::clamp(_mesh.boneWeights[i][j], 0.0f, 1.0f) * 255.0f + 0.5f);
+			}
+		}
 	}
-}
 
-void IndexedModel::Draw(RenderingEngine& _renderer) {
-	for (unsigned int i = 0; i < meshes.size(); ++i) {
-		glBindVertexArray(meshes[i].glData.VAO);
-		glDrawElements(GL_TRIANGLES, meshes[i].glData.indexCount, GL_UNSIGNED_INT, 0);
+	// The LODs share the vertices and follow the full mesh in the index buffer
+	unsigned int indexCount = _mesh.indices.size() + _mesh.lodIndices.size();
+
+	// 16-bit indices whenever every vertex can be addressed with them
+	if (_mesh.positions.size() <= 0xFFFF + 1) {
+		_indexData.resize(indexCount * sizeof(GLushort));
+		GLushort* indices = (GLushort*)_indexData.data();
+		for (unsigned int i = 0; i < _mesh.indices.size(); ++i) {
+			indices[i] = (GLushort)_mesh.indices[i];
+		}
+		for (unsigned int i = 0; i < _mesh.lodIndices.size(); ++i) {
+			indices[_mesh.indices.size() + i] = (GLushort)_mesh.lodIndices[i];
+		}
+		return GL_UNSIGNED_SHORT;
 	}
+	_indexData.resize(indexCount * sizeof(GLuint));
+	memcpy(_indexData.data(), _mesh.indices.data(), _mesh.indices.size() * sizeof(GLuint));
+	if (_mesh.lodIndices.size() > 0) {
+		memcpy(_indexData.data() + _mesh.indices.size() * sizeof(GLuint), _mesh.lodIndices.data(), _mesh.lodIndices.size() * sizeof(GLuint));
+	}
+	return GL_UNSIGNED_INT;
 }
 
-void IndexedModel::Finalize() {
-	for (unsigned int i = 0; i < meshes.size(); ++i) {
-		meshes[i].Finalize();
+void IndexedModel::Upload(MeshData& _mesh, const VertexLayout& _layout,
+	const void* _vertexData, unsigned int _vertexBytes,
+	const void* _indexData, unsigned int _indexBytes, GLenum _indexType) {
+	glGenVertexArrays(1, &_mesh.glData.VAO);
+	glGenBuffers(1, &_mesh.glData.VBO);
+	glGenBuffers(1, &_mesh.glData.IBO);
+
+	_mesh.glData.indexType = _indexType;
+	_mesh.glData.indexCount = _indexBytes / (_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint));
+	_mesh.glData.vertexSize = _layout.stride;
+	if (_mesh.lods.empty()) {
+		MeshLOD full = { 0, _mesh.glData.indexCount, 0.0f };
+		_mesh.lods.push_back(full);
 	}
-}
 
+	glBindVertexArray(_mesh.glData.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, _mesh.glData.VBO);
+	glBufferData(GL_ARRAY_BUFFER, _vertexBytes, _vertexData, GL_STATIC_DRAW);
 
-void IndexedModel::AddSkeleton(FBXSkeleton* _skeleton) {
-	skeletons.push_back(_skeleton);
-}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _mesh.glData.IBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indexBytes, _indexData, GL_STATIC_DRAW);
 
-void IndexedModel::AddAnimation(FBXAnimation* _animation) {
-	animations.push_back(_animation);
+	_layout.Apply();
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 // Mesh
 Mesh::Mesh(const string& _fileName, 
-	bool _useDefaultDir) : 
+	bool _useDefaultDir,
+	bool _loadAsync) : 
 	fileName(_fileName), 
 	shader(Shader("default-forward-lighting")) {
-	Init(_fileName, _useDefaultDir);
+	Init(_fileName, _useDefaultDir, _loadAsync);
 }
 
 Mesh::Mesh(const string& _fileName, 
@@ -313,71 +446,108 @@ Mesh::Mesh(const string& _fileName,
 
 Mesh::~Mesh(){}
 
-void Mesh::Init(const string& _fileName, bool _useDefaultDir) {
-	map<string, IndexedModel*>::const_iterator it = sm_resourceMap.find(_fileName);
-	if (it != sm_resourceMap.end()) {
-		model = it->second;
-	} else {
-		model = new IndexedModel();
-
-		string fullDir;
-		if (_useDefaultDir) {
-			fullDir = "models/" + _fileName;
+void Mesh::Init(const string& _fileName, bool _useDefaultDir, bool _loadAsync) {
+	bool isCached;
+	{
+		std::lock_guard<std::mutex> lock(sm_resourceMutex);
+		map<string, IndexedModel*>::const_iterator it = sm_resourceMap.find(_fileName);
+		isCached = it != sm_resourceMap.end();
+		if (isCached) {
+			model = it->second;
 		} else {
-			fullDir = _fileName;
+			model = new IndexedModel();
+			sm_resourceMap.insert(pair<string, IndexedModel*>(_fileName, model));
 		}
+	}
+	if (isCached) {
+		bounds = GetModel()->bounds;
+		return;
+	}
 
-		string fileExtension = _fileName.substr(_fileName.find_last_of("."), _fileName.length());
+	string fullDir;
+	if (_useDefaultDir) {
+		fullDir = "models/" + _fileName;
+	} else {
+		fullDir = _fileName;
+	}
 
-		if (fileExtension == ".obj" || fileExtension == ".OBJ") {
-			LoadOBJFile(fullDir);
-		} else if (fileExtension == ".fbx" || fileExtension == ".FBX") {
-			LoadFBXFile(fullDir);
+	string fileExtension = _fileName.substr(_fileName.find_last_of("."), _fileName.length());
+
+	// The placeholder itself always loads straight away
+	if (_loadAsync && _fileName != PLACEHOLDER_MESH) {
+		LoadAsync(fullDir, fileExtension);
+		bounds = GetModel()->bounds;
+		return;
+	}
+
+	if (fileExtension == ".obj" || fileExtension == ".OBJ") {
+		// Note(Manny): The cooked file already holds the packed buffers and bounds
+		if (CookedMesh::Load(fullDir, OBJ_IMPORT_FLAGS, *model, model->bounds)) {
+			bounds = model->bounds;
+			return;
 		}
+		LoadOBJFile(fullDir, *model);
+	} else if (fileExtension == ".fbx" || fileExtension == ".FBX") {
+		LoadFBXFile(fullDir, *model);
+	}
+
+	CalculateMeshBounds();
 
-		CalculateMeshBounds();
-		sm_resourceMap.insert(pair<string, IndexedModel*>(_fileName, model));
+	model->Finalize();
+	model->Optimize();
+	model->Init();
 
-		model->Finalize();
-		model->Init();
+	if (fileExtension == ".obj" || fileExtension == ".OBJ") {
+		CookedMesh::Save(fullDir, OBJ_IMPORT_FLAGS, *model, bounds);
 	}
 }
 
 void Mesh::Draw(RenderingEngine& _renderer) {
-	model->Draw(_renderer);
+	GetModel()->Draw(_renderer);
+}
+
+IndexedModel* Mesh::GetModel() const {
+	if (model->isLoaded) {
+		return model;
+	}
+	if (sm_placeholder == nullptr) {
+		sm_placeholder = Mesh(PLACEHOLDER_MESH).model;
+	}
+	return sm_placeholder;
 }
 
 Bounds Mesh::CalculateMeshBounds() {
 	if (model->meshes.size() > 0) {
-		vec3 min = vec3(FLT_MAX);
-		vec3 max = vec3(FLT_MIN);
-		vector<vec3>& positions = model->meshes[0].positions; //Note(Manny): Loop through all the meshes and calculate bounds for each
-		for (unsigned int i = 0; i < positions.size(); ++i) {
-			if (positions[i].x < min.x) min.x = positions[i].x;
-			if (positions[i].y < min.y) min.y = positions[i].y;
-			if (positions[i].z < min.z) min.z = positions[i].z;
-
-			if (positions[i].x > max.x) max.x = positions[i].x;
-			if (positions[i].y > max.y) max.y = positions[i].y;
-			if (positions[i].z > max.z) max.z = positions[i].z;
-		}
-		bounds.SetMinMax(min, max);
+		bounds = model->CalculateBounds();
 	}
 	return bounds;
 }
 
 void Mesh::Inspector() {
 	ImGui::Text(("Mesh: " + fileName).c_str());
+	if (!model->isLoaded) {
+		ImGui::Text("Loading...");
+		return;
+	}
+	// Note(Manny): Every attribute used to be stored as floats, 76 bytes a vertex
+	for (unsigned int i = 0; i < model->meshes.size(); ++i) {
+		const OpenGLData& glData = model->meshes[i].glData;
+		ImGui::Text("Submesh %u: %u bytes per vertex (was 76), %u-bit indices", i, glData.vertexSize,
+			glData.indexType == GL_UNSIGNED_SHORT ? 16 : 32);
+		// Note(Manny): Only known for models imported this run, cooked ones were optimized already
+		const MeshData& mesh = model->meshes[i];
+		if (mesh.cacheStatsBefore.acmr > 0.0f) {
+			ImGui::Text("  ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+				mesh.cacheStatsBefore.acmr, mesh.cacheStatsAfter.acmr,
+				mesh.cacheStatsBefore.atvr, mesh.cacheStatsAfter.atvr);
+		}
+	}
 }
 
-void Mesh::LoadOBJFile(const string& _fileName) {
+void Mesh::LoadOBJFile(const string& _fileName, IndexedModel& _model) {
 	Assimp::Importer importer;
 
-	const aiScene* scene = importer.ReadFile(_fileName.c_str(),
-		aiProcess_Triangulate |
-		aiProcess_GenSmoothNormals |
-		aiProcess_FlipUVs |
-		aiProcess_CalcTangentSpace);
+	const aiScene* scene = importer.ReadFile(_fileName.c_str(), OBJ_IMPORT_FLAGS);
 
 	if (!scene) {
 		std::cout << "Mesh load failed!: " << _fileName << std::endl;
@@ -410,37 +580,41 @@ void Mesh::LoadOBJFile(const string& _fileName) {
 			newMeshData.AddFace(face.mIndices[0], face.mIndices[1], face.mIndices[2]);
 		}
 
-		model->meshes.push_back(newMeshData);
+		_model.meshes.push_back(newMeshData);
 	}
 }
 
-void Mesh::LoadFBXFile(const string& _fileName) {
+void Mesh::LoadFBXFile(const string& _fileName, IndexedModel& _model) {
 	// Create a new FBX File
 	FBXFile* fbxFile = new FBXFile();
 	
 	// Load the FBX file
 	fbxFile->load(_fileName.c_str());
+	ReadFBXFile(fbxFile, _model);
+	ReadFBXMaterials(fbxFile, _model);
+}
 
+void Mesh::ReadFBXFile(FBXFile* _fbxFile, IndexedModel& _model) {
 	// Get the Skeletons from file
-	unsigned int skeletonCount = fbxFile->getSkeletonCount();
+	unsigned int skeletonCount = _fbxFile->getSkeletonCount();
 	for (unsigned int skeleIndex = 0; skeleIndex < skeletonCount; ++skeleIndex) {
-		FBXSkeleton* currentSkeleton = fbxFile->getSkeletonByIndex(skeleIndex);
-		model->AddSkeleton(currentSkeleton);
+		FBXSkeleton* currentSkeleton = _fbxFile->getSkeletonByIndex(skeleIndex);
+		_model.AddSkeleton(currentSkeleton);
 	}
 
 	// Get the Animations from file
-	unsigned int animationCount = fbxFile->getAnimationCount();
+	unsigned int animationCount = _fbxFile->getAnimationCount();
 	for (unsigned int animIndex = 0; animIndex < animationCount; ++animIndex) {
-		FBXAnimation* currentAnimation = fbxFile->getAnimationByIndex(animIndex);
-		model->AddAnimation(currentAnimation);
+		FBXAnimation* currentAnimation = _fbxFile->getAnimationByIndex(animIndex);
+		_model.AddAnimation(currentAnimation);
 	}
 
 	// Get number of meshes in FBX file
-	unsigned int meshCount = fbxFile->getMeshCount();
+	unsigned int meshCount = _fbxFile->getMeshCount();
 
 	// Loop through all meshes in fbx file
 	for (unsigned int meshIndex = 0; meshIndex < meshCount; ++meshIndex) {
-		FBXMeshNode* currentMesh = fbxFile->getMeshByIndex(meshIndex);
+		FBXMeshNode* currentMesh = _fbxFile->getMeshByIndex(meshIndex);
 
 		MeshData newMeshData;
 		for (unsigned int i = 0; i < currentMesh->m_vertices.size(); ++i) {
@@ -457,6 +631,16 @@ void Mesh::LoadFBXFile(const string& _fileName) {
 			newMeshData.AddIndices(currentMesh->m_indices[i]); 
 		}
 
+		_model.meshes.push_back(newMeshData);
+	}
+}
+
+void Mesh::ReadFBXMaterials(FBXFile* _fbxFile, IndexedModel& _model) {
+	// One material per mesh, in the order ReadFBXFile added the meshes
+	unsigned int meshCount = _fbxFile->getMeshCount();
+	for (unsigned int meshIndex = 0; meshIndex < meshCount; ++meshIndex) {
+		FBXMeshNode* currentMesh = _fbxFile->getMeshByIndex(meshIndex);
+
 		Texture diffuse = CreateFBXTexture(currentMesh->m_material->textures[FBXMaterial::DiffuseTexture]);
 		Texture normal = CreateFBXTexture(currentMesh->m_material->textures[FBXMaterial::NormalTexture]);
 		Texture specular = CreateFBXTexture(currentMesh->m_material->textures[FBXMaterial::SpecularTexture]);
@@ -470,8 +654,7 @@ void Mesh::LoadFBXFile(const string& _fileName) {
 		}
 
 		Material newMeshMaterial(currentMesh->m_material->name, diffuse, specular, 0, 20.0f, normal);
-		model->materials.push_back(newMeshMaterial);
-		model->meshes.push_back(newMeshData);
+		_model.materials.push_back(newMeshMaterial);
 	}
 }
 
@@ -535,35 +718,72 @@ void Mesh::UpdateAllBones() {
 	}
 }
 
-void Mesh::DrawGizmosBones() {
-	for (unsigned int skeleIndex = 0; skeleIndex < model->skeletons.size(); ++skeleIndex) {
-		FBXSkeleton& skele = *model->skeletons[skeleIndex];
-
-		// Loop through all bones
-		for (unsigned int boneIndex = 0; boneIndex < skele.m_boneCount; ++boneIndex) {
-			FBXNode* node = skele.m_nodes[boneIndex];
-			FBXNode* parentNode = node->m_parent;
-
-			node->updateGlobalTransform();
-
-			mat4& nodeGlobal = node->m_globalTransform;
-			vec3 nodePos = nodeGlobal[3].xyz;
-
-			Gizmos::AddAABBFilled(nodePos, vec3(3.0f), vec4(1, 0, 0, 1), &nodeGlobal);
-
-			if (parentNode != nullptr) {
-				vec3 parentPos = parentNode->m_globalTransform[3].xyz;
-				Gizmos::AddLine(nodePos, parentPos, vec4(0, 1, 0, 1));
-			}
-		}
-	}
-}
-
 void Mesh::Shutdown() {
+	// Uploads still queued would write into deleted models
+	AssetLoader::Flush();
+	std::lock_guard<std::mutex> lock(sm_resourceMutex);
 	// Delete all resources
 	for (auto resource : sm_resourceMap) {
 		delete resource.second;
 	}
 	// Clear the map
 	sm_resourceMap.clear();
+	sm_placeholder = nullptr;
+}
+
+// Private
+void Mesh::LoadAsync(const string& _fullDir, const string& _fileExtension) {
+	IndexedModel* target = model;
+	target->isLoaded = false;
+
+	// The worker imports into its own model, the renderer may read the target meanwhile
+	std::shared_ptr<IndexedModel> imported = std::make_shared<IndexedModel>();
+	std::shared_ptr<CookedMesh> cookedMesh = std::make_shared<CookedMesh>();
+
+	if (_fileExtension == ".obj" || _fileExtension == ".OBJ") {
+		AssetLoader::Load([imported, cookedMesh, _fullDir]() {
+			if (!cookedMesh->Open(_fullDir, OBJ_IMPORT_FLAGS)) {
+				// Cook the file on the worker, then read it back like a cached one
+				LoadOBJFile(_fullDir, *imported);
+				imported->CalculateBounds();
+				imported->Finalize();
+				imported->Optimize();
+				if (!CookedMesh::Save(_fullDir, OBJ_IMPORT_FLAGS, *imported, imported->bounds) ||
+					!cookedMesh->Open(_fullDir, OBJ_IMPORT_FLAGS)) {
+					return;
+				}
+				imported->meshes.clear();
+			}
+			cookedMesh->Read(*imported, imported->bounds);
+		}, [imported, cookedMesh, target]() {
+			target->meshes.swap(imported->meshes);
+			target->bounds = imported->bounds;
+			if (cookedMesh->IsOpen()) {
+				cookedMesh->Upload(*target);
+			} else {
+				target->Init();
+			}
+			target->isLoaded = true;
+		});
+	} else if (_fileExtension == ".fbx" || _fileExtension == ".FBX") {
+		// Note(Manny): FBX materials create textures, so only they wait for the main thread
+		FBXFile* file = new FBXFile();
+		AssetLoader::Load([file, imported, _fullDir]() {
+			file->load(_fullDir.c_str());
+			ReadFBXFile(file, *imported);
+			imported->CalculateBounds();
+			imported->Finalize();
+			imported->Optimize();
+		}, [file, imported, target]() {
+			target->meshes.swap(imported->meshes);
+			target->skeletons.swap(imported->skeletons);
+			target->animations.swap(imported->animations);
+			target->bounds = imported->bounds;
+			ReadFBXMaterials(file, *target);
+			target->Init();
+			target->isLoaded = true;
+		});
+	} else {
+		target->isLoaded = true;
+	}
 }
\ No newline at end of file
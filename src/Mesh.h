@@ -21,9 +21,13 @@ multiple triangle arrays.
 
 // Structs
 #include "Vertex.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Animation.h"
 #include "Bounds.h"
 #include "Texture.h"
 #include "Material.h"
+#include "TriangleTree.h"
 
 // Other
 #include <FBXFile.h>
@@ -34,6 +38,9 @@ using std::vector;
 #include <map>
 using std::map;
 using std::pair;
+#include <mutex>
+#include <memory>
+#include <atomic>
 
 // Forward declaration
 class RenderingEngine;
@@ -41,7 +48,7 @@ class RenderingEngine;
 class MeshData
 {
 public:
-	MeshData(){}
+	MeshData() : glData() {}
 	~MeshData();
 	void AddVertex(const vec3& _vert);
 	void AddTexCoord(const vec2& _texCoord);
@@ -63,40 +70,65 @@ public:
 	vector<vec3> normals;
 	vector<vec3> tangents;
 	vector<GLuint> indices;
+	vector<GLuint> lodIndices; //Indices of every simplified LOD, back to back after indices
+	vector<MeshLOD> lods; //lods[0] draws the full mesh
 	OpenGLData glData;
+	VertexCacheStats cacheStatsBefore; //Set when the optimizer ran on import
+	VertexCacheStats cacheStatsAfter;
 };
 
 class IndexedModel {
 public:
-	IndexedModel(){}
+	IndexedModel() : isLoaded(true) {}
 	virtual ~IndexedModel(){}
 	void Init();
 	void Draw(RenderingEngine& _renderer);
 	void Finalize();
+	void Optimize(); //Optimizes every submesh and builds its LODs in parallel, call after Finalize
+	unsigned int GetLODCount() const;
+	float GetLODError(unsigned int _lod) const; //Largest error of any submesh at that LOD
+	AnimationRig* GetRig(); //Built from the first skeleton on first use, null without skeletons
+	TriangleTree* GetTriangleTree(); //Built from every submesh on first use, null without triangles
 	void AddSkeleton(FBXSkeleton* _skeleton);
 	void AddAnimation(FBXAnimation* _animation);
+	Bounds CalculateBounds();
+	VertexLayout ChooseLayout(const MeshData& _mesh) const;
+	// Packs the mesh into an interleaved vertex blob and an index blob, returns the index type
+	GLenum PackVertices(const MeshData& _mesh, const VertexLayout& _layout,
+		vector<unsigned char>& _vertexData, vector<unsigned char>& _indexData) const;
+	static void Upload(MeshData& _mesh, const VertexLayout& _layout,
+		const void* _vertexData, unsigned int _vertexBytes,
+		const void* _indexData, unsigned int _indexBytes, GLenum _indexType);
 
 	vector<FBXSkeleton*> skeletons;
 	vector<FBXAnimation*> animations;
+	std::shared_ptr<AnimationRig> rig;
+	std::shared_ptr<TriangleTree> triangleTree; //Rest pose triangles in model space
 	vector<MeshData> meshes;
 	vector<Material> materials;
+	Bounds bounds;
+	std::atomic<bool> isLoaded; //False while an async load is still in flight, only the main thread sets it
+private:
+	static const float MAX_HALF_TEXCOORD; //Larger coordinates lose too much precision as halfs
 };
 
 struct FBXTexture;
 class Mesh {
 public:
-	Mesh(const string& _fileName = "cube.obj", bool _useDefaultDir = true);
+	Mesh(const string& _fileName = "cube.obj", bool _useDefaultDir = true, bool _loadAsync = false);
 	Mesh(const string& _fileName, const Shader& _shader, bool _useDefaultDir = true);
 	virtual ~Mesh();
-	void Init(const string& _fileName, bool _useDefaultDir);
+	void Init(const string& _fileName, bool _useDefaultDir, bool _loadAsync = false);
 	void Draw(RenderingEngine& _renderer);
 	void Inspector();
-	void LoadOBJFile(const string& _fileName);
-	void LoadFBXFile(const string& _fileName);
-	Texture CreateFBXTexture(FBXTexture* _fbxTexture);
+	IndexedModel* GetModel() const; //The placeholder until the model has loaded
+	static void LoadOBJFile(const string& _fileName, IndexedModel& _model);
+	static void LoadFBXFile(const string& _fileName, IndexedModel& _model);
+	static void ReadFBXFile(FBXFile* _fbxFile, IndexedModel& _model); //Geometry and animation only, safe on a worker
+	static void ReadFBXMaterials(FBXFile* _fbxFile, IndexedModel& _model); //Creates textures, main thread only
+	static Texture CreateFBXTexture(FBXTexture* _fbxTexture);
 	Bounds CalculateMeshBounds();
 	void UpdateAllBones();
-	void DrawGizmosBones();
 	static void Shutdown();
 
 	Shader shader;
@@ -104,8 +136,15 @@ public:
 	string fileName;
 	bool loadFBXTextures;
 	IndexedModel* model;
+
+	static const string PLACEHOLDER_MESH;
+	static const unsigned int OBJ_IMPORT_FLAGS; //Cooked OBJ files are only reused when they were imported with these
 private:
+	void LoadAsync(const string& _fullDir, const string& _fileExtension);
+
 	static map<string, IndexedModel*> sm_resourceMap;
+	static std::mutex sm_resourceMutex; //Guards the map, workers may look models up
+	static IndexedModel* sm_placeholder;
 };
 
 
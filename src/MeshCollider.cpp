@@ -55,7 +55,19 @@ bool MeshCollider::Update() {
 }
 
 bool MeshCollider::Raycast(Ray _ray, RaycastHit& _hitInfo, float _maxDistance) {
-	return false;
+	if (meshObject == nullptr || !meshObject->model->isLoaded) {
+		return false;
+	}
+	TriangleTree* triangleTree = meshObject->model->GetTriangleTree();
+	TriangleHit hit;
+	if (triangleTree == nullptr || !triangleTree->Raycast(_ray, transform->worldMatrix, _maxDistance, hit)) {
+		return false;
+	}
+	_hitInfo.collider = this;
+	_hitInfo.transform = transform;
+	_hitInfo.distance = hit.distance;
+	_hitInfo.point = _ray.GetPoint(hit.distance);
+	return true;
 }
 
 void MeshCollider::Inspector() {
@@ -0,0 +1,308 @@
+#include "MeshOptimizer.h"
+
+// Structs
+#include "Mesh.h"
+
+// Other
+#include <algorithm>
+#include <cstring>
+
+// Copies the vertices of _source into a new array in the order of _order
+template<typename T>
+static void RemapVertices(vector<T>& _source, const vector<unsigned int>& _order) {
+	if (_source.empty()) {
+		return;
+	}
+	vector<T> remapped(_order.size());
+	for (unsigned int i = 0; i < _order.size(); ++i) {
+		remapped[i] = _source[_order[i]];
+	}
+	_source.swap(remapped);
+}
+
+template<typename T>
+static bool VerticesEqual(const vector<T>& _source, unsigned int _a, unsigned int _b) {
+	return _source.empty() || memcmp(&_source[_a], &_source[_b], sizeof(T)) == 0;
+}
+
+template<typename T>
+static unsigned int HashVertex(const vector<T>& _source, unsigned int _index, unsigned int _hash) {
+	if (_source.empty()) {
+		return _hash;
+	}
+	// FNV-1a over the raw attribute bytes
+	const unsigned char* bytes = (const unsigned char*)&_source[_index];
+	for (unsigned int i = 0; i < sizeof(T); ++i) {
+		_hash = (_hash ^ bytes[i]) * 16777619u;
+	}
+	return _hash;
+}
+
+static bool VerticesEqual(const MeshData& _mesh, unsigned int _a, unsigned int _b) {
+	return VerticesEqual(_mesh.positions, _a, _b) &&
+		VerticesEqual(_mesh.texCoords, _a, _b) &&
+		VerticesEqual(_mesh.boneIndices, _a, _b) &&
+		VerticesEqual(_mesh.boneWeights, _a, _b) &&
+		VerticesEqual(_mesh.normals, _a, _b) &&
+		VerticesEqual(_mesh.tangents, _a, _b);
+}
+
+static unsigned int HashVertex(const MeshData& _mesh, unsigned int _index) {
+	unsigned int hash = 2166136261u;
+	hash = HashVertex(_mesh.positions, _index, hash);
+	hash = HashVertex(_mesh.texCoords, _index, hash);
+	hash = HashVertex(_mesh.boneIndices, _index, hash);
+	hash = HashVertex(_mesh.boneWeights, _index, hash);
+	hash = HashVertex(_mesh.normals, _index, hash);
+	hash = HashVertex(_mesh.tangents, _index, hash);
+	return hash;
+}
+
+static void RemapVertices(MeshData& _mesh, const vector<unsigned int>& _order) {
+	RemapVertices(_mesh.positions, _order);
+	RemapVertices(_mesh.texCoords, _order);
+	RemapVertices(_mesh.boneIndices, _order);
+	RemapVertices(_mesh.boneWeights, _order);
+	RemapVertices(_mesh.normals, _order);
+	RemapVertices(_mesh.tangents, _order);
+}
+
+// Static
+void MeshOptimizer::Optimize(MeshData& _mesh) {
+	if (_mesh.indices.size() < 3 || _mesh.indices.size() % 3 != 0 || !_mesh.IsValid()) {
+		return;
+	}
+	_mesh.cacheStatsBefore = AnalyzeVertexCache(_mesh.indices, _mesh.positions.size());
+
+	WeldVertices(_mesh);
+	vector<unsigned int> clusters;
+	OptimizeVertexCache(_mesh.indices, _mesh.positions.size(), clusters);
+	OptimizeOverdraw(_mesh.indices, _mesh.positions, clusters);
+	OptimizeVertexFetch(_mesh);
+
+	_mesh.cacheStatsAfter = AnalyzeVertexCache(_mesh.indices, _mesh.positions.size());
+}
+unsigned int MeshOptimizer::WeldVertices(MeshData& _mesh) {
+	unsigned int vertexCount = _mesh.positions.size();
+
+	// Open addressing table of vertex indices, kept at most half full
+	unsigned int tableSize = 1;
+	while (tableSize < vertexCount * 2) {
+		tableSize <<= 1;
+	}
+	vector<unsigned int> table(tableSize, ~0u);
+	vector<unsigned int> remap(vertexCount);
+	vector<unsigned int> order;
+	order.reserve(vertexCount);
+
+	for (unsigned int i = 0; i < vertexCount; ++i) {
+		unsigned int slot = HashVertex(_mesh, i) & (tableSize - 1);
+		while (table[slot] != ~0u && !VerticesEqual(_mesh, order[table[slot]], i)) {
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		if (table[slot] == ~0u) {
+			table[slot] = order.size();
+			order.push_back(i);
+		}
+		remap[i] = table[slot];
+	}
+
+	unsigned int removed = vertexCount - order.size();
+	if (removed > 0) {
+		RemapVertices(_mesh, order);
+		for (unsigned int i = 0; i < _mesh.indices.size(); ++i) {
+			_mesh.indices[i] = remap[_mesh.indices[i]];
+		}
+	}
+	return removed;
+}
+void MeshOptimizer::OptimizeVertexCache(vector<GLuint>& _indices, unsigned int _vertexCount,
+	vector<unsigned int>& _clusters) {
+	unsigned int triangleCount = _indices.size() / 3;
+	_clusters.clear();
+
+	// Triangles around every vertex
+	vector<unsigned int> liveCount(_vertexCount, 0);
+	for (unsigned int i = 0; i < _indices.size(); ++i) {
+		liveCount[_indices[i]]++;
+	}
+	vector<unsigned int> adjacencyOffset(_vertexCount + 1, 0);
+	for (unsigned int i = 0; i < _vertexCount; ++i) {
+		adjacencyOffset[i + 1] = adjacencyOffset[i] + liveCount[i];
+	}
+	vector<unsigned int> adjacency(_indices.size());
+	vector<unsigned int> adjacencyFill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+	for (unsigned int i = 0; i < _indices.size(); ++i) {
+		adjacency[adjacencyFill[_indices[i]]++] = i / 3;
+	}
+
+	vector<unsigned int> cacheTime(_vertexCount, 0);
+	vector<bool> emitted(triangleCount, false);
+	vector<unsigned int> deadEnds;
+	vector<unsigned int> candidates;
+	vector<GLuint> output;
+	output.reserve(_indices.size());
+
+	unsigned int time = CACHE_SIZE + 1;
+	unsigned int cursor = 0;
+	int fanning = _vertexCount > 0 ? 0 : -1;
+	bool coldStart = true;
+
+	while (fanning >= 0) {
+		candidates.clear();
+		for (unsigned int i = adjacencyOffset[fanning]; i < adjacencyOffset[fanning + 1]; ++i) {
+			unsigned int triangle = adjacency[i];
+			if (emitted[triangle]) {
+				continue;
+			}
+			if (coldStart) {
+				_clusters.push_back(output.size() / 3);
+				coldStart = false;
+			}
+			for (unsigned int j = 0; j < 3; ++j) {
+				unsigned int vertex = _indices[triangle * 3 + j];
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveCount[vertex]--;
+				if (time - cacheTime[vertex] > CACHE_SIZE) {
+					cacheTime[vertex] = time++;
+				}
+			}
+			emitted[triangle] = true;
+		}
+
+		// Prefer the candidate that is still in the cache and will stay
+		// there while its remaining triangles are emitted
+		int next = -1;
+		int bestPriority = -1;
+		for (unsigned int i = 0; i < candidates.size(); ++i) {
+			unsigned int vertex = candidates[i];
+			if (liveCount[vertex] == 0) {
+				continue;
+			}
+			int priority = 0;
+			if (time - cacheTime[vertex] + 2 * liveCount[vertex] <= CACHE_SIZE) {
+				priority = time - cacheTime[vertex];
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				next = vertex;
+			}
+		}
+
+		if (next == -1) {
+			// Dead end, back track through recently used vertices first
+			while (!deadEnds.empty() && next == -1) {
+				unsigned int vertex = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveCount[vertex] > 0) {
+					next = vertex;
+				}
+			}
+			// Otherwise continue with the next unfinished vertex in input order
+			while (next == -1 && cursor < _vertexCount) {
+				if (liveCount[cursor] > 0) {
+					next = cursor;
+				}
+				cursor++;
+			}
+			coldStart = true;
+		}
+		fanning = next;
+	}
+
+	_indices.swap(output);
+}
+void MeshOptimizer::OptimizeOverdraw(vector<GLuint>& _indices, const vector<vec3>& _positions,
+	const vector<unsigned int>& _clusters) {
+	unsigned int triangleCount = _indices.size() / 3;
+	if (_clusters.size() < 2) {
+		return;
+	}
+
+	vec3 meshCentroid;
+	for (unsigned int i = 0; i < _indices.size(); ++i) {
+		meshCentroid += _positions[_indices[i]];
+	}
+	meshCentroid /= (float)_indices.size();
+
+	// Clusters facing away from the centre are on the outside of the mesh
+	vector<pair<float, unsigned int> > sortKeys(_clusters.size());
+	for (unsigned int i = 0; i < _clusters.size(); ++i) {
+		unsigned int end = i + 1 < _clusters.size() ? _clusters[i + 1] : triangleCount;
+		vec3 centroid;
+		vec3 normal;
+		for (unsigned int triangle = _clusters[i]; triangle < end; ++triangle) {
+			const vec3& a = _positions[_indices[triangle * 3 + 0]];
+			const vec3& b = _positions[_indices[triangle * 3 + 1]];
+			const vec3& c = _positions[_indices[triangle * 3 + 2]];
+			centroid += a + b + c;
+			normal += glm::cross(b - a, c - a);
+		}
+		centroid /= (float)((end - _clusters[i]) * 3);
+		float length = glm::length(normal);
+		float facing = length > 0.0f ? glm::dot(centroid - meshCentroid, normal / length) : 0.0f;
+		sortKeys[i] = pair<float, unsigned int>(-facing, i);
+	}
+	std::stable_sort(sortKeys.begin(), sortKeys.end());
+
+	vector<GLuint> output;
+	output.reserve(_indices.size());
+	for (unsigned int i = 0; i < sortKeys.size(); ++i) {
+		unsigned int cluster = sortKeys[i].second;
+		unsigned int end = cluster + 1 < _clusters.size() ? _clusters[cluster + 1] : triangleCount;
+		output.insert(output.end(), _indices.begin() + _clusters[cluster] * 3, _indices.begin() + end * 3);
+	}
+	_indices.swap(output);
+}
+void MeshOptimizer::OptimizeVertexFetch(MeshData& _mesh) {
+	unsigned int vertexCount = _mesh.positions.size();
+	vector<unsigned int> remap(vertexCount, ~0u);
+	vector<unsigned int> order;
+	order.reserve(vertexCount);
+
+	for (unsigned int i = 0; i < _mesh.indices.size(); ++i) {
+		GLuint& index = _mesh.indices[i];
+		if (remap[index] == ~0u) {
+			remap[index] = order.size();
+			order.push_back(index);
+		}
+		index = remap[index];
+	}
+	// Note(Manny): Unreferenced vertices are kept at the end
+	for (unsigned int i = 0; i < vertexCount; ++i) {
+		if (remap[i] == ~0u) {
+			remap[i] = order.size();
+			order.push_back(i);
+		}
+	}
+	RemapVertices(_mesh, order);
+}
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const vector<GLuint>& _indices,
+	unsigned int _vertexCount, unsigned int _cacheSize) {
+	VertexCacheStats stats;
+	if (_indices.empty() || _vertexCount == 0) {
+		return stats;
+	}
+
+	// A vertex is still cached while fewer than _cacheSize misses happened since it was added
+	vector<unsigned int> cachedAt(_vertexCount, 0);
+	vector<bool> used(_vertexCount, false);
+	unsigned int misses = 0;
+	unsigned int uniqueCount = 0;
+	for (unsigned int i = 0; i < _indices.size(); ++i) {
+		GLuint index = _indices[i];
+		if (!used[index]) {
+			used[index] = true;
+			uniqueCount++;
+		} else if (misses - cachedAt[index] < _cacheSize) {
+			continue;
+		}
+		cachedAt[index] = misses++;
+	}
+
+	stats.acmr = (float)misses / (float)(_indices.size() / 3);
+	stats.atvr = (float)misses / (float)uniqueCount;
+	return stats;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: MeshOptimizer.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: Welds duplicate vertices and reorders
+imported meshes so the GPU transforms fewer
+vertices and reads them in order.
+===============================================*/
+
+#ifndef _MESH_OPTIMIZER_H_
+#define _MESH_OPTIMIZER_H_
+
+// Utilities
+#include "GLM_Header.h"
+#include "GLFW_Header.h"
+
+// Other
+#include <vector>
+using std::vector;
+
+// Forward declaration
+class MeshData;
+
+struct VertexCacheStats {
+	VertexCacheStats() : acmr(0.0f), atvr(0.0f) {}
+	float acmr; //Vertices transformed per triangle, 3 is no reuse at all
+	float atvr; //Vertices transformed per unique vertex, 1 is ideal
+};
+
+class MeshOptimizer {
+public:
+	static const unsigned int CACHE_SIZE = 16; //Post-transform cache entries assumed
+
+	// Runs every step below and records the cache stats before and after
+	static void Optimize(MeshData& _mesh);
+	// Merges vertices whose attributes are identical, returns how many were removed
+	static unsigned int WeldVertices(MeshData& _mesh);
+	// Tipsify triangle order, fills _clusters with the first triangle of every run
+	// that starts from a cold cache
+	static void OptimizeVertexCache(vector<GLuint>& _indices, unsigned int _vertexCount,
+		vector<unsigned int>& _clusters);
+	// Draws the outward facing clusters first so that they occlude the rest
+	static void OptimizeOverdraw(vector<GLuint>& _indices, const vector<vec3>& _positions,
+		const vector<unsigned int>& _clusters);
+	// Renumbers vertices in the order the indices first use them
+	static void OptimizeVertexFetch(MeshData& _mesh);
+	// Simulates a FIFO post-transform cache of _cacheSize entries
+	static VertexCacheStats AnalyzeVertexCache(const vector<GLuint>& _indices,
+		unsigned int _vertexCount, unsigned int _cacheSize = CACHE_SIZE);
+};
+
+#endif // _MESH_OPTIMIZER_H_
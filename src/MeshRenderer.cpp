@@ -5,42 +5,50 @@
 
 // Components
 #include "BoxCollider.h"
+#include "ComponentPool.h"
+
+// Utilities
+#include "JobSystem.h"
+#include "SpatialIndex.h"
 
 // GUI
 #include "imgui.h"
 
+// Other
+#include <algorithm>
+#include <atomic>
+
+bool MeshRenderer::lodEnabled = true;
+float MeshRenderer::lodPixelError = 1.0f;
+float MeshRenderer::lodHysteresis = 0.25f;
+
 MeshRenderer::MeshRenderer(const Mesh& _mesh, 
 	const Material& _material, 
 	bool _wireframe, 
 	bool _depthTestEnabled) :
 	mesh(_mesh),
 	depthTestEnabled(_depthTestEnabled),
-	wireframe(_wireframe) {
+	wireframe(_wireframe),
+	lod(0),
+	m_meshLoaded(false),
+	m_boundsDirty(true) {
 	materials.push_back(_material);
+	drawCommandMesh.bones = nullptr;
+	drawCommandMesh.boneCount = 0;
+}
+MeshRenderer::~MeshRenderer() {
+	// The spatial index may still point at this renderer
+	SpatialIndex::Invalidate();
 }
 bool MeshRenderer::Startup() {
-	if (mesh.model->materials.size() > 0) {
-		materials = mesh.model->materials;
+	if (mesh.model->isLoaded) {
+		OnMeshLoaded();
 	}
-	BoxCollider* boxCollider = gameObject->GetComponent<BoxCollider>();
-	if (boxCollider != nullptr) {
-		Bounds meshBounds = mesh.bounds;
-		Bounds& colliderBounds = boxCollider->bounds;
-		colliderBounds = meshBounds;
-		colliderBounds.center = transform->position + meshBounds.center;
-		colliderBounds.size = transform->scale * meshBounds.size;
-		colliderBounds.min = colliderBounds.center - colliderBounds.size;
-		colliderBounds.max = colliderBounds.center + colliderBounds.size;
-	}
-
 	return true;
 }
 bool MeshRenderer::Update() { 
+	// Note(Manny): Bounds and LOD are updated in UpdateAll, straight after the hierarchy
 	if (transform && transform->isSelected)	{ Inspector(); }
-	bounds.center = transform->position + mesh.bounds.center;
-	bounds.size = transform->scale * mesh.bounds.size;
-	bounds.min = bounds.center - bounds.size;
-	bounds.max = bounds.center + bounds.size;
 	return true; 
 }
 void MeshRenderer::Inspector() {
@@ -49,6 +57,7 @@ void MeshRenderer::Inspector() {
 	if (ImGui::TreeNode("MeshRenderer")) {
 		mesh.Inspector();
 		ImGui::Checkbox("Wireframe", &wireframe);
+		ImGui::Text("LOD: %u", lod);
 		for (unsigned int i = 0; i < materials.size(); ++i) {
 			materials[i].Inspector();
 		}
@@ -61,8 +70,104 @@ void MeshRenderer::Draw(RenderingEngine& _renderer) {
 	drawCommandMesh.transform = transform;
 	drawCommandMesh.mesh = &mesh;
 	drawCommandMesh.materials = &materials;
+	drawCommandMesh.bounds = &bounds;
+	drawCommandMesh.lod = lod;
 	drawCommandMesh.wireframe = wireframe;
 	drawCommandMesh.depthTestEnabled = depthTestEnabled;
 	drawCommandMesh.camera = Camera::current;
 	_renderer.AddDrawCommandMesh(&drawCommandMesh);
+}
+void MeshRenderer::SelectLOD() {
+	unsigned int lodCount = mesh.GetModel()->GetLODCount();
+	Camera* camera = Camera::current;
+	if (!lodEnabled || lodCount == 1 || camera == nullptr || camera->orthographic) {
+		lod = 0;
+		return;
+	}
+
+	float distance = glm::length(bounds.center - camera->transform->position);
+	float radius = glm::length(bounds.size);
+	if (distance <= radius) {
+		lod = 0;
+		return;
+	}
+
+	// LOD errors are relative to the mesh radius, so scaling them by the
+	// projected radius gives the error in pixels
+	float pixels = radius / (distance * tanf(glm::radians(camera->fieldOfView) * 0.5f)) * Window::height * 0.5f;
+	const IndexedModel* model = mesh.GetModel();
+	float errors[MeshSimplifier::MAX_LODS];
+	lodCount = std::min(lodCount, MeshSimplifier::MAX_LODS);
+	for (unsigned int i = 0; i < lodCount; ++i) {
+		errors[i] = model->GetLODError(i);
+	}
+	lod = MeshSimplifier::SelectLOD(errors, lodCount, lod, pixels, lodPixelError, lodHysteresis);
+}
+
+// Static
+void MeshRenderer::UpdateAll() {
+	vector<MeshRenderer*>& renderers = ComponentPool<MeshRenderer>::Get().components;
+
+	// Taking the loaded materials and collider bounds only happens on this thread
+	for (unsigned int i = 0; i < renderers.size(); ++i) {
+		MeshRenderer* renderer = renderers[i];
+		if (!renderer->m_meshLoaded && renderer->mesh.model->isLoaded) {
+			renderer->OnMeshLoaded();
+		}
+	}
+
+	// Every renderer only writes its own bounds and LOD. Bounds are only
+	// recomputed for transforms the hierarchy rebuilt this frame
+	std::atomic<bool> moved(false);
+	JobSystem::ParallelFor(renderers.size(), BATCH_SIZE, [&renderers, &moved](unsigned int _begin, unsigned int _end) {
+		bool batchMoved = false;
+		for (unsigned int i = _begin; i < _end; ++i) {
+			MeshRenderer* renderer = renderers[i];
+			if (renderer->m_boundsDirty || renderer->transform->HasChanged()) {
+				renderer->UpdateBounds();
+				batchMoved = true;
+			}
+			renderer->SelectLOD();
+		}
+		if (batchMoved) {
+			moved = true;
+		}
+	});
+
+	// A still scene leaves the spatial index as it is, no refit needed
+	if (moved) {
+		SpatialIndex::Invalidate();
+	}
+}
+
+// Private
+void MeshRenderer::UpdateBounds() {
+	// Transform the mesh bounds into a world space box that encloses the 
+	// rotated mesh, so that culling never rejects a visible object
+	const mat4& worldMatrix = transform->worldMatrix;
+	glm::mat3 absRotationScale = glm::mat3(glm::abs(vec3(worldMatrix[0])), glm::abs(vec3(worldMatrix[1])), glm::abs(vec3(worldMatrix[2])));
+	bounds.center = vec3(worldMatrix * vec4(mesh.bounds.center, 1.0f));
+	bounds.size = absRotationScale * glm::abs(mesh.bounds.size);
+	bounds.min = bounds.center - bounds.size;
+	bounds.max = bounds.center + bounds.size;
+	m_boundsDirty = false;
+}
+void MeshRenderer::OnMeshLoaded() {
+	m_meshLoaded = true;
+	// Note(Manny): Async meshes report the placeholder's bounds until now
+	mesh.bounds = mesh.model->bounds;
+	m_boundsDirty = true;
+	if (mesh.model->materials.size() > 0) {
+		materials = mesh.model->materials;
+	}
+	BoxCollider* boxCollider = gameObject->GetComponent<BoxCollider>();
+	if (boxCollider != nullptr) {
+		Bounds meshBounds = mesh.bounds;
+		Bounds& colliderBounds = boxCollider->bounds;
+		colliderBounds = meshBounds;
+		colliderBounds.center = transform->position + meshBounds.center;
+		colliderBounds.size = transform->scale * meshBounds.size;
+		colliderBounds.min = colliderBounds.center - colliderBounds.size;
+		colliderBounds.max = colliderBounds.center + colliderBounds.size;
+	}
 }
\ No newline at end of file
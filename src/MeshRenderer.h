@@ -28,12 +28,16 @@ Copyright (c) 2015 Emmanuel Vaccaro
 class MeshRenderer : public Component {
 public:
 	MeshRenderer(const Mesh& _mesh, const Material& _material = Material(), bool _wireframe = false, bool _depthTestEnabled = true);
+	~MeshRenderer();
 	virtual bool Startup();
 	virtual void Shutdown(){}
 	virtual bool Update();
 	virtual void Draw(RenderingEngine& _renderer);
 	void Render();
 	void Inspector();
+	void SelectLOD(); //Picks the LOD from the bounds' projected size on screen
+
+	static void UpdateAll(); //Bounds and LOD of every renderer, once world matrices are up to date
 
 	vector<Material> materials;
 	Mesh mesh;
@@ -41,6 +45,19 @@ public:
 	Bounds bounds;
 	bool wireframe;
 	bool depthTestEnabled;
+	unsigned int lod; //Level of detail drawn this frame
+
+	static bool lodEnabled;
+	static float lodPixelError; //Largest error a LOD may show on screen, in pixels
+	static float lodHysteresis; //A coarser LOD needs this much margin, so LODs don't flicker
+private:
+	void OnMeshLoaded(); //Takes the materials and bounds of the loaded mesh
+	void UpdateBounds();
+
+	static const unsigned int BATCH_SIZE = 256; //Renderers updated per job
+
+	bool m_meshLoaded;
+	bool m_boundsDirty; //Mesh bounds changed since the world bounds were last computed
 };
 
 #endif // _MESH_RENDERER_H_
\ No newline at end of file
@@ -0,0 +1,368 @@
+#include "MeshSimplifier.h"
+
+// Structs
+#include "Mesh.h"
+
+// Utilities
+#include "MeshOptimizer.h"
+
+// Other
+#include <algorithm>
+#include <cfloat>
+
+float MeshSimplifier::lodRatios[MAX_LODS - 1] = { 0.5f, 0.25f, 0.125f };
+float MeshSimplifier::maxError = 0.05f;
+
+// Sum of squared distances to a set of planes, weighted by triangle area
+struct Quadric {
+	Quadric() : a00(0), a01(0), a02(0), a03(0), a11(0), a12(0), a13(0), a22(0), a23(0), a33(0), weight(0) {}
+	void AddPlane(const vec3& _normal, float _distance, float _weight) {
+		double x = _normal.x, y = _normal.y, z = _normal.z, w = _distance;
+		a00 += _weight * x * x; a01 += _weight * x * y; a02 += _weight * x * z; a03 += _weight * x * w;
+		a11 += _weight * y * y; a12 += _weight * y * z; a13 += _weight * y * w;
+		a22 += _weight * z * z; a23 += _weight * z * w;
+		a33 += _weight * w * w;
+		weight += _weight;
+	}
+	void Add(const Quadric& _other) {
+		a00 += _other.a00; a01 += _other.a01; a02 += _other.a02; a03 += _other.a03;
+		a11 += _other.a11; a12 += _other.a12; a13 += _other.a13;
+		a22 += _other.a22; a23 += _other.a23;
+		a33 += _other.a33;
+		weight += _other.weight;
+	}
+	double Evaluate(const vec3& _point) const {
+		double x = _point.x, y = _point.y, z = _point.z;
+		return a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+			a11 * y * y + 2 * a12 * y * z + 2 * a13 * y +
+			a22 * z * z + 2 * a23 * z +
+			a33;
+	}
+	double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+	double weight;
+};
+
+struct Collapse {
+	double cost;
+	unsigned int from;
+	unsigned int to;
+	unsigned int seamFrom; //The other copy of a seam vertex, moved along the seam with it
+	unsigned int seamTo;
+	bool onSeam;
+	inline bool operator<(const Collapse& _other) const { return cost < _other.cost; }
+};
+
+// An edge between two seam vertices as one triangle sees it, a is the end with the lower position
+struct SeamEdge {
+	unsigned int a;
+	unsigned int b;
+	unsigned long long key;
+	inline bool operator<(const SeamEdge& _other) const { return key < _other.key; }
+};
+
+// Static
+void MeshSimplifier::GenerateLODs(MeshData& _mesh) {
+	_mesh.lods.clear();
+	_mesh.lodIndices.clear();
+	MeshLOD full = { 0, _mesh.indices.size(), 0.0f };
+	_mesh.lods.push_back(full);
+	if (_mesh.indices.size() < 3 || _mesh.indices.size() % 3 != 0) {
+		return;
+	}
+
+	vec3 min = vec3(FLT_MAX);
+	vec3 max = vec3(-FLT_MAX);
+	for (unsigned int i = 0; i < _mesh.positions.size(); ++i) {
+		min = glm::min(min, _mesh.positions[i]);
+		max = glm::max(max, _mesh.positions[i]);
+	}
+	float radius = glm::length(max - min) * 0.5f;
+	if (radius <= 0.0f) {
+		return;
+	}
+
+	// Each LOD simplifies the one before it, errors add up along the chain
+	vector<GLuint> previous = _mesh.indices;
+	vector<GLuint> lodIndices;
+	vector<unsigned int> clusters;
+	float error = 0.0f;
+	for (unsigned int i = 0; i < MAX_LODS - 1; ++i) {
+		unsigned int target = (unsigned int)(_mesh.indices.size() / 3 * lodRatios[i]) * 3;
+		if (target >= previous.size()) {
+			continue;
+		}
+		float stepError = Simplify(previous, _mesh.positions, target, (maxError - error) * radius, lodIndices);
+
+		// Stop once the error bound keeps the LOD from getting noticeably smaller
+		if (lodIndices.size() == 0 || lodIndices.size() > previous.size() * 9 / 10) {
+			break;
+		}
+		MeshOptimizer::OptimizeVertexCache(lodIndices, _mesh.positions.size(), clusters);
+
+		error += stepError / radius;
+		MeshLOD lod = { _mesh.indices.size() + _mesh.lodIndices.size(), lodIndices.size(), error };
+		_mesh.lods.push_back(lod);
+		_mesh.lodIndices.insert(_mesh.lodIndices.end(), lodIndices.begin(), lodIndices.end());
+		previous.swap(lodIndices);
+	}
+}
+unsigned int MeshSimplifier::SelectLOD(const float* _errors, unsigned int _lodCount, unsigned int _currentLOD,
+	float _radiusPixels, float _pixelError, float _hysteresis) {
+	unsigned int lod = std::min(_currentLOD, _lodCount - 1);
+	while (lod > 0 && _errors[lod] * _radiusPixels > _pixelError) {
+		lod--;
+	}
+	while (lod + 1 < _lodCount && _errors[lod + 1] * _radiusPixels <= _pixelError * (1.0f - _hysteresis)) {
+		lod++;
+	}
+	return lod;
+}
+float MeshSimplifier::Simplify(const vector<GLuint>& _indices, const vector<vec3>& _positions,
+	unsigned int _targetIndexCount, float _maxError, vector<GLuint>& _result) {
+	unsigned int vertexCount = _positions.size();
+	_result = _indices;
+
+	// Vertices split by a UV seam or hard edge share a position, both copies
+	// of a seam vertex only ever move together along the seam so it stays closed
+	vector<unsigned int> sorted(vertexCount);
+	for (unsigned int i = 0; i < vertexCount; ++i) {
+		sorted[i] = i;
+	}
+	std::sort(sorted.begin(), sorted.end(), [&_positions](unsigned int _a, unsigned int _b) {
+		const vec3& a = _positions[_a];
+		const vec3& b = _positions[_b];
+		return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+	});
+	vector<unsigned int> position(vertexCount);
+	unsigned int positionCount = 0;
+	for (unsigned int i = 0; i < vertexCount; ++i) {
+		if (i > 0 && _positions[sorted[i]] != _positions[sorted[i - 1]]) {
+			positionCount++;
+		}
+		position[sorted[i]] = positionCount;
+	}
+	positionCount++;
+
+	vector<bool> used(vertexCount, false);
+	vector<unsigned int> splitCount(positionCount, 0);
+	for (unsigned int i = 0; i < _indices.size(); ++i) {
+		if (!used[_indices[i]]) {
+			used[_indices[i]] = true;
+			splitCount[position[_indices[i]]]++;
+		}
+	}
+
+	// Open borders and non-manifold edges are locked as well
+	vector<unsigned long long> edges;
+	edges.reserve(_indices.size());
+	for (unsigned int i = 0; i < _indices.size(); i += 3) {
+		for (unsigned int j = 0; j < 3; ++j) {
+			unsigned long long a = position[_indices[i + j]];
+			unsigned long long b = position[_indices[i + (j + 1) % 3]];
+			edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	vector<bool> locked(positionCount, false);
+	for (unsigned int i = 0; i < edges.size();) {
+		unsigned int end = i + 1;
+		while (end < edges.size() && edges[end] == edges[i]) {
+			end++;
+		}
+		if (end - i != 2) {
+			locked[(unsigned int)(edges[i] >> 32)] = true;
+			locked[(unsigned int)(edges[i] & 0xFFFFFFFF)] = true;
+		}
+		i = end;
+	}
+	// Note(Manny): Where seams meet there are more than two copies, those stay put
+	vector<bool> seam(positionCount, false);
+	for (unsigned int i = 0; i < positionCount; ++i) {
+		seam[i] = splitCount[i] == 2;
+		if (splitCount[i] > 2) {
+			locked[i] = true;
+		}
+	}
+
+	vector<Quadric> quadrics(positionCount);
+	for (unsigned int i = 0; i < _indices.size(); i += 3) {
+		const vec3& a = _positions[_indices[i + 0]];
+		const vec3& b = _positions[_indices[i + 1]];
+		const vec3& c = _positions[_indices[i + 2]];
+		vec3 normal = glm::cross(b - a, c - a);
+		float area = glm::length(normal);
+		if (area <= 0.0f) {
+			continue;
+		}
+		normal /= area;
+		Quadric plane;
+		plane.AddPlane(normal, -glm::dot(normal, a), area * 0.5f);
+		for (unsigned int j = 0; j < 3; ++j) {
+			quadrics[position[_indices[i + j]]].Add(plane);
+		}
+	}
+
+	double maxCost = (double)_maxError * _maxError;
+	double reachedCost = 0.0;
+	vector<unsigned int> adjacencyOffset(vertexCount + 1);
+	vector<unsigned int> adjacency;
+	vector<Collapse> collapses;
+	vector<unsigned int> remap(vertexCount);
+	vector<unsigned int> touched(vertexCount, 0);
+	vector<SeamEdge> seamEdges;
+	unsigned int pass = 0;
+
+	// Queues moving _from onto _to, costed with the quadrics of both ends
+	auto addCollapse = [&](unsigned int _from, unsigned int _to, unsigned int _seamFrom, unsigned int _seamTo, bool _onSeam) {
+		Quadric quadric = quadrics[position[_from]];
+		quadric.Add(quadrics[position[_to]]);
+		double cost = quadric.weight > 0 ? quadric.Evaluate(_positions[_to]) / quadric.weight : 0.0;
+		Collapse collapse = { cost, _from, _to, _seamFrom, _seamTo, _onSeam };
+		collapses.push_back(collapse);
+	};
+	// Counts the triangles around _from the collapse removes, false if it would flip any other
+	auto checkCollapse = [&](unsigned int _from, unsigned int _to, unsigned int& _collapsedTriangles) {
+		const vec3& target = _positions[_to];
+		for (unsigned int j = adjacencyOffset[_from]; j < adjacencyOffset[_from + 1]; ++j) {
+			const GLuint* triangle = &_result[adjacency[j] * 3];
+			vec3 corners[3];
+			vec3 moved[3];
+			bool sharesEdge = false;
+			for (unsigned int k = 0; k < 3; ++k) {
+				corners[k] = _positions[triangle[k]];
+				moved[k] = triangle[k] == _from ? target : corners[k];
+				sharesEdge |= position[triangle[k]] == position[_to];
+			}
+			if (sharesEdge) {
+				_collapsedTriangles++;
+				continue;
+			}
+			vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+			vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+			if (glm::dot(before, after) <= 0.0f) {
+				return false;
+			}
+		}
+		return true;
+	};
+	auto touch = [&](unsigned int _from) {
+		for (unsigned int j = adjacencyOffset[_from]; j < adjacencyOffset[_from + 1]; ++j) {
+			const GLuint* triangle = &_result[adjacency[j] * 3];
+			touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = pass;
+		}
+	};
+
+	while (_result.size() > _targetIndexCount) {
+		pass++;
+
+		// Triangles around every vertex
+		std::fill(adjacencyOffset.begin(), adjacencyOffset.end(), 0);
+		for (unsigned int i = 0; i < _result.size(); ++i) {
+			adjacencyOffset[_result[i] + 1]++;
+		}
+		for (unsigned int i = 0; i < vertexCount; ++i) {
+			adjacencyOffset[i + 1] += adjacencyOffset[i];
+		}
+		adjacency.resize(_result.size());
+		vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+		for (unsigned int i = 0; i < _result.size(); ++i) {
+			adjacency[fill[_result[i]]++] = i / 3;
+		}
+
+		// Every edge can collapse onto either end unless the moving end is locked or on a seam
+		collapses.clear();
+		seamEdges.clear();
+		for (unsigned int i = 0; i < _result.size(); i += 3) {
+			for (unsigned int j = 0; j < 3; ++j) {
+				unsigned int from = _result[i + j];
+				for (unsigned int k = 1; k < 3; ++k) {
+					unsigned int to = _result[i + (j + k) % 3];
+					if (locked[position[from]] || seam[position[from]] || position[from] == position[to]) {
+						continue;
+					}
+					addCollapse(from, to, from, to, false);
+				}
+
+				unsigned int to = _result[i + (j + 1) % 3];
+				if (seam[position[from]] && seam[position[to]] && !locked[position[from]] && !locked[position[to]]) {
+					SeamEdge edge = { position[from] < position[to] ? from : to, position[from] < position[to] ? to : from };
+					edge.key = ((unsigned long long)position[edge.a] << 32) | position[edge.b];
+					seamEdges.push_back(edge);
+				}
+			}
+		}
+
+		// A seam edge is listed by one triangle on each side, each with its own copies of
+		// both ends. Seam vertices collapse along it, taking their other copy with them
+		std::sort(seamEdges.begin(), seamEdges.end());
+		for (unsigned int i = 0; i < seamEdges.size();) {
+			unsigned int end = i + 1;
+			while (end < seamEdges.size() && seamEdges[end].key == seamEdges[i].key) {
+				end++;
+			}
+			const SeamEdge& first = seamEdges[i];
+			const SeamEdge& second = seamEdges[end - 1];
+			if (end - i == 2 && first.a != second.a && first.b != second.b) {
+				addCollapse(first.a, first.b, second.a, second.b, true);
+				addCollapse(first.b, first.a, second.b, second.a, true);
+			}
+			i = end;
+		}
+		std::sort(collapses.begin(), collapses.end());
+
+		for (unsigned int i = 0; i < vertexCount; ++i) {
+			remap[i] = i;
+		}
+
+		// Take the cheapest collapses that don't share a triangle this pass
+		unsigned int trianglesToRemove = (_result.size() - _targetIndexCount + 2) / 3;
+		unsigned int removed = 0;
+		for (unsigned int i = 0; i < collapses.size() && removed < trianglesToRemove; ++i) {
+			const Collapse& collapse = collapses[i];
+			if (collapse.cost > maxCost) {
+				break;
+			}
+			if (touched[collapse.from] == pass || touched[collapse.to] == pass ||
+				touched[collapse.seamFrom] == pass || touched[collapse.seamTo] == pass) {
+				continue;
+			}
+
+			// Reject collapses that would flip a remaining triangle
+			unsigned int collapsedTriangles = 0;
+			if (!checkCollapse(collapse.from, collapse.to, collapsedTriangles) ||
+				(collapse.onSeam && !checkCollapse(collapse.seamFrom, collapse.seamTo, collapsedTriangles))) {
+				continue;
+			}
+
+			remap[collapse.from] = collapse.to;
+			remap[collapse.seamFrom] = collapse.seamTo;
+			quadrics[position[collapse.to]].Add(quadrics[position[collapse.from]]);
+			reachedCost = std::max(reachedCost, collapse.cost);
+			removed += collapsedTriangles;
+			touch(collapse.from);
+			if (collapse.onSeam) {
+				touch(collapse.seamFrom);
+			}
+		}
+		if (removed == 0) {
+			break;
+		}
+
+		// Drop the triangles that collapsed to a line
+		unsigned int writeIndex = 0;
+		for (unsigned int i = 0; i < _result.size(); i += 3) {
+			GLuint a = remap[_result[i + 0]];
+			GLuint b = remap[_result[i + 1]];
+			GLuint c = remap[_result[i + 2]];
+			if (position[a] == position[b] || position[b] == position[c] || position[c] == position[a]) {
+				continue;
+			}
+			_result[writeIndex++] = a;
+			_result[writeIndex++] = b;
+			_result[writeIndex++] = c;
+		}
+		_result.resize(writeIndex);
+	}
+
+	return (float)sqrt(reachedCost);
+}
\ No newline at end of file
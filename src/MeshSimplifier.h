@@ -0,0 +1,46 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: MeshSimplifier.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: Builds the lower levels of detail of a
+mesh by collapsing the edges that change its
+shape the least, measured with quadrics.
+===============================================*/
+
+#ifndef _MESH_SIMPLIFIER_H_
+#define _MESH_SIMPLIFIER_H_
+
+// Utilities
+#include "GLM_Header.h"
+#include "GLFW_Header.h"
+
+// Other
+#include <vector>
+using std::vector;
+
+// Forward declaration
+class MeshData;
+
+class MeshSimplifier {
+public:
+	static const unsigned int MAX_LODS = 4; //Including the full mesh
+
+	// Fills the mesh's LOD list, each LOD only draws a subset of the full mesh's vertices
+	static void GenerateLODs(MeshData& _mesh);
+	// Collapses edges until _result holds at most _targetIndexCount indices or the next
+	// collapse would move the surface further than _maxError, returns the error reached
+	static float Simplify(const vector<GLuint>& _indices, const vector<vec3>& _positions,
+		unsigned int _targetIndexCount, float _maxError, vector<GLuint>& _result);
+	// Coarsest LOD whose error, scaled by the mesh radius on screen in pixels, stays within
+	// _pixelError. Moving to a coarser LOD takes _hysteresis of margin so LODs don't flicker
+	static unsigned int SelectLOD(const float* _errors, unsigned int _lodCount, unsigned int _currentLOD,
+		float _radiusPixels, float _pixelError, float _hysteresis);
+
+	static float lodRatios[MAX_LODS - 1]; //Triangles kept by each LOD, relative to the full mesh
+	static float maxError; //Furthest a LOD may deviate, relative to the mesh radius
+};
+
+#endif // _MESH_SIMPLIFIER_H_
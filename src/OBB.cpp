@@ -1,605 +1,343 @@
 #include "OBB.h"
 
-OBB::OBB(){}
-OBB::~OBB(){}
-void OBB::SetFrom(const Bounds& _bounds, const Transform& _transform) {
-	local = _transform;
-	e = _bounds.size; //Obtain half-size
+// Components
+#include "Transform.h"
+
+// Other
+#include <cfloat>
+
+// Note(Manny): Edge axes only win when clearly better than a face axis, so
+// resting boxes keep the stable face contacts even when an edge ties
+static const float EDGE_RELATIVE_TOLERANCE = 0.95f;
+static const float EDGE_ABSOLUTE_TOLERANCE = 0.01f;
+static const float PARALLEL_TOLERANCE = 1.0e-6f;
+static const unsigned char EDGE_FEATURE = 0xFF; //Marks the single contact of two crossing edges
+
+// Half the length of the box's shadow on the axis
+static float GetRadius(const OBB& _box, const vec3& _axis) {
+	return _box.e.x * glm::abs(glm::dot(_box.axes[0], _axis)) +
+		_box.e.y * glm::abs(glm::dot(_box.axes[1], _axis)) +
+		_box.e.z * glm::abs(glm::dot(_box.axes[2], _axis));
 }
-
-bool OBB::Intersects(const OBB& _obb, Manifold* _manifold) {
-	Transform atx = this->local;
-	Transform btx = _obb.local;
-	glm::mat3 atxRotation = glm::toMat3(atx.rotation);
-	glm::mat3 btxRotation = glm::toMat3(btx.rotation);
-	vec3 eA = this->e;
-	vec3 eB = _obb.e;
-
-	glm::mat3 C = atxRotation * btxRotation;
-
-	// Generate a rotation matrix that transfroms from world space to this OBB's coordinate space
-	glm::mat3 absC;
-	bool parallel = false;
-	const float kCosTol = float(1.0e-6);
+// The point on the edge parallel to _axis that lies furthest along _direction
+static vec3 GetSupportEdge(const OBB& _box, int _axis, const vec3& _direction, vec3* _edge) {
+	vec3 point = _box.center;
 	for (int i = 0; i < 3; ++i) {
-		for (int j = 0; j < 3; ++j) {
-			float val = glm::abs(C[i][j]);
-			absC[i][j] = val;
-
-			if (val + kCosTol >= 1.0f) {
-				parallel = true;
-			}
+		if (i != _axis) {
+			point += _box.axes[i] * (glm::dot(_direction, _box.axes[i]) >= 0.0f ? _box.e[i] : -_box.e[i]);
 		}
 	}
+	*_edge = _box.axes[_axis] * _box.e[_axis];
+	return point;
+}
 
-	vec3 t = C * (btx.position - atx.position);
-	float s;
-	float aMax = -FLT_MAX;
-	float bMax = -FLT_MAX;
-	float eMax = -FLT_MAX;
-	int aAxis = -1;
-	int bAxis = -1;
-	int eAxis = -1;
-	vec3 nA;
-	vec3 nB;
-	vec3 nE;
-
-	// Test the three major axis of this OBB
+OBB::OBB() : center(vec3(0)), e(vec3(0)) {}
+OBB::~OBB(){}
+void OBB::Set(const vec3& _center, const quat& _rotation, const vec3& _halfSize) {
+	center = _center;
+	axes = glm::toMat3(_rotation);
+	e = _halfSize;
+}
+void OBB::SetFrom(const Bounds& _bounds, const Transform& _transform) {
+	Set(_transform.position, _transform.rotation, _bounds.size); //Obtain half-size
+}
+bool OBB::Intersects(const OBB& _obb, Manifold* _manifold, float _margin) const {
+	_manifold->contactCount = 0;
+	vec3 delta = _obb.center - center;
+
+	// Face axes of this box are 0-2, of the other box 3-5 and their edge pairs 6-14
+	float aMax = -FLT_MAX, bMax = -FLT_MAX, edgeMax = -FLT_MAX;
+	int aAxis = -1, bAxis = -1, edgeAxis = -1;
+	vec3 edgeNormal;
 	for (int i = 0; i < 3; ++i) {
-		s = glm::abs(t[i]) - (eA[i] + glm::dot(absC[i], eB));
-		if (TrackFaceAxis(&aAxis, i, s, &aMax, atxRotation[i], &nA)) {
+		float separation = glm::abs(glm::dot(delta, axes[i])) - e[i] - GetRadius(_obb, axes[i]);
+		if (TrackAxis(i, separation, _margin, &aMax, &aAxis)) {
 			return false;
 		}
 	}
-
-	// Test the three major axis of the OBB _obb
 	for (int i = 0; i < 3; ++i) {
-		s = glm::abs(glm::dot(t, absC[i])) - (eB[i] + glm::dot(absC[i], eA));
-		if (TrackFaceAxis(&bAxis, i + 3, s, &bMax, btxRotation[i], &nB)) {
+		float separation = glm::abs(glm::dot(delta, _obb.axes[i])) - _obb.e[i] - GetRadius(*this, _obb.axes[i]);
+		if (TrackAxis(i + 3, separation, _margin, &bMax, &bAxis)) {
 			return false;
 		}
 	}
-
-	if (!parallel) {
-		float Ra;
-		float Rb;
-		// A.x <cross> _obb.x
-		Ra = eA.y *	absC[2][0] + eA.z * absC[1][0];
-		Rb = eB.y * absC[0][2] + eB.z * absC[0][1];
-		s = glm::abs(t.z * C[1][0] - t.y * C[2][0]) - (Ra + Rb);
-		if (TrackEdgeAxis(&eAxis, 6, s, &eMax, vec3(0.0f, -C[2][0], C[1][0]), &nE)) {
-			return false;
-		}
-		// A.x < cross> _obb.y
-		Ra = eA.y *	absC[2][1] + eA.z * absC[1][1];
-		Rb = eB.x * absC[0][2] + eB.z * absC[0][0];
-		s = glm::abs(t.z * C[1][1] - t.y * C[2][1]) - (Ra + Rb);
-		if (TrackEdgeAxis(&eAxis, 7, s, &eMax, vec3(0.0f, -C[2][1], C[1][1]), &nE)) {
-			return false;
-		}
-		// A.x <ceAoss> _obb.z
-		Ra = eA.y *	absC[2][2] + eA.z * absC[1][2];
-		Rb = eB.x * absC[0][1] + eB.y * absC[0][0];
-		s = glm::abs(t.z * C[1][2] - t.y * C[2][2]) - (Ra + Rb);
-		if (TrackEdgeAxis(&eAxis, 8, s, &eMax, vec3(0.0f, -C[2][2], C[1][2]), &nE)) {
-			return false;
-		}
-		// A.y <cross> _obb.x
-		Ra = eA.x * absC[2][0] + eA.z * absC[0][0];
-		Rb = eB.y * absC[1][2] + eB.z * absC[1][1];
-		s = glm::abs(t.x * C[2][0] - t.z * C[0][0]) - (Ra + Rb);
-		if (TrackEdgeAxis(&eAxis, 9, s, &eMax, vec3(C[2][0], 0.0f, -C[0][0]), &nE)) {
-			return false;
-		}
-		// A.y <cross> _obb.y
-		Ra = eA.x *	absC[2][1] + eA.z * absC[0][1];
-		Rb = eB.x * absC[1][2] + eB.z * absC[1][0];
-		s = glm::abs(t.x * C[2][1] - t.z * C[0][1]) - (Ra + Rb);
-		if (TrackEdgeAxis(&eAxis, 10, s, &eMax, vec3(C[2][1], 0.0f, -C[0][1]), &nE)) {
-			return false;
-		}
-		// A.y <cross> _obb.z
-		Ra = eA.x *	absC[2][2] + eA.z * absC[0][2];
-		Rb = eB.x * absC[1][1] + eB.y * absC[1][0];
-		s = glm::abs(t.x * C[2][2] - t.z * C[0][2]) - (Ra + Rb);
-		if (TrackEdgeAxis(&eAxis, 11, s, &eMax, vec3(C[2][2], 0.0f, -C[0][2]), &nE)) {
-			return false;
-		}
-		// A.z <cross> _obb.x
-		Ra = eA.x *	absC[1][0] + eA.y * absC[0][0];
-		Rb = eB.y * absC[2][2] + eB.z * absC[2][1];
-		s = glm::abs(t.y * C[0][0] - t.x * C[1][0]) - (Ra + Rb);
-		if (TrackEdgeAxis(&eAxis, 12, s, &eMax, vec3(-C[1][0], C[0][0], 0.0f), &nE)) {
-			return false;
-		}
-		// A.z <cross> _obb.y
-		Ra = eA.x *	absC[1][1] + eA.y * absC[0][1];
-		Rb = eB.x * absC[2][2] + eB.z * absC[2][0];
-		s = glm::abs(t.y * C[0][1] - t.x * C[1][1]) - (Ra + Rb);
-		if (TrackEdgeAxis(&eAxis, 13, s, &eMax, vec3(-C[1][1], C[0][1], 0.0f), &nE)) {
-			return false;
-		}
-		// A.z <cross> _obb.z
-		Ra = eA.x *	absC[1][2] + eA.y * absC[0][2];
-		Rb = eB.x * absC[2][1] + eB.y * absC[2][0];
-		s = glm::abs(t.y * C[0][2] - t.x * C[1][2]) - (Ra + Rb);
-		if (TrackEdgeAxis(&eAxis, 14, s, &eMax, vec3(-C[1][2], C[0][2], 0.0f), &nE)) {
-			return false;
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			vec3 axis = glm::cross(axes[i], _obb.axes[j]);
+			float length = glm::length(axis);
+			if (length < PARALLEL_TOLERANCE) {
+				continue; //Parallel edges are covered by the face axes
+			}
+			axis /= length;
+			float separation = glm::abs(glm::dot(delta, axis)) - GetRadius(*this, axis) - GetRadius(_obb, axis);
+			if (TrackAxis(6 + i * 3 + j, separation, _margin, &edgeMax, &edgeAxis)) {
+				return false;
+			}
+			if (edgeAxis == 6 + i * 3 + j) {
+				edgeNormal = axis;
+			}
 		}
 	}
-	const float kRelTol = 0.95f;
-	const float kAbsTol = 0.01f;
-	int axes;
-	float sMax;
-	vec3 n;
-	float faceMax = glm::max(aMax, bMax);
-	if (kRelTol * eMax < faceMax + kAbsTol) {
-		axes = eAxis;
-		sMax = eMax;
-		n = nE;
-	} else {
-		if (kRelTol * bMax > aMax + kAbsTol) {
-			axes = bAxis;
-			sMax = bMax;
-			n = nB;
-		} else {
-			axes = aAxis;
-			sMax = aMax;
-			n = nA;
-		}
+
+	if (EDGE_RELATIVE_TOLERANCE * edgeMax > glm::max(aMax, bMax) + EDGE_ABSOLUTE_TOLERANCE) {
+		// Two edges cross, contact them at the midpoint of their closest points
+		vec3 normal = glm::dot(edgeNormal, delta) < 0.0f ? -edgeNormal : edgeNormal;
+		vec3 edgeA, edgeB;
+		vec3 pointA = GetSupportEdge(*this, (edgeAxis - 6) / 3, normal, &edgeA);
+		vec3 pointB = GetSupportEdge(_obb, (edgeAxis - 6) % 3, -normal, &edgeB);
+		vec3 r = pointA - pointB;
+		float a = glm::dot(edgeA, edgeA);
+		float b = glm::dot(edgeA, edgeB);
+		float c = glm::dot(edgeA, r);
+		float f = glm::dot(edgeB, r);
+		float denominator = a * glm::dot(edgeB, edgeB) - b * b;
+		float s = glm::clamp((b * f - c * glm::dot(edgeB, edgeB)) / denominator, -1.0f, 1.0f);
+		float t = glm::clamp((b * s + f) / glm::dot(edgeB, edgeB), -1.0f, 1.0f);
+
+		Contact& contact = _manifold->contacts[0];
+		contact.position = ((pointA + edgeA * s) + (pointB + edgeB * t)) * 0.5f;
+		contact.penetration = -edgeMax;
+		contact.fp.key = 0;
+		contact.fp.inR = (unsigned char)edgeAxis;
+		contact.fp.outR = EDGE_FEATURE;
+		_manifold->normal = normal;
+		_manifold->contactCount = 1;
+		return true;
 	}
 
-	if (glm::dot(n, btx.position - atx.position) < 0.0f) {
-		n = -n;
+	// The box owning the deepest face axis is the reference, the other box's
+	// most opposing face is clipped against the reference face's sides
+	bool flip = EDGE_RELATIVE_TOLERANCE * bMax > aMax + EDGE_ABSOLUTE_TOLERANCE;
+	const OBB& reference = flip ? _obb : *this;
+	const OBB& incident = flip ? *this : _obb;
+	int axis = flip ? bAxis - 3 : aAxis;
+	vec3 normal = reference.axes[axis];
+	int side = 1;
+	if (glm::dot(normal, incident.center - reference.center) < 0.0f) {
+		normal = -normal;
+		side = 0;
 	}
 
-	if (axes < 6) {
-		Transform rtx;
-		Transform itx;
-		vec3 eR;
-		vec3 eI;
-		bool flip;
+	int corners[4];
+	incident.GetIncidentFace(normal, corners);
+	ClipVertex face[8];
+	for (int i = 0; i < 4; ++i) {
+		face[i].v = incident.CornerPoint(corners[i]);
+		face[i].f.inI = GetEdgeId(corners[(i + 3) % 4], corners[i]);
+		face[i].f.outI = GetEdgeId(corners[i], corners[(i + 1) % 4]);
+	}
 
-		if (axes < 3) {
-			rtx = atx;
-			itx = btx;
-			eR = eA;
-			eI = eB;
-			flip = false;
-		} else {
-			rtx = btx;
-			itx = atx;
-			eR = eB;
-			eI = eA;
-			flip = true;
-			n = -n;
+	// Each side plane is named after the reference face edge lying on it
+	int u = (axis + 1) % 3;
+	int v = (axis + 2) % 3;
+	int faceBit = side << axis;
+	ClipVertex clipped[8];
+	int count = 4;
+	for (int plane = 0; plane < 4; ++plane) {
+		int sideAxis = (plane & 1) ? v : u;
+		int otherAxis = (plane & 1) ? u : v;
+		bool positive = plane < 2;
+		vec3 sideNormal = positive ? reference.axes[sideAxis] : -reference.axes[sideAxis];
+		float offset = glm::dot(reference.center, sideNormal) + reference.e[sideAxis];
+		int edgeCorner = faceBit | ((positive ? 1 : 0) << sideAxis);
+		unsigned char edge = GetEdgeId(edgeCorner, edgeCorner | (1 << otherAxis));
+		count = ClipSide(sideNormal, offset, edge, face, count, clipped);
+		if (count == 0) {
+			return false;
 		}
+		for (int i = 0; i < count; ++i) {
+			face[i] = clipped[i];
+		}
+	}
 
-		// Compute reference and incident edge information necessary for clipping
-		ClipVertex incident[4];
-		ComputeIncidentFace(itx, eI, n, incident);
-		unsigned int clipEdges[4];
-		glm::mat3 basis;
-		vec3 e;
-		ComputeReferenceEdgesAndBasis(eR, rtx, n, axes, clipEdges, &basis, &e);
-
-		// Clip the incident face against the reference face side planes
-		ClipVertex out[8];
-		float depths[8];
-		int outNum;
-		outNum = Clip(rtx.position, e, clipEdges, basis, incident, out, depths);
-
-		if (outNum) {
-			_manifold->contactCount = outNum;
-			_manifold->normal = flip ? -n : n;
-			for (int i = 0; i < outNum; ++i) {
-				Contact* c = _manifold->contacts + i;
-				FeaturePair pair = out[i].f;
-				if (flip) {
-					std::swap(pair.inI, pair.inR);
-					std::swap(pair.outI, pair.outR);
-				}
-				c->fp = out[i].f;
-				c->position = out[i].v;
-				c->penetration = depths[i];
-			}
+	// Keep what ended up behind the reference face, or close enough in front of it
+	float faceOffset = glm::dot(reference.center, normal) + reference.e[axis];
+	float depths[8];
+	int kept = 0;
+	for (int i = 0; i < count; ++i) {
+		float depth = faceOffset - glm::dot(face[i].v, normal);
+		if (depth >= -_margin) {
+			face[kept] = face[i];
+			depths[kept++] = depth;
 		}
-	} else {
-		n = atxRotation * n;
-		if (glm::dot(n, btx.position - atx.position) < 0.0f) {
-			n = -n;
+	}
+	int chosen[8];
+	int chosenCount = ReduceContacts(face, depths, kept, normal, chosen);
+	for (int j = 0; j < chosenCount; ++j) {
+		int i = chosen[j];
+		float depth = depths[i];
+		Contact& contact = _manifold->contacts[_manifold->contactCount++];
+		contact.position = face[i].v + normal * (depth * 0.5f);
+		contact.penetration = depth;
+		contact.fp = face[i].f;
+		if (flip) {
+			std::swap(contact.fp.inR, contact.fp.inI);
+			std::swap(contact.fp.outR, contact.fp.outI);
 		}
-		vec3 PA, QA;
-		vec3 PB, QB;
-		SupportEdge(atx, eA, n, &PA, &QA);
-		SupportEdge(btx, eB, -n, &PB, &QB);
-		vec3 CA, CB;
-		EdgesContact(&CA, &CB, PA, QA, PB, QB);
-		_manifold->normal = n;
-		_manifold->contactCount = 1;
-		Contact* c = _manifold->contacts;
-		FeaturePair pair;
-		pair.key = axes;
-		c->fp = pair;
-		c->penetration = sMax;
-		c->position = (CA + CB) * 0.5f;
 	}
-
-	// Note(Manny): Intersect info needs to be computed here
-
-	// No separating axis exists, so the two OBB don't intersect.
-	return true;
+	_manifold->normal = flip ? -normal : normal;
+	return _manifold->contactCount > 0;
 }
-bool OBB::TrackFaceAxis(int* _axis, int _index, float _s, float* _sMax, const vec3& _normal, vec3* _axisNormal) {
-	if (_s > 0.0f) {
-		return true;
+bool OBB::Intersects(const vec3& _planeNormal, float _planeDistance, Manifold* _manifold, float _margin) const {
+	_manifold->contactCount = 0;
+	if (glm::dot(center, _planeNormal) - _planeDistance > GetRadius(*this, _planeNormal) + _margin) {
+		return false;
 	}
-	if (_s > *_sMax) {
-		*_sMax = _s;
-		*_axis = _index;
-		*_axisNormal = _normal;
+	for (int i = 0; i < 8; ++i) {
+		vec3 corner = CornerPoint(i);
+		float depth = _planeDistance - glm::dot(corner, _planeNormal);
+		if (depth >= -_margin) {
+			Contact& contact = _manifold->contacts[_manifold->contactCount++];
+			contact.position = corner + _planeNormal * (depth * 0.5f);
+			contact.penetration = depth;
+			contact.fp.key = 0;
+			contact.fp.inR = (unsigned char)(i + 1);
+		}
 	}
-	return false;
+	_manifold->normal = -_planeNormal;
+	return _manifold->contactCount > 0;
 }
-bool OBB::TrackEdgeAxis(int* _axis, int _index, float _s, float* _sMax, const vec3& _normal, vec3* _axisNormal) {
-	if (_s > 0.0f) {
-		return true;
+LineSegment OBB::Edge(int _edgeIndex) const {
+	// Four edges run along each axis
+	int axis = _edgeIndex / 4;
+	int rest = _edgeIndex % 4;
+	int u = (axis + 1) % 3;
+	int v = (axis + 2) % 3;
+	int corner = ((rest & 1) << u) | (((rest >> 1) & 1) << v);
+	return LineSegment(CornerPoint(corner), CornerPoint(corner | (1 << axis)));
+}
+vec3 OBB::CornerPoint(int _cornerIndex) const {
+	return center +
+		axes[0] * ((_cornerIndex & 1) ? e.x : -e.x) +
+		axes[1] * ((_cornerIndex & 2) ? e.y : -e.y) +
+		axes[2] * ((_cornerIndex & 4) ? e.z : -e.z);
+}
+
+// Private
+bool OBB::TrackAxis(int _index, float _separation, float _margin, float* _maxSeparation, int* _axis) const {
+	if (_separation > _margin) {
+		return true; //Found a separating axis
 	}
-	float l = 1.0f / glm::length(_normal);
-	_s *= l;
-	if (_s > *_sMax) {
-		*_sMax = _s;
+	if (_separation > *_maxSeparation) {
+		*_maxSeparation = _separation;
 		*_axis = _index;
-		*_axisNormal = _normal * l;
 	}
 	return false;
 }
-void OBB::ComputeReferenceEdgesAndBasis(const vec3& _eR, const Transform& _rtx, vec3 _n, int _axis,
-	unsigned int* out, glm::mat3* _basis, vec3* _e) {
-	glm::mat3 rotation = glm::toMat3(_rtx.rotation);
-	vec3 r = rotation * _eR;
-	_n = r * _n;
-	if (_axis >= 3) {
-		_axis -= 3;
-	}
-	switch (_axis) {
-	case 0:
-		if (_n.x > 0.0f) {
-			out[0] = 1;
-			out[1] = 8;
-			out[2] = 7;
-			out[3] = 9;
-			*_e = vec3(_eR.y, _eR.z, _eR.x);
-			*_basis = glm::mat3(r[1], r[2], r[0],
-				r[1], r[2], r[0],
-				r[1], r[2], r[0]);
-		} else {
-			out[0] = 11;
-			out[1] = 3;
-			out[2] = 10;
-			out[3] = 5;
-			*_e = vec3(_eR.z, _eR.y, _eR.x);
-			*_basis = glm::mat3(r[2], r[1], r[0],
-				r[2], r[1], r[0],
-				r[2], r[1], r[0]);
-		} break;
-	case 1:
-		if (_n.y > 0.0f) {
-			out[0] = 0;
-			out[1] = 1;
-			out[2] = 2;
-			out[3] = 3;
-			*_e = vec3(_eR.z, _eR.x, _eR.y);
-			*_basis = glm::mat3(r[2], r[0], r[1],
-				r[2], r[0], r[1],
-				r[2], r[0], r[1]);
-		} else {
-			out[0] = 4;
-			out[1] = 5;
-			out[2] = 6;
-			out[3] = 7;
-			*_e = vec3(_eR.z, _eR.x, _eR.y);
-			*_basis = glm::mat3(r[2], r[0], r[1],
-				r[2], r[0], r[1],
-				r[2], r[0], r[1]);
-		} break;
-	case 2:
-		if (_n.z > 0.0f) {
-			out[0] = 11;
-			out[1] = 4;
-			out[2] = 8;
-			out[3] = 0;
-			*_e = vec3(_eR.y, _eR.x, _eR.z);
-			*_basis = glm::mat3(r[1], r[0], r[2],
-				r[1], r[0], r[2],
-				r[1], r[0], r[2]);
-		} else {
-			out[0] = 6;
-			out[1] = 10;
-			out[2] = 2;
-			out[3] = 9;
-			*_e = vec3(_eR.y, _eR.x, _eR.z);
-			*_basis = glm::mat3(r[1], r[0], r[2],
-				r[1], r[0], r[2],
-				r[1], r[0], r[2]);
-		} break;
-	default:
-		break;
+int OBB::GetIncidentFace(const vec3& _normal, int* _corners) const {
+	// The face whose outward normal points most against _normal
+	int axis = 0;
+	float best = -1.0f;
+	for (int i = 0; i < 3; ++i) {
+		float alignment = glm::abs(glm::dot(_normal, axes[i]));
+		if (alignment > best) {
+			best = alignment;
+			axis = i;
+		}
 	}
+	int faceBit = glm::dot(_normal, axes[axis]) > 0.0f ? 0 : (1 << axis);
+	int u = 1 << ((axis + 1) % 3);
+	int v = 1 << ((axis + 2) % 3);
+	_corners[0] = faceBit;
+	_corners[1] = faceBit | u;
+	_corners[2] = faceBit | u | v;
+	_corners[3] = faceBit | v;
+	return axis;
+}
+unsigned char OBB::GetEdgeId(int _cornerA, int _cornerB) {
+	// 1-12, four edges per axis told apart by the corner's other two bits
+	int difference = _cornerA ^ _cornerB;
+	int axis = difference == 1 ? 0 : (difference == 2 ? 1 : 2);
+	int corner = _cornerA & ~difference;
+	int u = (axis + 1) % 3;
+	int v = (axis + 2) % 3;
+	int rest = ((corner >> u) & 1) | (((corner >> v) & 1) << 1);
+	return (unsigned char)(1 + axis * 4 + rest);
 }
-void OBB::ComputeIncidentFace(const Transform& _rtx, const vec3& _e, vec3 _n, ClipVertex* _out) {
-	_n = -(glm::toMat3(_rtx.rotation) * _n);
-	vec3 absN = glm::abs(_n);
-	if (absN.x > absN.y && absN.x > absN.z) {
-		if (_n.x > 0.0f) {
-			_out[0].v = vec3(_e.x,  _e.y, -_e.z);
-			_out[1].v = vec3(_e.x,  _e.y,  _e.z);
-			_out[2].v = vec3(_e.x, -_e.y,  _e.z);
-			_out[3].v = vec3(_e.x, -_e.y, -_e.z);
-			_out[0].f.inI = 9;
-			_out[0].f.outI = 1;
-			_out[1].f.inI = 1;
-			_out[1].f.outI = 8;
-			_out[2].f.inI = 8;
-			_out[2].f.outI = 7;
-			_out[3].f.inI = 7;
-			_out[3].f.outI = 9;
-		} else {
-			_out[0].v = vec3(-_e.x, -_e.y,  _e.z);
-			_out[1].v = vec3(-_e.x,  _e.y,  _e.z);
-			_out[2].v = vec3(-_e.x,  _e.y, -_e.z);
-			_out[3].v = vec3(-_e.x, -_e.y, -_e.z);
-			_out[0].f.inI = 5;
-			_out[0].f.outI = 11;
-			_out[1].f.inI = 11;
-			_out[1].f.outI = 3;
-			_out[2].f.inI = 3;
-			_out[2].f.outI = 10;
-			_out[3].f.inI = 10;
-			_out[3].f.outI = 5;
+int OBB::ReduceContacts(const ClipVertex* _points, const float* _depths, int _count, const vec3& _normal, int* _chosen) {
+	// Note(Manny): A slightly turned face clips into up to eight points, many of
+	// them almost on top of each other, which the solver handles badly. Four
+	// points spanning the largest area hold a box just as well
+	if (_count <= 4) {
+		for (int i = 0; i < _count; ++i) {
+			_chosen[i] = i;
+		}
+		return _count;
+	}
+
+	// The deepest point, the point furthest from it, then the points making
+	// the largest triangle with those two on either side
+	int first = 0;
+	for (int i = 1; i < _count; ++i) {
+		if (_depths[i] > _depths[first]) {
+			first = i;
 		}
-	} else if (absN.y > absN.x && absN.y > absN.z) {
-		if (_n.y > 0.0f) {
-			_out[0].v = vec3(-_e.x, _e.y,  _e.z);
-			_out[1].v = vec3( _e.x, _e.y,  _e.z);
-			_out[2].v = vec3( _e.x, _e.y, -_e.z);
-			_out[3].v = vec3(-_e.x, _e.y, -_e.z);
-			_out[0].f.inI = 3;
-			_out[0].f.outI = 0;
-			_out[1].f.inI = 0;
-			_out[1].f.outI = 1;
-			_out[2].f.inI = 1;
-			_out[2].f.outI = 2;
-			_out[3].f.inI = 2;
-			_out[3].f.outI = 3;
-		} else {
-			_out[0].v = vec3( _e.x, -_e.y,  _e.z);
-			_out[1].v = vec3(-_e.x, -_e.y,  _e.z);
-			_out[2].v = vec3(-_e.x, -_e.y, -_e.z);
-			_out[3].v = vec3( _e.x, -_e.y, -_e.z);
-			_out[0].f.inI = 7;
-			_out[0].f.outI = 4;
-			_out[1].f.inI = 4;
-			_out[1].f.outI = 5;
-			_out[2].f.inI = 5;
-			_out[2].f.outI = 6;
-			_out[3].f.inI = 5;
-			_out[3].f.outI = 6;
+	}
+	int second = first;
+	float bestDistance = -1.0f;
+	for (int i = 0; i < _count; ++i) {
+		vec3 offset = _points[i].v - _points[first].v;
+		float distance = glm::dot(offset, offset);
+		if (distance > bestDistance) {
+			bestDistance = distance;
+			second = i;
 		}
-	} else {
-		if (_n.z > 0.0) {
-			_out[0].v = vec3(-_e.x,  _e.y, _e.z);
-			_out[1].v = vec3(-_e.x, -_e.y, _e.z);
-			_out[2].v = vec3( _e.x, -_e.y, _e.z);
-			_out[3].v = vec3( _e.x,  _e.y, _e.z);
-			_out[0].f.inI = 0;
-			_out[0].f.outI = 11;
-			_out[1].f.inI = 11;
-			_out[1].f.outI = 4;
-			_out[2].f.inI = 4;
-			_out[2].f.outI = 8;
-			_out[3].f.inI = 8;
-			_out[3].f.outI = 0;
-		} else {
-			_out[0].v = vec3( _e.x, -_e.y, -_e.z);
-			_out[1].v = vec3(-_e.x, -_e.y, -_e.z);
-			_out[2].v = vec3(-_e.x,  _e.y, -_e.z);
-			_out[3].v = vec3( _e.x,  _e.y, -_e.z);
-			_out[0].f.inI = 9;
-			_out[0].f.outI = 6;
-			_out[1].f.inI = 6;
-			_out[1].f.outI = 10;
-			_out[2].f.inI = 10;
-			_out[2].f.outI = 2;
-			_out[3].f.inI = 2;
-			_out[3].f.outI = 9;
+	}
+	int third = -1, fourth = -1;
+	float maxArea = 0.0f, minArea = 0.0f;
+	for (int i = 0; i < _count; ++i) {
+		float area = glm::dot(glm::cross(_points[first].v - _points[i].v, _points[second].v - _points[i].v), _normal);
+		if (area > maxArea) {
+			maxArea = area;
+			third = i;
+		} else if (area < minArea) {
+			minArea = area;
+			fourth = i;
 		}
 	}
-	for (int i = 0; i < 4; ++i) {
-		_out[i].v = glm::toMat3(_rtx.rotation) * _out[i].v + _rtx.position;
+
+	int count = 0;
+	_chosen[count++] = first;
+	if (second != first) {
+		_chosen[count++] = second;
 	}
+	if (third >= 0) {
+		_chosen[count++] = third;
+	}
+	if (fourth >= 0) {
+		_chosen[count++] = fourth;
+	}
+	return count;
 }
-
-#define InFront( a ) \
-	((a) < 0.0f)
-
-#define Behind( a ) \
-	((a) >= 0.0)
-
-#define On( a ) \
-	((a) < 0.005f && (a) > -0.005f)
-
-int OBB::Orthographic(float _sign, float _e, int _axis, int _clipEdge, ClipVertex* _in, int _inCount, ClipVertex* _out) {
+int OBB::ClipSide(const vec3& _side, float _offset, unsigned char _edge, const ClipVertex* _in, int _inCount, ClipVertex* _out) {
+	// Sutherland-Hodgman against one side plane. New vertices remember the
+	// reference edge that cut them instead of the incident edge they came from
 	int outCount = 0;
 	ClipVertex a = _in[_inCount - 1];
-
+	float da = glm::dot(a.v, _side) - _offset;
 	for (int i = 0; i < _inCount; ++i) {
-		ClipVertex b = _in[i];
-		float da = _sign * a.v[_axis] - _e;
-		float db = _sign * b.v[_axis] - _e;
-		ClipVertex cv;
-		
-		if (((InFront(da) && InFront(db)) || On(da) || On(db))) {
-			// B
-			assert(outCount < 8);
+		const ClipVertex& b = _in[i];
+		float db = glm::dot(b.v, _side) - _offset;
+		if (da <= 0.0f && db <= 0.0f) {
 			_out[outCount++] = b;
-		} else if (InFront(da) && Behind(db)) {
-			// I
+		} else if (da <= 0.0f && db > 0.0f) {
+			ClipVertex cv;
 			cv.f = b.f;
 			cv.v = a.v + (b.v - a.v) * (da / (da - db));
-			cv.f.outR = _clipEdge;
+			cv.f.outR = _edge;
 			cv.f.outI = 0;
-			assert(outCount < 8);
 			_out[outCount++] = cv;
-		} else if (Behind(da) && InFront(db)) {
-			// I, B
+		} else if (da > 0.0f && db <= 0.0f) {
+			ClipVertex cv;
 			cv.f = a.f;
 			cv.v = a.v + (b.v - a.v) * (da / (da - db));
-			cv.f.inR = _clipEdge;
+			cv.f.inR = _edge;
 			cv.f.inI = 0;
-			assert(outCount < 8);
 			_out[outCount++] = cv;
-			assert(outCount < 8);
 			_out[outCount++] = b;
 		}
 		a = b;
+		da = db;
 	}
 	return outCount;
-}
-
-int OBB::Clip(const vec3& rPos, const vec3& _e, unsigned int* _clipEdges, const glm::mat3& _basis, 
-	ClipVertex* _incident, ClipVertex* _outVerts, float* _outDepths) {
-	int inCount = 4;
-	int outCount;
-	ClipVertex in[8];
-	ClipVertex out[8];
-	for (int i = 0; i < 4; ++i) {
-		in[i].v = glm::transpose(_basis) * (_incident[i].v - rPos);
-	}
-	outCount = Orthographic(1.0f, _e.x, 0, _clipEdges[0], in, inCount, out);
-	if (!outCount) {
-		return 0;
-	}
-	inCount = Orthographic(1.0f, _e.y, 1, _clipEdges[1], out, outCount, in);
-	if (!inCount) {
-		return 0;
-	}
-	outCount = Orthographic(-1.0f, _e.x, 0, _clipEdges[2], in, inCount, out);
-	if (!outCount) {
-		return 0;
-	}
-	inCount = Orthographic(-1.0f, _e.y, 1, _clipEdges[3], out, outCount, in);
-
-	// Keep incident vertices behind the reference face
-	outCount = 0;
-	for (int i = 0; i < inCount; ++i) {
-		float d = in[i].v.z - _e.z;
-		if (d <= 0.0f) {
-			_outVerts[outCount].v = (_basis * in[i].v) + rPos;
-			_outVerts[outCount].f = in[i].f;
-			_outDepths[outCount++] = d;
-		}
-	}
-	assert(outCount <= 8);
-	return outCount;
-}
-void OBB::EdgesContact(vec3* _CA, vec3* _CB, const vec3& _PA, const vec3& _QA, const vec3& _PB, const vec3& _QB) {
-	vec3 DA = _QA - _PA;
-	vec3 DB = _QB - _PB;
-	vec3 r = _PA - _PB;
-	float  a = glm::dot(DA, DA);
-	float  e = glm::dot(DB, DB);
-	float  f = glm::dot(DB, r);
-	float  c = glm::dot(DA, r);
-
-	float b = glm::dot(DA, DB);
-	float denom = a * e - b * b;
-
-	float TA = (b * f - c * e) / denom;
-	float TB = (b * TA + f) / e;
-
-	*_CA = _PA + DA * TA;
-	*_CB = _PB + DB * TB;
-} 
-void OBB::SupportEdge(const Transform& _tx, const vec3& _e, vec3 _n, vec3* _aOut, vec3* _bOut) {
-	_n = glm::toMat3(_tx.rotation) * _n;
-	vec3 absN = glm::abs(_n);
-	vec3 a, b;
-	// x > y
-	if (absN.x > absN.y) {
-		// x > y > z
-		if (absN.y > absN.z) {
-			a = vec3(_e.x, _e.y,  _e.z);
-			b = vec3(_e.x, _e.y, -_e.z);
-		} else { // x > z > y || z > x > y
-			a = vec3(_e.x,  _e.y, _e.z);
-			b = vec3(_e.x, -_e.y, _e.z);
-		}
-	} else {
-		// y > x > z
-		if (absN.x > absN.z) {
-			a = vec3(_e.x, _e.y,  _e.z);
-			b = vec3(_e.x, _e.y, -_e.z);
-		} else { // z > y > x || y > z > x
-
-			a = vec3( _e.x, _e.y, _e.z);
-			b = vec3(-_e.x, _e.y, _e.z);
-		}
-	}
-
-	float signx = FloatSign(_n.x);
-	float signy = FloatSign(_n.y);
-	float signz = FloatSign(_n.z);
-
-	a.x *= signx;
-	a.y *= signy;
-	a.z *= signz;
-	b.x *= signx;
-	b.y *= signy;
-	b.z *= signz;
-
-	*_aOut = glm::toMat3(_tx.rotation) * a + _tx.position;
-	*_bOut = glm::toMat3(_tx.rotation) * b + _tx.position;
-}
-float OBB::FloatSign(float _a) {
-	if (_a >= 0.0f) {
-		return 1.0f;
-	} else {
-		return -1.0f;
-	}
-}
-
-LineSegment OBB::Edge(int _edgeIndex) {
-	switch (_edgeIndex) {
-		case 0: return LineSegment(CornerPoint(0), CornerPoint(1));
-		case 1: return LineSegment(CornerPoint(0), CornerPoint(2));
-		case 2: return LineSegment(CornerPoint(0), CornerPoint(4));
-		case 3: return LineSegment(CornerPoint(1), CornerPoint(3));
-		case 4: return LineSegment(CornerPoint(1), CornerPoint(5));
-		case 5: return LineSegment(CornerPoint(2), CornerPoint(3));
-		case 6: return LineSegment(CornerPoint(2), CornerPoint(6));
-		case 7: return LineSegment(CornerPoint(3), CornerPoint(7));
-		case 8: return LineSegment(CornerPoint(4), CornerPoint(5));
-		case 9: return LineSegment(CornerPoint(4), CornerPoint(6));
-		case 10: return LineSegment(CornerPoint(5), CornerPoint(7));
-		case 11: return LineSegment(CornerPoint(6), CornerPoint(7));
-		default:
-			break;
-	}
-	return LineSegment();
-}
-vec3 OBB::CornerPoint(int _cornerIndex) {
-	switch (_cornerIndex) {
-		case 0: return local.position - e.x * local.right - e.y * local.up - e.z * local.forward;
-		case 1: return local.position - e.x * local.right - e.y * local.up + e.z * local.forward;
-		case 2: return local.position - e.x * local.right + e.y * local.up - e.z * local.forward;
-		case 3: return local.position - e.x * local.right + e.y * local.up + e.z * local.forward;
-		case 4: return local.position + e.x * local.right - e.y * local.up - e.z * local.forward;
-		case 5: return local.position + e.x * local.right - e.y * local.up + e.z * local.forward;
-		case 6: return local.position + e.x * local.right + e.y * local.up - e.z * local.forward;
-		case 7: return local.position + e.x * local.right + e.y * local.up + e.z * local.forward;
-		default:
-			break;
-	}
-	return vec3(0);
-}
+}
\ No newline at end of file
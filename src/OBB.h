@@ -12,9 +12,6 @@ orientaiton applied to them.
 #ifndef _OBB_H_
 #define _OBB_H_
 
-// Components
-#include "Transform.h"
-
 // Structs
 #include "Bounds.h"
 #include "LineSegment.h"
@@ -22,30 +19,35 @@ orientaiton applied to them.
 // Utilities
 #include "GLM_Header.h"
 
+// Forward declaration
+class Transform;
+
+// The edges of the reference and incident box that produced a contact, it
+// stays the same while the boxes keep touching the same way
 union FeaturePair {
 	struct {
-		unsigned int inR;
-		unsigned int outR;
-		unsigned int inI;
-		unsigned int outI;
+		unsigned char inR;
+		unsigned char outR;
+		unsigned char inI;
+		unsigned char outI;
 	};
 	int key;
 };
 
 struct Contact {
 	vec3 position;				// World coordinate of contact
-	float penetration;			// Depth of penetration from collision
+	float penetration;			// Depth of penetration from collision, negative while still apart
 	float normalImpulse;		// Accumulated normal impulse
 	float tangentImpulse[2];	// Accumulated friction impulse
 	float bias;					// Restitution + baumgarte
 	float normalMass;			// Normal constraint mass
 	float tangentMass[2];		// Tangent constraint mass
 	FeaturePair fp;				// Features on A and B for this contact
-	unsigned int warmStarted;	// Used for debug rendering
+	unsigned int warmStarted;	// Steps in a row this contact has persisted, used for debug rendering
 };
 
 struct ClipVertex {
-	ClipVertex() { f.key = ~0; }
+	ClipVertex() { f.key = 0; }
 	vec3 v;
 	FeaturePair f;
 };
@@ -56,30 +58,31 @@ struct Manifold {
 	vec3 tangentVectors[2];	// Tangent vectors
 	int contactCount;
 	bool sensor;
-	Manifold* next;
-	Manifold* prev;
 };
 
 class OBB {
 public:
 	OBB();
 	~OBB();
+	void Set(const vec3& _center, const quat& _rotation, const vec3& _halfSize);
 	void SetFrom(const Bounds& _bounds, const Transform& _transform);
-	bool Intersects(const OBB& _obb, Manifold* _manifold);
-	bool TrackFaceAxis(int* _axis, int _index, float _s, float* _sMax, const vec3& _normal, vec3* _axisNormal);
-	bool TrackEdgeAxis(int* _axis, int _index, float _s, float* _sMax, const vec3& _normal, vec3* _axisNormal);
-	void ComputeReferenceEdgesAndBasis(const vec3& _eR, const Transform& _rtx, vec3 _n, int _axis, unsigned int* out, glm::mat3* _basis, vec3* _e);
-	void ComputeIncidentFace(const Transform& _rtx, const vec3& _e, vec3 _n, ClipVertex* _out);
-	int Orthographic(float _sign, float _e, int _axis, int _clipEdge, ClipVertex* _in, int _inCount, ClipVertex* _out);
-	int Clip(const vec3& rPos, const vec3& _e, unsigned int* _clipEdges, const glm::mat3& _basis, ClipVertex* _incident, ClipVertex* _outVerts, float* _outDepths);
-	void EdgesContact(vec3* _CA, vec3* _CB, const vec3& _PA, const vec3& _QA, const vec3& _PB, const vec3& _QB);
-	void SupportEdge(const Transform& _tx, const vec3& _e, vec3 _n, vec3* _aOut, vec3* _bOut);
-	float FloatSign(float _a);
-	LineSegment Edge(int _edgeIndex);
-	vec3 CornerPoint(int _cornerIndex);
+	// Separating axis test that fills the manifold with up to four contacts. Points
+	// up to _margin apart are kept too, with a negative penetration
+	bool Intersects(const OBB& _obb, Manifold* _manifold, float _margin = 0.0f) const;
+	// Every corner near or behind the plane becomes a contact, the normal points into the plane
+	bool Intersects(const vec3& _planeNormal, float _planeDistance, Manifold* _manifold, float _margin = 0.0f) const;
+	LineSegment Edge(int _edgeIndex) const;
+	vec3 CornerPoint(int _cornerIndex) const; //Bit 0, 1 and 2 of the index pick the +x, +y and +z side
 
-	Transform local;
-	vec3 e; 
+	vec3 center;
+	glm::mat3 axes; //Columns are the box's local x, y and z axis in world space
+	vec3 e; //Half size along each axis
+private:
+	bool TrackAxis(int _index, float _separation, float _margin, float* _maxSeparation, int* _axis) const;
+	int GetIncidentFace(const vec3& _normal, int* _corners) const;
+	static unsigned char GetEdgeId(int _cornerA, int _cornerB);
+	static int ReduceContacts(const ClipVertex* _points, const float* _depths, int _count, const vec3& _normal, int* _chosen);
+	static int ClipSide(const vec3& _side, float _offset, unsigned char _edge, const ClipVertex* _in, int _inCount, ClipVertex* _out);
 };
 
 #endif // _OBB_H_
\ No newline at end of file
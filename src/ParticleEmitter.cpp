@@ -2,7 +2,9 @@
 
 // Sub-engines
 #include "PhysicsEngine.h"
+#include "PhysXEngine.h"
 #include "CoreEngine.h"
+#include "RenderingEngine.h"
 
 // Transform
 #include "Transform.h"
@@ -30,18 +32,34 @@ ParticleEmitter::ParticleEmitter(int _maxParticles) :
 	stiffness(100.0f),
 	enabled(false),
 	isChangedInGUI(false),
-	m_releaseDelay(0.1f) {}
+	sparseColor(1, 0, 1, 1),
+	denseColor(0.2f, 0.4f, 1, 1),
+	particleMaxAge(8.0f),
+	backend(PARTICLE_BACKEND_NATIVE),
+	particleFluid(nullptr),
+	m_releaseDelay(0.1f),
+	m_activeParticles(nullptr) {}
 ParticleEmitter::~ParticleEmitter(){}
 bool ParticleEmitter::Startup() {
-	// Allocate an array
-	m_activeParticles = new FluidParticle[maxParticles]; // Array of particle structs
 	m_time = 0; // Time system has been running
 	m_respawnTime = 0; // Time for next respawn
-	m_particleMaxAge = 8; // Maximum time in seconds that a particle can live 
 
-	// Initialize the buffer
+	// Note(Manny): Without PhysX the particles are simulated by the engine itself
+	if (dynamic_cast<PhysXEngine*>(CoreEngine::physics) == nullptr) {
+		backend = PARTICLE_BACKEND_NATIVE;
+		m_system.Reserve(maxParticles);
+		return true;
+	}
+	backend = PARTICLE_BACKEND_PHYSX;
+
+	// Allocate an array
+	m_activeParticles = new FluidParticle[maxParticles]; // Array of particle structs
+
+	// Initialize the buffer, every particle starts on the free list
+	m_freeParticles.resize(maxParticles);
 	for (int index = 0; index < maxParticles; index++) {
 		m_activeParticles[index].isActive = false;
+		m_freeParticles[index] = maxParticles - 1 - index;
 	}
 
 	CoreEngine::physics->AddActor(this);
@@ -49,9 +67,15 @@ bool ParticleEmitter::Startup() {
 	return true;
 }
 void ParticleEmitter::Shutdown() {
+	if (backend == PARTICLE_BACKEND_NATIVE) {
+		m_system.Clear();
+		return;
+	}
 	CoreEngine::physics->RemoveActor(this);
 	// Remove all the active particles
-	delete m_activeParticles;
+	delete[] m_activeParticles;
+	m_activeParticles = nullptr;
+	m_freeParticles.clear();
 }
 bool ParticleEmitter::Update() {
 	if (this->transform->isSelected) { Inspector(); }
@@ -68,26 +92,35 @@ bool ParticleEmitter::Update() {
 			m_respawnTime -= (numberSpawn * m_releaseDelay);
 		}
 		// Spawn the required number of particles 
-		for (int count = 0; count < numberSpawn; count++) {
-			// Get the next free particle
-			int particleIndex = GetNextFreeParticle();
-			if (particleIndex >= 0) {
-				// If we got a particle ID then spawn it
-				AddPhysXParticle(particleIndex);
-			}
-		}
+		Emit(numberSpawn);
 	}
 
+	if (backend == PARTICLE_BACKEND_NATIVE) {
+		// The fluid settings map onto the native simulation as closely as they can
+		m_system.radius = restParticleDistance * 0.5f;
+		m_system.drag = damping;
+		m_system.restitution = restitution;
+		m_system.friction = dynamicFriction;
+		m_system.Update(Time::deltaTime, CoreEngine::physics->gravity);
+		return true;
+	}
+
+	// Note(Manny): PhysX only allows reading the fluid between fetching a step and
+	// simulating the next, which LateUpdate starts before the frame is drawn. The
+	// particles are copied out here so Draw never touches the SDK buffers
+	m_particles.clear();
 	// Check to see if we need to release particles. They can either be too old or have hit the particle sink
 	// Lock the particle buffer so we can work on it and get a pointer to read data
-	PxParticleReadData* readData = particleFluid->lockParticleReadData();
+	PxParticleFluidReadData* readData = particleFluid->lockParticleFluidReadData();
 	// Access particle data from PxParticleReadData was OK
 	if (readData) {
 		vector<PxU32> particlesToRemove; //we need to build a list of particles to remove so we can do it all in one go
+		bool hasDensity = readData->densityBuffer.ptr() != nullptr;
 		PxStrideIterator<const PxParticleFlags> flagsIt(readData->flagsBuffer);
 		PxStrideIterator<const PxVec3> positionIt(readData->positionBuffer);
+		PxStrideIterator<const PxF32> densityIt(readData->densityBuffer);
 
-		for (unsigned i = 0; i < readData->validParticleRange; ++i, ++flagsIt, ++positionIt) {
+		for (unsigned i = 0; i < readData->validParticleRange; ++i, ++flagsIt, ++positionIt, ++densityIt) {
 			if (*flagsIt & PxParticleFlag::eVALID) {
 				//if particle is either too old or has hit the sink then mark it for removal.  We can't remove it here because we buffer is locked
 				if (*flagsIt & PxParticleFlag::eCOLLISION_WITH_DRAIN) {
@@ -95,6 +128,11 @@ bool ParticleEmitter::Update() {
 					ReleaseParticle(i);
 					//add to our list of particles to remove
 					particlesToRemove.push_back(i);
+				} else {
+					// Density tells us how many neighbours a particle has.  
+					// If it has a density of 0 it has no neighbours, 1 is maximum neighbours
+					// We can use this to decide if the particle is seperate or part of a larger body of fluid
+					m_particles.push_back(vec4(positionIt->x, positionIt->y, positionIt->z, hasDensity ? *densityIt : 0.0f));
 				}
 			}
 		}
@@ -112,26 +150,21 @@ bool ParticleEmitter::Update() {
 	return true;
 }
 void ParticleEmitter::Draw(RenderingEngine& _renderer) {
-	// Lock SDK buffers of *PxParticleSystem* ps for reading
-	PxParticleFluidReadData * fd = particleFluid->lockParticleFluidReadData();
-	// Access particle data from PxParticleReadData
-	float minX = 1000, maxX = -1000, minZ = 1000, maxZ = -1000, minY = 1000, maxY = -1000;
-	if (fd) {
-		PxStrideIterator<const PxParticleFlags> flagsIt(fd->flagsBuffer);
-		PxStrideIterator<const PxVec3> positionIt(fd->positionBuffer);
-		PxStrideIterator<const PxF32> densityIt(fd->densityBuffer);
-		for (unsigned i = 0; i < fd->validParticleRange; ++i, ++flagsIt, ++positionIt, ++densityIt) {
-			if (*flagsIt & PxParticleFlag::eVALID) {
-				// Density tells us how many neighbours a particle has.  
-				// If it has a density of 0 it has no neighbours, 1 is maximum neighbours
-				// We can use this to decide if the particle is seperate or part of a larger body of fluid
-				vec3 position(positionIt->x, positionIt->y, positionIt->z);
-				Gizmos::AddSphere(position, restParticleDistance * 0.5f, 4, 4, vec4(1, 0, 1, 1));
-			}
-		}
-		// return ownership of the buffers back to the SDK
-		fd->unlock();
+	if (backend == PARTICLE_BACKEND_NATIVE) {
+		unsigned int count = m_system.GetCount();
+		m_system.Write(_renderer.particleRenderer.BeginBatch(count));
+		_renderer.particleRenderer.EndBatch(count, m_system.radius, sparseColor, denseColor);
+		Gizmos::AddTransform(this->transform->worldMatrix);
+		return;
+	}
+
+	// Copied in Update, the fluid may be simulating the next step by now
+	unsigned int count = m_particles.size();
+	vec4* particles = _renderer.particleRenderer.BeginBatch(count);
+	if (count > 0) {
+		memcpy(particles, &m_particles[0], count * sizeof(vec4));
 	}
+	_renderer.particleRenderer.EndBatch(count, restParticleDistance * 0.5f, sparseColor, denseColor);
 	Gizmos::AddTransform(this->transform->worldMatrix);
 }
 void ParticleEmitter::Inspector() {
@@ -156,6 +189,16 @@ void ParticleEmitter::Inspector() {
 		ImGui::DragFloat("Restitution", &restitution, 0.01f);
 		ImGui::DragFloat("Stiffness", &stiffness, 0.01f);
 		ImGui::Checkbox("Enabled", &enabled);
+		if (backend == PARTICLE_BACKEND_NATIVE) {
+			ImGui::DragFloat("Max Age", &particleMaxAge, 0.1f);
+			ImGui::ColorEdit4("Start Color", &sparseColor[0]);
+			ImGui::ColorEdit4("End Color", &denseColor[0]);
+			ImGui::Checkbox("Collision", &m_system.collisionEnabled);
+			ImGui::Text("Particles: %u / %u (%.2fms)", m_system.GetCount(), m_system.GetMaxParticles(), m_system.updateTime);
+		} else {
+			ImGui::ColorEdit4("Sparse Color", &sparseColor[0]);
+			ImGui::ColorEdit4("Dense Color", &denseColor[0]);
+		}
 
 		ImGui::TreePop();
 
@@ -184,32 +227,50 @@ void ParticleEmitter::SetVelocityRange(float _minX, float _minY, float _minZ,
 	m_maxVelocity.y = _maxY;
 	m_maxVelocity.z = _maxZ;
 }
-int ParticleEmitter::GetNextFreeParticle() {
-	// Loop through particles. 
-	// Note(Manny): Might be a better way to do this.
-	for (int particleIndex = 0; particleIndex < maxParticles; particleIndex++) {
-		// Find a particle which is free
-		if (!m_activeParticles[particleIndex].isActive) {
-			// Mark it as not free
-			m_activeParticles[particleIndex].isActive = true; 
-	
-			// Record when the particle was created so we know when to remove it
-			m_activeParticles[particleIndex].maxTime = m_time + m_particleMaxAge;  
-			return particleIndex;
+void ParticleEmitter::Emit(int _count) {
+	for (int count = 0; count < _count; count++) {
+		if (!SpawnParticle()) {
+			break;
 		}
 	}
+}
+bool ParticleEmitter::SpawnParticle() {
+	if (backend == PARTICLE_BACKEND_NATIVE) {
+		return m_system.Emit(this->transform->position, GetRandomVelocity(), particleMaxAge);
+	}
+	// Get the next free particle
+	int particleIndex = GetNextFreeParticle();
+	if (particleIndex < 0) {
+		return false;
+	}
+	// If we got a particle ID then spawn it
+	return AddPhysXParticle(particleIndex);
+}
+int ParticleEmitter::GetNextFreeParticle() {
 	// Returns -1 if a particle was not allocated
-	return -1;
+	if (m_freeParticles.empty()) {
+		return -1;
+	}
+	int particleIndex = m_freeParticles.back();
+	m_freeParticles.pop_back();
+
+	// Mark it as not free
+	m_activeParticles[particleIndex].isActive = true; 
+	
+	// Record when the particle was created so we know when to remove it
+	m_activeParticles[particleIndex].maxTime = m_time + particleMaxAge;  
+	return particleIndex;
 }
 void ParticleEmitter::ReleaseParticle(int _particleIndex) {
 	// Release a particle from the system using it's index to ID it
-	if (_particleIndex >= 0 && _particleIndex < maxParticles) {
+	if (_particleIndex >= 0 && _particleIndex < maxParticles && m_activeParticles[_particleIndex].isActive) {
 		m_activeParticles[_particleIndex].isActive = false;
+		m_freeParticles.push_back(_particleIndex);
 	}
 }
 // Returns true if a particle age is greater than it's maximum allowed age
 bool ParticleEmitter::isTooOld(int _particleIndex) {
-	if (_particleIndex >= 0 && _particleIndex < maxParticles &&
+	if (m_activeParticles != nullptr && _particleIndex >= 0 && _particleIndex < maxParticles &&
 		m_time > m_activeParticles[_particleIndex].maxTime) {
 		return true;
 	}
@@ -228,17 +289,8 @@ bool ParticleEmitter::AddPhysXParticle(int _particleIndex) {
 							 this->transform->position.y, 
 							 this->transform->position.z);
 	
-	PxVec3 startVel((float)(rand() % (int)m_maxVelocity.x + (int)m_minVelocity.x), 
-					(float)(rand() % (int)m_maxVelocity.y + (int)m_minVelocity.y), 
-					(float)(rand() % (int)m_maxVelocity.z + (int)m_minVelocity.z));
-
-	// Randomize starting velocity.
-	float fT = (rand() % (RAND_MAX + 1)) / (float)RAND_MAX;
-	startVel.x += m_minVelocity.x + (fT * (m_maxVelocity.x - m_minVelocity.x));
-	fT = (rand() % (RAND_MAX + 1)) / (float)RAND_MAX;
-	startVel.y += m_minVelocity.y + (fT * (m_maxVelocity.y - m_minVelocity.y));
-	fT = (rand() % (RAND_MAX + 1)) / (float)RAND_MAX;
-	startVel.z += m_minVelocity.z + (fT * (m_maxVelocity.z - m_minVelocity.z));
+	vec3 velocity = GetRandomVelocity();
+	PxVec3 startVel(velocity.x, velocity.y, velocity.z);
 
 	// We can change starting position tos get different emitter shapes
 	PxVec3 myPositionBuffer[] = { startPos };
@@ -249,4 +301,18 @@ bool ParticleEmitter::AddPhysXParticle(int _particleIndex) {
 	particleCreationData.velocityBuffer = PxStrideIterator<const PxVec3>(myVelocityBuffer);
 	// Create particles in *PxParticleSystem* ps
 	return particleFluid->createParticles(particleCreationData);
+}
+vec3 ParticleEmitter::GetRandomVelocity() const {
+	vec3 velocity((float)(rand() % (int)m_maxVelocity.x + (int)m_minVelocity.x), 
+				  (float)(rand() % (int)m_maxVelocity.y + (int)m_minVelocity.y), 
+				  (float)(rand() % (int)m_maxVelocity.z + (int)m_minVelocity.z));
+
+	// Randomize starting velocity.
+	float fT = (rand() % (RAND_MAX + 1)) / (float)RAND_MAX;
+	velocity.x += m_minVelocity.x + (fT * (m_maxVelocity.x - m_minVelocity.x));
+	fT = (rand() % (RAND_MAX + 1)) / (float)RAND_MAX;
+	velocity.y += m_minVelocity.y + (fT * (m_maxVelocity.y - m_minVelocity.y));
+	fT = (rand() % (RAND_MAX + 1)) / (float)RAND_MAX;
+	velocity.z += m_minVelocity.z + (fT * (m_maxVelocity.z - m_minVelocity.z));
+	return velocity;
 }
\ No newline at end of file
@@ -17,6 +17,16 @@ RenderingEngine and the PhysXEngine
 
 // Physics
 #include "PhysicsObject.h"
+#include "ParticleSystem.h"
+
+// Other
+#include <vector>
+using std::vector;
+
+enum ParticleBackend {
+	PARTICLE_BACKEND_PHYSX, //A PxParticleFluid, only while PhysX is the physics engine
+	PARTICLE_BACKEND_NATIVE //The engine's own ParticleSystem
+};
 
 struct FluidParticle {
 	bool isActive;
@@ -31,6 +41,7 @@ public:
 	void Shutdown();
 	bool Update();
 	void Draw(RenderingEngine& _renderer);
+	void Emit(int _count); //Releases up to _count particles straight away
 	void ReleaseParticle(int _particleIndex);
 	bool isTooOld(int _particleIndex);
 	void SetVelocityRange(float _minX, float _minY, float _minZ,
@@ -47,11 +58,17 @@ public:
 	float stiffness;
 	bool enabled;
 	bool isChangedInGUI;
+	vec4 sparseColor; //Drawn colour of a particle with no neighbours, or a newborn native particle
+	vec4 denseColor; //Drawn colour of a particle inside a body of fluid, or a dying native particle
+	float particleMaxAge; //Seconds a native particle lives for
+	ParticleBackend backend; //Picked at startup from the running physics engine
 	PxParticleFluid* particleFluid;
 
 private:
+	bool SpawnParticle();
 	int GetNextFreeParticle();
 	bool AddPhysXParticle(int _particleIndex);
+	vec3 GetRandomVelocity() const;
 
 	vec3 m_minVelocity;
 	vec3 m_maxVelocity;
@@ -64,8 +81,10 @@ private:
 	float m_releaseDelay;
 	float m_time;
 	float m_respawnTime;
-	float m_particleMaxAge;
 	FluidParticle* m_activeParticles;
+	vector<int> m_freeParticles; //PhysX particle indices ready to be reused
+	vector<vec4> m_particles; //Valid PhysX particles as xyz position and w density, read back in Update
+	ParticleSystem m_system;
 };
 
 #endif // _PARTICLE_EMITTER_H_
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "ParticleRenderer.h"
+
+// Other
+#include <algorithm>
+#include <chrono>
+
+// Public
+ParticleRenderer::ParticleRenderer() :
+	particleCount(0),
+	uploadTime(0.0f),
+	m_shader("particle-sprite"),
+	m_batchFirst(0),
+	m_capacity(0) {
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_vbo);
+
+	// One vec4 per particle, the sprite's corners come from gl_VertexID
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(vec4), 0);
+	glVertexAttribDivisor(0, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+ParticleRenderer::~ParticleRenderer() {
+	glDeleteBuffers(1, &m_vbo);
+	glDeleteVertexArrays(1, &m_vao);
+}
+vec4* ParticleRenderer::BeginBatch(unsigned int _maxCount) {
+	m_batchFirst = m_particles.size();
+	m_particles.resize(m_batchFirst + _maxCount);
+	return _maxCount > 0 ? &m_particles[m_batchFirst] : nullptr;
+}
+void ParticleRenderer::EndBatch(unsigned int _count, float _size, const vec4& _sparseColor, const vec4& _denseColor) {
+	m_particles.resize(m_batchFirst + _count);
+	if (_count == 0) {
+		return;
+	}
+	ParticleBatch batch;
+	batch.first = m_batchFirst;
+	batch.count = _count;
+	batch.size = _size;
+	batch.sparseColor = _sparseColor;
+	batch.denseColor = _denseColor;
+	m_batches.push_back(batch);
+}
+void ParticleRenderer::Draw(const mat4& _projection, const mat4& _view) {
+	particleCount = m_particles.size();
+	uploadTime = 0.0f;
+	if (m_batches.empty()) {
+		m_particles.clear();
+		return;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	if (particleCount > m_capacity) {
+		m_capacity = std::max(particleCount, m_capacity * 2);
+	}
+	// Note(Manny): Orphaning gives the driver a fresh block, so last frame's
+	// draws never stall this copy
+	glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(vec4), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, particleCount * sizeof(vec4), &m_particles[0]);
+	uploadTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// The view matrix's rows are the camera's axes in world space
+	vec3 cameraRight(_view[0][0], _view[1][0], _view[2][0]);
+	vec3 cameraUp(_view[0][1], _view[1][1], _view[2][1]);
+
+	m_shader.Enable();
+	m_shader.SetMatrix4("viewProj", 1, _projection * _view);
+	m_shader.SetVector3("cameraRight", cameraRight);
+	m_shader.SetVector3("cameraUp", cameraUp);
+	glBindVertexArray(m_vao);
+	for (unsigned int i = 0; i < m_batches.size(); ++i) {
+		const ParticleBatch& batch = m_batches[i];
+		m_shader.SetFloat("particleSize", batch.size);
+		m_shader.SetVector4("sparseColor", batch.sparseColor);
+		m_shader.SetVector4("denseColor", batch.denseColor);
+		// Pointing the attribute at the batch lets every batch share the one buffer
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(vec4), (void*)(batch.first * sizeof(vec4)));
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, batch.count);
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_shader.Disable();
+
+	m_particles.clear();
+	m_batches.clear();
+}
\ No newline at end of file
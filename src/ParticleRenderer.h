@@ -0,0 +1,63 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: ParticleRenderer.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: Draws every emitter's particles as
+camera facing sprites, with one instanced draw
+call per emitter.
+===============================================*/
+
+#ifndef _PARTICLE_RENDERER_H_
+#define _PARTICLE_RENDERER_H_
+
+// Objects
+#include "Shader.h"
+
+// Utilities
+#include "GLM_Header.h"
+
+// Other
+#include <vector>
+using std::vector;
+
+// Particles of one emitter, drawn with the same size and colours
+struct ParticleBatch {
+	unsigned int first;
+	unsigned int count;
+	float size; //World space radius of a particle
+	vec4 sparseColor; //Colour of a particle with no neighbours
+	vec4 denseColor; //Colour of a particle inside a body of fluid
+};
+
+// Emitters write their particles straight into one staging array, which is
+// uploaded to the GPU in a single copy when the frame's particles are drawn.
+class ParticleRenderer {
+public:
+	ParticleRenderer();
+	~ParticleRenderer();
+	// Returns room for _maxCount particles, each written as xyz position and w density
+	vec4* BeginBatch(unsigned int _maxCount);
+	// Submits the first _count particles written since BeginBatch
+	void EndBatch(unsigned int _count, float _size, const vec4& _sparseColor, const vec4& _denseColor);
+	void Draw(const mat4& _projection, const mat4& _view);
+
+	unsigned int particleCount; //Particles drawn last frame
+	float uploadTime; //Milliseconds spent copying last frame's particles to the GPU
+
+private:
+	ParticleRenderer(const ParticleRenderer& other) {}
+	void operator=(const ParticleRenderer& other) {}
+
+	Shader m_shader;
+	vector<vec4> m_particles;
+	vector<ParticleBatch> m_batches;
+	unsigned int m_batchFirst; //First particle of the batch being written
+	GLuint m_vao;
+	GLuint m_vbo;
+	unsigned int m_capacity; //Particles the VBO can hold before it has to grow
+};
+
+#endif // _PARTICLE_RENDERER_H_
@@ -0,0 +1,213 @@
+#include "ParticleSystem.h"
+
+// Components
+#include "PlaneCollider.h"
+#include "SphereCollider.h"
+#include "ComponentPool.h"
+#include "Transform.h"
+
+// Utilities
+#include "JobSystem.h"
+
+// Other
+#include <xmmintrin.h>
+#include <chrono>
+
+// Picks _a where the mask is set and _b everywhere else
+static inline __m128 Select(__m128 _mask, __m128 _a, __m128 _b) {
+	return _mm_or_ps(_mm_and_ps(_mask, _a), _mm_andnot_ps(_mask, _b));
+}
+
+// Public
+ParticleSystem::ParticleSystem() :
+	radius(0.15f),
+	drag(0.01f),
+	restitution(0.0f),
+	friction(0.01f),
+	collisionEnabled(true),
+	updateTime(0.0f),
+	m_count(0),
+	m_maxParticles(0) {}
+void ParticleSystem::Reserve(unsigned int _maxParticles) {
+	// Note(Manny): Padded to a multiple of 4, so the last group of four
+	// particles never reads past the end of the arrays
+	unsigned int paddedCount = (_maxParticles + 3) & ~3u;
+	m_positionX.assign(paddedCount, 0.0f);
+	m_positionY.assign(paddedCount, 0.0f);
+	m_positionZ.assign(paddedCount, 0.0f);
+	m_velocityX.assign(paddedCount, 0.0f);
+	m_velocityY.assign(paddedCount, 0.0f);
+	m_velocityZ.assign(paddedCount, 0.0f);
+	m_age.assign(paddedCount, 0.0f);
+	m_lifetime.assign(paddedCount, 0.0f);
+	m_maxParticles = _maxParticles;
+	m_count = 0;
+}
+void ParticleSystem::Clear() {
+	m_count = 0;
+}
+bool ParticleSystem::Emit(const vec3& _position, const vec3& _velocity, float _lifetime) {
+	if (m_count >= m_maxParticles) {
+		return false;
+	}
+	unsigned int index = m_count++;
+	m_positionX[index] = _position.x;
+	m_positionY[index] = _position.y;
+	m_positionZ[index] = _position.z;
+	m_velocityX[index] = _velocity.x;
+	m_velocityY[index] = _velocity.y;
+	m_velocityZ[index] = _velocity.z;
+	m_age[index] = 0.0f;
+	m_lifetime[index] = _lifetime;
+	return true;
+}
+void ParticleSystem::Update(float _deltaTime, const vec3& _gravity) {
+	updateTime = 0.0f;
+	if (m_count == 0) {
+		return;
+	}
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	GatherColliders();
+
+	// Chunks start on a multiple of CHUNK_SIZE, so every job works on whole groups of four
+	JobSystem::ParallelFor(m_count, CHUNK_SIZE, [this, _deltaTime, &_gravity](unsigned int _begin, unsigned int _end) {
+		Simulate(_begin, _end, _deltaTime, _gravity);
+	});
+
+	for (unsigned int i = 0; i < m_count;) {
+		if (m_age[i] >= m_lifetime[i]) {
+			Remove(i);
+		} else {
+			++i;
+		}
+	}
+	updateTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+void ParticleSystem::Write(vec4* _particles) const {
+	JobSystem::ParallelFor(m_count, CHUNK_SIZE, [this, _particles](unsigned int _begin, unsigned int _end) {
+		for (unsigned int i = _begin; i < _end; ++i) {
+			float age = m_lifetime[i] > 0.0f ? m_age[i] / m_lifetime[i] : 1.0f;
+			_particles[i] = vec4(m_positionX[i], m_positionY[i], m_positionZ[i], glm::min(age, 1.0f));
+		}
+	});
+}
+
+// Private
+void ParticleSystem::GatherColliders() {
+	m_planes.clear();
+	m_spheres.clear();
+	if (!collisionEnabled) {
+		return;
+	}
+	// Note(Manny): Planes are tested the same way CustomPhysicsEngine::SphereToPlane does
+	vector<PlaneCollider*>& planes = ComponentPool<PlaneCollider>::Get().components;
+	for (unsigned int i = 0; i < planes.size(); ++i) {
+		if (planes[i]->enabled && !planes[i]->isTrigger) {
+			m_planes.push_back(vec4(planes[i]->normal, planes[i]->distance));
+		}
+	}
+	vector<SphereCollider*>& spheres = ComponentPool<SphereCollider>::Get().components;
+	for (unsigned int i = 0; i < spheres.size(); ++i) {
+		if (spheres[i]->enabled && !spheres[i]->isTrigger) {
+			m_spheres.push_back(vec4(spheres[i]->transform->position, spheres[i]->radius));
+		}
+	}
+}
+void ParticleSystem::Simulate(unsigned int _begin, unsigned int _end, float _deltaTime, const vec3& _gravity) {
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 deltaTime = _mm_set1_ps(_deltaTime);
+	const __m128 gravityX = _mm_set1_ps(_gravity.x * _deltaTime);
+	const __m128 gravityY = _mm_set1_ps(_gravity.y * _deltaTime);
+	const __m128 gravityZ = _mm_set1_ps(_gravity.z * _deltaTime);
+	const __m128 dragScale = _mm_set1_ps(glm::max(0.0f, 1.0f - drag * _deltaTime));
+	const __m128 particleRadius = _mm_set1_ps(radius);
+	const __m128 bounce = _mm_set1_ps(restitution);
+	const __m128 slide = _mm_set1_ps(glm::clamp(1.0f - friction, 0.0f, 1.0f));
+	const __m128 minDistanceSquared = _mm_set1_ps(1e-12f);
+
+	for (unsigned int i = _begin; i < _end; i += 4) {
+		__m128 positionX = _mm_loadu_ps(&m_positionX[i]);
+		__m128 positionY = _mm_loadu_ps(&m_positionY[i]);
+		__m128 positionZ = _mm_loadu_ps(&m_positionZ[i]);
+		__m128 velocityX = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&m_velocityX[i]), gravityX), dragScale);
+		__m128 velocityY = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&m_velocityY[i]), gravityY), dragScale);
+		__m128 velocityZ = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&m_velocityZ[i]), gravityZ), dragScale);
+		positionX = _mm_add_ps(positionX, _mm_mul_ps(velocityX, deltaTime));
+		positionY = _mm_add_ps(positionY, _mm_mul_ps(velocityY, deltaTime));
+		positionZ = _mm_add_ps(positionZ, _mm_mul_ps(velocityZ, deltaTime));
+
+		for (unsigned int j = 0; j < m_planes.size(); ++j) {
+			__m128 normalX = _mm_set1_ps(m_planes[j].x);
+			__m128 normalY = _mm_set1_ps(m_planes[j].y);
+			__m128 normalZ = _mm_set1_ps(m_planes[j].z);
+			__m128 offset = _mm_set1_ps(m_planes[j].w + radius);
+
+			// Negative depth means the particle has sunk into the plane
+			__m128 depth = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(positionX, normalX), _mm_mul_ps(positionY, normalY)), _mm_mul_ps(positionZ, normalZ)), offset);
+			__m128 hit = _mm_cmplt_ps(depth, zero);
+			if (_mm_movemask_ps(hit) == 0) {
+				continue;
+			}
+			depth = _mm_and_ps(hit, depth);
+			positionX = _mm_sub_ps(positionX, _mm_mul_ps(normalX, depth));
+			positionY = _mm_sub_ps(positionY, _mm_mul_ps(normalY, depth));
+			positionZ = _mm_sub_ps(positionZ, _mm_mul_ps(normalZ, depth));
+
+			// Only particles moving into the plane bounce off it
+			__m128 normalSpeed = _mm_add_ps(_mm_add_ps(_mm_mul_ps(velocityX, normalX), _mm_mul_ps(velocityY, normalY)), _mm_mul_ps(velocityZ, normalZ));
+			hit = _mm_and_ps(hit, _mm_cmplt_ps(normalSpeed, zero));
+			__m128 reflected = _mm_mul_ps(normalSpeed, bounce);
+			velocityX = Select(hit, _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(velocityX, _mm_mul_ps(normalX, normalSpeed)), slide), _mm_mul_ps(normalX, reflected)), velocityX);
+			velocityY = Select(hit, _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(velocityY, _mm_mul_ps(normalY, normalSpeed)), slide), _mm_mul_ps(normalY, reflected)), velocityY);
+			velocityZ = Select(hit, _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(velocityZ, _mm_mul_ps(normalZ, normalSpeed)), slide), _mm_mul_ps(normalZ, reflected)), velocityZ);
+		}
+
+		for (unsigned int j = 0; j < m_spheres.size(); ++j) {
+			__m128 toParticleX = _mm_sub_ps(positionX, _mm_set1_ps(m_spheres[j].x));
+			__m128 toParticleY = _mm_sub_ps(positionY, _mm_set1_ps(m_spheres[j].y));
+			__m128 toParticleZ = _mm_sub_ps(positionZ, _mm_set1_ps(m_spheres[j].z));
+			__m128 minDistance = _mm_add_ps(_mm_set1_ps(m_spheres[j].w), particleRadius);
+
+			__m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toParticleX, toParticleX), _mm_mul_ps(toParticleY, toParticleY)), _mm_mul_ps(toParticleZ, toParticleZ));
+			__m128 hit = _mm_and_ps(_mm_cmplt_ps(distanceSquared, _mm_mul_ps(minDistance, minDistance)), _mm_cmpgt_ps(distanceSquared, minDistanceSquared));
+			if (_mm_movemask_ps(hit) == 0) {
+				continue;
+			}
+			__m128 distance = _mm_sqrt_ps(_mm_max_ps(distanceSquared, minDistanceSquared));
+			__m128 normalX = _mm_div_ps(toParticleX, distance);
+			__m128 normalY = _mm_div_ps(toParticleY, distance);
+			__m128 normalZ = _mm_div_ps(toParticleZ, distance);
+			__m128 depth = _mm_and_ps(hit, _mm_sub_ps(minDistance, distance));
+			positionX = _mm_add_ps(positionX, _mm_mul_ps(normalX, depth));
+			positionY = _mm_add_ps(positionY, _mm_mul_ps(normalY, depth));
+			positionZ = _mm_add_ps(positionZ, _mm_mul_ps(normalZ, depth));
+
+			__m128 normalSpeed = _mm_add_ps(_mm_add_ps(_mm_mul_ps(velocityX, normalX), _mm_mul_ps(velocityY, normalY)), _mm_mul_ps(velocityZ, normalZ));
+			hit = _mm_and_ps(hit, _mm_cmplt_ps(normalSpeed, zero));
+			__m128 reflected = _mm_mul_ps(normalSpeed, bounce);
+			velocityX = Select(hit, _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(velocityX, _mm_mul_ps(normalX, normalSpeed)), slide), _mm_mul_ps(normalX, reflected)), velocityX);
+			velocityY = Select(hit, _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(velocityY, _mm_mul_ps(normalY, normalSpeed)), slide), _mm_mul_ps(normalY, reflected)), velocityY);
+			velocityZ = Select(hit, _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(velocityZ, _mm_mul_ps(normalZ, normalSpeed)), slide), _mm_mul_ps(normalZ, reflected)), velocityZ);
+		}
+
+		_mm_storeu_ps(&m_positionX[i], positionX);
+		_mm_storeu_ps(&m_positionY[i], positionY);
+		_mm_storeu_ps(&m_positionZ[i], positionZ);
+		_mm_storeu_ps(&m_velocityX[i], velocityX);
+		_mm_storeu_ps(&m_velocityY[i], velocityY);
+		_mm_storeu_ps(&m_velocityZ[i], velocityZ);
+		_mm_storeu_ps(&m_age[i], _mm_add_ps(_mm_loadu_ps(&m_age[i]), deltaTime));
+	}
+}
+void ParticleSystem::Remove(unsigned int _index) {
+	// Swap the last live particle into the removed one to keep them packed
+	unsigned int last = --m_count;
+	m_positionX[_index] = m_positionX[last];
+	m_positionY[_index] = m_positionY[last];
+	m_positionZ[_index] = m_positionZ[last];
+	m_velocityX[_index] = m_velocityX[last];
+	m_velocityY[_index] = m_velocityY[last];
+	m_velocityZ[_index] = m_velocityZ[last];
+	m_age[_index] = m_age[last];
+	m_lifetime[_index] = m_lifetime[last];
+}
\ No newline at end of file
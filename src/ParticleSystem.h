@@ -0,0 +1,65 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: ParticleSystem.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: A CPU particle simulation that needs
+no physics SDK, used by ParticleEmitters when
+PhysX is not the running physics engine.
+===============================================*/
+
+#ifndef _PARTICLE_SYSTEM_H_
+#define _PARTICLE_SYSTEM_H_
+
+// Utilities
+#include "GLM_Header.h"
+
+// Other
+#include <vector>
+using std::vector;
+
+// Every property lives in its own array so four particles are integrated at
+// once with SSE. Live particles are kept packed at the front of the arrays,
+// a dead particle is replaced by the last live one.
+class ParticleSystem {
+public:
+	ParticleSystem();
+	void Reserve(unsigned int _maxParticles); //Also removes every live particle
+	void Clear();
+	bool Emit(const vec3& _position, const vec3& _velocity, float _lifetime); //False once full
+	void Update(float _deltaTime, const vec3& _gravity);
+	// Writes xyz position and w age, from 0 when born to 1 when it dies
+	void Write(vec4* _particles) const;
+	inline unsigned int GetCount() const { return m_count; }
+	inline unsigned int GetMaxParticles() const { return m_maxParticles; }
+
+	float radius; //Distance a particle keeps from colliders
+	float drag; //Fraction of velocity lost per second
+	float restitution; //Bounce off colliders, 0 stops dead and 1 is fully elastic
+	float friction; //Fraction of sliding velocity lost on each contact
+	bool collisionEnabled; //Collides with every enabled plane and sphere collider
+	float updateTime; //Milliseconds the last Update took
+
+	static const unsigned int CHUNK_SIZE = 4096; //Particles integrated per job, a multiple of 4
+private:
+	void GatherColliders();
+	void Simulate(unsigned int _begin, unsigned int _end, float _deltaTime, const vec3& _gravity);
+	void Remove(unsigned int _index);
+
+	unsigned int m_count;
+	unsigned int m_maxParticles;
+	vector<float> m_positionX;
+	vector<float> m_positionY;
+	vector<float> m_positionZ;
+	vector<float> m_velocityX;
+	vector<float> m_velocityY;
+	vector<float> m_velocityZ;
+	vector<float> m_age;
+	vector<float> m_lifetime;
+	vector<vec4> m_planes; //xyz normal and w distance from the origin
+	vector<vec4> m_spheres; //xyz center and w radius
+};
+
+#endif // _PARTICLE_SYSTEM_H_
@@ -30,6 +30,7 @@
 
 // Other
 #include "Time.h"
+#include "JobSystem.h"
 
 #define Assert(val) if (val){}else{ *((char*)0) = 0;}
 #define ArrayCount(val) (sizeof(val)/sizeof(val[0]))
@@ -46,6 +47,22 @@ public:
 	}
 };
 
+// Runs PhysX tasks on the engine's job system instead of a separate thread pool
+class PhysXJobDispatcher : public PxCpuDispatcher {
+public:
+	virtual ~PhysXJobDispatcher(){}
+	virtual void submitTask(PxBaseTask& _task) {
+		PxBaseTask* task = &_task;
+		JobSystem::Run([task]() {
+			task->run();
+			task->release();
+		});
+	}
+	virtual PxU32 getWorkerCount() const {
+		return JobSystem::GetWorkerCount();
+	}
+};
+
 class PhysXErrorCallback : public PxErrorCallback {
 public:
 	virtual void reportError(PxErrorCode::Enum code, const char* message, const char* file, int line) {
@@ -151,8 +168,9 @@ bool PhysXEngine::Startup() {
 	sceneDesc.gravity = PxVec3(gravity.x, gravity.y, gravity.z);
 	sceneDesc.filterShader = &PxDefaultSimulationFilterShader;
 	
-	// Create CPU dispatcher which mNbThreads worker threads
-	sceneDesc.cpuDispatcher = PxDefaultCpuDispatcherCreate(1);
+	// PhysX shares the job system's worker threads
+	cpuDispatcher = new PhysXJobDispatcher();
+	sceneDesc.cpuDispatcher = cpuDispatcher;
 
 #ifdef PX_WINDOWS
 	PxCudaContextManagerDesc cudaContextManagerDesc;
@@ -180,21 +198,50 @@ bool PhysXEngine::Startup() {
 }
 
 void PhysXEngine::Shutdown() {
+	WaitForSimulation();
 	actors.clear();
+	m_poses.clear();
 	characterManager->release();
 	PxCloseExtensions();
 	physicsCooker->release();
 	physics->release();
 	cudaContextManager->release();
 	physicsFoundation->release();
+	delete cpuDispatcher;
 }
 
 bool PhysXEngine::Update() {
-	if (Time::deltaTime <= 0) return true;
-
-	physicsScene->simulate(Time::deltaTime > 0.033f ? 0.033f : Time::deltaTime);
-	while (physicsScene->fetchResults() == false);
+	// Collect the step that ran while the last frame was drawn
+	bool stepped = m_isSimulating;
+	WaitForSimulation();
+	ReadActors();
+	if (stepped) {
+		StoreSteppedPoses();
+	}
+
+	// Extra steps run now, the last one overlaps with rendering
+	m_queuedSteps = BeginFixedUpdate(Time::deltaTime);
+	while (m_queuedSteps > 1) {
+		physicsScene->simulate(timeStep);
+		m_isSimulating = true;
+		WaitForSimulation();
+		// Each catch up step gets its own pose so previous and current stay one step apart
+		ReadActors();
+		StoreSteppedPoses();
+		m_queuedSteps--;
+	}
+	InterpolatePoses();
 
+	return true;
+}
+void PhysXEngine::LateUpdate() {
+	if (m_queuedSteps > 0) {
+		physicsScene->simulate(timeStep);
+		m_isSimulating = true;
+		m_queuedSteps = 0;
+	}
+}
+void PhysXEngine::ReadActors() {
 	for (unsigned int i = 0; i < actors.size(); ++i) {
 		PhysXActor* actor = &actors[i];
 		PhysicsObject* physicsObject = actors[i].physicsObject;
@@ -241,8 +288,26 @@ bool PhysXEngine::Update() {
 			UpdateArticulationRagdoll(articulation);
 		}
 	}
-
-	return true;
+}
+void PhysXEngine::StoreSteppedPoses() {
+	// The poses just read back become current, the last ones become previous
+	for (unsigned int i = 0; i < m_poses.size(); ++i) {
+		m_poses[i].previousPosition = m_poses[i].currentPosition;
+		m_poses[i].previousRotation = m_poses[i].currentRotation;
+	}
+	StoreCurrentPoses();
+}
+void PhysXEngine::WaitForSimulation() {
+	if (!m_isSimulating) {
+		return;
+	}
+	// Help the workers with the simulation tasks instead of spinning
+	while (physicsScene->fetchResults() == false) {
+		if (!JobSystem::RunPendingJob()) {
+			std::this_thread::yield();
+		}
+	}
+	m_isSimulating = false;
 }
 
 // Actor
@@ -504,6 +569,7 @@ bool PhysXEngine::RemoveActor(PhysicsObject* _actor) {
 		// Check if actor already exists in list 
 		if (actors[actorIndex].physicsObject == _actor) {
 			actors.erase(actors.begin() + actorIndex);
+			RemovePose(&_actor->gameObject->transform);
 			return true;
 		}
 	}
@@ -582,6 +648,8 @@ bool PhysXEngine::CreateParticleEmitter(ParticleEmitter& _particleEmitter, Physi
 
 	// eCOLLISION_TWOWAY tells PhysX to sends a collision response to any object the particles hit
 	particleFluid->setParticleBaseFlag(PxParticleBaseFlag::eCOLLISION_TWOWAY, false);
+	// Density is read back to colour the particles when they are drawn
+	particleFluid->setParticleReadDataFlag(PxParticleReadDataFlag::eDENSITY_BUFFER, true);
 	
 	if (particleFluid) {
 		particleEmitter.pxActor = particleFluid;
@@ -612,10 +680,12 @@ bool PhysXEngine::CreateRigidbody(Rigidbody& _rigidbody, PhysicsObject* _actor)
 
 			physicsObject.shapeId = collider->shapeId;
 			if (collider->shapeId != SHAPE_MESH) {
-				if (!gameObject->isStatic)
+				if (!gameObject->isStatic) {
 					physicsObject.pxActor = PxCreateDynamic(*physics, pose, *geometry, *physicsMaterial, _rigidbody.density);
-				else
+					AddPose(&gameObject->transform);
+				} else {
 					physicsObject.pxActor = PxCreateStatic(*physics, pose, *geometry, *physicsMaterial);
+				}
 
 				_rigidbody.isKinematic = false;
 			} else {
@@ -815,7 +885,7 @@ PxGeometry* PhysXEngine::GetColliderGeometry(Collider* _collider) {
 		MeshCollider* meshCollider = dynamic_cast<MeshCollider*>(_collider);
 		GameObject* gameObject = meshCollider->gameObject;
 		Mesh* meshObject = meshCollider->meshObject;
-		IndexedModel* model = meshObject->model;
+		IndexedModel* model = meshObject->GetModel();
 
 		MeshData& mesh = model->meshes[0];
 
@@ -860,7 +930,7 @@ vector<PxGeometry*> PhysXEngine::GetMeshColliderGeometry(Collider* _collider) {
 	if (meshCollider) {
 		GameObject* gameObject = meshCollider->gameObject;
 		Mesh* meshObject = meshCollider->meshObject;
-		IndexedModel* model = meshObject->model;
+		IndexedModel* model = meshObject->GetModel();
 
 		for (unsigned int i = 0; i < model->meshes.size(); ++i) {
 			MeshData& mesh = model->meshes[i];
@@ -76,11 +76,12 @@ class Ragdoll;
 
 class PhysXEngine : public PhysicsEngine {
 public:
-	PhysXEngine(){}
+	PhysXEngine() : m_isSimulating(false), m_queuedSteps(0) {}
 	virtual ~PhysXEngine(){}
 	bool Startup();
 	void Shutdown();
 	bool Update();
+	void LateUpdate();
 	void AddActor(PhysicsObject* _actor);
 	bool RemoveActor(PhysicsObject* _actor);
 	void AddArticulation(PhysicsObject* _articulation);
@@ -117,12 +118,20 @@ public:
 	PxMaterial*	boxMaterial;
 	PxMaterial*	ragdollMaterial;
 	PxCooking* physicsCooker;
+	PxCpuDispatcher* cpuDispatcher;
 	PxProfileZoneManager* profileZoneManager;
 	PxCudaContextManager* cudaContextManager;
 	PxControllerManager* characterManager;
 	PhysXControllerHitReportCallback* characterHitReport;
 	PxMaterial*	playerPhysicsMaterial;
 	PxController* playerController;
+private:
+	void WaitForSimulation();
+	void ReadActors();
+	void StoreSteppedPoses();
+
+	bool m_isSimulating; //A step is running while the frame renders
+	int m_queuedSteps; //Steps still to start in LateUpdate
 };
 
 
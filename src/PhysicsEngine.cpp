@@ -0,0 +1,76 @@
+#include "PhysicsEngine.h"
+
+// Components
+#include "Transform.h"
+
+int PhysicsEngine::BeginFixedUpdate(float _deltaTime) {
+	if (_deltaTime > 0) {
+		m_accumulator += _deltaTime;
+	}
+
+	int steps = (int)(m_accumulator / timeStep);
+	if (steps > maxSubSteps) {
+		// Note(Manny): Falling behind, drop the time we can't afford to
+		// simulate rather than taking even longer next frame
+		steps = maxSubSteps;
+		m_accumulator = timeStep * steps;
+	}
+	m_accumulator -= timeStep * steps;
+	alpha = m_accumulator / timeStep;
+	return steps;
+}
+void PhysicsEngine::AddPose(Transform* _transform) {
+	PhysicsPose pose;
+	pose.transform = _transform;
+	pose.previousPosition = pose.currentPosition = pose.renderedPosition = _transform->position;
+	pose.previousRotation = pose.currentRotation = pose.renderedRotation = _transform->rotation;
+	m_poses.push_back(pose);
+}
+void PhysicsEngine::RemovePose(Transform* _transform) {
+	for (unsigned int i = 0; i < m_poses.size(); ++i) {
+		if (m_poses[i].transform == _transform) {
+			m_poses.erase(m_poses.begin() + i);
+			return;
+		}
+	}
+}
+void PhysicsEngine::RestorePoses() {
+	for (unsigned int i = 0; i < m_poses.size(); ++i) {
+		PhysicsPose& pose = m_poses[i];
+		Transform* transform = pose.transform;
+		if (transform->position == pose.renderedPosition && transform->rotation == pose.renderedRotation) {
+			transform->position = pose.currentPosition;
+			transform->rotation = pose.currentRotation;
+		} else {
+			// Moved by the game since the last frame, so teleport there
+			pose.previousPosition = pose.currentPosition = transform->position;
+			pose.previousRotation = pose.currentRotation = transform->rotation;
+		}
+	}
+}
+void PhysicsEngine::StorePreviousPoses() {
+	for (unsigned int i = 0; i < m_poses.size(); ++i) {
+		m_poses[i].previousPosition = m_poses[i].transform->position;
+		m_poses[i].previousRotation = m_poses[i].transform->rotation;
+	}
+}
+void PhysicsEngine::StoreCurrentPoses() {
+	for (unsigned int i = 0; i < m_poses.size(); ++i) {
+		m_poses[i].currentPosition = m_poses[i].transform->position;
+		m_poses[i].currentRotation = m_poses[i].transform->rotation;
+	}
+}
+void PhysicsEngine::InterpolatePoses() {
+	for (unsigned int i = 0; i < m_poses.size(); ++i) {
+		PhysicsPose& pose = m_poses[i];
+		if (interpolate) {
+			pose.renderedPosition = glm::mix(pose.previousPosition, pose.currentPosition, alpha);
+			pose.renderedRotation = glm::slerp(pose.previousRotation, pose.currentRotation, alpha);
+		} else {
+			pose.renderedPosition = pose.currentPosition;
+			pose.renderedRotation = pose.currentRotation;
+		}
+		pose.transform->position = pose.renderedPosition;
+		pose.transform->rotation = pose.renderedRotation;
+	}
+}
\ No newline at end of file
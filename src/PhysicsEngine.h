@@ -29,17 +29,31 @@ enum ShapeID
 
 class PhysicsObject;
 class Collider;
+class Transform;
+
+// The last two simulated poses of a body, rendered in between
+struct PhysicsPose {
+	Transform* transform;
+	vec3 previousPosition;
+	vec3 currentPosition;
+	vec3 renderedPosition;
+	quat previousRotation;
+	quat currentRotation;
+	quat renderedRotation;
+};
 
 class PhysicsEngine
 {
 public:
-	PhysicsEngine() : collisionEnabled(true), timeStep(0.001f), gravity(vec3(0, -9.807f, 0)) {}
+	PhysicsEngine() : collisionEnabled(true), interpolate(true), timeStep(1.0f / 60.0f), maxSubSteps(4),
+		gravity(vec3(0, -9.807f, 0)), alpha(0), m_accumulator(0) {}
 	~PhysicsEngine(){}
 
 	virtual bool Startup(){ return true; }
 	virtual void Shutdown(){}
 
 	virtual bool Update() = 0;
+	virtual void LateUpdate(){} //Called once the game has updated
 	
 	virtual void AddActor(PhysicsObject* _actor) = 0;
 	virtual bool RemoveActor(PhysicsObject* _actor) = 0;
@@ -48,8 +62,23 @@ public:
 	virtual bool RemoveArticulation(PhysicsObject* _articulation) = 0;
 
 	bool collisionEnabled;
-	float timeStep;
+	bool interpolate; //Render bodies between their last two simulated poses
+	float timeStep; //Length of one fixed simulation step
+	int maxSubSteps; //Most steps simulated in one frame, the rest of the time is dropped
 	vec3 gravity;
+	float alpha; //How far the frame is between the last two steps
+protected:
+	int BeginFixedUpdate(float _deltaTime);
+	void AddPose(Transform* _transform);
+	void RemovePose(Transform* _transform);
+	void RestorePoses();
+	void StorePreviousPoses();
+	void StoreCurrentPoses();
+	void InterpolatePoses();
+
+	vector<PhysicsPose> m_poses;
+private:
+	float m_accumulator;
 };
 
 #endif //_PHYSICS_ENGINE_H_
\ No newline at end of file
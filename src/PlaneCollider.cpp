@@ -20,6 +20,8 @@ PlaneCollider::~PlaneCollider(){}
 
 bool PlaneCollider::Startup() {
 	gameObject->AddCollider(this);
+	normal = transform->up;
+	distance = glm::dot(normal, transform->position);
 	return true;
 }
 
@@ -36,7 +38,7 @@ bool PlaneCollider::Update() {
 	}
 
 	normal = transform->up;
-	distance = glm::length(transform->position);
+	distance = glm::dot(normal, transform->position); //Signed, so planes below the origin work too
 	return true;
 }
 
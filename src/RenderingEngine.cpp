@@ -1,6 +1,13 @@
 #include "RenderingEngine.h"
 #include "GameObject.h"
 
+// Components
+#include "Animator.h"
+#include "ComponentPool.h"
+
+// Utilities
+#include "JobSystem.h"
+
 // GUI
 #include "imgui.h"
 
@@ -10,6 +17,7 @@
 
 // Other
 #include <algorithm>
+#include <chrono>
 
 const mat4 RenderingEngine::BIAS_MATRIX = glm::scale(vec3(0.5, 0.5, 0.5)) * glm::translate(vec3(1.0, 1.0, 1.0));
 // Construct a Matrix in this format:
@@ -26,6 +34,8 @@ const mat4 RenderingEngine::BIAS_MATRIX = glm::scale(vec3(0.5, 0.5, 0.5)) * glm:
 vector<DirectionalLight*>	RenderingEngine::m_dirLights;
 vector<PointLight*>			RenderingEngine::m_pointLights;
 
+bool RenderingEngine::instancingEnabled = true;
+
 // Public
 RenderingEngine::RenderingEngine() :
 	m_plane(Mesh("plane.obj")),
@@ -37,12 +47,24 @@ RenderingEngine::RenderingEngine() :
 	m_gausBlurFilter("filter-gausBlur7x1"),
 	m_fxaaFilter("filter-fxaa"),
 	m_lightingShader("default-forward-lighting"),
+	m_instancedLightingShader("default-forward-lighting-instanced"),
 	m_altCameraTransform(vec3(0, 0, 0), quat(glm::radians(180.0f), vec3(0, 1, 0)), vec3(1)),
 	m_altCamera(mat4(), &m_altCameraTransform),
 	m_fxaaSpanMax(8.0f),
 	m_fxaaReduceMin(1.0f / 128.0f),
 	m_fxaaReduceMul(1.0f / 8.0f),
-	m_fxaaAspectDistortion(150.0f) {
+	m_fxaaAspectDistortion(150.0f),
+	m_instanceBufferOffset(0),
+	m_gridLayer(0),
+	m_displayTextureId(GetPropertyId("displayTexture")),
+	m_filterTextureId(GetPropertyId("filterTexture")),
+	m_blurScaleId(GetPropertyId("blurScale")),
+	m_inverseFilterTextureSizeId(GetPropertyId("inverseFilterTextureSize")),
+	m_shininessId(GetPropertyId("shininess")),
+	m_fxaaSpanMaxId(GetPropertyId("fxaaSpanMax")),
+	m_fxaaReduceMinId(GetPropertyId("fxaaReduceMin")),
+	m_fxaaReduceMulId(GetPropertyId("fxaaReduceMul")),
+	m_fxaaAspectDistortionId(GetPropertyId("fxaaAspectDistortion")) {
 
 	SetSamplerSlot("diffuse", 0);
 	SetSamplerSlot("normalMap", 1);
@@ -77,12 +99,88 @@ RenderingEngine::RenderingEngine() :
 	m_lightMatrix = glm::scale(vec3(0, 0, 0));
 	m_innerGridColor = Color(1, 1, 1, 25.0f / 255.0f);
 	m_outerGridColor = Color(1, 1, 1, 100.0f / 255.0f);
+
+	glGenBuffers(1, &m_instanceBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, INSTANCE_BUFFER_SIZE, NULL, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+RenderingEngine::~RenderingEngine() {
+	glDeleteBuffers(1, &m_instanceBuffer);
 }
 void RenderingEngine::AddDrawCommandMesh(DrawCommandMesh* _command) {
-	meshDrawCommands.push(_command);
+	meshDrawCommands.push_back(_command);
+}
+void RenderingEngine::CullMeshDrawCommands(vector<DrawCommandMesh*>& _meshDrawCommands) {
+	unsigned int commandCount = _meshDrawCommands.size();
+	m_cullCenterX.resize(commandCount);
+	m_cullCenterY.resize(commandCount);
+	m_cullCenterZ.resize(commandCount);
+	m_cullSizeX.resize(commandCount);
+	m_cullSizeY.resize(commandCount);
+	m_cullSizeZ.resize(commandCount);
+	m_cullVisible.resize(commandCount);
+
+	for (unsigned int i = 0; i < commandCount; ++i) {
+		const Bounds* bounds = _meshDrawCommands[i]->bounds;
+		if (bounds != nullptr) {
+			m_cullCenterX[i] = bounds->center.x;
+			m_cullCenterY[i] = bounds->center.y;
+			m_cullCenterZ[i] = bounds->center.z;
+			m_cullSizeX[i] = fabsf(bounds->size.x);
+			m_cullSizeY[i] = fabsf(bounds->size.y);
+			m_cullSizeZ[i] = fabsf(bounds->size.z);
+		} else {
+			m_cullCenterX[i] = m_cullCenterY[i] = m_cullCenterZ[i] = 0.0f;
+			m_cullSizeX[i] = m_cullSizeY[i] = m_cullSizeZ[i] = 0.0f;
+		}
+	}
+
+	// Test each run of commands that share a camera against that camera's frustum
+	unsigned int runStart = 0;
+	while (runStart < commandCount) {
+		Camera* camera = _meshDrawCommands[runStart]->camera;
+		unsigned int runEnd = runStart + 1;
+		while (runEnd < commandCount && _meshDrawCommands[runEnd]->camera == camera) {
+			runEnd++;
+		}
+		Frustum frustum(camera->projectionMatrix * camera->viewMatrix);
+		JobSystem::ParallelFor(runEnd - runStart, CULL_BATCH_SIZE, [&](unsigned int _begin, unsigned int _end) {
+			unsigned int first = runStart + _begin;
+			frustum.IntersectsAABBs(&m_cullCenterX[first], &m_cullCenterY[first], &m_cullCenterZ[first],
+				&m_cullSizeX[first], &m_cullSizeY[first], &m_cullSizeZ[first],
+				_end - _begin, &m_cullVisible[first]);
+		});
+		runStart = runEnd;
+	}
+
+	unsigned int visibleCount = 0;
+	for (unsigned int i = 0; i < commandCount; ++i) {
+		if (m_cullVisible[i] || _meshDrawCommands[i]->bounds == nullptr) {
+			_meshDrawCommands[visibleCount++] = _meshDrawCommands[i];
+		}
+	}
+	_meshDrawCommands.resize(visibleCount);
+
+	stats.visibleObjects += visibleCount;
+	stats.culledObjects += commandCount - visibleCount;
 }
-void RenderingEngine::OptimizeMeshRenderQueue(queue<DrawCommandMesh*>& _meshDrawCommands) {
-	// Note(Manny): Optimize mesh render queue to sort by game object renderer materials
+void RenderingEngine::OptimizeMeshRenderQueue(vector<DrawCommandMesh*>& _meshDrawCommands) {
+	// Note(Manny): Every sub-mesh becomes its own queue item so that
+	// sub-meshes sharing a material can be batched across renderers
+	for (unsigned int i = 0; i < _meshDrawCommands.size(); ++i) {
+		DrawCommandMesh* meshDrawCommand = _meshDrawCommands[i];
+		unsigned int meshCount = meshDrawCommand->mesh->GetModel()->meshes.size();
+		for (unsigned int j = 0; j < meshCount; ++j) {
+			if (meshDrawCommand->depthTestEnabled) {
+				renderQueue.push_back(RenderQueueItem(CreateSortKey(*meshDrawCommand, j), meshDrawCommand, j));
+			} else {
+				// Objects without depth testing are drawn over the scene in the order they were submitted
+				depthQueue.push_back(RenderQueueItem(depthQueue.size(), meshDrawCommand, j));
+			}
+		}
+	}
+	_meshDrawCommands.clear();
 }
 void RenderingEngine::Render(vector<GameObject*>& _objects) {
 	m_planeTransform.Update();
@@ -94,24 +192,39 @@ void RenderingEngine::Render(vector<GameObject*>& _objects) {
 	ImGui::DragFloat("FXAA Aspect Distortion", &m_fxaaAspectDistortion);
 	ImGui::End();
 
-	SetFloat("fxaaSpanMax", m_fxaaSpanMax);
-	SetFloat("fxaaReduceMin", m_fxaaReduceMin);
-	SetFloat("fxaaReduceMul", m_fxaaReduceMul);
-	SetFloat("fxaaAspectDistortion", m_fxaaAspectDistortion);
+	ImGui::Begin("Render Stats");
+	ImGui::Text("Visible Objects: %u (%u culled)", stats.visibleObjects, stats.culledObjects);
+	ImGui::Text("Draw Calls: %u (%u instanced, %u instances)", stats.drawCalls, stats.instancedDrawCalls, stats.instances);
+	ImGui::Text("Submit Time: %.2fms", stats.submitTime);
+	ImGui::Checkbox("GPU Instancing", &instancingEnabled);
+	ImGui::Text("Triangles: %u", stats.triangles);
+	ImGui::Text("Shader Changes: %u (%u avoided)", stats.shaderChanges, stats.shaderChangesAvoided);
+	ImGui::Text("Material Changes: %u (%u avoided)", stats.materialChanges, stats.materialChangesAvoided);
+	ImGui::Text("Animation: %.2fms (%u animators)", Animator::updateTime, ComponentPool<Animator>::Get().components.size());
+	ImGui::Text("Particles: %u (%.2fms upload)", particleRenderer.particleCount, particleRenderer.uploadTime);
+	ImGui::End();
+	stats.Reset();
+
+	SetFloat(m_fxaaSpanMaxId, m_fxaaSpanMax);
+	SetFloat(m_fxaaReduceMinId, m_fxaaReduceMin);
+	SetFloat(m_fxaaReduceMulId, m_fxaaReduceMul);
+	SetFloat(m_fxaaAspectDistortionId, m_fxaaAspectDistortion);
 
-	SetFloat("shininess", 0.5f);
+	SetFloat(m_shininessId, 0.5f);
 
-	GetTexture("displayTexture")->BindAsRenderTarget();
+	const Texture* displayTexture = GetTexture(m_displayTextureId);
+	displayTexture->BindAsRenderTarget();
 
 	glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	for (unsigned int i = 0; i < _objects.size(); ++i) { _objects[i]->Draw(*this); }
 	RenderAllObjects();
+	particleRenderer.Draw(Camera::current->projectionMatrix, Camera::current->viewMatrix);
 
-	float displayTextureAspect = (float)GetTexture("displayTexture")->GetWidth() / (float)GetTexture("displayTexture")->GetHeight();
-	float displayTextureHeightAdditive = displayTextureAspect * *GetFloat("fxaaAspectDistortion");
-	SetVector3("inverseFilterTextureSize", vec3(1.0f / (float)GetTexture("displayTexture")->GetWidth(), 1.0f / ((float)GetTexture("displayTexture")->GetHeight() + displayTextureHeightAdditive), 0.0f));
+	float displayTextureAspect = (float)displayTexture->GetWidth() / (float)displayTexture->GetHeight();
+	float displayTextureHeightAdditive = displayTextureAspect * m_fxaaAspectDistortion;
+	SetVector3(m_inverseFilterTextureSizeId, vec3(1.0f / (float)displayTexture->GetWidth(), 1.0f / ((float)displayTexture->GetHeight() + displayTextureHeightAdditive), 0.0f));
 
 	DrawGrid(50, 50, 1);
 
@@ -119,122 +232,41 @@ void RenderingEngine::Render(vector<GameObject*>& _objects) {
 
 	RenderAllDepthTestObjects();
 
-	ApplyFilter(m_fxaaFilter, *GetTexture("displayTexture"), 0);
+	ApplyFilter(m_fxaaFilter, *displayTexture, 0);
 }
 void RenderingEngine::RenderAllObjects() {
-	//SortRenderQueueByMaterial(meshDrawCommands);
-
-	while (meshDrawCommands.size() > 0) {
-		DrawCommandMesh* meshDrawCommand = meshDrawCommands.front();
-		meshDrawCommands.pop();
-		
-		if (!meshDrawCommand->depthTestEnabled) {
-			depthQueue.push(meshDrawCommand);
-			continue;
-		}
-
-		Shader& shader = meshDrawCommand->mesh->shader;
-		shader.Enable();
-		shader.UpdateUniforms(*this);
-		shader.UpdateCameraUniforms(*meshDrawCommand->camera);
-
-		//Note(Manny): Only update uniforms once for each material
-		
-		shader.UpdateTransformUniforms(*meshDrawCommand->transform);
-
-		Mesh* mesh = meshDrawCommand->mesh;
-		IndexedModel* model = mesh->model;
-		vector<MeshData>& meshes = model->meshes;
-		vector<Material>& materials = *meshDrawCommand->materials;
-		
-		unsigned int materialIndex = 0; 
-		for (unsigned int i = 0; i < meshes.size(); ++i) {
-			shader.UpdateMaterialUniforms(materials[materialIndex], *this);
-
-			materialIndex++;
-			
-			if (materialIndex >= materials.size()) {
-				materialIndex--;
-			}
-
-			mesh->UpdateAllBones();
-			mesh->DrawGizmosBones();
-
-			if (model->skeletons.size() > 0) {
-				shader.SetMatrix4("bones", model->skeletons[0]->m_boneCount, *model->skeletons[0]->m_bones, GL_FALSE);
-			}
-
-			if (meshDrawCommand->wireframe) {
-				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-			}
-
-			glBindVertexArray(meshes[i].glData.VAO);
-			glDrawElements(GL_TRIANGLES, meshes[i].glData.indexCount, GL_UNSIGNED_INT, 0);
-			
-			if (meshDrawCommand->wireframe) {
-				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-			}
-		}
-	}
+	CullMeshDrawCommands(meshDrawCommands);
+	OptimizeMeshRenderQueue(meshDrawCommands);
+	SortRenderQueueByMaterial(renderQueue);
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	DrawRenderQueue(renderQueue, false);
+	stats.submitTime += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	renderQueue.clear();
 }
 void RenderingEngine::RenderAllDepthTestObjects() {
-	while (depthQueue.size() > 0) {
-		glClear(GL_DEPTH_BUFFER_BIT);
-
-		DrawCommandMesh* meshDrawCommand = depthQueue.front();
-		depthQueue.pop();
-
-		Shader& shader = meshDrawCommand->mesh->shader;
-		shader.Enable();
-		shader.UpdateUniforms(*this);
-		shader.UpdateCameraUniforms(*meshDrawCommand->camera);
-
-		//Note(Manny): Only update uniforms once for each material
-		
-		shader.UpdateTransformUniforms(*meshDrawCommand->transform);
-
-		Mesh* mesh = meshDrawCommand->mesh;
-		IndexedModel* model = mesh->model;
-		vector<MeshData>& meshes = model->meshes;
-		vector<Material>& materials = *meshDrawCommand->materials;
-
-		unsigned int materialIndex = 0;
-		for (unsigned int i = 0; i < meshes.size(); ++i) {
-			shader.UpdateMaterialUniforms(materials[materialIndex], *this);
-
-			materialIndex++;
-
-			if (materialIndex >= materials.size()) {
-				materialIndex--;
-			}
-
-			mesh->UpdateAllBones();
-			mesh->DrawGizmosBones();
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	DrawRenderQueue(depthQueue, true);
+	stats.submitTime += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	depthQueue.clear();
+}
+void RenderingEngine::SortRenderQueueByMaterial(vector<RenderQueueItem>& _renderQueue) {
+	std::sort(_renderQueue.begin(), _renderQueue.end());
+}
 
-			if (model->skeletons.size() > 0) {
-				shader.SetMatrix4("bones", model->skeletons[0]->m_boneCount, *model->skeletons[0]->m_bones, GL_FALSE);
-			}
+// Static
+unsigned long long RenderingEngine::PackSortKey(unsigned int _program, unsigned int _materialId, unsigned int _vao, unsigned int _lod, float _depth) {
+	unsigned long long program = (unsigned long long)_program & 0xfff;
+	unsigned long long materialId = (unsigned long long)_materialId & 0xfffff;
+	unsigned long long vao = (unsigned long long)_vao & 0xffff;
 
-			if (meshDrawCommand->wireframe) {
-				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-			}
+	// The level of detail sits above the depth so that instanced runs stay together
+	unsigned long long lod = _lod < 3 ? _lod : 3;
 
-			glBindVertexArray(meshes[i].glData.VAO);
-			glDrawElements(GL_TRIANGLES, meshes[i].glData.indexCount, GL_UNSIGNED_INT, 0);
+	// Quantize the camera distance so that equal state draws front to back
+	unsigned long long quantizedDepth = (unsigned long long)(glm::clamp(_depth, 0.0f, 1.0f) * 0x3fff);
 
-			if (meshDrawCommand->wireframe) {
-				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-			}
-		}
-	}
+	return (program << 52) | (materialId << 32) | (vao << 16) | (lod << 14) | quantizedDepth;
 }
-void RenderingEngine::SortRenderQueueByMaterial(queue<DrawCommandMesh*>& _meshDrawCommands)
-{
-	//Note(Manny): Sort by material here
-	
-}
-
-// Static
 void RenderingEngine::AddDirLight(DirectionalLight& _dirLight) { m_dirLights.push_back(&_dirLight); }
 void RenderingEngine::AddPointLight(PointLight& _pointLight) { m_pointLights.push_back(&_pointLight); }
 
@@ -249,9 +281,9 @@ void RenderingEngine::UpdateUniformStruct(const Transform& transform,
 
 // Private
 void RenderingEngine::BlurShadowMap(int shadowMapIndex, float blurAmount) {
-	SetVector3("blurScale", vec3(blurAmount / (m_shadowMaps[shadowMapIndex].GetWidth()), 0.0f, 0.0f));
+	SetVector3(m_blurScaleId, vec3(blurAmount / (m_shadowMaps[shadowMapIndex].GetWidth()), 0.0f, 0.0f));
 	ApplyFilter(m_gausBlurFilter, m_shadowMaps[shadowMapIndex], &m_shadowMapTempTargets[shadowMapIndex]);
-	SetVector3("blurScale", vec3(0.0f, blurAmount / (m_shadowMaps[shadowMapIndex].GetHeight()), 0.0f));
+	SetVector3(m_blurScaleId, vec3(0.0f, blurAmount / (m_shadowMaps[shadowMapIndex].GetHeight()), 0.0f));
 	ApplyFilter(m_gausBlurFilter, m_shadowMapTempTargets[shadowMapIndex], &m_shadowMaps[shadowMapIndex]);
 }
 void RenderingEngine::ApplyFilter(Shader& filter, const Texture& source, const Texture* dest) {
@@ -266,7 +298,7 @@ void RenderingEngine::ApplyFilter(Shader& filter, const Texture& source, const T
 	m_altCamera.transform->position = vec3(0, 0, 0);
 	m_altCamera.transform->rotation = quat(glm::radians(180.0f), vec3(1, 0, 0));
 
-	SetTexture("filterTexture", source);
+	SetTexture(m_filterTextureId, source);
 
 	glClear(GL_DEPTH_BUFFER_BIT);
 	filter.Enable();
@@ -276,9 +308,15 @@ void RenderingEngine::ApplyFilter(Shader& filter, const Texture& source, const T
 	filter.UpdateCameraUniforms(m_altCamera);
 	m_plane.Draw(*this);
 
-	SetTexture("filterTexture", 0);
+	SetTexture(m_filterTextureId, 0);
 }
 void RenderingEngine::DrawGrid(int _rows, int _cols, int _spacing) {
+	// The grid never changes, so it is uploaded once and redrawn by Gizmos::Draw
+	if (m_gridLayer != 0) {
+		return;
+	}
+	m_gridLayer = Gizmos::CreateLayer();
+	Gizmos::BeginLayer(m_gridLayer);
 	Gizmos::AddTransform(mat4(1));
 	vec4 white(1);
 	vec4 black(0, 0, 0, 1);
@@ -297,4 +335,187 @@ void RenderingEngine::DrawGrid(int _rows, int _cols, int _spacing) {
 			vec3(cols, 0, -cols + lineOffset), 
 			line % 10 == 0 ? m_outerGridColor.ToVec4() : m_innerGridColor.ToVec4());
 	}
+	Gizmos::EndLayer();
+}
+void RenderingEngine::DrawRenderQueue(vector<RenderQueueItem>& _renderQueue, bool _clearDepthPerCommand) {
+	ShaderData* currentShader = nullptr;
+	MaterialData* currentMaterial = nullptr;
+	Camera* currentCamera = nullptr;
+	DrawCommandMesh* currentCommand = nullptr;
+
+	for (unsigned int i = 0; i < _renderQueue.size(); ++i) {
+		DrawCommandMesh* meshDrawCommand = _renderQueue[i].command;
+		unsigned int meshIndex = _renderQueue[i].meshIndex;
+		bool commandChanged = meshDrawCommand != currentCommand;
+		currentCommand = meshDrawCommand;
+
+		if (_clearDepthPerCommand && commandChanged) {
+			glClear(GL_DEPTH_BUFFER_BIT);
+		}
+
+		// Runs of the same sub-mesh and material are collapsed into one instanced draw
+		unsigned int runEnd = _clearDepthPerCommand ? i + 1 : FindInstanceRun(_renderQueue, i);
+		bool instanced = runEnd - i >= INSTANCE_RUN_MIN;
+
+		// Only re-apply shader state when the program changes
+		Shader& shader = instanced ? m_instancedLightingShader : meshDrawCommand->mesh->shader;
+		if (shader.shaderData != currentShader) {
+			shader.Enable();
+			shader.UpdateUniforms(*this);
+			currentShader = shader.shaderData;
+			currentMaterial = nullptr;
+			currentCamera = nullptr;
+			commandChanged = true;
+			stats.shaderChanges++;
+		} else {
+			stats.shaderChangesAvoided++;
+		}
+
+		if (meshDrawCommand->camera != currentCamera) {
+			shader.UpdateCameraUniforms(*meshDrawCommand->camera);
+			currentCamera = meshDrawCommand->camera;
+		}
+
+		if (commandChanged && !instanced) {
+			shader.UpdateTransformUniforms(*meshDrawCommand->transform);
+		}
+
+		Mesh* mesh = meshDrawCommand->mesh;
+		IndexedModel* model = mesh->GetModel();
+		vector<Material>& materials = *meshDrawCommand->materials;
+		Material& material = materials[std::min(meshIndex, (unsigned int)materials.size() - 1)];
+
+		// Only re-apply material state when the material changes
+		if (material.materialData != currentMaterial) {
+			shader.UpdateMaterialUniforms(material, *this);
+			currentMaterial = material.materialData;
+			stats.materialChanges++;
+		} else {
+			stats.materialChangesAvoided++;
+		}
+
+		// The palette is the same for every sub-mesh of a command
+		if (commandChanged && model->skeletons.size() > 0) {
+			if (meshDrawCommand->bones != nullptr) {
+				shader.SetMatrix4("bones", meshDrawCommand->boneCount, *meshDrawCommand->bones, GL_FALSE);
+			} else {
+				// Note(Manny): Without an Animator the model is drawn in the pose its nodes hold
+				mesh->UpdateAllBones();
+				shader.SetMatrix4("bones", model->skeletons[0]->m_boneCount, *model->skeletons[0]->m_bones, GL_FALSE);
+			}
+		}
+
+		if (meshDrawCommand->wireframe) {
+			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		}
+
+		MeshData& meshData = model->meshes[meshIndex];
+		glBindVertexArray(meshData.glData.VAO);
+		const MeshLOD& lod = meshData.lods[std::min(meshDrawCommand->lod, (unsigned int)meshData.lods.size() - 1)];
+		unsigned int indexSize = meshData.glData.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+		if (instanced) {
+			unsigned int instanceCount = runEnd - i;
+			StreamInstances(_renderQueue, i, runEnd);
+			glDrawElementsInstanced(GL_TRIANGLES, lod.indexCount, meshData.glData.indexType, (void*)(lod.indexOffset * indexSize), instanceCount);
+			UnbindInstances();
+			stats.instancedDrawCalls++;
+			stats.instances += instanceCount;
+			stats.triangles += lod.indexCount / 3 * instanceCount;
+			// Skip the rest of the run, the next item always starts a new command
+			i = runEnd - 1;
+			currentCommand = _renderQueue[i].command;
+		} else {
+			glDrawElements(GL_TRIANGLES, lod.indexCount, meshData.glData.indexType, (void*)(lod.indexOffset * indexSize));
+			stats.triangles += lod.indexCount / 3;
+		}
+		stats.drawCalls++;
+
+		if (meshDrawCommand->wireframe) {
+			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		}
+	}
+}
+unsigned long long RenderingEngine::CreateSortKey(const DrawCommandMesh& _command, unsigned int _meshIndex) const {
+	const vector<Material>& materials = *_command.materials;
+	const Material& material = materials[std::min(_meshIndex, (unsigned int)materials.size() - 1)];
+	unsigned int materialId = material.materialData ? material.materialData->materialId : 0;
+
+	float depth = 0.0f;
+	if (_command.camera != nullptr && _command.transform != nullptr) {
+		float distance = glm::length(_command.transform->position - _command.camera->transform->position);
+		depth = distance / _command.camera->farClipPlane;
+	}
+	return PackSortKey((unsigned int)_command.mesh->shader.shaderData->program, materialId,
+		_command.mesh->GetModel()->meshes[_meshIndex].glData.VAO, _command.lod, depth);
+}
+unsigned int RenderingEngine::FindInstanceRun(const vector<RenderQueueItem>& _renderQueue, unsigned int _begin) const {
+	const RenderQueueItem& first = _renderQueue[_begin];
+	const DrawCommandMesh& command = *first.command;
+	IndexedModel* model = command.mesh->GetModel();
+	// Note(Manny): Only the default lighting shader has an instanced variant,
+	// and skinned models need their own bone uniforms
+	if (!instancingEnabled || command.mesh->shader.shaderData != m_lightingShader.shaderData || model->skeletons.size() > 0) {
+		return _begin + 1;
+	}
+
+	const vector<Material>& materials = *command.materials;
+	MaterialData* materialData = materials[std::min(first.meshIndex, (unsigned int)materials.size() - 1)].materialData;
+	unsigned int maxEnd = _begin + INSTANCE_BUFFER_SIZE / sizeof(mat4);
+	unsigned int end = _begin + 1;
+	while (end < _renderQueue.size() && end < maxEnd) {
+		const RenderQueueItem& item = _renderQueue[end];
+		const DrawCommandMesh& other = *item.command;
+		const vector<Material>& otherMaterials = *other.materials;
+		if (item.meshIndex != first.meshIndex ||
+			other.mesh->GetModel() != model ||
+			other.mesh->shader.shaderData != command.mesh->shader.shaderData ||
+			otherMaterials[std::min(item.meshIndex, (unsigned int)otherMaterials.size() - 1)].materialData != materialData ||
+			other.lod != command.lod ||
+			other.camera != command.camera ||
+			other.wireframe != command.wireframe) {
+			break;
+		}
+		end++;
+	}
+	return end;
+}
+void RenderingEngine::StreamInstances(const vector<RenderQueueItem>& _renderQueue, unsigned int _begin, unsigned int _end) {
+	unsigned int size = (_end - _begin) * sizeof(mat4);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+
+	// Note(Manny): A full buffer is orphaned, so the driver hands back fresh
+	// storage instead of waiting for the GPU to finish reading the old one
+	if (m_instanceBufferOffset + size > INSTANCE_BUFFER_SIZE) {
+		glBufferData(GL_ARRAY_BUFFER, INSTANCE_BUFFER_SIZE, NULL, GL_STREAM_DRAW);
+		m_instanceBufferOffset = 0;
+	}
+
+	// Ranges are never rewritten before an orphan, so the write needs no synchronisation
+	mat4* matrices = (mat4*)glMapBufferRange(GL_ARRAY_BUFFER, m_instanceBufferOffset, size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (matrices != nullptr) {
+		for (unsigned int i = _begin; i < _end; ++i) {
+			matrices[i - _begin] = _renderQueue[i].command->transform->worldMatrix;
+		}
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+
+	// The matrix takes one attribute per column on the bound vertex array
+	for (unsigned int column = 0; column < 4; ++column) {
+		GLuint location = VERTEX_INSTANCE_MODEL + column;
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(mat4), (void*)(m_instanceBufferOffset + column * sizeof(vec4)));
+		glVertexAttribDivisor(location, 1);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_instanceBufferOffset += size;
+}
+void RenderingEngine::UnbindInstances() {
+	// Note(Manny): The vertex array is shared with regular draws of the same mesh,
+	// which would otherwise keep reading the instance attributes per instance
+	for (unsigned int column = 0; column < 4; ++column) {
+		GLuint location = VERTEX_INSTANCE_MODEL + column;
+		glVertexAttribDivisor(location, 0);
+		glDisableVertexAttribArray(location);
+	}
 }
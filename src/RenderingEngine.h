@@ -25,19 +25,22 @@ of rendering within the game engine
 #include "Texture.h"
 #include "Mesh.h"
 #include "Color.h"
+#include "Bounds.h"
+#include "Frustum.h"
 
 // Utilities
 #include "GLM_Header.h"
 #include "MaterialData.h"
 #include "Window.h"
+#include "ParticleRenderer.h"
 
 // Other
 #include <map>
 using std::map;
 #include <string>
 using std::string;
-#include <queue>
-using std::queue;
+#include <vector>
+using std::vector;
 
 struct DrawCommandMesh {
 	string fileName;
@@ -46,25 +49,66 @@ struct DrawCommandMesh {
 	vector<Material>* materials;
 	Camera* camera;
 	Mesh* mesh;
+	Bounds* bounds; //World space bounds used for culling, null if never culled
+	unsigned int lod; //Level of detail of every sub-mesh, clamped to the ones it has
+	const mat4* bones; //Skinning palette written by an Animator, null if not animated
+	unsigned int boneCount;
 	bool depthTestEnabled;
 	bool wireframe;
 };
 
-struct RenderQueue {
+// Sort key layout (most to least significant bits):
+// [63-52] shader program | [51-32] material | [31-16] VAO | [15-14] LOD | [13-0] depth
+struct RenderQueueItem {
+	unsigned long long sortKey;
 	DrawCommandMesh* command;
-	int commandCount; //size of command list
+	unsigned int meshIndex; //Sub-mesh of the command's model to draw
+	RenderQueueItem(unsigned long long _sortKey, DrawCommandMesh* _command, unsigned int _meshIndex) :
+		sortKey(_sortKey),
+		command(_command),
+		meshIndex(_meshIndex) {}
+	inline bool operator<(const RenderQueueItem& _other) const { return sortKey < _other.sortKey; }
+};
+
+struct RenderStats {
+	unsigned int drawCalls;
+	unsigned int instancedDrawCalls;
+	unsigned int instances; //Objects drawn by instanced draw calls
+	unsigned int triangles;
+	unsigned int shaderChanges;
+	unsigned int shaderChangesAvoided;
+	unsigned int materialChanges;
+	unsigned int materialChangesAvoided;
+	unsigned int visibleObjects;
+	unsigned int culledObjects;
+	float submitTime; //Milliseconds spent issuing the render queues
+	RenderStats() { Reset(); }
+	void Reset() {
+		drawCalls = 0;
+		instancedDrawCalls = 0;
+		instances = 0;
+		triangles = 0;
+		shaderChanges = 0;
+		shaderChangesAvoided = 0;
+		materialChanges = 0;
+		materialChangesAvoided = 0;
+		visibleObjects = 0;
+		culledObjects = 0;
+		submitTime = 0.0f;
+	}
 };
 
 class RenderingEngine : public MaterialData {
 public:
 	RenderingEngine();
-	virtual ~RenderingEngine() {}
+	virtual ~RenderingEngine();
 	void AddDrawCommandMesh(DrawCommandMesh* _command);
-	void OptimizeMeshRenderQueue(queue<DrawCommandMesh*>& _meshDrawCommands);
+	void CullMeshDrawCommands(vector<DrawCommandMesh*>& _meshDrawCommands);
+	void OptimizeMeshRenderQueue(vector<DrawCommandMesh*>& _meshDrawCommands);
 	void Render(vector<GameObject*>& _objects);
 	void RenderAllObjects();
 	void RenderAllDepthTestObjects();
-	void SortRenderQueueByMaterial(queue<DrawCommandMesh*>& _meshDrawCommands);
+	void SortRenderQueueByMaterial(vector<RenderQueueItem>& _renderQueue);
 	inline vector<DirectionalLight*>& GetActiveDirLights() { return m_dirLights; }
 	inline vector<PointLight*>& GetActivePointLights() { return m_pointLights; }
 	inline unsigned int GetSamplerSlot(const string& samplerName) const { return m_samplerMap.find(samplerName)->second; }
@@ -72,14 +116,20 @@ public:
 	inline void SetSamplerSlot(const string& _name, unsigned int _value) { m_samplerMap[_name] = _value; }
 	static void AddDirLight(DirectionalLight& _dirLight);
 	static void AddPointLight(PointLight& _pointLight);
+	// Packs draw state into a RenderQueueItem sort key, _depth is the distance over the far plane
+	static unsigned long long PackSortKey(unsigned int _program, unsigned int _materialId, unsigned int _vao, unsigned int _lod, float _depth);
 	virtual void UpdateUniformStruct(const Transform& transform,
 		const Material& material,
 		const Shader& shader,
 		const string& uniformName,
 		const string& uniformType) const;
 
-	queue<DrawCommandMesh*> meshDrawCommands;
-	queue<DrawCommandMesh*> depthQueue;
+	vector<DrawCommandMesh*> meshDrawCommands;
+	vector<RenderQueueItem> renderQueue;
+	vector<RenderQueueItem> depthQueue; //Items without depth testing, unsorted, depth is cleared before each command
+	RenderStats stats;
+	ParticleRenderer particleRenderer;
+	static bool instancingEnabled;
 	
 private:
 	RenderingEngine(const RenderingEngine& other) : m_altCamera(mat4()) {}
@@ -87,6 +137,11 @@ private:
 	void BlurShadowMap(int shadowMapIndex, float blurAmount);
 	void ApplyFilter(Shader& filter, const Texture& source, const Texture* dest);
 	void DrawGrid(int _rows, int _cols, int _spacing);
+	void DrawRenderQueue(vector<RenderQueueItem>& _renderQueue, bool _clearDepthPerCommand);
+	unsigned long long CreateSortKey(const DrawCommandMesh& _command, unsigned int _meshIndex) const;
+	unsigned int FindInstanceRun(const vector<RenderQueueItem>& _renderQueue, unsigned int _begin) const;
+	void StreamInstances(const vector<RenderQueueItem>& _renderQueue, unsigned int _begin, unsigned int _end);
+	void UnbindInstances(); //Undoes the attribute setup of StreamInstances on the bound vertex array
 
 	static const int NUM_SHADOW_MAPS = 1;
 	static const mat4 BIAS_MATRIX;
@@ -105,6 +160,7 @@ private:
 	Shader m_gausBlurFilter;
 	Shader m_fxaaFilter;
 	Shader m_lightingShader;
+	Shader m_instancedLightingShader;
 	Transform m_planeTransform;
 	Transform m_altCameraTransform;
 	mat4 m_lightMatrix;
@@ -114,6 +170,31 @@ private:
 	float m_fxaaReduceMin;
 	float m_fxaaReduceMul;
 	float m_fxaaAspectDistortion;
+	// Culling input, stored per axis so that four boxes are tested at once
+	static const unsigned int CULL_BATCH_SIZE = 1024; //Multiple of four
+	vector<float> m_cullCenterX;
+	vector<float> m_cullCenterY;
+	vector<float> m_cullCenterZ;
+	vector<float> m_cullSizeX;
+	vector<float> m_cullSizeY;
+	vector<float> m_cullSizeZ;
+	vector<unsigned char> m_cullVisible;
+	// World matrices of instanced runs, written front to back and orphaned once full
+	static const unsigned int INSTANCE_BUFFER_SIZE = 4 * 1024 * 1024;
+	static const unsigned int INSTANCE_RUN_MIN = 2; //Shorter runs use a regular draw call
+	GLuint m_instanceBuffer;
+	unsigned int m_instanceBufferOffset;
+	unsigned int m_gridLayer; //Gizmo layer holding the grid, 0 until it is first drawn
+	// Properties set or read every frame, interned once
+	unsigned int m_displayTextureId;
+	unsigned int m_filterTextureId;
+	unsigned int m_blurScaleId;
+	unsigned int m_inverseFilterTextureSizeId;
+	unsigned int m_shininessId;
+	unsigned int m_fxaaSpanMaxId;
+	unsigned int m_fxaaReduceMinId;
+	unsigned int m_fxaaReduceMulId;
+	unsigned int m_fxaaAspectDistortionId;
 };
 
 
@@ -26,10 +26,16 @@ Rigidbody::Rigidbody() :
 	angularVelocity(vec3(0)),
 	angularMomentum(vec3(0)),
 	useGravity(false),
+	enabled(true),
 	isKinematic(false),
 	staticFriction(0.1f),
 	dynamicFriction(0.5f),
-	isChangedInGUI(false)
+	restitution(0.0f),
+	isChangedInGUI(false),
+	bodyIndex(0),
+	sleepIsland(0),
+	sleepTime(0.0f),
+	isSleeping(false)
 {}
 Rigidbody::~Rigidbody(){}
 bool Rigidbody::Startup() {
@@ -43,23 +49,12 @@ bool Rigidbody::Update() {
 	if (transform && transform->isSelected) Inspector();
 	return true;
 }
-void Rigidbody::PhysicsUpdate(float _timeStep) {
-	if (gameObject->isStatic) {
+void Rigidbody::PhysicsUpdate(float) {
+	// Note(Manny): Forces, gravity and drag are integrated by the physics engine's solver
+	if (gameObject->isStatic || isSleeping) {
 		return;
 	}
 	CalculateMomentOfInertia();
-	AddForce( (useGravity ? CoreEngine::physics->gravity * mass : vec3(0)));
-	vec3 frictionForce = -mass * dynamicFriction * velocity;
-	AddForce(frictionForce);
-	vec3 frictionTorque = (-momentOfInertia * dynamicFriction * angularVelocity);
-	AddTorque(frictionTorque);
-	vec3 acceleration = totalForce / mass;
-	vec3 angularAcceleration = totalTorque / momentOfInertia;
-	OldPosition = transform->position; //keep our old position for collision response
-	velocity += acceleration * _timeStep;
-	transform->position += velocity * _timeStep;
-	totalForce = vec3(0);
-	totalTorque = vec3(0);
 }
 void Rigidbody::AddForce(vec3 _force) {
 	AddForceAtPosition(_force, transform->position);
@@ -71,6 +66,18 @@ void Rigidbody::AddForceAtPosition(vec3 _force, vec3 _position) {
 }
 void Rigidbody::AddTorque(vec3 _torque) {
 	totalTorque += _torque;
+	WakeUp();
+}
+void Rigidbody::Sleep() {
+	isSleeping = true;
+	sleepIsland = 0;
+	velocity = vec3(0);
+	angularVelocity = vec3(0);
+}
+void Rigidbody::WakeUp() {
+	// Note(Manny): The physics engine wakes the rest of the island before the next step
+	isSleeping = false;
+	sleepTime = 0.0f;
 }
 void Rigidbody::Inspector() {
 	ImGui::Begin("Inspector");
@@ -78,6 +85,7 @@ void Rigidbody::Inspector() {
 	if (ImGui::TreeNode("Rigidbody")) {
 		vec3 oldGUIVelocity = velocity;
 		float oldGUIDynamicFriction = dynamicFriction;
+		float oldGUIRestitution = restitution;
 		float oldGUIMass = mass;
 		float oldGUIDrag = drag;
 		float oldGUIDensity = density;
@@ -89,6 +97,7 @@ void Rigidbody::Inspector() {
 		// Settings go here
 		ImGui::DragFloat3("Velocity", (float*)&velocity);
 		ImGui::DragFloat("DynamicFriction", &dynamicFriction);
+		ImGui::DragFloat("Restitution", &restitution, 0.01f, 0.0f, 1.0f);
 		ImGui::DragFloat("Mass", &mass, 0.01f, 0.01f, 10.0f);
 		ImGui::DragFloat("Drag", &drag);
 		ImGui::DragFloat("Density", &density);
@@ -96,11 +105,13 @@ void Rigidbody::Inspector() {
 		ImGui::Checkbox("Use Gravity", &useGravity);
 		ImGui::Checkbox("Is Kinematic", &isKinematic);
 		ImGui::Checkbox("Enabled", &enabled);
+		ImGui::Text(isSleeping ? "Sleeping" : "Awake");
 		
 		ImGui::TreePop();
 
 		if (oldGUIVelocity != velocity ||
 			oldGUIDynamicFriction != dynamicFriction ||
+			oldGUIRestitution != restitution ||
 			oldGUIMass != mass ||
 			oldGUIDrag != drag ||
 			oldGUIDensity != density ||
@@ -109,6 +120,7 @@ void Rigidbody::Inspector() {
 			oldGUIIsKinematic != isKinematic ||
 			oldGUIEnabled != enabled) {
 			isChangedInGUI = true;
+			WakeUp();
 		} else {
 			isChangedInGUI = false;
 		}
@@ -117,7 +129,7 @@ void Rigidbody::Inspector() {
 	ImGui::End();
 }
 void Rigidbody::CalculateMomentOfInertia() {
-	momentOfInertia = 0;
+	inertiaTensor = vec3(0);
 	if (gameObject != nullptr) {
 		vector<Collider*>& colliders = gameObject->colliders;
 		for (unsigned int i = 0; i < colliders.size(); ++i) {
@@ -127,25 +139,27 @@ void Rigidbody::CalculateMomentOfInertia() {
 				break;
 			case SHAPE_SPHERE: {
 				SphereCollider* sphere = dynamic_cast<SphereCollider*>(colliders[i]);
-				momentOfInertia += (mass * (sphere->radius * sphere->radius)) / 2.0f;
+				inertiaTensor += vec3(0.4f * mass * (sphere->radius * sphere->radius));
 				break;
 			} 
 			case SHAPE_BOX: {
+				// bounds.size holds the half size
 				BoxCollider* box = dynamic_cast<BoxCollider*>(colliders[i]);
 				float w = 2.0f * box->bounds.size.x;
 				float h = 2.0f * box->bounds.size.y;
 				float d = 2.0f * box->bounds.size.z;
-				float Ih = 1.0f / 12.0f * mass * (w * w + d * d);
 				float Iw = 1.0f / 12.0f * mass * (h * h + d * d);
+				float Ih = 1.0f / 12.0f * mass * (w * w + d * d);
 				float Id = 1.0f / 12.0f * mass * (h * h + w * w);
-				momentOfInertia += Ih + Iw + Id;
+				inertiaTensor += vec3(Iw, Ih, Id);
 				break;
 			} 
 			default:
 				break;
 			}
 		}
-		momentOfInertia = (colliders.size() > 0 ? momentOfInertia / colliders.size() : 0);
+		inertiaTensor = (colliders.size() > 0 ? inertiaTensor / (float)colliders.size() : vec3(0));
+		momentOfInertia = (inertiaTensor.x + inertiaTensor.y + inertiaTensor.z) / 3.0f;
 	} else {
 		std::cout << "ERROR IN RIGIDBODY!" << std::endl;
 	}
@@ -30,6 +30,9 @@ public:
 	void AddForceAtPosition(vec3 _force, vec3 _position);
 	void AddTorque(vec3 _torque);
 	void CalculateMomentOfInertia();
+	void Sleep(); // Stops the rigidbody until something touches it or a force is added.
+	void WakeUp(); // Wakes the rigidbody and everything that fell asleep together with it.
+	inline bool IsSleeping() const { return isSleeping; }
 	bool HasChangedInGUI();
 	void Inspector();
 
@@ -49,6 +52,7 @@ public:
 	float density;
 	float staticFriction;
 	float dynamicFriction;
+	float restitution; // How much of the closing speed is kept when bouncing off, from 0 to 1.
 	float maxAngularVelocity;
 	float drag;
 	float angularDrag; // Angular drag can be used to slow down the rotation of an object. The higher the drag the more the rotation slows down.
@@ -57,6 +61,10 @@ public:
 	bool detectCollisions;
 	bool isKinematic; // Controls whether physics affects the rigidbody.
 	bool isChangedInGUI;
+	unsigned int bodyIndex; // Where the custom physics engine keeps this body during a step.
+	unsigned int sleepIsland; // Shared by the rigidbodies that fell asleep together, 0 when none did.
+	float sleepTime; // Seconds the rigidbody has been slow enough to sleep.
+	bool isSleeping;
 };
 
 #endif // _RIGID_BODY_H_
\ No newline at end of file
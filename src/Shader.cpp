@@ -3,6 +3,7 @@
 #include <vector>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 #include "RenderingEngine.h"
 #include "Transform.h"
@@ -74,6 +75,8 @@ ShaderData::ShaderData(const string& _fileName) {
 	CompileShader();
 
 	AddShaderUniforms(shaderText);
+
+	BuildUniformBindings();
 }
 void ShaderData::LoadFromFile(const string& _file, ShaderType _shaderType) {
 	GLuint shaderHandle = 0;
@@ -289,99 +292,211 @@ void ShaderData::GetAllUniforms() {
 		uniformMap[name] = glGetUniformLocation(program, name);
 	}
 }
-GLint ShaderData::GetLocation(string _name) {
-	if (uniformMap.find(_name) != uniformMap.end()) {
-		return uniformMap[_name];
+void ShaderData::BuildUniformBindings() {
+	static const char* DIR_LIGHT_MEMBERS[DIR_LIGHT_MEMBER_COUNT] = { 
+		"base.ambient", "base.diffuse", "base.specular", "direction" };
+	static const char* POINT_LIGHT_MEMBERS[POINT_LIGHT_MEMBER_COUNT] = { 
+		"base.ambient", "base.diffuse", "base.specular", "atten.constant", "atten.linear", "atten.quadratic", "position" };
+
+	for (unsigned int i = 0; i < uniformNames.size(); i++) {
+		const string& uniformName = uniformNames[i];
+		const string& uniformType = uniformTypes[i];
+
+		if (uniformName.length() < 3 || uniformName[1] != '_') {
+			continue;
+		}
+
+		string unprefixedName = uniformName.substr(2, uniformName.length());
+		GLint location = glGetUniformLocation(program, uniformName.c_str());
+
+		switch (uniformName[0]) {
+			case 'R': {
+				if (unprefixedName == "lightMatrix") {
+					rendererUniforms.push_back(UniformSlot(UNIFORM_R_LIGHT_MATRIX, location, unprefixedName));
+				} else if (uniformType == "sampler2D") {
+					rendererUniforms.push_back(UniformSlot(UNIFORM_R_SAMPLER2D, location, unprefixedName));
+				} else if (uniformType == "vec3") {
+					rendererUniforms.push_back(UniformSlot(UNIFORM_R_VEC3, location, unprefixedName));
+				} else if (uniformType == "float") {
+					rendererUniforms.push_back(UniformSlot(UNIFORM_R_FLOAT, location, unprefixedName));
+				} else if (uniformType == "int") {
+					if (uniformName == "R_DIR_LIGHT_COUNT") {
+						rendererUniforms.push_back(UniformSlot(UNIFORM_R_DIR_LIGHT_COUNT, location, unprefixedName));
+					} else if (uniformName == "R_POINT_LIGHT_COUNT") {
+						rendererUniforms.push_back(UniformSlot(UNIFORM_R_POINT_LIGHT_COUNT, location, unprefixedName));
+					}
+				} else if (uniformType == "DirLight") {
+					rendererUniforms.push_back(UniformSlot(UNIFORM_R_DIR_LIGHTS, location, unprefixedName));
+					AddLightArrayLocations(rendererUniforms.back(), uniformName, DIR_LIGHT_MEMBERS, DIR_LIGHT_MEMBER_COUNT);
+				} else if (uniformType == "PointLight") {
+					rendererUniforms.push_back(UniformSlot(UNIFORM_R_POINT_LIGHTS, location, unprefixedName));
+					AddLightArrayLocations(rendererUniforms.back(), uniformName, POINT_LIGHT_MEMBERS, POINT_LIGHT_MEMBER_COUNT);
+				} else {
+					Debug::LogError("Shader '" + fileName + "' has an invalid R_ Uniform: " + uniformName);
+					continue;
+				}
+				rendererUniforms.back().propertyId = MaterialData::GetPropertyId(unprefixedName);
+				break;
+			}
+			case 'T': {
+				if (uniformName == "T_model") {
+					transformUniforms.push_back(UniformSlot(UNIFORM_T_MODEL, location, unprefixedName));
+				} else {
+					Debug::LogError("Shader '" + fileName + "' has an invalid Transform Uniform: " + uniformName);
+				}
+				break;
+			}
+			case 'C': {
+				if (uniformName == "C_eyePos") {
+					cameraUniforms.push_back(UniformSlot(UNIFORM_C_EYE_POS, location, unprefixedName));
+				} else if (uniformName == "C_viewProj") {
+					cameraUniforms.push_back(UniformSlot(UNIFORM_C_VIEW_PROJ, location, unprefixedName));
+				} else {
+					Debug::LogError("Shader '" + fileName + "' has an invalid Camera Uniform: " + uniformName);
+				}
+				break;
+			}
+			case 'M': {
+				if (uniformType == "sampler2D") {
+					materialUniforms.push_back(UniformSlot(UNIFORM_M_SAMPLER2D, location, unprefixedName));
+				} else if (uniformType == "vec3") {
+					materialUniforms.push_back(UniformSlot(UNIFORM_M_VEC3, location, unprefixedName));
+				} else if (uniformType == "float") {
+					materialUniforms.push_back(UniformSlot(UNIFORM_M_FLOAT, location, unprefixedName));
+				} else {
+					Debug::LogError(uniformType + " is not supported by the Material class");
+					continue;
+				}
+				materialUniforms.back().propertyId = MaterialData::GetPropertyId(unprefixedName);
+				break;
+			}
+		}
+	}
+}
+GLint ShaderData::GetLocation(const string& _name) {
+	map<string, GLint>::const_iterator it = uniformMap.find(_name);
+	if (it != uniformMap.end()) {
+		return it->second;
+	}
+	// Note(Manny): Cache names the parser could not see, such as light array elements
+	GLint location = glGetUniformLocation(program, _name.c_str());
+	uniformMap.insert(pair<string, GLint>(_name, location));
+	return location;
+}
+void ShaderData::AddLightArrayLocations(UniformSlot& _slot, const string& _uniformName, const char** _members, unsigned int _memberCount) {
+	for (unsigned int element = 0; ; ++element) {
+		string elementName = _uniformName + "[" + to_string(element) + "].";
+		bool elementFound = false;
+		for (unsigned int i = 0; i < _memberCount; ++i) {
+			GLint location = glGetUniformLocation(program, (elementName + _members[i]).c_str());
+			elementFound |= location != -1;
+			_slot.arrayLocations.push_back(location);
+		}
+		if (!elementFound) {
+			_slot.arrayLocations.resize(element * _memberCount);
+			break;
+		}
 	}
-	return -1;
 }
 void Shader::UpdateUniforms(RenderingEngine& _renderingEngine) {
-	for (unsigned int i = 0; i < shaderData->uniformNames.size(); i++) {
-		string uniformName = shaderData->uniformNames[i];
-		string uniformType = shaderData->uniformTypes[i];
-
-		if (uniformName.substr(0, 2) == "R_") {
-			string unprefixedName = uniformName.substr(2, uniformName.length());
-
-			if (unprefixedName == "lightMatrix") {
-				SetMatrix4(uniformName, 1, _renderingEngine.GetLightMatrix());
-			} else if (uniformType == "sampler2D") {
-				int samplerSlot = _renderingEngine.GetSamplerSlot(unprefixedName);
-				_renderingEngine.GetTexture(unprefixedName)->Bind(samplerSlot);
-				SetInt(uniformName, samplerSlot);
-			} else if (uniformType == "vec3") {
-				SetVector3(uniformName, *_renderingEngine.GetVector3(unprefixedName));
-			} else if (uniformType == "float") {
-				SetFloat(uniformName, *_renderingEngine.GetFloat(unprefixedName));
-			} else if (uniformType == "int") {
-				if (uniformName == "R_DIR_LIGHT_COUNT") {
-					SetInt(uniformName, _renderingEngine.GetActiveDirLights().size());
-				} if (uniformName == "R_POINT_LIGHT_COUNT") {
-					SetInt(uniformName, _renderingEngine.GetActivePointLights().size());
+	vector<UniformSlot>& uniforms = shaderData->rendererUniforms;
+	for (unsigned int i = 0; i < uniforms.size(); i++) {
+		UniformSlot& uniform = uniforms[i];
+		switch (uniform.binding) {
+			case UNIFORM_R_LIGHT_MATRIX: {
+				glUniformMatrix4fv(uniform.location, 1, GL_FALSE, (float*)&_renderingEngine.GetLightMatrix());
+				break;
+			}
+			case UNIFORM_R_SAMPLER2D: {
+				if (uniform.samplerSlot < 0) {
+					uniform.samplerSlot = _renderingEngine.GetSamplerSlot(uniform.propertyName);
 				}
-			} else if (uniformType == "DirLight") {
-				SetDirectionalLights(uniformName, _renderingEngine.GetActiveDirLights());
-			} else if (uniformType == "PointLight") {
-				SetPointLights(uniformName, _renderingEngine.GetActivePointLights());
-			} else {
-				throw "Invalid R_ Uniform:" + uniformName;
+				_renderingEngine.GetTexture(uniform.propertyId)->Bind(uniform.samplerSlot);
+				glUniform1i(uniform.location, uniform.samplerSlot);
+				break;
+			}
+			case UNIFORM_R_VEC3: {
+				glUniform3fv(uniform.location, 1, (float*)_renderingEngine.GetVector3(uniform.propertyId));
+				break;
+			}
+			case UNIFORM_R_FLOAT: {
+				float* value = _renderingEngine.GetFloat(uniform.propertyId);
+				if (value != nullptr) {
+					glUniform1f(uniform.location, *value);
+				}
+				break;
+			}
+			case UNIFORM_R_DIR_LIGHT_COUNT: {
+				glUniform1i(uniform.location, _renderingEngine.GetActiveDirLights().size());
+				break;
+			}
+			case UNIFORM_R_POINT_LIGHT_COUNT: {
+				glUniform1i(uniform.location, _renderingEngine.GetActivePointLights().size());
+				break;
+			}
+			case UNIFORM_R_DIR_LIGHTS: {
+				SetDirectionalLights(uniform, _renderingEngine.GetActiveDirLights());
+				break;
+			}
+			case UNIFORM_R_POINT_LIGHTS: {
+				SetPointLights(uniform, _renderingEngine.GetActivePointLights());
+				break;
 			}
 		}
 	}
 }
 void Shader::UpdateTransformUniforms(const Transform& _transform) {
-	mat4 worldMatrix = _transform.worldMatrix;
-	for (unsigned int i = 0; i < shaderData->uniformNames.size(); i++) {
-		string uniformName = shaderData->uniformNames[i];
-		string uniformType = shaderData->uniformTypes[i];
-		if (uniformName.substr(0, 2) == "T_") {
-			if (uniformName == "T_model") {
-				SetMatrix4(uniformName, 1, worldMatrix);
-			} else {
-				throw "Invalid Transform Uniform: " + uniformName;
-			}
+	vector<UniformSlot>& uniforms = shaderData->transformUniforms;
+	for (unsigned int i = 0; i < uniforms.size(); i++) {
+		if (uniforms[i].binding == UNIFORM_T_MODEL) {
+			glUniformMatrix4fv(uniforms[i].location, 1, GL_FALSE, (float*)&_transform.worldMatrix);
 		}
 	}
 }
 void Shader::UpdateCameraUniforms(const Camera& _camera) {
-	mat4 viewProj = _camera.projectionMatrix * _camera.viewMatrix;
-	for (unsigned int i = 0; i < shaderData->uniformNames.size(); i++) {
-		string uniformName = shaderData->uniformNames[i];
-		string uniformType = shaderData->uniformTypes[i];
-
-		if (uniformName.substr(0, 2) == "C_") {
-			//uniformName = uniformName.substr(2, uniformName.length());
-			if (uniformName == "C_eyePos") {
+	vector<UniformSlot>& uniforms = shaderData->cameraUniforms;
+	for (unsigned int i = 0; i < uniforms.size(); i++) {
+		switch (uniforms[i].binding) {
+			case UNIFORM_C_EYE_POS: {
 				vec3 cameraPos = _camera.transform->position;
 				if (_camera.transform->parent) {
 					cameraPos += _camera.transform->parent->position;
 				}
-				SetVector3(uniformName, cameraPos);
-			} else if (uniformName == "C_viewProj") {
-				SetMatrix4(uniformName, 1, viewProj);
-			} else {
-				throw "Invalid Camera Uniform: " + uniformName;
+				glUniform3fv(uniforms[i].location, 1, (float*)&cameraPos);
+				break;
+			}
+			case UNIFORM_C_VIEW_PROJ: {
+				mat4 viewProj = _camera.projectionMatrix * _camera.viewMatrix;
+				glUniformMatrix4fv(uniforms[i].location, 1, GL_FALSE, (float*)&viewProj);
+				break;
 			}
 		}
 	}
 }
 void Shader::UpdateMaterialUniforms(const Material& _material, RenderingEngine& _renderer) {
-	for (unsigned int i = 0; i < shaderData->uniformNames.size(); i++) {
-		string uniformName = shaderData->uniformNames[i];
-		string uniformType = shaderData->uniformTypes[i];
-		string uniformPrefix = uniformName.substr(0, 2);
-		if (uniformPrefix == "M_") {
-			string unprefixedName = uniformName.substr(2, uniformName.length());
-			if (uniformType == "sampler2D") {
-				int samplerSlot = _renderer.GetSamplerSlot(unprefixedName);
-				_material.GetTexture(unprefixedName)->Bind(samplerSlot);
-				SetInt(uniformName, samplerSlot);
-			} else if (uniformType == "vec3") {
-				SetVector3(uniformName, *_material.GetVector3(unprefixedName));
-			} else if (uniformType == "float") {
-				SetFloat(uniformName, *_material.GetFloat(unprefixedName));
-			} else {
-				throw uniformType + " is not supported by the Material class";
+	const MaterialData* materialData = _material.materialData;
+	vector<UniformSlot>& uniforms = shaderData->materialUniforms;
+	for (unsigned int i = 0; i < uniforms.size(); i++) {
+		UniformSlot& uniform = uniforms[i];
+		switch (uniform.binding) {
+			case UNIFORM_M_SAMPLER2D: {
+				if (uniform.samplerSlot < 0) {
+					uniform.samplerSlot = _renderer.GetSamplerSlot(uniform.propertyName);
+				}
+				materialData->GetTexture(uniform.propertyId)->Bind(uniform.samplerSlot);
+				glUniform1i(uniform.location, uniform.samplerSlot);
+				break;
+			}
+			case UNIFORM_M_VEC3: {
+				glUniform3fv(uniform.location, 1, (float*)materialData->GetVector3(uniform.propertyId));
+				break;
+			}
+			case UNIFORM_M_FLOAT: {
+				float* value = materialData->GetFloat(uniform.propertyId);
+				if (value != nullptr) {
+					glUniform1f(uniform.location, *value);
+				}
+				break;
 			}
 		}
 	}
@@ -427,61 +542,61 @@ void Shader::Disable() const {
 	glUseProgram(0);
 }
 void Shader::SetFloat(string _propertyName, const float& _value) {
-	GLuint valueHandle = glGetUniformLocation(shaderData->program, _propertyName.c_str());
+	GLint valueHandle = shaderData->GetLocation(_propertyName);
 	if (valueHandle >= 0) {
 		glUniform1f(valueHandle, _value);
 	}
 }
 void Shader::SetInt(string _propertyName, const int& _value) {
-	GLuint valueHandle = shaderData->GetLocation(_propertyName);
+	GLint valueHandle = shaderData->GetLocation(_propertyName);
 	if (valueHandle >= 0) {
 		glUniform1i(valueHandle, _value);
 	}
 }
 void Shader::SetMatrix4(string _propertyName, const int _size, const mat4& _value, bool _transposed) {
-	GLuint valueHandle = shaderData->GetLocation(_propertyName);
+	GLint valueHandle = shaderData->GetLocation(_propertyName);
 	if (valueHandle >= 0) {
 		glUniformMatrix4fv(valueHandle, _size, _transposed, (float*)&_value);
 	}
 }
 void Shader::SetVector4(string _propertyName, const vec4& _value) {
-	GLuint valueHandle = shaderData->GetLocation(_propertyName);
+	GLint valueHandle = shaderData->GetLocation(_propertyName);
 	if (valueHandle >= 0) {
 		glUniform4fv(valueHandle, 1, (float*)&_value);
 	}
 }
 void Shader::SetVector3(string _propertyName, const vec3& _value) {
-	GLuint valueHandle = shaderData->GetLocation(_propertyName);
+	GLint valueHandle = shaderData->GetLocation(_propertyName);
 	if (valueHandle >= 0) {
 		glUniform3fv(valueHandle, 1, (float*)&_value);
 	}
 }
 void Shader::SetVector3(string _propertyName, const Color& _value) {
-	GLuint valueHandle = shaderData->GetLocation(_propertyName);
+	GLint valueHandle = shaderData->GetLocation(_propertyName);
 	if (valueHandle >= 0) {
 		glUniform3fv(valueHandle, 1, (float*)&vec3(_value.r, _value.g, _value.b));
 	}
 }
 void Shader::SetFloat2(string _propertyName, const vec2& _value) {
-	GLuint valueHandle = glGetUniformLocation(shaderData->program, _propertyName.c_str());
+	GLint valueHandle = shaderData->GetLocation(_propertyName);
 	if (valueHandle >= 0) {
 		glUniform2f(valueHandle, _value.x, _value.y);
 	}
 }
 void Shader::SetFloat2(string _propertyName, const float& _a, const float& _b) {
-	GLuint valueHandle = glGetUniformLocation(shaderData->program, _propertyName.c_str());
+	GLint valueHandle = shaderData->GetLocation(_propertyName);
 	if (valueHandle >= 0) {
 		glUniform2f(valueHandle, _a, _b);
 	}
 }
 void Shader::SetFloat3(string _propertyName, const vec3& _value) {
-	GLuint valueHandle = glGetUniformLocation(shaderData->program, _propertyName.c_str());
+	GLint valueHandle = shaderData->GetLocation(_propertyName);
 	if (valueHandle >= 0) {
 		glUniform3f(valueHandle, _value.x, _value.y, _value.z);
 	}
 }
 void Shader::SetFloat3(string _propertyName, const float& _a, const float& _b, const float& _c) {
-	GLuint valueHandle = glGetUniformLocation(shaderData->program, _propertyName.c_str());
+	GLint valueHandle = shaderData->GetLocation(_propertyName);
 	if (valueHandle >= 0) {
 		glUniform3f(valueHandle, _a, _b, _c);
 	}
@@ -512,6 +627,34 @@ void Shader::SetPointLights(const string& _uniformName, const vector<PointLight*
 	}
 }
 
+void Shader::SetDirectionalLights(const UniformSlot& _uniform, const vector<DirectionalLight*>& _dirLights) {
+	unsigned int lightCount = std::min((unsigned int)_dirLights.size(), (unsigned int)_uniform.arrayLocations.size() / DIR_LIGHT_MEMBER_COUNT);
+	for (unsigned int i = 0; i < lightCount; ++i) {
+		const GLint* locations = &_uniform.arrayLocations[i * DIR_LIGHT_MEMBER_COUNT];
+		//Base Light
+		glUniform3fv(locations[DIR_LIGHT_AMBIENT], 1, (float*)&_dirLights[i]->ambient);
+		glUniform3fv(locations[DIR_LIGHT_DIFFUSE], 1, (float*)&_dirLights[i]->diffuse);
+		glUniform3fv(locations[DIR_LIGHT_SPECULAR], 1, (float*)&_dirLights[i]->specular);
+		//Direction Light
+		glUniform3fv(locations[DIR_LIGHT_DIRECTION], 1, (float*)&_dirLights[i]->direction);
+	}
+}
+void Shader::SetPointLights(const UniformSlot& _uniform, const vector<PointLight*>& _pointLights) {
+	unsigned int lightCount = std::min((unsigned int)_pointLights.size(), (unsigned int)_uniform.arrayLocations.size() / POINT_LIGHT_MEMBER_COUNT);
+	for (unsigned int i = 0; i < lightCount; ++i) {
+		const GLint* locations = &_uniform.arrayLocations[i * POINT_LIGHT_MEMBER_COUNT];
+		//Base Light
+		glUniform3fv(locations[POINT_LIGHT_AMBIENT], 1, (float*)&_pointLights[i]->ambient);
+		glUniform3fv(locations[POINT_LIGHT_DIFFUSE], 1, (float*)&_pointLights[i]->diffuse);
+		glUniform3fv(locations[POINT_LIGHT_SPECULAR], 1, (float*)&_pointLights[i]->specular);
+		//Point Light
+		glUniform1f(locations[POINT_LIGHT_CONSTANT], _pointLights[i]->attenuation.constant);
+		glUniform1f(locations[POINT_LIGHT_LINEAR], _pointLights[i]->attenuation.linear);
+		glUniform1f(locations[POINT_LIGHT_QUADRATIC], _pointLights[i]->attenuation.quadratic);
+		glUniform3fv(locations[POINT_LIGHT_POSITION], 1, (float*)&_pointLights[i]->transform->position);
+	}
+}
+
 // Static
 void Shader::Shutdown() {
 	for (auto resource : sm_resourceMap) {
@@ -54,6 +54,45 @@ struct TypedData {
 	string type;
 };
 
+// Identifies what feeds a uniform so that it can be set without
+// inspecting its name during rendering
+enum UniformBinding {
+	UNIFORM_R_LIGHT_MATRIX,
+	UNIFORM_R_SAMPLER2D,
+	UNIFORM_R_VEC3,
+	UNIFORM_R_FLOAT,
+	UNIFORM_R_DIR_LIGHT_COUNT,
+	UNIFORM_R_POINT_LIGHT_COUNT,
+	UNIFORM_R_DIR_LIGHTS,
+	UNIFORM_R_POINT_LIGHTS,
+	UNIFORM_T_MODEL,
+	UNIFORM_C_EYE_POS,
+	UNIFORM_C_VIEW_PROJ,
+	UNIFORM_M_SAMPLER2D,
+	UNIFORM_M_VEC3,
+	UNIFORM_M_FLOAT
+};
+
+// Light array member locations, stored per element in this order
+enum DirLightMember { DIR_LIGHT_AMBIENT, DIR_LIGHT_DIFFUSE, DIR_LIGHT_SPECULAR, DIR_LIGHT_DIRECTION, DIR_LIGHT_MEMBER_COUNT };
+enum PointLightMember { POINT_LIGHT_AMBIENT, POINT_LIGHT_DIFFUSE, POINT_LIGHT_SPECULAR, POINT_LIGHT_CONSTANT, 
+	POINT_LIGHT_LINEAR, POINT_LIGHT_QUADRATIC, POINT_LIGHT_POSITION, POINT_LIGHT_MEMBER_COUNT };
+
+struct UniformSlot {
+	UniformSlot(UniformBinding _binding, GLint _location, const string& _propertyName) :
+		binding(_binding),
+		location(_location),
+		propertyId(0),
+		samplerSlot(-1),
+		propertyName(_propertyName) {}
+	UniformBinding binding;
+	GLint location;
+	unsigned int propertyId; //MaterialData property id of the unprefixed name
+	int samplerSlot; //Resolved from the rendering engine on first use
+	string propertyName;
+	vector<GLint> arrayLocations; //Light array member locations
+};
+
 struct UniformData {
 public:
 	UniformData(const string& _name, const vector<TypedData>& _memberNames) :
@@ -78,7 +117,8 @@ public:
 	void AddUniform(const string& _uniformName, const string& _uniformType, const vector<UniformData>& _structs);
 	void CompileShader();
 	void GetAllUniforms();
-	GLint GetLocation(string _name);
+	void BuildUniformBindings();
+	GLint GetLocation(const string& _name);
 	
 	static int s_supportedOpenGLLevel;
 	static string s_glslVersion;
@@ -88,7 +128,12 @@ public:
 	vector<string> uniformNames;
 	vector<string> uniformTypes;
 	map<string, GLint> uniformMap;
+	vector<UniformSlot> rendererUniforms;
+	vector<UniformSlot> transformUniforms;
+	vector<UniformSlot> cameraUniforms;
+	vector<UniformSlot> materialUniforms;
 private:
+	void AddLightArrayLocations(UniformSlot& _slot, const string& _uniformName, const char** _members, unsigned int _memberCount);
 	bool CompileShader(string _file, GLuint& _shaderHandle);
 	bool CompileSucceeded(GLuint _shaderHandle);
 	bool LinkSucceeded() const;
@@ -120,6 +165,8 @@ public:
 	void SetFloat3(string _propertyName, const float& _a, const float& _b, const float& _c);
 	void SetDirectionalLights(const string& _uniformName, const vector<DirectionalLight*>& _dirLights);
 	void SetPointLights(const string& _uniformName, const vector<PointLight*>& _pointLights);
+	void SetDirectionalLights(const UniformSlot& _uniform, const vector<DirectionalLight*>& _dirLights);
+	void SetPointLights(const UniformSlot& _uniform, const vector<PointLight*>& _pointLights);
 	
 	static void Shutdown();
 
@@ -0,0 +1,134 @@
+#include "SpatialIndex.h"
+
+// Components
+#include "MeshRenderer.h"
+#include "ComponentPool.h"
+#include "Transform.h"
+
+// Other
+#include <algorithm>
+
+const float SpatialIndex::REBUILD_GROWTH = 2.0f;
+vector<MeshRenderer*> SpatialIndex::sm_renderers;
+BoundsTree SpatialIndex::sm_tree;
+bool SpatialIndex::sm_dirty = true;
+
+// Public
+void SpatialIndex::Invalidate() {
+	sm_dirty = true;
+}
+bool SpatialIndex::Raycast(const Ray& _ray, RaycastHit& _hitInfo, float _maxDistance, bool _selectableOnly) {
+	Refresh();
+	unsigned int item;
+	float distance;
+	vector<MeshRenderer*>& renderers = sm_renderers;
+	bool hit = sm_tree.Raycast(_ray, _maxDistance, [&renderers, &_ray, _selectableOnly](unsigned int _item, float _maxDistance, float& _distance) {
+		MeshRenderer* renderer = renderers[_item];
+		return (!_selectableOnly || renderer->transform->isSelectable) && IntersectRenderer(renderer, _ray, _maxDistance, _distance);
+	}, item, distance);
+	if (!hit) {
+		return false;
+	}
+	_hitInfo.collider = nullptr;
+	_hitInfo.transform = sm_renderers[item]->transform;
+	_hitInfo.distance = distance;
+	_hitInfo.point = _ray.origin + _ray.direction * distance;
+	return true;
+}
+void SpatialIndex::RaycastAll(const Ray& _ray, vector<RaycastHit>& _hits, float _maxDistance) {
+	_hits.clear();
+	Refresh();
+	vector<unsigned int> items;
+	vector<float> distances;
+	vector<MeshRenderer*>& renderers = sm_renderers;
+	sm_tree.RaycastAll(_ray, _maxDistance, [&renderers, &_ray](unsigned int _item, float _maxDistance, float& _distance) {
+		return IntersectRenderer(renderers[_item], _ray, _maxDistance, _distance);
+	}, items, distances);
+	for (unsigned int i = 0; i < items.size(); ++i) {
+		RaycastHit hit;
+		hit.transform = sm_renderers[items[i]]->transform;
+		hit.distance = distances[i];
+		hit.point = _ray.origin + _ray.direction * distances[i];
+		_hits.push_back(hit);
+	}
+	std::sort(_hits.begin(), _hits.end(), [](const RaycastHit& _a, const RaycastHit& _b) {
+		return _a.distance < _b.distance;
+	});
+}
+void SpatialIndex::OverlapSphere(const vec3& _center, float _radius, vector<Transform*>& _results) {
+	_results.clear();
+	Refresh();
+	vector<unsigned int> items;
+	sm_tree.OverlapSphere(_center, _radius, items);
+	for (unsigned int i = 0; i < items.size(); ++i) {
+		_results.push_back(sm_renderers[items[i]]->transform);
+	}
+}
+void SpatialIndex::OverlapBox(const vec3& _center, const vec3& _halfSize, vector<Transform*>& _results) {
+	_results.clear();
+	Refresh();
+	vector<unsigned int> items;
+	sm_tree.OverlapBox(_center, _halfSize, items);
+	for (unsigned int i = 0; i < items.size(); ++i) {
+		_results.push_back(sm_renderers[items[i]]->transform);
+	}
+}
+void SpatialIndex::KNearest(const vec3& _point, unsigned int _count, vector<Transform*>& _results) {
+	_results.clear();
+	Refresh();
+	vector<unsigned int> items;
+	sm_tree.KNearest(_point, _count, items);
+	for (unsigned int i = 0; i < items.size(); ++i) {
+		_results.push_back(sm_renderers[items[i]]->transform);
+	}
+}
+
+// Private
+void SpatialIndex::Refresh() {
+	if (!sm_dirty) {
+		return;
+	}
+	sm_dirty = false;
+
+	// Any renderer added or removed since the last build means a rebuild
+	vector<MeshRenderer*>& renderers = ComponentPool<MeshRenderer>::Get().components;
+	bool changed = renderers.size() != sm_renderers.size();
+	for (unsigned int i = 0; !changed && i < renderers.size(); ++i) {
+		changed = renderers[i] != sm_renderers[i];
+	}
+	if (changed) {
+		Build();
+		return;
+	}
+
+	// Note(Manny): Refitting keeps the tree valid but not tight, so once the
+	// objects have spread out far enough it is cheaper to start again
+	sm_tree.Refit();
+	if (!sm_tree.IsEmpty() && sm_tree.GetSurfaceArea() > sm_tree.GetBuiltSurfaceArea() * REBUILD_GROWTH) {
+		Build();
+	}
+}
+void SpatialIndex::Build() {
+	sm_renderers = ComponentPool<MeshRenderer>::Get().components;
+	vector<const Bounds*> bounds(sm_renderers.size(), nullptr);
+	for (unsigned int i = 0; i < sm_renderers.size(); ++i) {
+		if (sm_renderers[i]->transform != nullptr) {
+			bounds[i] = &sm_renderers[i]->bounds;
+		}
+	}
+	sm_tree.Build(bounds);
+}
+bool SpatialIndex::IntersectRenderer(MeshRenderer* _renderer, const Ray& _ray, float _maxDistance, float& _distance) {
+	// Note(Manny): Models still loading only have their bounds to hit
+	IndexedModel* model = _renderer->mesh.model;
+	TriangleTree* triangleTree = model->isLoaded ? model->GetTriangleTree() : nullptr;
+	if (triangleTree == nullptr) {
+		return true;
+	}
+	TriangleHit hit;
+	if (!triangleTree->Raycast(_ray, _renderer->transform->worldMatrix, _maxDistance, hit)) {
+		return false;
+	}
+	_distance = hit.distance;
+	return true;
+}
\ No newline at end of file
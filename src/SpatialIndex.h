@@ -0,0 +1,62 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: SpatialIndex.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: A bounding volume hierarchy over the
+world bounds of every MeshRenderer, answering
+ray, overlap and nearest object queries.
+===============================================*/
+
+#ifndef _SPATIAL_INDEX_H_
+#define _SPATIAL_INDEX_H_
+
+// Structs
+#include "Ray.h"
+
+// Utilities
+#include "GLM_Header.h"
+#include "BoundsTree.h"
+
+// Other
+#include <vector>
+using std::vector;
+
+// Forward declaration
+class MeshRenderer;
+class Transform;
+
+// The tree is rebuilt when renderers are added or removed and otherwise only
+// refit, so it stays cheap when objects move. Nothing is done until the first
+// query of a frame. Query from the main thread, or from jobs that the main
+// thread waits on once the frame's first query has been made. Rays hit a
+// model's triangles, whose tree is built by the first ray to reach it.
+class SpatialIndex {
+public:
+	// Marks the world bounds as changed, called by renderers that moved or went away
+	static void Invalidate();
+	// Finds the closest object the ray hits, optionally skipping unselectable ones
+	static bool Raycast(const Ray& _ray, RaycastHit& _hitInfo, float _maxDistance, bool _selectableOnly = false);
+	// Every object the ray hits, closest first
+	static void RaycastAll(const Ray& _ray, vector<RaycastHit>& _hits, float _maxDistance);
+	static void OverlapSphere(const vec3& _center, float _radius, vector<Transform*>& _results);
+	static void OverlapBox(const vec3& _center, const vec3& _halfSize, vector<Transform*>& _results);
+	// The _count objects whose bounds are closest to _point, closest first
+	static void KNearest(const vec3& _point, unsigned int _count, vector<Transform*>& _results);
+	inline static unsigned int GetObjectCount() { return sm_renderers.size(); }
+
+	static const float REBUILD_GROWTH; //Root surface area growth that triggers a rebuild
+private:
+	static void Refresh();
+	static void Build();
+	// Tests the triangles of the renderer's model once loaded, its bounds were hit at _distance
+	static bool IntersectRenderer(MeshRenderer* _renderer, const Ray& _ray, float _maxDistance, float& _distance);
+
+	static vector<MeshRenderer*> sm_renderers; //Renderers the tree was built for, indexed by its items
+	static BoundsTree sm_tree;
+	static bool sm_dirty;
+};
+
+#endif // _SPATIAL_INDEX_H_
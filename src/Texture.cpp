@@ -2,29 +2,46 @@
 
 // Utilities
 #include "GLM_Header.h"
+#include "AssetLoader.h"
 #include "stb_image.h"
 
 // Other
 #include <iostream>
+#include <memory>
 
 map<string, TextureData*> Texture::sm_resourceMap;
+std::mutex Texture::sm_resourceMutex;
+TextureData* Texture::sm_placeholder = nullptr;
+const string Texture::PLACEHOLDER_TEXTURE = "default_texture.png";
 
 // TextureData
 TextureData::TextureData(GLenum _textureTarget, int _width, int _height, int _numTextures,
 	unsigned char** _pixelData, GLfloat* _filters, GLenum* _internalFormat,
-	GLenum* _format, bool _clamp, GLenum* _attachments) {
+	GLenum* _format, bool _clamp, GLenum* _attachments) :
+	TextureData(_textureTarget, _numTextures) {
+	Init(_width, _height, _pixelData, _filters, _internalFormat, _format, _clamp, _attachments);
+}
+TextureData::TextureData(GLenum _textureTarget, int _numTextures) {
 	m_textureID = new GLuint[_numTextures];
+	for (int i = 0; i < _numTextures; ++i) {
+		m_textureID[i] = 0;
+	}
 	m_textureTarget = _textureTarget;
 	m_numTextures = _numTextures;
 
-	width = _width;
-	height = _height;
+	width = 0;
+	height = 0;
 
 	m_frameBuffer = 0;
 	m_renderBuffer = 0;
-
-	InitTextures(_pixelData, _filters, _internalFormat, _format, _clamp);
-	InitRenderTargets(_attachments);
+	m_format = GL_RGBA;
+	m_loaded = false;
+	m_pixelBuffer = 0;
+	m_mappedPixels = nullptr;
+	m_pixelBufferIndex = 0;
+	for (int i = 0; i < PIXEL_BUFFER_COUNT; ++i) {
+		m_pixelBufferFences[i] = 0;
+	}
 }
 TextureData::~TextureData() {
 	if (*m_textureID) { 
@@ -39,6 +56,27 @@ TextureData::~TextureData() {
 	if (m_textureID) {
 		delete[] m_textureID;
 	}
+	if (m_pixelBuffer) {
+		for (int i = 0; i < PIXEL_BUFFER_COUNT; ++i) {
+			if (m_pixelBufferFences[i]) {
+				glDeleteSync(m_pixelBufferFences[i]);
+			}
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &m_pixelBuffer);
+	}
+}
+void TextureData::Init(int _width, int _height, unsigned char** _pixelData, GLfloat* _filters,
+	GLenum* _internalFormat, GLenum* _format, bool _clamp, GLenum* _attachments) {
+	width = _width;
+	height = _height;
+	m_format = _format[0];
+
+	InitTextures(_pixelData, _filters, _internalFormat, _format, _clamp);
+	InitRenderTargets(_attachments);
+	m_loaded = true;
 }
 void TextureData::InitTextures(unsigned char** _pixelData, GLfloat* _filters,
 	GLenum* _internalFormat, GLenum* _format, bool _clamp) {
@@ -123,6 +161,52 @@ void TextureData::BindAsRenderTarget() const {
 	glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
 	glViewport(0, 0, width, height);
 }
+void TextureData::UpdatePixels(const unsigned char* _pixelData, int _x, int _y, int _width, int _height) {
+	glBindTexture(m_textureTarget, m_textureID[0]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(m_textureTarget, 0, _x, _y, _width, _height, m_format, GL_UNSIGNED_BYTE, _pixelData);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+unsigned char* TextureData::BeginUpdate() {
+	if (m_pixelBuffer == 0) {
+		InitPixelBuffer();
+	}
+	m_pixelBufferIndex = (m_pixelBufferIndex + 1) % PIXEL_BUFFER_COUNT;
+
+	// Wait for the upload that last used this slice, normally long finished
+	GLsync& fence = m_pixelBufferFences[m_pixelBufferIndex];
+	if (fence) {
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		glDeleteSync(fence);
+		fence = 0;
+	}
+	return m_mappedPixels + m_pixelBufferIndex * width * height * GetBytesPerPixel();
+}
+void TextureData::EndUpdate() {
+	size_t offset = m_pixelBufferIndex * width * height * GetBytesPerPixel();
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+	UpdatePixels((const unsigned char*)offset, 0, 0, width, height);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	m_pixelBufferFences[m_pixelBufferIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+int TextureData::GetBytesPerPixel() const {
+	switch (m_format) {
+	case GL_RED: return 1;
+	case GL_RG: return 2;
+	case GL_RGB: return 3;
+	default: return 4;
+	}
+}
+void TextureData::InitPixelBuffer() {
+	GLsizeiptr size = width * height * GetBytesPerPixel() * PIXEL_BUFFER_COUNT;
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &m_pixelBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+	m_mappedPixels = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
 
 // Texture
 Texture::Texture(int _width, int _height,
@@ -135,11 +219,10 @@ Texture::Texture(int _width, int _height,
 	bool _clamp,
 	GLenum _attachment) {
 	fileName = _fileName;
-	map<string, TextureData*>::const_iterator it = sm_resourceMap.find(fileName);
-	if (it != sm_resourceMap.end()) {
-		m_textureData = it->second;
-	} else {
+	m_textureData = FindTexture(fileName);
+	if (m_textureData == nullptr) {
 		m_textureData = new TextureData(_textureTarget, _width, _height, 1, &_data, &_filter, &_internalFormat, &_format, _clamp, &_attachment);
+		std::lock_guard<std::mutex> lock(sm_resourceMutex);
 		sm_resourceMap.insert(std::pair<std::string, TextureData*>(fileName, m_textureData));
 	}
 }
@@ -151,10 +234,8 @@ Texture::Texture(const string& _fileName,
 	bool _clamp,
 	GLenum _attachment) {
 	fileName = _fileName;
-	map<string, TextureData*>::const_iterator it = sm_resourceMap.find(_fileName);
-	if (it != sm_resourceMap.end()) {
-		m_textureData = it->second;
-	} else {
+	m_textureData = FindTexture(_fileName);
+	if (m_textureData == nullptr) {
 		int x, y, bytesPerPixel;
 		unsigned char* data = stbi_load(("./textures/" + _fileName).c_str(), &x, &y, &bytesPerPixel, 4);
 
@@ -165,16 +246,24 @@ Texture::Texture(const string& _fileName,
 		m_textureData = new TextureData(_textureTarget, x, y, 1, &data, &_filter, &_internalFormat, &_format, _clamp, &_attachment);
 		stbi_image_free(data);
 
+		std::lock_guard<std::mutex> lock(sm_resourceMutex);
 		sm_resourceMap.insert(std::pair<std::string, TextureData*>(_fileName, m_textureData));
 	}
 }
+Texture::Texture(const string& _fileName, TextureData* _textureData) :
+	fileName(_fileName),
+	m_textureData(_textureData) {}
 Texture::~Texture() {}
 unsigned int Texture::GetTextureHardwareID() {
 	return textureHardwareID;
 }
 void Texture::Bind(unsigned int _unit) const {
 	glActiveTexture(GL_TEXTURE0 + _unit);
-	m_textureData->Bind(0);
+	if (m_textureData->IsLoaded()) {
+		m_textureData->Bind(0);
+	} else {
+		GetPlaceholder()->Bind(0);
+	}
 }
 void Texture::BindAsRenderTarget() const {
 	m_textureData->BindAsRenderTarget();
@@ -185,18 +274,95 @@ int Texture::GetWidth() const {
 int Texture::GetHeight() const {
 	return m_textureData->height;
 }
+void Texture::UpdatePixels(const unsigned char* _pixelData) {
+	m_textureData->UpdatePixels(_pixelData, 0, 0, m_textureData->width, m_textureData->height);
+}
+unsigned char* Texture::BeginUpdate() {
+	return m_textureData->BeginUpdate();
+}
+void Texture::EndUpdate() {
+	m_textureData->EndUpdate();
+}
 void Texture::Shutdown() {
+	// Uploads still queued would write into deleted textures
+	AssetLoader::Flush();
+	std::lock_guard<std::mutex> lock(sm_resourceMutex);
 	for (auto resource : sm_resourceMap) {
 		delete resource.second;
 	}
 	sm_resourceMap.clear();
+	sm_placeholder = nullptr;
 }
 void Texture::RemoveTexture(string _textureName) {
-	for (auto resource : sm_resourceMap) {
-		if (resource.first == _textureName) {
-			delete resource.second;
-			sm_resourceMap.erase(resource.first);
+	TextureData* textureData = FindTexture(_textureName);
+	if (textureData != nullptr && !textureData->IsLoaded()) {
+		AssetLoader::Flush();
+	}
+	std::lock_guard<std::mutex> lock(sm_resourceMutex);
+	map<string, TextureData*>::iterator it = sm_resourceMap.find(_textureName);
+	if (it != sm_resourceMap.end()) {
+		delete it->second;
+		sm_resourceMap.erase(it);
+	}
+}
+Texture Texture::LoadAsync(const string& _fileName,
+	GLenum _textureTarget,
+	GLfloat _filter,
+	GLenum _internalFormat,
+	GLenum _format,
+	bool _clamp) {
+	// The placeholder itself always loads straight away
+	if (_fileName == PLACEHOLDER_TEXTURE) {
+		return Texture(_fileName, _textureTarget, _filter, _internalFormat, _format, _clamp);
+	}
+
+	TextureData* textureData;
+	{
+		std::lock_guard<std::mutex> lock(sm_resourceMutex);
+		map<string, TextureData*>::const_iterator it = sm_resourceMap.find(_fileName);
+		if (it != sm_resourceMap.end()) {
+			return Texture(_fileName, it->second);
+		}
+		textureData = new TextureData(_textureTarget, 1);
+		sm_resourceMap.insert(std::pair<std::string, TextureData*>(_fileName, textureData));
+	}
+
+	struct DecodedImage {
+		unsigned char* pixels;
+		int width;
+		int height;
+	};
+	std::shared_ptr<DecodedImage> image = std::make_shared<DecodedImage>();
+
+	AssetLoader::Load([image, _fileName]() {
+		int bytesPerPixel;
+		image->pixels = stbi_load(("./textures/" + _fileName).c_str(), &image->width, &image->height, &bytesPerPixel, 4);
+	}, [image, textureData, _fileName, _filter, _internalFormat, _format, _clamp]() {
+		if (image->pixels == NULL) {
+			// Note(Manny): The texture keeps showing the placeholder
+			std::cerr << "Unable to load texture: " << _fileName << std::endl;
 			return;
 		}
+		GLfloat filter = _filter;
+		GLenum internalFormat = _internalFormat;
+		GLenum format = _format;
+		GLenum attachment = GL_NONE;
+		textureData->Init(image->width, image->height, &image->pixels, &filter, &internalFormat, &format, _clamp, &attachment);
+		stbi_image_free(image->pixels);
+	});
+
+	return Texture(_fileName, textureData);
+}
+
+// Protected
+TextureData* Texture::FindTexture(const string& _fileName) {
+	std::lock_guard<std::mutex> lock(sm_resourceMutex);
+	map<string, TextureData*>::const_iterator it = sm_resourceMap.find(_fileName);
+	return it != sm_resourceMap.end() ? it->second : nullptr;
+}
+TextureData* Texture::GetPlaceholder() {
+	if (sm_placeholder == nullptr) {
+		sm_placeholder = Texture(PLACEHOLDER_TEXTURE).m_textureData;
 	}
+	return sm_placeholder;
 }
\ No newline at end of file
@@ -20,6 +20,7 @@ Copyright (c) 2015 Emmanuel Vaccaro
 // Other
 #include <map>
 using std::map;
+#include <mutex>
 
 class TextureData {
 public:
@@ -27,22 +28,43 @@ public:
 	TextureData(GLenum _textureTarget, int _width, int _height, int _numTextures,
 		unsigned char** _pixelData, GLfloat* _filters, GLenum* _internalFormat,
 		GLenum* _format, bool _clamp, GLenum* _attachments);
+	// Creates the texture without any GL objects, Init fills it in later
+	TextureData(GLenum _textureTarget, int _numTextures);
 	~TextureData();
+	void Init(int _width, int _height, unsigned char** _pixelData, GLfloat* _filters,
+		GLenum* _internalFormat, GLenum* _format, bool _clamp, GLenum* _attachments);
+	inline bool IsLoaded() const { return m_loaded; }
 	void Bind(int _textureIndex) const;
 	void BindAsRenderTarget() const;
+	// Dynamic textures
+	void UpdatePixels(const unsigned char* _pixelData, int _x, int _y, int _width, int _height);
+	unsigned char* BeginUpdate();
+	void EndUpdate();
+	int GetBytesPerPixel() const;
 
 	int width;
 	int height;
 private:
+	static const int PIXEL_BUFFER_COUNT = 3;
+
 	void InitTextures(unsigned char** _pixelData, GLfloat* _filters,
 		GLenum* _internalFormat, GLenum* _format, bool _clamp);
 	void InitRenderTargets(GLenum* _attachments);
+	void InitPixelBuffer();
 
 	GLuint m_frameBuffer;
 	GLuint m_renderBuffer;
 	int m_numTextures;
 	GLenum m_textureTarget;
 	GLuint* m_textureID;
+	GLenum m_format;
+	bool m_loaded;
+	// Streaming uploads go through a ring of slices in one persistently
+	// mapped buffer, so the CPU never writes a slice the GPU is reading
+	GLuint m_pixelBuffer;
+	unsigned char* m_mappedPixels;
+	GLsync m_pixelBufferFences[PIXEL_BUFFER_COUNT];
+	int m_pixelBufferIndex;
 };
 
 class Texture {
@@ -64,21 +86,40 @@ public:
 		bool _clamp = false,
 		GLenum _attachment = GL_NONE);
 	~Texture();
+	// Returns straight away, the texture binds the placeholder until it is decoded
+	static Texture LoadAsync(const string& _fileName,
+		GLenum _textureTarget = GL_TEXTURE_2D,
+		GLfloat _filter = GL_LINEAR,
+		GLenum _internalFormat = GL_RGBA,
+		GLenum _format = GL_RGBA,
+		bool _clamp = false);
 	unsigned int GetTextureHardwareID();
 	void Bind(unsigned int _unit = 0) const;
 	void BindAsRenderTarget() const;
 	int GetWidth() const;
 	int GetHeight() const;
+	// Writes new pixels into the existing texture, no GL objects are created
+	void UpdatePixels(const unsigned char* _pixelData);
+	unsigned char* BeginUpdate(); //Returns width * height pixels to write into
+	void EndUpdate();
 	static void Shutdown();
 	static void RemoveTexture(string _textureName);
 
 	string fileName;
 	int anisoLevel; // Note(Manny): Impliment "anisotropic level".
 	int channels;
+
+	static const string PLACEHOLDER_TEXTURE;
 protected:
+	Texture(const string& _fileName, TextureData* _textureData);
+	static TextureData* FindTexture(const string& _fileName);
+	static TextureData* GetPlaceholder();
+
 	unsigned int textureHardwareID;
 
 	static map<string, TextureData*> sm_resourceMap;
+	static std::mutex sm_resourceMutex; //Guards the map, workers may look textures up
+	static TextureData* sm_placeholder;
 
 	TextureData* m_textureData;
 };
@@ -27,8 +27,13 @@
 
 // Utilities
 #include "Input.h"
+#include "SpatialIndex.h"
+
+// Other
+#include <algorithm>
 
 int Transform::transformCount = 0;
+unsigned int Transform::hierarchyVersion = 0;
 map<int, Transform*> Transform::sm_transforms;
 
 // Public
@@ -44,48 +49,54 @@ Transform::Transform(vec3 _position, quat _rotation, vec3 _scale) :
 	isSelected(false),
 	initializedOldStuff(false),
 	isChangedInGUI(false),
+	hasChanged(true),
 	transformID(transformCount++),
 	parent(nullptr) {
 	sm_transforms[transformID] = this;
+	hierarchyVersion++;
 }
 Transform::~Transform() {
 	map<int, Transform*>::iterator it = sm_transforms.find(transformID);
 	if (it != sm_transforms.end()) {
 		sm_transforms.erase(it);
 	}
+	hierarchyVersion++;
 }
 bool Transform::Update() {
 	if (isSelected) { Inspector(); }
 	
-	if (initializedOldStuff) {
-		oldPosition = position;
-		oldEulerAngles = eulerAngles;
-		oldRotation = rotation;
-		oldScale = scale;
-		oldModelMatrix = worldMatrix;
-	} else {
-		oldPosition = position + vec3(1);
-		oldRotation = rotation + quat();
-		oldEulerAngles = glm::eulerAngles(rotation);
-		oldScale = scale + vec3(1);
-		oldModelMatrix = worldMatrix + mat4(1);
-		initializedOldStuff = true;
+	// Note(Manny): Only used by transforms outside of the scene hierarchy,
+	// scene transforms are updated by the TransformHierarchy
+	hasChanged = HasLocalChanged();
+	if (hasChanged) {
+		UpdateWorldMatrix();
 	}
-	
-	UpdateWorldMatrix();
 
 	return true;
 }
 void Transform::UpdateWorldMatrix() {
+	UpdateLocalMatrix();
+	worldMatrix = localMatrix;
+}
+void Transform::UpdateLocalMatrix() {
+	oldModelMatrix = worldMatrix;
+
 	matTranslation = glm::translate(mat4(1.0f), position);
 	matScale = glm::scale(scale);
 	matRotation	= glm::toMat4(rotation);
 
-	worldMatrix = matTranslation * matRotation * matScale;
+	localMatrix = matTranslation * matRotation * matScale;
 
 	right = TransformDirection(vec3(1, 0, 0));
 	up = TransformDirection(vec3(0, 1, 0));
 	forward = TransformDirection(vec3(0, 0, 1));
+
+	// The old values hold the state the local matrix was last built from
+	oldPosition = position;
+	oldEulerAngles = eulerAngles;
+	oldRotation = rotation;
+	oldScale = scale;
+	initializedOldStuff = true;
 }
 void Transform::Inspector() {
 	ImGui::Begin("Inspector", 0, 0 | ImGuiWindowFlags_MenuBar);
@@ -175,9 +186,13 @@ void Transform::Inspector() {
 	ImGui::End();
 }
 bool Transform::HasChanged() {
+	return hasChanged || HasLocalChanged();
+}
+bool Transform::HasLocalChanged() const {
+	if (!initializedOldStuff) { return true; }
 	if (position != oldPosition) { return true; }
 	if (rotation != oldRotation) { return true; }
-	if (scale != scale) { return true; }
+	if (scale != oldScale) { return true; }
 	return false;
 }
 bool Transform::HasChangedInGUI() {
@@ -207,12 +222,16 @@ void Transform::LookAt(const vec3& _toLookAt) {
 	eulerAngles = glm::degrees(glm::eulerAngles(rotation));
 } 
 void Transform::SetParent(Transform* _transform) {
+	if (parent != nullptr) {
+		vector<Transform*>& siblings = parent->children;
+		siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+	}
 	_transform->children.push_back(this);
 	parent = _transform;
+	hierarchyVersion++;
 }
 void Transform::SetParent(GameObject* _gameObject) {
-	_gameObject->transform.children.push_back(this);
-	parent = &_gameObject->transform;
+	SetParent(&_gameObject->transform);
 }
 vec3 Transform::TransformDirection(vec3& _direction) {
 	return (matRotation * vec4(_direction, 0)).xyz();
@@ -227,47 +246,17 @@ void Transform::SetSelectedTransform(Transform* _transform) {
 	_transform->isSelected = true;
 }
 void Transform::UpdateTransformSelection() {
-	vector<SelectedTransform> selectedTransforms;
-	bool mousePressed = false;
-	for (auto trans : sm_transforms) {
-		Transform* transform = trans.second;
-		if (transform->isSelectable) {
-			if (transform->gameObject == nullptr) {
-				continue;
-			}
-			MeshRenderer* meshRenderer = transform->gameObject->GetComponent<MeshRenderer>();
-			if (meshRenderer != nullptr) {
-				vec3 mousePos = Input::GetMousePosition();
-				RaycastHit hitInfo;
-				if (meshRenderer->bounds.RayCast(Camera::current->ScreenPointToRay(mousePos), &hitInfo, 10000.0f)) {
-					if (!ImGui::IsMouseHoveringAnyWindow() && !ImGui::IsMouseDragging(0)) {
-						if (Input::GetMouseButtonDown(GLFW_MOUSE_BUTTON_1)) {
-							mousePressed = true;
-							SelectedTransform newSelectedTransform;
-							newSelectedTransform.transform = transform;
-							newSelectedTransform.hitInfo = hitInfo;
-							selectedTransforms.push_back(newSelectedTransform);
-						}
-					}
-				}
-			}
-		}
+	// Picking only happens on a click, with one ray through the spatial index
+	if (!Input::GetMouseButtonDown(GLFW_MOUSE_BUTTON_1) || 
+		ImGui::IsMouseHoveringAnyWindow() || ImGui::IsMouseDragging(0)) {
+		return;
 	}
-
-	if (selectedTransforms.empty() && mousePressed == true) {
+	RaycastHit hitInfo;
+	Ray mouseRay = Camera::current->ScreenPointToRay(Input::GetMousePosition());
+	if (SpatialIndex::Raycast(mouseRay, hitInfo, 10000.0f, true) && hitInfo.transform->gameObject != nullptr) {
+		SetSelectedTransform(hitInfo.transform);
+	} else {
 		DeselectAllTransforms();
-	} else if (selectedTransforms.size() > 0) {
-		Transform* closestTransform = nullptr;
-		float min = FLT_MAX;
-		for (unsigned int i = 0; i < selectedTransforms.size(); ++i) {
-			float currentDistance = selectedTransforms[i].hitInfo.distance;
-			if (currentDistance < min) {
-				closestTransform = selectedTransforms[i].transform;
-				min = currentDistance;
-			}
-		} if (closestTransform != nullptr) {
-			SetSelectedTransform(closestTransform);
-		}
 	}
 }
 Transform* Transform::GetSelectedTransform() {
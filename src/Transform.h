@@ -35,8 +35,10 @@ public:
 	virtual ~Transform();
 	virtual bool Update();
 	void UpdateWorldMatrix();
+	void UpdateLocalMatrix();
 	void Inspector();
 	bool HasChanged();
+	bool HasLocalChanged() const;
 	bool HasChangedInGUI();
 	void Rotate(const vec3& _eulerAngles);
 	void Rotate(const vec3& _axis, float _angle);
@@ -52,8 +54,10 @@ public:
 	static void DeselectAllTransforms();
 
 	static int transformCount;
+	static unsigned int hierarchyVersion; //Incremented whenever a transform is added, removed or reparented
 
 	mat4 worldMatrix;
+	mat4 localMatrix;
 	mat4 matTranslation;
 	mat4 matRotation;
 	mat4 matScale;
@@ -68,6 +72,7 @@ public:
 	bool isSelectable;
 	bool isSelected;
 	bool isChangedInGUI;
+	bool hasChanged; //Was the world matrix rebuilt during the last update?
 
 	mutable mat4 oldModelMatrix;
 	mutable quat oldRotation;
@@ -80,10 +85,6 @@ public:
 	Transform* parent;
 	GameObject* gameObject;
 private:
-	struct SelectedTransform {
-		Transform* transform;
-		RaycastHit hitInfo;
-	};
 	static map<int, Transform*> sm_transforms;
 };
 
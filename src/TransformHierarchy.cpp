@@ -0,0 +1,127 @@
+#include "TransformHierarchy.h"
+
+// Objects
+#include "GameObject.h"
+
+// Components
+#include "Transform.h"
+
+// Utilities
+#include "JobSystem.h"
+
+// Other
+#include <xmmintrin.h>
+
+bool TransformHierarchy::useSIMD = true;
+
+// Public
+TransformHierarchy::TransformHierarchy() :
+	m_hierarchyVersion(0),
+	m_objectCount(0),
+	m_changedCount(0),
+	m_rebuilt(false) {}
+void TransformHierarchy::Update(vector<GameObject*>& _objects) {
+	if (m_objectCount != _objects.size() || m_hierarchyVersion != Transform::hierarchyVersion) {
+		Rebuild(_objects);
+	}
+
+	// Local matrices only depend on their own transform, so they are rebuilt
+	// across the job threads before the world matrices are walked in order
+	JobSystem::ParallelFor(m_transforms.size(), LOCAL_BATCH_SIZE, [this](unsigned int _begin, unsigned int _end) {
+		for (unsigned int i = _begin; i < _end; ++i) {
+			Transform* transform = m_transforms[i];
+			m_localChanged[i] = transform->HasLocalChanged();
+			if (m_localChanged[i]) {
+				transform->UpdateLocalMatrix();
+				m_localMatrices[i] = transform->localMatrix;
+			}
+		}
+	});
+
+	m_changedCount = 0;
+	for (unsigned int i = 0; i < m_transforms.size(); ++i) {
+		Transform* transform = m_transforms[i];
+		int parentIndex = m_parentIndices[i];
+
+		// A node is dirty if it changed or anything above it changed
+		bool dirty = m_rebuilt || m_localChanged[i] || (parentIndex >= 0 && m_dirty[parentIndex]);
+		m_dirty[i] = dirty;
+		transform->hasChanged = dirty;
+
+		if (dirty) {
+			if (parentIndex >= 0) {
+				MultiplyMatrices(m_worldMatrices[parentIndex], m_localMatrices[i], m_worldMatrices[i]);
+			} else {
+				m_worldMatrices[i] = m_localMatrices[i];
+			}
+			transform->worldMatrix = m_worldMatrices[i];
+			m_changedCount++;
+		}
+	}
+	m_rebuilt = false;
+}
+
+// Static
+void TransformHierarchy::MultiplyMatrices(const mat4& _a, const mat4& _b, mat4& _out) {
+	if (!useSIMD) {
+		_out = _a * _b;
+		return;
+	}
+
+	// Note(Manny): glm matrices are column major, so each output column
+	// is the columns of _a weighted by the matching column of _b
+	const float* a = &_a[0][0];
+	const float* b = &_b[0][0];
+	__m128 a0 = _mm_loadu_ps(a);
+	__m128 a1 = _mm_loadu_ps(a + 4);
+	__m128 a2 = _mm_loadu_ps(a + 8);
+	__m128 a3 = _mm_loadu_ps(a + 12);
+
+	float result[16];
+	for (unsigned int i = 0; i < 4; ++i) {
+		const float* column = b + i * 4;
+		__m128 sum = _mm_mul_ps(a0, _mm_set1_ps(column[0]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(column[1])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(column[2])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(column[3])));
+		_mm_storeu_ps(result + i * 4, sum);
+	}
+	_out = glm::make_mat4(result);
+}
+
+// Private
+void TransformHierarchy::Rebuild(vector<GameObject*>& _objects) {
+	m_transforms.clear();
+	m_parentIndices.clear();
+
+	for (unsigned int i = 0; i < _objects.size(); ++i) {
+		Transform* transform = &_objects[i]->transform;
+		if (transform->parent == nullptr) {
+			AddNode(transform, -1);
+		}
+	}
+
+	// Breadth first, so every parent lands before its children
+	for (unsigned int i = 0; i < m_transforms.size(); ++i) {
+		vector<Transform*>& children = m_transforms[i]->children;
+		for (unsigned int j = 0; j < children.size(); ++j) {
+			AddNode(children[j], i);
+		}
+	}
+
+	m_localMatrices.resize(m_transforms.size());
+	m_worldMatrices.resize(m_transforms.size());
+	m_dirty.resize(m_transforms.size());
+	m_localChanged.resize(m_transforms.size());
+	for (unsigned int i = 0; i < m_transforms.size(); ++i) {
+		m_localMatrices[i] = m_transforms[i]->localMatrix;
+	}
+
+	m_objectCount = _objects.size();
+	m_hierarchyVersion = Transform::hierarchyVersion;
+	m_rebuilt = true;
+}
+void TransformHierarchy::AddNode(Transform* _transform, int _parentIndex) {
+	m_transforms.push_back(_transform);
+	m_parentIndices.push_back(_parentIndex);
+}
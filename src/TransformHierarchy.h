@@ -0,0 +1,55 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: TransformHierarchy.h
+@date: 14/08/2015
+@author: Emmanuel Vaccaro
+@brief: Stores the scene's transforms in flat
+parent-before-child arrays and only rebuilds
+the world matrices of changed subtrees.
+===============================================*/
+
+#ifndef _TRANSFORM_HIERARCHY_H_
+#define _TRANSFORM_HIERARCHY_H_
+
+// Utilities
+#include "GLM_Header.h"
+
+// Other
+#include <vector>
+using std::vector;
+
+// Forward declaration
+class Transform;
+class GameObject;
+
+class TransformHierarchy {
+public:
+	TransformHierarchy();
+	void Update(vector<GameObject*>& _objects);
+	inline unsigned int GetTransformCount() const { return m_transforms.size(); }
+	inline unsigned int GetChangedCount() const { return m_changedCount; }
+	static void MultiplyMatrices(const mat4& _a, const mat4& _b, mat4& _out);
+
+	static bool useSIMD; //Multiply world matrices with SSE
+private:
+	static const unsigned int LOCAL_BATCH_SIZE = 256;
+
+	void Rebuild(vector<GameObject*>& _objects);
+	void AddNode(Transform* _transform, int _parentIndex);
+
+	// Parallel arrays, every parent is stored before its children
+	vector<Transform*> m_transforms;
+	vector<int> m_parentIndices;
+	vector<mat4> m_localMatrices;
+	vector<mat4> m_worldMatrices;
+	vector<unsigned char> m_dirty;
+	vector<unsigned char> m_localChanged;
+	unsigned int m_hierarchyVersion;
+	unsigned int m_objectCount;
+	unsigned int m_changedCount;
+	bool m_rebuilt;
+};
+
+#endif // _TRANSFORM_HIERARCHY_H_
\ No newline at end of file
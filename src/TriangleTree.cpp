@@ -0,0 +1,356 @@
+#include "TriangleTree.h"
+
+// Other
+#include <xmmintrin.h>
+#include <algorithm>
+#include <cfloat>
+
+// Public
+void TriangleTree::AddMesh(const vector<vec3>& _positions, const vector<unsigned int>& _indices) {
+	for (unsigned int i = 0; i + 2 < _indices.size(); i += 3) {
+		m_vertices.push_back(_positions[_indices[i]]);
+		m_vertices.push_back(_positions[_indices[i + 1]]);
+		m_vertices.push_back(_positions[_indices[i + 2]]);
+	}
+	m_triangleCount = m_vertices.size() / 3;
+}
+void TriangleTree::Build() {
+	m_nodes.clear();
+	m_packets.clear();
+	m_build.resize(m_triangleCount);
+	for (unsigned int i = 0; i < m_triangleCount; ++i) {
+		const vec3* triangle = &m_vertices[i * 3];
+		BuildTriangle& build = m_build[i];
+		build.min = glm::min(glm::min(triangle[0], triangle[1]), triangle[2]);
+		build.max = glm::max(glm::max(triangle[0], triangle[1]), triangle[2]);
+		build.center = (build.min + build.max) * 0.5f;
+		build.triangle = i;
+	}
+	if (m_triangleCount > 0) {
+		m_nodes.reserve(m_triangleCount * 2 / PACKET_SIZE + 1);
+		m_packets.reserve(m_triangleCount / PACKET_SIZE + 1);
+		BuildNode(0, m_triangleCount, 0);
+	}
+
+	// The packets hold everything queries need
+	vector<vec3>().swap(m_vertices);
+	vector<BuildTriangle>().swap(m_build);
+}
+bool TriangleTree::Raycast(const Ray& _ray, float _maxDistance, TriangleHit& _hit) const {
+	if (m_nodes.empty()) {
+		return false;
+	}
+	bool hit = false;
+	float closest = _maxDistance;
+	unsigned int stack[STACK_SIZE];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		unsigned int nodeIndex = stack[--stackSize];
+		const Node& node = m_nodes[nodeIndex];
+		float distance;
+		if (!IntersectBox(node, _ray, closest, distance)) {
+			continue;
+		}
+		if (node.count > 0) {
+			if (IntersectPacket(m_packets[node.first], node.count, _ray, closest, _hit)) {
+				closest = _hit.distance;
+				hit = true;
+			}
+			continue;
+		}
+
+		// Push the farther child first so the nearer one is searched first
+		unsigned int left = nodeIndex + 1;
+		unsigned int right = node.first;
+		float leftDistance, rightDistance;
+		bool hitLeft = IntersectBox(m_nodes[left], _ray, closest, leftDistance);
+		bool hitRight = IntersectBox(m_nodes[right], _ray, closest, rightDistance);
+		if (hitLeft && hitRight) {
+			if (leftDistance < rightDistance) {
+				std::swap(left, right);
+			}
+			stack[stackSize++] = left;
+			stack[stackSize++] = right;
+		} else if (hitLeft) {
+			stack[stackSize++] = left;
+		} else if (hitRight) {
+			stack[stackSize++] = right;
+		}
+	}
+	return hit;
+}
+bool TriangleTree::Raycast(const Ray& _ray, const mat4& _worldMatrix, float _maxDistance, TriangleHit& _hit) const {
+	// Note(Manny): The direction is left unnormalized so distances along it match the world ray's
+	mat4 toModel = glm::inverse(_worldMatrix);
+	Ray modelRay(vec3(toModel * vec4(_ray.origin, 1.0f)), vec3(toModel * vec4(_ray.direction, 0.0f)));
+	return Raycast(modelRay, _maxDistance, _hit);
+}
+bool TriangleTree::ClosestPoint(const vec3& _point, float _maxDistance, vec3& _closest) const {
+	if (m_nodes.empty()) {
+		return false;
+	}
+	bool found = false;
+	float closestSquared = _maxDistance * _maxDistance;
+	unsigned int stack[STACK_SIZE];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0) {
+		unsigned int nodeIndex = stack[--stackSize];
+		const Node& node = m_nodes[nodeIndex];
+		if (GetDistanceSquared(node, _point) > closestSquared) {
+			continue;
+		}
+		if (node.count > 0) {
+			const TrianglePacket& packet = m_packets[node.first];
+			for (unsigned int i = 0; i < node.count; ++i) {
+				vec3 a(packet.vertexX[i], packet.vertexY[i], packet.vertexZ[i]);
+				vec3 b = a + vec3(packet.edge1X[i], packet.edge1Y[i], packet.edge1Z[i]);
+				vec3 c = a + vec3(packet.edge2X[i], packet.edge2Y[i], packet.edge2Z[i]);
+				vec3 point = ClosestPointOnTriangle(_point, a, b, c);
+				float distanceSquared = glm::dot(point - _point, point - _point);
+				if (distanceSquared <= closestSquared) {
+					closestSquared = distanceSquared;
+					_closest = point;
+					found = true;
+				}
+			}
+			continue;
+		}
+
+		unsigned int left = nodeIndex + 1;
+		unsigned int right = node.first;
+		if (GetDistanceSquared(m_nodes[left], _point) < GetDistanceSquared(m_nodes[right], _point)) {
+			std::swap(left, right);
+		}
+		stack[stackSize++] = left;
+		stack[stackSize++] = right;
+	}
+	return found;
+}
+bool TriangleTree::OverlapSphere(const vec3& _center, float _radius) const {
+	vec3 closest;
+	return ClosestPoint(_center, _radius, closest);
+}
+
+// Private
+void TriangleTree::BuildNode(unsigned int _first, unsigned int _count, unsigned int _depth) {
+	unsigned int nodeIndex = m_nodes.size();
+	m_nodes.push_back(Node());
+
+	vec3 min(FLT_MAX), max(-FLT_MAX);
+	vec3 centerMin(FLT_MAX), centerMax(-FLT_MAX);
+	for (unsigned int i = _first; i < _first + _count; ++i) {
+		min = glm::min(min, m_build[i].min);
+		max = glm::max(max, m_build[i].max);
+		centerMin = glm::min(centerMin, m_build[i].center);
+		centerMax = glm::max(centerMax, m_build[i].center);
+	}
+	m_nodes[nodeIndex].min = min;
+	m_nodes[nodeIndex].max = max;
+
+	if (_count <= PACKET_SIZE) {
+		// Unused lanes keep zero edges, which no ray can hit
+		TrianglePacket packet = {};
+		for (unsigned int i = 0; i < _count; ++i) {
+			unsigned int triangle = m_build[_first + i].triangle;
+			const vec3* vertices = &m_vertices[triangle * 3];
+			vec3 edge1 = vertices[1] - vertices[0];
+			vec3 edge2 = vertices[2] - vertices[0];
+			packet.vertexX[i] = vertices[0].x; packet.vertexY[i] = vertices[0].y; packet.vertexZ[i] = vertices[0].z;
+			packet.edge1X[i] = edge1.x; packet.edge1Y[i] = edge1.y; packet.edge1Z[i] = edge1.z;
+			packet.edge2X[i] = edge2.x; packet.edge2Y[i] = edge2.y; packet.edge2Z[i] = edge2.z;
+			packet.triangles[i] = triangle;
+		}
+		m_nodes[nodeIndex].first = m_packets.size();
+		m_nodes[nodeIndex].count = _count;
+		m_packets.push_back(packet);
+		return;
+	}
+
+	// Bin the centers along each axis and take the split with the lowest
+	// surface area cost, count * area summed over both sides
+	int bestAxis = -1;
+	unsigned int bestSplit = 0;
+	float bestCost = FLT_MAX;
+	vec3 extent = centerMax - centerMin;
+	for (int axis = 0; axis < 3 && _depth < MAX_SAH_DEPTH; ++axis) {
+		if (extent[axis] <= 0.0f) {
+			continue;
+		}
+		unsigned int binCounts[BIN_COUNT] = {};
+		vec3 binMin[BIN_COUNT], binMax[BIN_COUNT];
+		for (unsigned int i = 0; i < BIN_COUNT; ++i) {
+			binMin[i] = vec3(FLT_MAX);
+			binMax[i] = vec3(-FLT_MAX);
+		}
+		float scale = BIN_COUNT / extent[axis];
+		for (unsigned int i = _first; i < _first + _count; ++i) {
+			unsigned int bin = std::min((unsigned int)((m_build[i].center[axis] - centerMin[axis]) * scale), BIN_COUNT - 1);
+			binCounts[bin]++;
+			binMin[bin] = glm::min(binMin[bin], m_build[i].min);
+			binMax[bin] = glm::max(binMax[bin], m_build[i].max);
+		}
+
+		// Sweep from the right to get each split's right side, then from the left
+		float rightCost[BIN_COUNT];
+		vec3 sideMin(FLT_MAX), sideMax(-FLT_MAX);
+		unsigned int sideCount = 0;
+		for (unsigned int i = BIN_COUNT - 1; i > 0; --i) {
+			sideMin = glm::min(sideMin, binMin[i]);
+			sideMax = glm::max(sideMax, binMax[i]);
+			sideCount += binCounts[i];
+			vec3 size = sideMax - sideMin;
+			rightCost[i] = sideCount > 0 ? sideCount * (size.x * size.y + size.y * size.z + size.z * size.x) : 0.0f;
+		}
+		sideMin = vec3(FLT_MAX);
+		sideMax = vec3(-FLT_MAX);
+		sideCount = 0;
+		for (unsigned int i = 0; i < BIN_COUNT - 1; ++i) {
+			sideMin = glm::min(sideMin, binMin[i]);
+			sideMax = glm::max(sideMax, binMax[i]);
+			sideCount += binCounts[i];
+			if (sideCount == 0 || sideCount == _count) {
+				continue;
+			}
+			vec3 size = sideMax - sideMin;
+			float cost = sideCount * (size.x * size.y + size.y * size.z + size.z * size.x) + rightCost[i + 1];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = i + 1;
+			}
+		}
+	}
+
+	unsigned int leftCount;
+	if (bestAxis >= 0) {
+		float scale = BIN_COUNT / extent[bestAxis];
+		float axisMin = centerMin[bestAxis];
+		vector<BuildTriangle>::iterator middle = std::partition(m_build.begin() + _first, m_build.begin() + _first + _count,
+			[bestAxis, bestSplit, scale, axisMin](const BuildTriangle& _triangle) {
+			return std::min((unsigned int)((_triangle.center[bestAxis] - axisMin) * scale), BIN_COUNT - 1) < bestSplit;
+		});
+		leftCount = middle - (m_build.begin() + _first);
+	} else {
+		// Note(Manny): Identical centers, or too deep for the stack, so split
+		// at the median of the widest axis to keep the tree balanced
+		int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+		leftCount = _count / 2;
+		std::nth_element(m_build.begin() + _first, m_build.begin() + _first + leftCount, m_build.begin() + _first + _count,
+			[axis](const BuildTriangle& _a, const BuildTriangle& _b) { return _a.center[axis] < _b.center[axis]; });
+	}
+
+	BuildNode(_first, leftCount, _depth + 1);
+	m_nodes[nodeIndex].first = m_nodes.size();
+	m_nodes[nodeIndex].count = 0;
+	BuildNode(_first + leftCount, _count - leftCount, _depth + 1);
+}
+bool TriangleTree::IntersectPacket(const TrianglePacket& _packet, unsigned int _count, const Ray& _ray, float _maxDistance, TriangleHit& _hit) const {
+	// Moller-Trumbore on four triangles at once, both faces count as hits
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128 directionX = _mm_set1_ps(_ray.direction.x);
+	__m128 directionY = _mm_set1_ps(_ray.direction.y);
+	__m128 directionZ = _mm_set1_ps(_ray.direction.z);
+	__m128 edge1X = _mm_loadu_ps(_packet.edge1X), edge1Y = _mm_loadu_ps(_packet.edge1Y), edge1Z = _mm_loadu_ps(_packet.edge1Z);
+	__m128 edge2X = _mm_loadu_ps(_packet.edge2X), edge2Y = _mm_loadu_ps(_packet.edge2Y), edge2Z = _mm_loadu_ps(_packet.edge2Z);
+
+	// p = direction x edge2
+	__m128 pX = _mm_sub_ps(_mm_mul_ps(directionY, edge2Z), _mm_mul_ps(directionZ, edge2Y));
+	__m128 pY = _mm_sub_ps(_mm_mul_ps(directionZ, edge2X), _mm_mul_ps(directionX, edge2Z));
+	__m128 pZ = _mm_sub_ps(_mm_mul_ps(directionX, edge2Y), _mm_mul_ps(directionY, edge2X));
+	__m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edge1X, pX), _mm_mul_ps(edge1Y, pY)), _mm_mul_ps(edge1Z, pZ));
+	__m128 absDeterminant = _mm_max_ps(determinant, _mm_sub_ps(zero, determinant));
+	__m128 valid = _mm_cmpgt_ps(absDeterminant, _mm_set1_ps(1e-12f));
+	__m128 inverseDeterminant = _mm_div_ps(one, _mm_or_ps(_mm_and_ps(valid, determinant), _mm_andnot_ps(valid, one)));
+
+	// t = origin - vertex
+	__m128 tX = _mm_sub_ps(_mm_set1_ps(_ray.origin.x), _mm_loadu_ps(_packet.vertexX));
+	__m128 tY = _mm_sub_ps(_mm_set1_ps(_ray.origin.y), _mm_loadu_ps(_packet.vertexY));
+	__m128 tZ = _mm_sub_ps(_mm_set1_ps(_ray.origin.z), _mm_loadu_ps(_packet.vertexZ));
+	__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tX, pX), _mm_mul_ps(tY, pY)), _mm_mul_ps(tZ, pZ)), inverseDeterminant);
+
+	// q = t x edge1
+	__m128 qX = _mm_sub_ps(_mm_mul_ps(tY, edge1Z), _mm_mul_ps(tZ, edge1Y));
+	__m128 qY = _mm_sub_ps(_mm_mul_ps(tZ, edge1X), _mm_mul_ps(tX, edge1Z));
+	__m128 qZ = _mm_sub_ps(_mm_mul_ps(tX, edge1Y), _mm_mul_ps(tY, edge1X));
+	__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(directionX, qX), _mm_mul_ps(directionY, qY)), _mm_mul_ps(directionZ, qZ)), inverseDeterminant);
+	__m128 distance = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(edge2X, qX), _mm_mul_ps(edge2Y, qY)), _mm_mul_ps(edge2Z, qZ)), inverseDeterminant);
+
+	valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+	valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+	valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), one));
+	valid = _mm_and_ps(valid, _mm_cmpge_ps(distance, zero));
+	valid = _mm_and_ps(valid, _mm_cmplt_ps(distance, _mm_set1_ps(_maxDistance)));
+	int mask = _mm_movemask_ps(valid) & ((1 << _count) - 1);
+	if (mask == 0) {
+		return false;
+	}
+
+	float distances[PACKET_SIZE], us[PACKET_SIZE], vs[PACKET_SIZE];
+	_mm_storeu_ps(distances, distance);
+	_mm_storeu_ps(us, u);
+	_mm_storeu_ps(vs, v);
+	int best = -1;
+	for (unsigned int i = 0; i < _count; ++i) {
+		if ((mask & (1 << i)) && (best < 0 || distances[i] < distances[best])) {
+			best = i;
+		}
+	}
+	_hit.distance = distances[best];
+	_hit.triangle = _packet.triangles[best];
+	_hit.barycentric = vec2(us[best], vs[best]);
+	return true;
+}
+bool TriangleTree::IntersectBox(const Node& _node, const Ray& _ray, float _maxDistance, float& _distance) {
+	vec3 t0 = (_node.min - _ray.origin) * _ray.invDirection;
+	vec3 t1 = (_node.max - _ray.origin) * _ray.invDirection;
+	vec3 tNear = glm::min(t0, t1);
+	vec3 tFar = glm::max(t0, t1);
+	float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+	float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, _maxDistance));
+	_distance = enter;
+	return enter <= exit;
+}
+float TriangleTree::GetDistanceSquared(const Node& _node, const vec3& _point) {
+	vec3 offset = glm::max(glm::max(_node.min - _point, _point - _node.max), vec3(0.0f));
+	return glm::dot(offset, offset);
+}
+vec3 TriangleTree::ClosestPointOnTriangle(const vec3& _point, const vec3& _a, const vec3& _b, const vec3& _c) {
+	// Finds which of the triangle's vertex, edge or face regions the point projects into
+	vec3 ab = _b - _a;
+	vec3 ac = _c - _a;
+	vec3 ap = _point - _a;
+	float d1 = glm::dot(ab, ap);
+	float d2 = glm::dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f) {
+		return _a;
+	}
+	vec3 bp = _point - _b;
+	float d3 = glm::dot(ab, bp);
+	float d4 = glm::dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3) {
+		return _b;
+	}
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+		return _a + ab * (d1 / (d1 - d3));
+	}
+	vec3 cp = _point - _c;
+	float d5 = glm::dot(ab, cp);
+	float d6 = glm::dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6) {
+		return _c;
+	}
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+		return _a + ac * (d2 / (d2 - d6));
+	}
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+		return _b + (_c - _b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	}
+	float denominator = 1.0f / (va + vb + vc);
+	return _a + ab * (vb * denominator) + ac * (vc * denominator);
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: TriangleTree.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: A bounding volume hierarchy over the
+triangles of a model, for exact raycasts and
+closest point queries in model space.
+===============================================*/
+
+#ifndef _TRIANGLE_TREE_H_
+#define _TRIANGLE_TREE_H_
+
+// Structs
+#include "Ray.h"
+
+// Utilities
+#include "GLM_Header.h"
+
+// Other
+#include <vector>
+using std::vector;
+
+struct TriangleHit {
+	float distance; //In units of the ray's direction
+	unsigned int triangle; //Index in the order the meshes were added
+	vec2 barycentric; //Weights of the triangle's second and third vertex
+};
+
+// Built with the surface area heuristic. Every leaf holds one packet of up to
+// four triangles laid out for SSE, so a leaf is tested with a single pass.
+// Nodes are flattened depth first, a branch's left child is the node after it.
+class TriangleTree {
+public:
+	TriangleTree() : m_triangleCount(0) {}
+	void AddMesh(const vector<vec3>& _positions, const vector<unsigned int>& _indices);
+	void Build();
+	bool Raycast(const Ray& _ray, float _maxDistance, TriangleHit& _hit) const;
+	// Raycasts a world space ray against the tree placed by _worldMatrix, distances stay in world units
+	bool Raycast(const Ray& _ray, const mat4& _worldMatrix, float _maxDistance, TriangleHit& _hit) const;
+	// Closest point on any triangle within _maxDistance of _point
+	bool ClosestPoint(const vec3& _point, float _maxDistance, vec3& _closest) const;
+	bool OverlapSphere(const vec3& _center, float _radius) const;
+	inline unsigned int GetTriangleCount() const { return m_triangleCount; }
+	inline unsigned int GetNodeCount() const { return m_nodes.size(); }
+
+	static const unsigned int PACKET_SIZE = 4; //Triangles tested at once
+	static const unsigned int BIN_COUNT = 12; //Split candidates tried per axis
+	static const unsigned int STACK_SIZE = 64;
+	static const unsigned int MAX_SAH_DEPTH = 32; //Deeper nodes split at the median so the tree stays shallower than the stack
+private:
+	struct Node {
+		vec3 min;
+		unsigned int first; //Packet for leaves, right child for branches
+		vec3 max;
+		unsigned int count; //Triangles in a leaf's packet, 0 for branches
+	};
+	// Four triangles as a vertex and two edges, one lane each
+	struct TrianglePacket {
+		float vertexX[PACKET_SIZE], vertexY[PACKET_SIZE], vertexZ[PACKET_SIZE];
+		float edge1X[PACKET_SIZE], edge1Y[PACKET_SIZE], edge1Z[PACKET_SIZE];
+		float edge2X[PACKET_SIZE], edge2Y[PACKET_SIZE], edge2Z[PACKET_SIZE];
+		unsigned int triangles[PACKET_SIZE];
+	};
+	struct BuildTriangle {
+		vec3 min;
+		vec3 max;
+		vec3 center;
+		unsigned int triangle;
+	};
+
+	void BuildNode(unsigned int _first, unsigned int _count, unsigned int _depth);
+	bool IntersectPacket(const TrianglePacket& _packet, unsigned int _count, const Ray& _ray, float _maxDistance, TriangleHit& _hit) const;
+	static bool IntersectBox(const Node& _node, const Ray& _ray, float _maxDistance, float& _distance);
+	static float GetDistanceSquared(const Node& _node, const vec3& _point);
+	static vec3 ClosestPointOnTriangle(const vec3& _point, const vec3& _a, const vec3& _b, const vec3& _c);
+
+	vector<vec3> m_vertices; //Three per triangle, only kept until the tree is built
+	vector<Node> m_nodes;
+	vector<TrianglePacket> m_packets;
+	vector<BuildTriangle> m_build; //Only used while building
+	unsigned int m_triangleCount;
+};
+
+#endif // _TRIANGLE_TREE_H_
@@ -13,6 +13,7 @@ Copyright (c) 2015 Emmanuel Vaccaro
 
 // Utilities
 #include "GLM_Header.h"
+#include "GLFW_Header.h"
 
 struct Vertex {
 	vec4 position;
@@ -35,7 +36,70 @@ struct OpenGLData {
 	unsigned int VAO;
 	unsigned int VBO;
 	unsigned int IBO;
+	unsigned int indexCount; //Every LOD's indices in the IBO
+	unsigned int indexType; //GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	unsigned int vertexSize; //Bytes per vertex in the VBO
+};
+
+// A range of a mesh's index buffer that draws it at one level of detail
+struct MeshLOD {
+	unsigned int indexOffset;
 	unsigned int indexCount;
+	float error; //How far the surface moved, relative to the mesh radius
+};
+
+// Attribute locations shared by every mesh shader
+enum VertexAttribute {
+	VERTEX_POSITION = 0,
+	VERTEX_TEXCOORD = 1,
+	VERTEX_BONE_INDICES = 2,
+	VERTEX_BONE_WEIGHTS = 3,
+	VERTEX_NORMAL = 4,
+	VERTEX_TANGENT = 5,
+	VERTEX_ATTRIBUTE_COUNT = 6,
+	VERTEX_INSTANCE_MODEL = 6 //Instanced shaders only, one location per matrix column
+};
+
+struct VertexElement {
+	bool enabled;
+	GLint size;
+	GLenum type;
+	GLboolean normalized;
+	unsigned int offset; //Bytes from the start of the vertex
+};
+
+// Describes an interleaved vertex. Attributes that are never added stay
+// disabled, so they take no space in the vertex buffer.
+struct VertexLayout {
+	VertexLayout() : stride(0) {
+		for (unsigned int i = 0; i < VERTEX_ATTRIBUTE_COUNT; ++i) {
+			elements[i].enabled = false;
+		}
+	}
+	void Add(VertexAttribute _attribute, GLint _size, GLenum _type, GLboolean _normalized, unsigned int _bytes) {
+		VertexElement& element = elements[_attribute];
+		element.enabled = true;
+		element.size = _size;
+		element.type = _type;
+		element.normalized = _normalized;
+		element.offset = stride;
+		stride += _bytes;
+	}
+	// Points the bound vertex array at the bound vertex buffer
+	void Apply() const {
+		for (unsigned int i = 0; i < VERTEX_ATTRIBUTE_COUNT; ++i) {
+			const VertexElement& element = elements[i];
+			if (element.enabled) {
+				glEnableVertexAttribArray(i);
+				glVertexAttribPointer(i, element.size, element.type, element.normalized, stride, (void*)element.offset);
+			} else {
+				glDisableVertexAttribArray(i);
+			}
+		}
+	}
+
+	VertexElement elements[VERTEX_ATTRIBUTE_COUNT];
+	unsigned int stride;
 };
 
 #endif // _VERTEX_H_
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "Test.h"
+
+// Structs
+#include "Mesh.h"
+
+// Utilities
+#include "AssetLoader.h"
+#include "CookedMesh.h"
+#include "MappedFile.h"
+#include "JobSystem.h"
+#include "stb_image.h"
+
+// Other
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <functional>
+#include <algorithm>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// Note(Manny): The loads below are the worker halves of Mesh::LoadAsync and
+// Texture::LoadAsync, their uploads only count the asset in instead of making
+// GL objects, so the frames here are Update calls without any drawing.
+
+static const unsigned int MODEL_COUNT = 11;
+static const char* MODEL_NAMES[MODEL_COUNT] = {
+	"bucket.obj", "capsule.obj", "cube.obj", "plane.obj", "plane2.obj", "plane3.obj",
+	"plane4.obj", "plane5.obj", "sphere.obj", "terrain02.obj", "plane.fbx"
+};
+static const unsigned int TEXTURE_COUNT = 4;
+static const char* TEXTURE_NAMES[TEXTURE_COUNT] = {
+	"default_displacement.png", "default_normal.jpg", "default_specular.png", "default_texture.png"
+};
+
+struct AssetLoad {
+	std::function<void()> load;
+	std::function<void()> upload;
+};
+
+static bool FindDataDir(string& _dataDir) {
+	const char* dirs[3] = { "data/", "../data/", "./" };
+	for (unsigned int i = 0; i < 3; ++i) {
+		unsigned long long time, size;
+		if (MappedFile::GetFileInfo(string(dirs[i]) + "textures/" + TEXTURE_NAMES[0], time, size)) {
+			_dataDir = dirs[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+// Every model and texture in data, cooked meshes removed first so the models import like on a first launch
+static void CreateAssetLoads(const string& _dataDir, std::atomic<unsigned int>& _loadedCount, vector<AssetLoad>& _loads) {
+	_loads.clear();
+	for (unsigned int i = 0; i < MODEL_COUNT; ++i) {
+		string fileName = _dataDir + "models/" + MODEL_NAMES[i];
+		std::shared_ptr<IndexedModel> imported = std::make_shared<IndexedModel>();
+		AssetLoad asset;
+		if (fileName.substr(fileName.find_last_of(".")) == ".obj") {
+			std::remove(CookedMesh::GetCookedFileName(fileName).c_str());
+			std::shared_ptr<CookedMesh> cookedMesh = std::make_shared<CookedMesh>();
+			asset.load = [fileName, imported, cookedMesh]() {
+				Mesh::LoadOBJFile(fileName, *imported);
+				imported->CalculateBounds();
+				imported->Finalize();
+				imported->Optimize();
+				if (!CookedMesh::Save(fileName, Mesh::OBJ_IMPORT_FLAGS, *imported, imported->bounds) ||
+					!cookedMesh->Open(fileName, Mesh::OBJ_IMPORT_FLAGS)) {
+					return;
+				}
+				imported->meshes.clear();
+				cookedMesh->Read(*imported, imported->bounds);
+			};
+			asset.upload = [imported, cookedMesh, &_loadedCount]() {
+				_loadedCount += cookedMesh->IsOpen() && !imported->meshes.empty() ? 1 : 0;
+			};
+		} else {
+			std::shared_ptr<FBXFile> file = std::make_shared<FBXFile>();
+			asset.load = [fileName, imported, file]() {
+				file->load(fileName.c_str());
+				Mesh::ReadFBXFile(file.get(), *imported);
+				imported->CalculateBounds();
+				imported->Finalize();
+				imported->Optimize();
+			};
+			asset.upload = [imported, &_loadedCount]() {
+				_loadedCount += !imported->meshes.empty() ? 1 : 0;
+			};
+		}
+		_loads.push_back(asset);
+	}
+
+	struct DecodedImage {
+		unsigned char* pixels;
+		int width;
+		int height;
+	};
+	for (unsigned int i = 0; i < TEXTURE_COUNT; ++i) {
+		string fileName = _dataDir + "textures/" + TEXTURE_NAMES[i];
+		std::shared_ptr<DecodedImage> image = std::make_shared<DecodedImage>();
+		AssetLoad asset;
+		asset.load = [fileName, image]() {
+			int bytesPerPixel;
+			image->pixels = stbi_load(fileName.c_str(), &image->width, &image->height, &bytesPerPixel, 4);
+		};
+		asset.upload = [image, &_loadedCount]() {
+			if (image->pixels != NULL) {
+				_loadedCount++;
+				stbi_image_free(image->pixels);
+			}
+		};
+		_loads.push_back(asset);
+	}
+}
+
+// Every asset loaded on the main thread before the first frame, against requested
+// through the AssetLoader with placeholders drawn until the uploads are done
+TEST(AssetLoaderLoadToFirstFrame) {
+	string dataDir;
+	CHECK(FindDataDir(dataDir));
+	if (TestRegistry::failureCount > 0) {
+		return;
+	}
+
+	JobSystem::Create();
+	const unsigned int assetCount = MODEL_COUNT + TEXTURE_COUNT;
+	std::atomic<unsigned int> loadedCounts[2];
+	vector<AssetLoad> loads;
+
+	loadedCounts[0] = 0;
+	CreateAssetLoads(dataDir, loadedCounts[0], loads);
+	Clock::time_point start = Clock::now();
+	for (unsigned int i = 0; i < loads.size(); ++i) {
+		loads[i].load();
+		loads[i].upload();
+	}
+	double blockingTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	// Frames are paced at 60Hz, the first one only waits for the requests to be made
+	const std::chrono::microseconds frameTime(16667);
+	loadedCounts[1] = 0;
+	CreateAssetLoads(dataDir, loadedCounts[1], loads);
+	start = Clock::now();
+	for (unsigned int i = 0; i < loads.size(); ++i) {
+		AssetLoader::Load(loads[i].load, loads[i].upload);
+	}
+	double firstFrameTime = -1.0;
+	double longestUpdate = 0.0;
+	unsigned int frameCount = 0;
+	while (AssetLoader::GetPendingCount() > 0) {
+		Clock::time_point frameStart = Clock::now();
+		AssetLoader::Update();
+		longestUpdate = std::max(longestUpdate, AssetLoader::lastUploadTime * 1000.0);
+		if (firstFrameTime < 0.0) {
+			firstFrameTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+		frameCount++;
+		std::this_thread::sleep_until(frameStart + frameTime);
+	}
+	double asyncTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	unsigned int workerCount = JobSystem::GetWorkerCount();
+	JobSystem::Shutdown();
+
+	printf("    %u assets loaded on the main thread: first frame after %.2fms\n", assetCount, blockingTime);
+	printf("    %u assets through the loader on %u workers: first frame after %.2fms, all loaded after %.2fms (%u frames, longest upload step %.2fms)\n",
+		assetCount, workerCount, firstFrameTime, asyncTime, frameCount, longestUpdate);
+	CHECK(loadedCounts[0] == assetCount);
+	CHECK(loadedCounts[1] == assetCount);
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "Test.h"
+
+// Objects
+#include "GameObject.h"
+
+// Physics
+#include "Broadphase.h"
+#include "PhysicsObject.h"
+
+// Components
+#include "SphereCollider.h"
+#include "BoxCollider.h"
+#include "PlaneCollider.h"
+
+// Other
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// Tests every pair of bounded proxies, the answer the other broadphases have to give
+class BruteForceBroadphase : public Broadphase {
+protected:
+	virtual void FindPairs(vector<BroadphasePair>& _pairs) {
+		for (unsigned int a = 0; a < m_bounded.size(); ++a) {
+			for (unsigned int b = a + 1; b < m_bounded.size(); ++b) {
+				pairsTested++;
+				if (Overlaps(m_proxies[m_bounded[a]], m_proxies[m_bounded[b]])) {
+					AddPair(m_bounded[a], m_bounded[b], _pairs);
+				}
+			}
+		}
+	}
+};
+
+// Spheres and rotated boxes scattered through a cube, plus one plane
+struct BroadphaseScene {
+	BroadphaseScene(unsigned int _objectCount) {
+		float extent = powf((float)_objectCount, 1.0f / 3.0f) * 2.0f;
+		for (unsigned int i = 0; i <= _objectCount; ++i) {
+			GameObject* gameObject = new GameObject();
+			Collider* collider = nullptr;
+			if (i == _objectCount) {
+				collider = new PlaneCollider();
+			} else if (i % 2 == 0) {
+				SphereCollider* sphere = new SphereCollider();
+				sphere->radius = RandomRange(0.25f, 1.0f);
+				collider = sphere;
+			} else {
+				BoxCollider* box = new BoxCollider();
+				box->bounds.size = vec3(RandomRange(0.25f, 1.0f), RandomRange(0.25f, 1.0f), RandomRange(0.25f, 1.0f));
+				collider = box;
+			}
+			gameObject->transform.position = vec3(RandomRange(-extent, extent),
+				RandomRange(-extent, extent), RandomRange(-extent, extent));
+			gameObject->transform.rotation = glm::angleAxis(RandomRange(0.0f, 360.0f),
+				glm::normalize(vec3(RandomRange(-1, 1), RandomRange(-1, 1), 1.0f)));
+			collider->gameObject = gameObject;
+			collider->transform = &gameObject->transform;
+			gameObject->AddCollider(collider);
+
+			PhysicsObject* actor = new PhysicsObject();
+			actor->gameObject = gameObject;
+			actor->transform = &gameObject->transform;
+			actors.push_back(actor);
+		}
+	}
+	~BroadphaseScene() {
+		for (unsigned int i = 0; i < actors.size(); ++i) {
+			GameObject* gameObject = actors[i]->gameObject;
+			delete gameObject->colliders.front();
+			delete gameObject;
+			delete actors[i];
+		}
+	}
+	// Small moves keep most of the old order and tree, a few objects jump across the scene
+	void Move() {
+		for (unsigned int i = 0; i < actors.size(); ++i) {
+			Transform& transform = actors[i]->gameObject->transform;
+			if (rand() % 50 == 0) {
+				transform.position = -transform.position;
+			} else {
+				transform.position += vec3(RandomRange(-0.2f, 0.2f), RandomRange(-0.2f, 0.2f), RandomRange(-0.2f, 0.2f));
+			}
+		}
+	}
+	static float RandomRange(float _min, float _max) {
+		return _min + (_max - _min) * (rand() / (float)RAND_MAX);
+	}
+
+	vector<PhysicsObject*> actors;
+};
+
+static bool SamePairs(const vector<BroadphasePair>& _pairs, const vector<BroadphasePair>& _expected) {
+	if (_pairs.size() != _expected.size()) {
+		return false;
+	}
+	for (unsigned int i = 0; i < _pairs.size(); ++i) {
+		if (_pairs[i].colliderA != _expected[i].colliderA || _pairs[i].colliderB != _expected[i].colliderB) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Both broadphases have to report exactly the brute force pairs, in the same
+// order, over several frames of motion at 100, 1k and 10k colliders
+TEST(BroadphaseMatchesBruteForce) {
+	srand(3);
+	const unsigned int objectCounts[3] = { 100, 1000, 10000 };
+	const unsigned int frameCount = 5;
+	for (unsigned int i = 0; i < 3; ++i) {
+		BroadphaseScene scene(objectCounts[i]);
+		BruteForceBroadphase bruteForce;
+		std::unique_ptr<Broadphase> sweepAndPrune(Broadphase::Create(BROADPHASE_SWEEP_AND_PRUNE));
+		std::unique_ptr<Broadphase> tree(Broadphase::Create(BROADPHASE_AABB_TREE));
+
+		vector<BroadphasePair> expected, pairs;
+		unsigned int mismatchCount = 0;
+		double times[3] = { 0, 0, 0 };
+		for (unsigned int frame = 0; frame < frameCount; ++frame) {
+			scene.Move();
+			Clock::time_point start = Clock::now();
+			bruteForce.Update(scene.actors, expected);
+			times[0] += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+			Broadphase* broadphases[2] = { sweepAndPrune.get(), tree.get() };
+			for (unsigned int j = 0; j < 2; ++j) {
+				start = Clock::now();
+				broadphases[j]->Update(scene.actors, pairs);
+				times[j + 1] += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+				mismatchCount += SamePairs(pairs, expected) ? 0 : 1;
+			}
+		}
+		printf("    %u colliders, %u pairs: brute force %u tests %.2fms, sweep and prune %u tests %.2fms, tree %u tests %.2fms\n",
+			objectCounts[i], (unsigned int)expected.size(),
+			bruteForce.pairsTested, times[0] / frameCount,
+			sweepAndPrune->pairsTested, times[1] / frameCount,
+			tree->pairsTested, times[2] / frameCount);
+		CHECK(mismatchCount == 0);
+		// The plane alone pairs with every collider, anything more are real overlaps
+		CHECK(expected.size() > objectCounts[i]);
+	}
+}
\ No newline at end of file
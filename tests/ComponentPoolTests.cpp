@@ -0,0 +1,146 @@
+#include "Test.h"
+
+// Objects
+#include "GameObject.h"
+
+// Components
+#include "ComponentPool.h"
+
+// Other
+#include <chrono>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static unsigned int g_shutdownCount = 0;
+static unsigned int g_destroyCount = 0;
+
+// Counts the pooled copies only, not the temporaries handed to AddComponent
+template<int N>
+class CountedComponent : public Component {
+public:
+	~CountedComponent() {
+		if (pool != nullptr) { g_destroyCount++; }
+	}
+	void Shutdown() { g_shutdownCount++; }
+	bool Update() { return true; }
+};
+
+// Objects shut down the way Game::Shutdown does it, the pools then destroy
+// whatever is left. Every component goes exactly once
+TEST(ComponentPoolShutdownDestroysOnce) {
+	g_shutdownCount = 0;
+	g_destroyCount = 0;
+	const unsigned int objectCount = 300;
+	vector<GameObject*> objects;
+	unsigned int componentCount = 0;
+	for (unsigned int i = 0; i < objectCount; ++i) {
+		GameObject* object = new GameObject("Counted");
+		object->AddComponent<CountedComponent<0> >(CountedComponent<0>());
+		componentCount++;
+		if (i % 3 == 0) {
+			object->AddComponent<CountedComponent<1> >(CountedComponent<1>());
+			componentCount++;
+		}
+		objects.push_back(object);
+	}
+	CHECK(g_destroyCount == 0);
+
+	// The first two thirds were added to the scene, the rest never started
+	unsigned int shutdownCount = 0;
+	for (unsigned int i = 0; i < objectCount * 2 / 3; ++i) {
+		shutdownCount += objects[i]->components.size();
+		objects[i]->Shutdown();
+		delete objects[i];
+	}
+	CHECK(g_shutdownCount == shutdownCount);
+	CHECK(g_destroyCount == shutdownCount);
+
+	ComponentPoolBase::DestroyPools();
+	CHECK(g_destroyCount == componentCount);
+	CHECK(ComponentPool<CountedComponent<0> >::Get().components.empty());
+	CHECK(ComponentPool<CountedComponent<1> >::Get().components.empty());
+
+	// Nothing is left to destroy a second time
+	ComponentPoolBase::DestroyPools();
+	CHECK(g_shutdownCount == shutdownCount);
+	CHECK(g_destroyCount == componentCount);
+	for (unsigned int i = objectCount * 2 / 3; i < objectCount; ++i) {
+		delete objects[i];
+	}
+}
+
+template<int N>
+class ValueComponent : public Component {
+public:
+	ValueComponent(float _value = 0.0f) : value(_value) {}
+	bool Update() { return true; }
+
+	float value;
+};
+
+// The old lookup, a dynamic_cast over every component of the object
+template<typename T>
+static T* FindComponent(GameObject* _object) {
+	for (unsigned int i = 0; i < _object->components.size(); ++i) {
+		T* component = dynamic_cast<T*>(_object->components[i]);
+		if (component != nullptr) { return component; }
+	}
+	return nullptr;
+}
+
+// GetComponent is one indexed read however many components an object has, and a
+// per-type loop over the pool touches only that type's packed components
+TEST(ComponentPoolLookupAndIteration) {
+	const unsigned int objectCount = 50000;
+	const int repeats = 10;
+	vector<GameObject*> objects;
+	for (unsigned int i = 0; i < objectCount; ++i) {
+		GameObject* object = new GameObject("Value");
+		object->AddComponent<ValueComponent<0> >(ValueComponent<0>(1.0f));
+		object->AddComponent<ValueComponent<1> >(ValueComponent<1>(2.0f));
+		object->AddComponent<ValueComponent<2> >(ValueComponent<2>((float)(i % 7)));
+		objects.push_back(object);
+	}
+
+	double times[4] = { 0.0, 0.0, 0.0, 0.0 };
+	float sums[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int repeat = 0; repeat < repeats; ++repeat) {
+		Clock::time_point start = Clock::now();
+		for (unsigned int i = 0; i < objectCount; ++i) {
+			sums[0] += objects[i]->GetComponent<ValueComponent<2> >()->value;
+		}
+		times[0] += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		start = Clock::now();
+		for (unsigned int i = 0; i < objectCount; ++i) {
+			sums[1] += FindComponent<ValueComponent<2> >(objects[i])->value;
+		}
+		times[1] += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		start = Clock::now();
+		vector<ValueComponent<2>*>& components = ComponentPool<ValueComponent<2> >::Get().components;
+		for (unsigned int i = 0; i < components.size(); ++i) {
+			sums[2] += components[i]->value;
+		}
+		times[2] += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		start = Clock::now();
+		for (unsigned int i = 0; i < objectCount; ++i) {
+			for (unsigned int j = 0; j < objects[i]->components.size(); ++j) {
+				ValueComponent<2>* component = dynamic_cast<ValueComponent<2>*>(objects[i]->components[j]);
+				if (component != nullptr) { sums[3] += component->value; }
+			}
+		}
+		times[3] += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+	printf("    %u objects: GetComponent %.2fms, dynamic_cast search %.2fms, pool loop %.2fms, object loop %.2fms\n",
+		objectCount, times[0] / repeats, times[1] / repeats, times[2] / repeats, times[3] / repeats);
+	CHECK(ComponentPool<ValueComponent<2> >::Get().components.size() == objectCount);
+	CHECK(sums[0] == sums[1] && sums[0] == sums[2] && sums[0] == sums[3]);
+
+	for (unsigned int i = 0; i < objectCount; ++i) {
+		objects[i]->Shutdown();
+		delete objects[i];
+	}
+	CHECK(ComponentPool<ValueComponent<2> >::Get().components.empty());
+}
\ No newline at end of file
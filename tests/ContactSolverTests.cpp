@@ -0,0 +1,242 @@
+#include "Test.h"
+
+// Physics
+#include "ContactSolver.h"
+#include "IslandBuilder.h"
+
+// Utilities
+#include "JobSystem.h"
+
+// Other
+#include <utility>
+#include <chrono>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// Pyramids of unit boxes on the ground plane, one behind the other. Body 0 is the ground,
+// which nothing moves. Every box is paired with the ground and with the others of its
+// pyramid, standing in for the broadphase.
+struct Pyramid {
+	Pyramid(int _base, int _count = 1) {
+		SolverBody ground = {};
+		ground.rotation = quat();
+		bodies.push_back(ground);
+		for (int pyramid = 0; pyramid < _count; ++pyramid) {
+			unsigned int first = bodies.size();
+			for (int row = 0; row < _base; ++row) {
+				for (int i = 0; i < _base - row; ++i) {
+					SolverBody box = {};
+					box.position = vec3(i - (_base - row - 1) * 0.5f, row + 0.5f, pyramid * 3.0f);
+					box.rotation = quat();
+					box.inverseMass = 1.0f;
+					box.localInverseInertia = vec3(6.0f);
+					box.useGravity = true;
+					bodies.push_back(box);
+				}
+			}
+			for (unsigned int i = first; i < bodies.size(); ++i) {
+				pairs.push_back(std::make_pair(i, 0u));
+				for (unsigned int j = first; j < i; ++j) {
+					pairs.push_back(std::make_pair(i, j));
+				}
+			}
+		}
+		initial = bodies;
+		colliderIds.resize(bodies.size());
+	}
+	// Boxes against the ground plane and against each other, like CheckForCollisions
+	void FindContacts() {
+		constraints.clear();
+		for (unsigned int k = 0; k < pairs.size(); ++k) {
+			unsigned int a = pairs[k].first;
+			unsigned int b = pairs[k].second;
+			// Bodies that nothing moves are never pushed apart, sleeping ones included
+			if (bodies[a].inverseMass == 0.0f && bodies[b].inverseMass == 0.0f) {
+				continue;
+			}
+			if (b != 0 && glm::length(bodies[a].position - bodies[b].position) > 1.8f) {
+				continue;
+			}
+			ContactConstraint constraint;
+			constraint.colliderA = reinterpret_cast<const Collider*>(&colliderIds[a]);
+			constraint.colliderB = reinterpret_cast<const Collider*>(&colliderIds[b]);
+			constraint.bodyA = a;
+			constraint.bodyB = b;
+			constraint.friction = 0.5f;
+			constraint.restitution = 0.0f;
+			OBB box;
+			box.Set(bodies[a].position, bodies[a].rotation, vec3(0.5f));
+			bool touching;
+			if (b == 0) {
+				touching = box.Intersects(vec3(0, 1, 0), 0.0f, &constraint.manifold, 0.02f);
+			} else {
+				OBB other;
+				other.Set(bodies[b].position, bodies[b].rotation, vec3(0.5f));
+				touching = box.Intersects(other, &constraint.manifold, 0.02f);
+			}
+			if (touching) {
+				constraints.push_back(constraint);
+			}
+		}
+	}
+	// Returns the milliseconds spent in the solver
+	double Simulate(ContactSolver& _solver, int _steps) {
+		double solverTime = 0.0;
+		for (int step = 0; step < _steps; ++step) {
+			FindContacts();
+			islands.Build(bodies, constraints);
+			Clock::time_point start = Clock::now();
+			_solver.Step(bodies, constraints, islands, vec3(0, -9.807f, 0), 1.0f / 60.0f);
+			solverTime += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+		return solverTime;
+	}
+	// Puts islands that rested long enough to sleep, by making their bodies static
+	// to the solver the way CustomPhysicsEngine::FillBody does
+	void SleepIslands() {
+		islands.UpdateSleep(bodies, 1.0f / 60.0f);
+		for (unsigned int i = 0; i < islands.islands.size(); ++i) {
+			const Island& island = islands.islands[i];
+			if (!islands.CanSleep(island)) {
+				continue;
+			}
+			for (unsigned int j = 0; j < island.bodyCount; ++j) {
+				SolverBody& body = bodies[islands.bodies[island.firstBody + j]];
+				body.velocity = vec3(0);
+				body.angularVelocity = vec3(0);
+				body.inverseMass = 0.0f;
+				body.localInverseInertia = vec3(0);
+			}
+		}
+	}
+	unsigned int GetSleepingCount() const {
+		unsigned int count = 0;
+		for (unsigned int i = 1; i < bodies.size(); ++i) {
+			count += bodies[i].inverseMass == 0.0f ? 1 : 0;
+		}
+		return count;
+	}
+	// How far the boxes moved from where they were stacked, on average and at most
+	void GetDrift(float& _average, float& _largest) const {
+		_average = _largest = 0.0f;
+		for (unsigned int i = 1; i < bodies.size(); ++i) {
+			float drift = glm::length(bodies[i].position - initial[i].position);
+			_average += drift;
+			_largest = glm::max(_largest, drift);
+		}
+		_average /= bodies.size() - 1;
+	}
+
+	vector<SolverBody> bodies;
+	vector<SolverBody> initial;
+	vector<ContactConstraint> constraints;
+	vector<std::pair<unsigned int, unsigned int> > pairs;
+	vector<char> colliderIds; //Only their addresses are used, to tell the colliders apart
+	IslandBuilder islands;
+};
+
+// Pyramids have to stand still for five seconds at the default iterations,
+// with warm starting carrying most contacts over from one step to the next
+TEST(ContactSolverStacksStayStill) {
+	const int bases[3] = { 5, 10, 20 };
+	for (unsigned int i = 0; i < 3; ++i) {
+		Pyramid pyramid(bases[i]);
+		ContactSolver solver;
+		pyramid.Simulate(solver, 300);
+
+		float average, largest;
+		pyramid.GetDrift(average, largest);
+		unsigned int contactCount = 0;
+		for (unsigned int j = 0; j < pyramid.constraints.size(); ++j) {
+			contactCount += pyramid.constraints[j].manifold.contactCount;
+		}
+		printf("    %u boxes, %u contacts, %u warm started: average drift %.4f, largest %.4f\n",
+			(unsigned int)pyramid.bodies.size() - 1, contactCount, solver.warmStartedCount, average, largest);
+		CHECK(average < 0.05f);
+		CHECK(largest < 0.1f);
+		CHECK(solver.warmStartedCount > contactCount * 9 / 10);
+	}
+}
+
+// Warm starting is what lets a stack stand on few iterations, without it the
+// same iterations let the pyramid slide apart
+TEST(ContactSolverWarmStartingReducesDrift) {
+	const int iterations[3] = { 2, 4, 8 };
+	for (unsigned int i = 0; i < 3; ++i) {
+		float drift[2];
+		for (unsigned int warm = 0; warm < 2; ++warm) {
+			Pyramid pyramid(10);
+			ContactSolver solver;
+			solver.velocityIterations = iterations[i];
+			solver.warmStarting = warm == 1;
+			pyramid.Simulate(solver, 300);
+			float largest;
+			pyramid.GetDrift(drift[warm], largest);
+		}
+		printf("    %d iterations: average drift %.4f cold, %.4f warm started\n", iterations[i], drift[0], drift[1]);
+		CHECK(drift[1] < drift[0]);
+	}
+}
+
+// Four pyramids big enough to be coloured, solved with 1 to 16 threads. Constraints
+// of a colour share no body, so every thread count has to end up with the same stack
+TEST(ContactSolverThreadScaling) {
+	const unsigned int threadCounts[5] = { 1, 2, 4, 8, 16 };
+	const int steps = 20;
+	vector<SolverBody> expected;
+	double singleTime = 0.0;
+	for (unsigned int i = 0; i < 5; ++i) {
+		if (threadCounts[i] > 1) {
+			JobSystem::Create(threadCounts[i] - 1);
+		}
+		Pyramid pyramid(32, 4);
+		ContactSolver solver;
+		double time = pyramid.Simulate(solver, steps) / steps;
+		JobSystem::Shutdown();
+
+		if (i == 0) {
+			expected = pyramid.bodies;
+			singleTime = time;
+		}
+		bool matches = true;
+		for (unsigned int j = 0; j < expected.size(); ++j) {
+			matches = matches && pyramid.bodies[j].position == expected[j].position && pyramid.bodies[j].rotation == expected[j].rotation;
+		}
+		printf("    %u threads, %u boxes, %u constraints, %u colours: %.2fms a step, %.2fx one thread\n", threadCounts[i],
+			(unsigned int)pyramid.bodies.size() - 1, (unsigned int)pyramid.constraints.size(), solver.colourCount, time, singleTime / time);
+		CHECK(matches);
+		CHECK(solver.colourCount > 0);
+	}
+}
+
+// 5000 boxes in small pyramids settle within two seconds. With sleeping every
+// island goes to sleep, and a step then skips the narrowphase and the solver
+TEST(ContactSolverIslandsSleep) {
+	const int steps = 120;
+	const int timedSteps = 30;
+	double stepTimes[2];
+	for (unsigned int sleeping = 0; sleeping < 2; ++sleeping) {
+		Pyramid pyramid(3, 834);
+		ContactSolver solver;
+		stepTimes[sleeping] = 0.0;
+		for (int step = 0; step < steps; ++step) {
+			Clock::time_point start = Clock::now();
+			pyramid.Simulate(solver, 1);
+			if (sleeping == 1) {
+				pyramid.SleepIslands();
+			}
+			if (step >= steps - timedSteps) {
+				stepTimes[sleeping] += std::chrono::duration<double, std::milli>(Clock::now() - start).count() / timedSteps;
+			}
+		}
+		float average, largest;
+		pyramid.GetDrift(average, largest);
+		unsigned int sleepingCount = pyramid.GetSleepingCount();
+		printf("    sleeping %s: %u of %u boxes asleep, %u islands, largest drift %.4f, %.2fms a step after settling\n",
+			sleeping == 1 ? "on" : "off", sleepingCount, (unsigned int)pyramid.bodies.size() - 1,
+			(unsigned int)pyramid.islands.islands.size(), largest, stepTimes[sleeping]);
+		CHECK(sleepingCount == (sleeping == 1 ? pyramid.bodies.size() - 1 : 0));
+		CHECK(largest < 0.1f);
+	}
+	CHECK(stepTimes[1] * 10.0 < stepTimes[0]);
+}
\ No newline at end of file
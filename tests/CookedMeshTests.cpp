@@ -0,0 +1,95 @@
+#include "Test.h"
+
+// Structs
+#include "Mesh.h"
+
+// Utilities
+#include "CookedMesh.h"
+#include "MappedFile.h"
+#include "JobSystem.h"
+
+// Other
+#include <chrono>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// Note(Manny): Both paths below are the worker half of Mesh::LoadAsync, the
+// GL upload that follows them is left out. The Tests project may be started
+// from the solution, the tests folder or data, so the models are looked for in each.
+
+static const unsigned int MODEL_COUNT = 10;
+static const char* MODEL_NAMES[MODEL_COUNT] = {
+	"bucket.obj", "capsule.obj", "cube.obj", "plane.obj", "plane2.obj",
+	"plane3.obj", "plane4.obj", "plane5.obj", "sphere.obj", "terrain02.obj"
+};
+
+static bool FindModelDir(string& _modelDir) {
+	const char* dirs[3] = { "data/models/", "../data/models/", "models/" };
+	for (unsigned int i = 0; i < 3; ++i) {
+		unsigned long long time, size;
+		if (MappedFile::GetFileInfo(string(dirs[i]) + MODEL_NAMES[0], time, size)) {
+			_modelDir = dirs[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+// Every model imported and cooked from its .obj, then read back from the .cmesh it left
+TEST(CookedMeshColdAndWarmLoad) {
+	string modelDir;
+	CHECK(FindModelDir(modelDir));
+	if (TestRegistry::failureCount > 0) {
+		return;
+	}
+
+	JobSystem::Create();
+	double coldTotal = 0.0;
+	double warmTotal = 0.0;
+	unsigned int mismatches = 0;
+	for (unsigned int i = 0; i < MODEL_COUNT; ++i) {
+		string fileName = modelDir + MODEL_NAMES[i];
+		std::remove(CookedMesh::GetCookedFileName(fileName).c_str());
+
+		Clock::time_point start = Clock::now();
+		IndexedModel imported;
+		Mesh::LoadOBJFile(fileName, imported);
+		imported.CalculateBounds();
+		imported.Finalize();
+		imported.Optimize();
+		bool saved = CookedMesh::Save(fileName, Mesh::OBJ_IMPORT_FLAGS, imported, imported.bounds);
+		double coldTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		start = Clock::now();
+		CookedMesh cookedMesh;
+		IndexedModel cooked;
+		Bounds bounds;
+		bool opened = cookedMesh.Open(fileName, Mesh::OBJ_IMPORT_FLAGS);
+		if (opened) {
+			cookedMesh.Read(cooked, bounds);
+		}
+		double warmTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		cookedMesh.Close();
+
+		// The cooked copy has to hand back what importing gave
+		bool matches = saved && opened && cooked.meshes.size() == imported.meshes.size() &&
+			bounds.min == imported.bounds.min && bounds.max == imported.bounds.max;
+		unsigned int vertexCount = 0;
+		for (unsigned int j = 0; matches && j < imported.meshes.size(); ++j) {
+			matches = cooked.meshes[j].positions == imported.meshes[j].positions &&
+				cooked.meshes[j].indices == imported.meshes[j].indices;
+			vertexCount += imported.meshes[j].positions.size();
+		}
+		mismatches += matches ? 0 : 1;
+
+		printf("    %-14s %7u vertices: imported and cooked %8.2fms, cooked %6.2fms (%.0fx)\n",
+			MODEL_NAMES[i], vertexCount, coldTime, warmTime, coldTime / warmTime);
+		coldTotal += coldTime;
+		warmTotal += warmTime;
+	}
+	JobSystem::Shutdown();
+
+	printf("    %u models: imported and cooked %.2fms, cooked %.2fms (%.0fx)\n",
+		MODEL_COUNT, coldTotal, warmTotal, coldTotal / warmTotal);
+	CHECK(mismatches == 0);
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "Test.h"
+
+// Sub-engines
+#include "PhysicsEngine.h"
+
+// Components
+#include "Transform.h"
+
+// Other
+#include <cstdlib>
+
+// Moves one body at a constant velocity through the same pose calls
+// CustomPhysicsEngine::Update makes around its steps
+class FixedStepEngine : public PhysicsEngine {
+public:
+	FixedStepEngine(Transform* _body, vec3 _velocity) :
+		stepCount(0), m_body(_body), m_velocity(_velocity) {
+		AddPose(_body);
+	}
+	bool Update() { return true; }
+	int Step(float _deltaTime) {
+		RestorePoses();
+		int steps = BeginFixedUpdate(_deltaTime);
+		for (int step = 0; step < steps; ++step) {
+			StorePreviousPoses();
+			m_body->position += m_velocity * timeStep;
+		}
+		if (steps > 0) {
+			StoreCurrentPoses();
+		}
+		InterpolatePoses();
+		stepCount += steps;
+		return steps;
+	}
+	void AddActor(PhysicsObject* _actor) {}
+	bool RemoveActor(PhysicsObject* _actor) { return false; }
+	void AddArticulation(PhysicsObject* _articulation) {}
+	bool RemoveArticulation(PhysicsObject* _articulation) { return false; }
+
+	int stepCount;
+private:
+	Transform* m_body;
+	vec3 m_velocity;
+};
+
+// Uneven frame times add up to the same number of steps as the elapsed time,
+// and the body is always drawn exactly one step behind where it really is
+TEST(FixedStepKeepsUpWithFrameTime) {
+	Transform body;
+	FixedStepEngine engine(&body, vec3(3, 0, 0));
+	const float frameTimes[4] = { 1.0f / 144.0f, 1.0f / 30.0f, 0.013f, 1.0f / 60.0f };
+	double elapsed = 0.0;
+	float largestError = 0.0f;
+	for (int frame = 0; frame < 1000; ++frame) {
+		float deltaTime = frameTimes[frame % 4];
+		engine.Step(deltaTime);
+		elapsed += deltaTime;
+
+		CHECK(engine.alpha >= 0.0f && engine.alpha < 1.0f);
+		if (elapsed > engine.timeStep) {
+			float expected = 3.0f * ((float)elapsed - engine.timeStep);
+			largestError = glm::max(largestError, fabsf(body.position.x - expected));
+		}
+	}
+	int expectedSteps = (int)(elapsed / engine.timeStep);
+	printf("    %d steps for %.3fs, largest drawn position error %g\n", engine.stepCount, elapsed, largestError);
+	CHECK(abs(engine.stepCount - expectedSteps) <= 1);
+	CHECK(largestError < 1e-3f);
+}
+
+// A long stall only simulates maxSubSteps and drops the rest of the time
+TEST(FixedStepClampsLongFrames) {
+	Transform body;
+	FixedStepEngine engine(&body, vec3(0, 1, 0));
+	CHECK(engine.Step(1.0f) == engine.maxSubSteps);
+	CHECK(engine.alpha == 0.0f);
+	CHECK(engine.Step(0.0f) == 0);
+	CHECK(engine.Step(engine.timeStep * 0.5f) == 0);
+	CHECK(fabsf(engine.alpha - 0.5f) < 1e-4f);
+	CHECK(engine.Step(engine.timeStep * 0.5f) == 1);
+}
+
+// Without interpolation the body is drawn where it was last simulated, and a
+// transform moved by the game is teleported rather than blended
+TEST(FixedStepPoses) {
+	Transform body;
+	FixedStepEngine engine(&body, vec3(0, 0, 6));
+	engine.interpolate = false;
+	engine.Step(engine.timeStep * 2.5f);
+	CHECK(fabsf(body.position.z - 6.0f * engine.timeStep * 2.0f) < 1e-5f);
+
+	engine.interpolate = true;
+	body.position = vec3(100, 0, 0);
+	engine.Step(engine.timeStep);
+	CHECK(fabsf(body.position.x - 100.0f) < 1e-5f);
+	CHECK(body.position.z > 0.0f && body.position.z < 6.0f * engine.timeStep);
+}
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include "Test.h"
+
+// Components
+#include "Fluid.h"
+
+// Utilities
+#include "JobSystem.h"
+
+// Other
+#include <chrono>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// The interleaved solver Fluid used before its planes were split, kept
+// here as the reference the SoA, SSE and banded solver has to reproduce
+struct ReferenceFluid {
+	struct Cells {
+		vector<float> pressure;
+		vector<vec2> velocity;
+		vector<vec3> dyeColor;
+	};
+
+	ReferenceFluid(int _width, int _height, float _viscocity, float _cellDist) :
+		width(_width), height(_height), viscocity(_viscocity), cellDist(_cellDist) {
+		int cellCount = _width * _height;
+		Cells* cells[2] = { &front, &back };
+		for (unsigned int i = 0; i < 2; ++i) {
+			cells[i]->pressure.assign(cellCount, 0.0f);
+			cells[i]->velocity.assign(cellCount, vec2(0));
+			cells[i]->dyeColor.assign(cellCount, vec3(0));
+		}
+		divergence.assign(cellCount, 0.0f);
+		for (int i = 0; i < cellCount; ++i) {
+			front.dyeColor[i] = vec3((float)(i % width), (float)(i / width), 0);
+			front.pressure[i] = 1;
+		}
+	}
+	int Index(int _x, int _y) const {
+		return glm::clamp(_x, 0, width - 1) + glm::clamp(_y, 0, height - 1) * width;
+	}
+	void Advect(float _deltaTime) {
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				int cellIndex = x + y * width;
+				vec2 vel = front.velocity[cellIndex] * _deltaTime;
+				vec2 samplePoint = vec2((float)x - vel.x / cellDist, (float)y - vel.y / cellDist);
+				samplePoint.x = glm::clamp(samplePoint.x, 0.0f, (float)width - 1.1f);
+				samplePoint.y = glm::clamp(samplePoint.y, 0.0f, (float)height - 1.1f);
+
+				vec2 bl = glm::floor(samplePoint);
+				int bli = (int)bl.x + width * (int)bl.y;
+				int bri = bli + 1;
+				int tli = bli + width;
+				int tri = tli + 1;
+				vec2 sampleFract = samplePoint - bl;
+
+				vec3 dyeB = glm::mix(front.dyeColor[bli], front.dyeColor[bri], sampleFract.x);
+				vec3 dyeT = glm::mix(front.dyeColor[tli], front.dyeColor[tri], sampleFract.x);
+				back.dyeColor[cellIndex] = glm::mix(dyeB, dyeT, sampleFract.y);
+
+				vec2 velB = glm::mix(front.velocity[bli], front.velocity[bri], sampleFract.x);
+				vec2 velT = glm::mix(front.velocity[tli], front.velocity[tri], sampleFract.x);
+				back.velocity[cellIndex] = glm::mix(velB, velT, sampleFract.y);
+			}
+		}
+	}
+	void Diffuse(float _deltaTime) {
+		float invViscosityDeltaTime = 1.0f / (viscocity * _deltaTime);
+		float denom = 1.0f / (4 + invViscosityDeltaTime);
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				vec2 velCenter = front.velocity[x + y * width];
+				back.velocity[x + y * width] = (front.velocity[Index(x, y + 1)] + front.velocity[Index(x + 1, y)] +
+					front.velocity[Index(x, y - 1)] + front.velocity[Index(x - 1, y)] +
+					velCenter * invViscosityDeltaTime) * denom;
+			}
+		}
+	}
+	void Divergence() {
+		float invCellDist = 1.0f / (2.0f * cellDist);
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				divergence[x + y * width] = ((front.velocity[Index(x + 1, y)].x - front.velocity[Index(x - 1, y)].x) +
+					(front.velocity[Index(x, y + 1)].y - front.velocity[Index(x, y - 1)].y)) * invCellDist;
+			}
+		}
+	}
+	void UpdatePressure() {
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				back.pressure[x + y * width] = (front.pressure[Index(x, y + 1)] + front.pressure[Index(x, y - 1)] +
+					front.pressure[Index(x - 1, y)] + front.pressure[Index(x + 1, y)] -
+					divergence[x + y * width] * cellDist * cellDist) * 0.25f;
+			}
+		}
+	}
+	void ApplyPressure() {
+		float invCellDist = 1.0f / (2.0f * cellDist);
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				vec2 deltaV = -vec2(front.pressure[Index(x + 1, y)] - front.pressure[Index(x - 1, y)],
+					front.pressure[Index(x, y + 1)] - front.pressure[Index(x, y - 1)]) * invCellDist;
+				back.velocity[x + y * width] = front.velocity[x + y * width] + deltaV;
+			}
+		}
+	}
+	void UpdateBoundary() {
+		vector<float>& p = front.pressure;
+		vector<vec2>& v = front.velocity;
+		for (int x = 0; x < width; ++x) {
+			int last = x + (height - 1) * width;
+			int secondLast = x + (height - 2) * width;
+			p[x] = p[x + width];
+			v[x] = vec2(v[x + width].x, -v[x + width].y);
+			p[last] = p[secondLast];
+			v[last] = vec2(v[secondLast].x, -v[secondLast].y);
+		}
+		for (int y = 0; y < height; ++y) {
+			int first = y * width;
+			int last = (width - 1) + y * width;
+			p[first] = p[first + 1];
+			v[first] = vec2(-v[first + 1].x, v[first + 1].y);
+			p[last] = p[last - 1];
+			v[last] = vec2(-v[last - 1].x, v[last - 1].y);
+		}
+	}
+	void Step(float _deltaTime) {
+		Advect(_deltaTime);
+		std::swap(front.velocity, back.velocity);
+		std::swap(front.dyeColor, back.dyeColor);
+		for (int i = 0; i < 50; ++i) {
+			Diffuse(_deltaTime);
+			std::swap(front.velocity, back.velocity);
+		}
+		Divergence();
+		for (int i = 0; i < 60; ++i) {
+			UpdatePressure();
+			std::swap(front.pressure, back.pressure);
+		}
+		ApplyPressure();
+		std::swap(front.velocity, back.velocity);
+		UpdateBoundary();
+		for (int x = width / 2 - 5; x < width / 2 + 5; ++x) {
+			for (int y = 5; y < 15; ++y) {
+				front.velocity[x + y * width].y += 10 * _deltaTime;
+			}
+		}
+	}
+
+	Cells front;
+	Cells back;
+	vector<float> divergence;
+	int width, height;
+	float viscocity;
+	float cellDist;
+};
+
+// Largest difference between the two solvers relative to the size of the value
+static float LargestError(const Fluid& _fluid, const ReferenceFluid& _reference) {
+	float largest = 0.0f;
+	for (int i = 0; i < _fluid.cellCount; ++i) {
+		float values[6] = { _fluid.frontCells.pressure[i], _fluid.frontCells.velocityX[i], _fluid.frontCells.velocityY[i],
+			_fluid.frontCells.dyeR[i], _fluid.frontCells.dyeG[i], _fluid.frontCells.dyeB[i] };
+		float expected[6] = { _reference.front.pressure[i], _reference.front.velocity[i].x, _reference.front.velocity[i].y,
+			_reference.front.dyeColor[i].r, _reference.front.dyeColor[i].g, _reference.front.dyeColor[i].b };
+		for (unsigned int j = 0; j < 6; ++j) {
+			float error = fabsf(values[j] - expected[j]) / glm::max(1.0f, fabsf(expected[j]));
+			largest = glm::max(largest, error);
+		}
+	}
+	return largest;
+}
+
+// 100 frames of the banded solver, with and without SSE, against the old solver.
+// The width leaves a scalar tail after the four wide interior cells
+static void CheckFluidMatchesReference(bool _useSIMD, unsigned int _workerCount) {
+	const int width = 131;
+	const int height = 96;
+	const float deltaTime = 1.0f / 60.0f;
+	JobSystem::Create(_workerCount);
+	Fluid::useSIMD = _useSIMD;
+
+	Fluid fluid(width, height);
+	fluid.Startup();
+	ReferenceFluid reference(width, height, fluid.viscocity, fluid.cellDist);
+	float largestError = 0.0f;
+	for (int frame = 0; frame < 100; ++frame) {
+		fluid.Simulate(deltaTime);
+		reference.Step(deltaTime);
+		largestError = glm::max(largestError, LargestError(fluid, reference));
+	}
+	printf("    SIMD %s, %u workers, largest relative error %g\n", _useSIMD ? "on" : "off", JobSystem::GetWorkerCount(), largestError);
+	CHECK(largestError < 1e-4f);
+
+	fluid.Shutdown();
+	Fluid::useSIMD = true;
+	JobSystem::Shutdown();
+}
+
+TEST(FluidMatchesReferenceSolver) {
+	CheckFluidMatchesReference(false, 0);
+	CheckFluidMatchesReference(true, 0);
+	CheckFluidMatchesReference(true, 3);
+}
+
+// Time per step of the scalar and SSE solvers on the main thread alone, and of
+// the SSE solver banded across the default number of workers
+TEST(FluidStepTimes) {
+	const int sizes[3] = { 64, 256, 1024 };
+	const int steps[3] = { 20, 4, 1 };
+	const float deltaTime = 1.0f / 60.0f;
+	for (unsigned int i = 0; i < 3; ++i) {
+		double times[3];
+		float sums[3];
+		unsigned int workerCount = 0;
+		for (unsigned int mode = 0; mode < 3; ++mode) {
+			if (mode == 2) {
+				JobSystem::Create();
+				workerCount = JobSystem::GetWorkerCount();
+			}
+			Fluid::useSIMD = mode != 0;
+			Fluid fluid(sizes[i], sizes[i]);
+			fluid.Startup();
+			Clock::time_point start = Clock::now();
+			for (int step = 0; step < steps[i]; ++step) {
+				fluid.Simulate(deltaTime);
+			}
+			times[mode] = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / steps[i];
+			sums[mode] = 0.0f;
+			for (int j = 0; j < fluid.cellCount; ++j) {
+				sums[mode] += fluid.frontCells.velocityY[j];
+			}
+			fluid.Shutdown();
+		}
+		JobSystem::Shutdown();
+		Fluid::useSIMD = true;
+		printf("    %dx%d: scalar %.2fms, SSE %.2fms, SSE with %u workers %.2fms per step\n",
+			sizes[i], sizes[i], times[0], times[1], workerCount, times[2]);
+		CHECK(fabsf(sums[1] - sums[0]) <= 1e-3f * glm::max(1.0f, fabsf(sums[0])));
+		CHECK(sums[2] == sums[1]);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "Test.h"
+
+// Structs
+#include "Frustum.h"
+
+// Other
+#include <chrono>
+#include <cstdlib>
+#include <cfloat>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static float RandomRange(float _min, float _max) {
+	return _min + (_max - _min) * (rand() / (float)RAND_MAX);
+}
+
+// Brute force reference: a box is culled once all eight corners are behind the same plane
+static bool IsOutside(const Frustum& _frustum, const vec3& _center, const vec3& _halfSize) {
+	for (unsigned int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+		const vec4& plane = _frustum.planes[i];
+		bool allBehind = true;
+		for (int corner = 0; corner < 8 && allBehind; ++corner) {
+			vec3 point = _center + vec3(corner & 1 ? _halfSize.x : -_halfSize.x,
+				corner & 2 ? _halfSize.y : -_halfSize.y,
+				corner & 4 ? _halfSize.z : -_halfSize.z);
+			allBehind = glm::dot(vec3(plane), point) + plane.w < 0.0f;
+		}
+		if (allBehind) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Distance of the box's nearest corner from the closest plane it is behind, used to
+// skip boxes that only lie on a plane and so depend on rounding
+static float DistanceToPlanes(const Frustum& _frustum, const vec3& _center, const vec3& _halfSize) {
+	float closest = FLT_MAX;
+	for (unsigned int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+		const vec4& plane = _frustum.planes[i];
+		float distance = glm::dot(vec3(plane), _center) + plane.w +
+			glm::dot(glm::abs(vec3(plane)), _halfSize);
+		closest = glm::min(closest, fabsf(distance));
+	}
+	return closest;
+}
+
+// 100k boxes scattered around a perspective camera, the SIMD and scalar
+// tests have to agree with the corner test on every box
+TEST(FrustumCullMatchesBruteForce) {
+	srand(1);
+	mat4 projection = glm::perspective(75.0f, 16.0f / 9.0f, 0.1f, 500.0f);
+	mat4 view = glm::lookAt(vec3(10, 15, 15), vec3(0), vec3(0, 1, 0));
+	Frustum frustum(projection * view);
+
+	const unsigned int boxCount = 100000;
+	const unsigned int paddedCount = (boxCount + 3) & ~3;
+	vector<float> centerX(paddedCount, 0.0f), centerY(paddedCount, 0.0f), centerZ(paddedCount, 0.0f);
+	vector<float> sizeX(paddedCount, 0.0f), sizeY(paddedCount, 0.0f), sizeZ(paddedCount, 0.0f);
+	for (unsigned int i = 0; i < boxCount; ++i) {
+		centerX[i] = RandomRange(-200.0f, 200.0f);
+		centerY[i] = RandomRange(-200.0f, 200.0f);
+		centerZ[i] = RandomRange(-200.0f, 200.0f);
+		sizeX[i] = RandomRange(0.1f, 5.0f);
+		sizeY[i] = RandomRange(0.1f, 5.0f);
+		sizeZ[i] = RandomRange(0.1f, 5.0f);
+	}
+
+	vector<unsigned char> visible(paddedCount, 0);
+	Clock::time_point start = Clock::now();
+	frustum.IntersectsAABBs(&centerX[0], &centerY[0], &centerZ[0], &sizeX[0], &sizeY[0], &sizeZ[0], boxCount, &visible[0]);
+	double simdTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	unsigned int visibleCount = 0;
+	unsigned int mismatchCount = 0;
+	start = Clock::now();
+	for (unsigned int i = 0; i < boxCount; ++i) {
+		vec3 center(centerX[i], centerY[i], centerZ[i]);
+		vec3 halfSize(sizeX[i], sizeY[i], sizeZ[i]);
+		bool expected = !IsOutside(frustum, center, halfSize);
+		visibleCount += expected ? 1 : 0;
+		if (DistanceToPlanes(frustum, center, halfSize) < 1e-3f) {
+			continue;
+		}
+		Bounds bounds(center, halfSize);
+		if ((visible[i] != 0) != expected || frustum.Intersects(bounds) != expected) {
+			mismatchCount++;
+		}
+	}
+	double bruteForceTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	printf("    %u of %u boxes visible, SIMD %.2fms, brute force %.2fms\n", visibleCount, boxCount, simdTime, bruteForceTime);
+	CHECK(mismatchCount == 0);
+	CHECK(visibleCount > 0 && visibleCount < boxCount);
+}
+
+// Boxes straddling a plane or surrounding the camera must never be culled
+TEST(FrustumKeepsBoxesAroundTheCamera) {
+	mat4 projection = glm::perspective(60.0f, 1.0f, 1.0f, 100.0f);
+	mat4 view = glm::lookAt(vec3(0), vec3(0, 0, -1), vec3(0, 1, 0));
+	Frustum frustum(projection * view);
+
+	CHECK(frustum.Intersects(Bounds(vec3(0, 0, -50), vec3(1))));
+	CHECK(frustum.Intersects(Bounds(vec3(0), vec3(1000))));
+	CHECK(frustum.Intersects(Bounds(vec3(0, 0, -100), vec3(1))));
+	CHECK(!frustum.Intersects(Bounds(vec3(0, 0, 50), vec3(1))));
+	CHECK(!frustum.Intersects(Bounds(vec3(0, 0, -200), vec3(1))));
+	CHECK(!frustum.Intersects(Bounds(vec3(500, 0, -50), vec3(1))));
+}
+
+// Camera runs in the render queue start and end anywhere, so a run is tested straight
+// from the middle of unpadded arrays. Every box of the run gets the scalar answer and
+// nothing outside the run is written
+TEST(FrustumCullUnalignedRuns) {
+	srand(3);
+	mat4 projection = glm::perspective(75.0f, 1.0f, 0.1f, 100.0f);
+	mat4 view = glm::lookAt(vec3(0, 5, 20), vec3(0), vec3(0, 1, 0));
+	Frustum frustum(projection * view);
+
+	const unsigned int boxCount = 23;
+	vector<float> centerX(boxCount), centerY(boxCount), centerZ(boxCount);
+	vector<float> sizeX(boxCount), sizeY(boxCount), sizeZ(boxCount);
+	for (unsigned int i = 0; i < boxCount; ++i) {
+		centerX[i] = RandomRange(-60.0f, 60.0f);
+		centerY[i] = RandomRange(-20.0f, 20.0f);
+		centerZ[i] = RandomRange(-60.0f, 60.0f);
+		sizeX[i] = RandomRange(0.5f, 3.0f);
+		sizeY[i] = RandomRange(0.5f, 3.0f);
+		sizeZ[i] = RandomRange(0.5f, 3.0f);
+	}
+
+	unsigned int mismatchCount = 0;
+	unsigned int overwriteCount = 0;
+	for (unsigned int first = 0; first < boxCount; ++first) {
+		for (unsigned int count = 1; first + count <= boxCount; ++count) {
+			vector<unsigned char> visible(boxCount, 2);
+			frustum.IntersectsAABBs(&centerX[first], &centerY[first], &centerZ[first],
+				&sizeX[first], &sizeY[first], &sizeZ[first], count, &visible[first]);
+			for (unsigned int i = 0; i < boxCount; ++i) {
+				if (i < first || i >= first + count) {
+					overwriteCount += visible[i] != 2 ? 1 : 0;
+					continue;
+				}
+				bool expected = frustum.Intersects(vec3(centerX[i], centerY[i], centerZ[i]), vec3(sizeX[i], sizeY[i], sizeZ[i]));
+				mismatchCount += (visible[i] == 1) != expected ? 1 : 0;
+			}
+		}
+	}
+	CHECK(mismatchCount == 0);
+	CHECK(overwriteCount == 0);
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "Test.h"
+
+// Utilities
+#include "JobSystem.h"
+
+// Other
+#include <chrono>
+#include <cmath>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// Enough arithmetic per item that the batches, not the queues, take the time
+static void Work(unsigned int _begin, unsigned int _end, vector<float>& _results) {
+	for (unsigned int i = _begin; i < _end; ++i) {
+		float value = (float)i;
+		for (int j = 0; j < 64; ++j) {
+			value = sqrtf(value * 1.0001f + 1.0f) + sinf(value);
+		}
+		_results[i] = value;
+	}
+}
+
+// Jobs that wait on a counter only start once every job of that counter has
+// finished, and ParallelFor covers every index exactly once
+TEST(JobSystemDependencies) {
+	JobSystem::Create(4);
+	const unsigned int jobCount = 256;
+	std::atomic<unsigned int> firstDone(0);
+	std::atomic<unsigned int> startedEarly(0);
+	JobCounter first;
+	JobCounter second;
+	for (unsigned int i = 0; i < jobCount; ++i) {
+		JobSystem::Run([&firstDone]() { firstDone++; }, &first);
+	}
+	for (unsigned int i = 0; i < jobCount; ++i) {
+		JobSystem::Run([&firstDone, &startedEarly, jobCount]() {
+			if (firstDone.load() != jobCount) { startedEarly++; }
+		}, &second, &first);
+	}
+	JobSystem::Wait(second);
+	CHECK(first.IsDone() && second.IsDone());
+	CHECK(firstDone.load() == jobCount);
+	CHECK(startedEarly.load() == 0);
+
+	const unsigned int count = 100003;
+	vector<std::atomic<int> > visitCounts(count);
+	for (unsigned int i = 0; i < count; ++i) { visitCounts[i] = 0; }
+	JobSystem::ParallelFor(count, 64, [&visitCounts](unsigned int _begin, unsigned int _end) {
+		for (unsigned int i = _begin; i < _end; ++i) { visitCounts[i]++; }
+	});
+	bool allOnce = true;
+	for (unsigned int i = 0; i < count; ++i) { allOnce = allOnce && visitCounts[i].load() == 1; }
+	CHECK(allOnce);
+	JobSystem::Shutdown();
+}
+
+// The same ParallelFor with 1, 2, 4 and 8 workers against running it on the
+// main thread alone. Speedups only show when the machine has the cores
+TEST(JobSystemScaling) {
+	const unsigned int count = 1 << 16;
+	const unsigned int batchSize = 1024;
+	const int repeats = 3;
+	vector<float> expected(count);
+	Clock::time_point start = Clock::now();
+	for (int repeat = 0; repeat < repeats; ++repeat) {
+		Work(0, count, expected);
+	}
+	double serialTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / repeats;
+	printf("    %u cores, main thread only %.2fms\n", std::thread::hardware_concurrency(), serialTime);
+
+	const unsigned int workerCounts[4] = { 1, 2, 4, 8 };
+	for (unsigned int i = 0; i < 4; ++i) {
+		JobSystem::Create(workerCounts[i]);
+		CHECK(JobSystem::GetWorkerCount() == workerCounts[i]);
+		vector<float> results(count);
+		start = Clock::now();
+		for (int repeat = 0; repeat < repeats; ++repeat) {
+			JobSystem::ParallelFor(count, batchSize, [&results](unsigned int _begin, unsigned int _end) {
+				Work(_begin, _end, results);
+			});
+		}
+		double time = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / repeats;
+
+		// Many tiny jobs show what queueing and stealing costs on its own
+		const unsigned int jobCount = 20000;
+		JobCounter counter;
+		start = Clock::now();
+		for (unsigned int j = 0; j < jobCount; ++j) {
+			JobSystem::Run([]() {}, &counter);
+		}
+		JobSystem::Wait(counter);
+		double jobTime = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / jobCount;
+		JobSystem::Shutdown();
+
+		printf("    %u workers: %.2fms, %.2fx the main thread alone, %.2fus per empty job\n",
+			workerCounts[i], time, serialTime / time, jobTime);
+		CHECK(results == expected);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "Test.h"
+
+// Structs
+#include "MaterialData.h"
+
+// Utilities
+#include "JobSystem.h"
+
+// Other
+#include <algorithm>
+#include <chrono>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// Note(Manny): MaterialData and the glUniform calls need a GL context, so the
+// update rate below is measured on the lookups alone. Property values sit in
+// plain maps standing in for the material, with a sampler slot for a texture.
+
+// The uniforms default-forward-lighting.glsl and forward-lighting-fragment.glh declare
+static const unsigned int UNIFORM_COUNT = 14;
+static const char* UNIFORM_NAMES[UNIFORM_COUNT] = {
+	"T_model", "C_viewProj", "C_eyePos", "R_dirLights", "R_pointLights", "R_DIR_LIGHT_COUNT", "R_POINT_LIGHT_COUNT",
+	"M_diffuse", "M_normalMap", "M_specularPower", "M_specMap", "M_dispMap", "M_dispMapScale", "M_dispMapBias"
+};
+static const char* UNIFORM_TYPES[UNIFORM_COUNT] = {
+	"mat4", "mat4", "vec3", "DirLight", "PointLight", "int", "int",
+	"sampler2D", "sampler2D", "float", "sampler2D", "sampler2D", "float", "float"
+};
+
+// Every thread interning the same names gets the same ids, and different names never share one
+TEST(MaterialPropertyIdsAcrossThreads) {
+	JobSystem::Create(4);
+	const unsigned int count = 1 << 14;
+	const unsigned int nameCount = 512;
+	vector<unsigned int> ids(count);
+	JobSystem::ParallelFor(count, 16, [&ids](unsigned int _begin, unsigned int _end) {
+		for (unsigned int i = _begin; i < _end; ++i) {
+			ids[i] = MaterialData::GetPropertyId("threadedProperty" + std::to_string(i % nameCount));
+		}
+	});
+	JobSystem::Shutdown();
+
+	bool consistent = true;
+	for (unsigned int i = nameCount; i < count; ++i) {
+		consistent = consistent && ids[i] == ids[i % nameCount];
+	}
+	CHECK(consistent);
+	vector<unsigned int> firstIds(ids.begin(), ids.begin() + nameCount);
+	std::sort(firstIds.begin(), firstIds.end());
+	CHECK(std::unique(firstIds.begin(), firstIds.end()) == firstIds.end());
+	CHECK(MaterialData::GetPropertyId("threadedProperty7") == ids[7]);
+}
+
+// Binding every uniform of the lighting shader the way the update functions did
+// before, from the parsed name and type strings, against the per slot binding
+TEST(MaterialUniformUpdateRate) {
+	enum Binding { BINDING_MATRIX, BINDING_VEC3, BINDING_STRUCT, BINDING_INT, BINDING_SAMPLER, BINDING_FLOAT };
+	struct Slot {
+		Binding binding;
+		unsigned int propertyId;
+	};
+	map<string, float> floatsByName;
+	map<string, vec3> vectorsByName;
+	map<string, int> samplersByName;
+	map<unsigned int, float> floats;
+	map<unsigned int, vec3> vectors;
+	map<unsigned int, int> samplers;
+	vector<Slot> slots;
+	for (unsigned int i = 0; i < UNIFORM_COUNT; ++i) {
+		string name = string(UNIFORM_NAMES[i]).substr(2);
+		string type = UNIFORM_TYPES[i];
+		Slot slot;
+		slot.propertyId = MaterialData::GetPropertyId(name);
+		if (type == "mat4") {
+			slot.binding = BINDING_MATRIX;
+		} else if (type == "vec3") {
+			slot.binding = BINDING_VEC3;
+			vectorsByName[name] = vec3((float)i);
+			vectors[slot.propertyId] = vec3((float)i);
+		} else if (type == "int") {
+			slot.binding = BINDING_INT;
+		} else if (type == "sampler2D") {
+			slot.binding = BINDING_SAMPLER;
+			samplersByName[name] = i;
+			samplers[slot.propertyId] = i;
+		} else if (type == "float") {
+			slot.binding = BINDING_FLOAT;
+			floatsByName[name] = (float)i;
+			floats[slot.propertyId] = (float)i;
+		} else {
+			slot.binding = BINDING_STRUCT;
+		}
+		slots.push_back(slot);
+	}
+
+	const unsigned int drawCount = 20000;
+	float sums[2] = { 0.0f, 0.0f };
+	Clock::time_point start = Clock::now();
+	for (unsigned int draw = 0; draw < drawCount; ++draw) {
+		for (unsigned int i = 0; i < UNIFORM_COUNT; ++i) {
+			string uniformName = UNIFORM_NAMES[i];
+			string uniformType = UNIFORM_TYPES[i];
+			string prefix = uniformName.substr(0, 2);
+			string name = uniformName.substr(2);
+			if (prefix != "M_" && prefix != "C_") {
+				continue;
+			}
+			if (uniformType == "sampler2D") {
+				sums[0] += (float)samplersByName[name];
+			} else if (uniformType == "vec3") {
+				sums[0] += vectorsByName[name].x;
+			} else if (uniformType == "float") {
+				sums[0] += floatsByName[name];
+			}
+		}
+	}
+	double nameTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (unsigned int draw = 0; draw < drawCount; ++draw) {
+		for (unsigned int i = 0; i < UNIFORM_COUNT; ++i) {
+			const Slot& slot = slots[i];
+			switch (slot.binding) {
+				case BINDING_SAMPLER: {
+					sums[1] += (float)samplers.find(slot.propertyId)->second;
+					break;
+				}
+				case BINDING_VEC3: {
+					sums[1] += vectors.find(slot.propertyId)->second.x;
+					break;
+				}
+				case BINDING_FLOAT: {
+					sums[1] += floats.find(slot.propertyId)->second;
+					break;
+				}
+				default: {
+					break;
+				}
+			}
+		}
+	}
+	double slotTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+	double updates = (double)drawCount * UNIFORM_COUNT;
+	printf("    %u uniforms per draw: by name %.2fM updates/s, by slot %.2fM updates/s (%.1fx)\n",
+		UNIFORM_COUNT, updates / nameTime / 1000000.0, updates / slotTime / 1000000.0, nameTime / slotTime);
+	CHECK(sums[0] == sums[1]);
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "Test.h"
+
+// Objects
+#include "Mesh.h"
+
+// Other
+#include <cstring>
+
+// A grid of _size by _size quads on the XZ plane, texture coordinates run from 0 to _tiling
+static void CreateGrid(unsigned int _size, float _tiling, MeshData& _mesh) {
+	for (unsigned int z = 0; z <= _size; ++z) {
+		for (unsigned int x = 0; x <= _size; ++x) {
+			_mesh.AddVertex(vec3((float)x, sinf(x * 0.3f) * cosf(z * 0.2f), (float)z));
+			_mesh.AddTexCoord(vec2((float)x / _size, (float)z / _size) * _tiling);
+			_mesh.AddNormal(glm::normalize(vec3(sinf(x * 0.3f), 2.0f, cosf(z * 0.2f))));
+			_mesh.AddTangent(glm::normalize(vec3(1.0f, cosf(x * 0.3f), 0.0f)));
+		}
+	}
+	for (unsigned int z = 0; z < _size; ++z) {
+		for (unsigned int x = 0; x < _size; ++x) {
+			GLuint a = x + z * (_size + 1);
+			GLuint b = a + _size + 1;
+			_mesh.AddFace(a, b, a + 1);
+			_mesh.AddFace(a + 1, b, b + 1);
+		}
+	}
+}
+
+// Every packed attribute has to read back close to what went in
+static bool MatchesPacked(const MeshData& _mesh, const VertexLayout& _layout, const vector<unsigned char>& _vertexData) {
+	const VertexElement* elements = _layout.elements;
+	for (unsigned int i = 0; i < _mesh.positions.size(); ++i) {
+		const unsigned char* vertex = &_vertexData[i * _layout.stride];
+		vec3 position;
+		memcpy(&position, vertex + elements[VERTEX_POSITION].offset, sizeof(vec3));
+		GLuint normal;
+		memcpy(&normal, vertex + elements[VERTEX_NORMAL].offset, sizeof(GLuint));
+		vec2 texCoord;
+		if (elements[VERTEX_TEXCOORD].type == GL_HALF_FLOAT) {
+			GLushort halfs[2];
+			memcpy(halfs, vertex + elements[VERTEX_TEXCOORD].offset, sizeof(halfs));
+			texCoord = vec2(glm::unpackHalf1x16(halfs[0]), glm::unpackHalf1x16(halfs[1]));
+		} else {
+			memcpy(&texCoord, vertex + elements[VERTEX_TEXCOORD].offset, sizeof(vec2));
+		}
+		if (position != _mesh.positions[i] ||
+			glm::length(vec3(glm::unpackSnorm3x10_1x2(normal)) - _mesh.normals[i]) > 4e-3f ||
+			glm::length(texCoord - _mesh.texCoords[i]) > 2e-3f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// A static mesh packs into 24 bytes a vertex with 16-bit indices, down from 76 and 32-bit
+TEST(MeshPackingStaticLayout) {
+	IndexedModel model;
+	model.meshes.resize(1);
+	CreateGrid(32, 1.0f, model.meshes[0]);
+	model.Finalize();
+	const MeshData& mesh = model.meshes[0];
+	CHECK(mesh.IsValid());
+
+	VertexLayout layout = model.ChooseLayout(mesh);
+	vector<unsigned char> vertexData, indexData;
+	GLenum indexType = model.PackVertices(mesh, layout, vertexData, indexData);
+	CHECK(layout.stride == 24);
+	CHECK(layout.elements[VERTEX_TEXCOORD].type == GL_HALF_FLOAT);
+	CHECK(!layout.elements[VERTEX_BONE_INDICES].enabled && !layout.elements[VERTEX_BONE_WEIGHTS].enabled);
+	CHECK(indexType == GL_UNSIGNED_SHORT);
+	CHECK(vertexData.size() == mesh.positions.size() * 24);
+	CHECK(indexData.size() == mesh.indices.size() * sizeof(GLushort));
+	CHECK(MatchesPacked(mesh, layout, vertexData));
+}
+
+// Tiled texture coordinates stay floats, halfs would lose too much precision out there
+TEST(MeshPackingTiledTexCoords) {
+	IndexedModel model;
+	model.meshes.resize(1);
+	CreateGrid(16, 8.0f, model.meshes[0]);
+	model.Finalize();
+
+	VertexLayout layout = model.ChooseLayout(model.meshes[0]);
+	vector<unsigned char> vertexData, indexData;
+	model.PackVertices(model.meshes[0], layout, vertexData, indexData);
+	CHECK(layout.stride == 28);
+	CHECK(layout.elements[VERTEX_TEXCOORD].type == GL_FLOAT);
+	CHECK(MatchesPacked(model.meshes[0], layout, vertexData));
+}
+
+// Skinned meshes add 8 bytes of bone indices and weights
+TEST(MeshPackingSkinnedLayout) {
+	IndexedModel model;
+	model.meshes.resize(1);
+	CreateGrid(4, 1.0f, model.meshes[0]);
+	MeshData& mesh = model.meshes[0];
+	for (unsigned int i = 0; i < mesh.positions.size(); ++i) {
+		mesh.AddBoneIndices(vec4((float)(i % 60), 1, 2, 3));
+		mesh.AddBoneWeights(vec4(0.5f, 0.25f, 0.25f, 0.0f));
+	}
+	model.Finalize();
+	model.skeletons.push_back(nullptr); //Only whether there is a skeleton changes the layout
+
+	VertexLayout layout = model.ChooseLayout(mesh);
+	vector<unsigned char> vertexData, indexData;
+	model.PackVertices(mesh, layout, vertexData, indexData);
+	model.skeletons.clear();
+	CHECK(layout.stride == 32);
+	CHECK(MatchesPacked(mesh, layout, vertexData));
+	for (unsigned int i = 0; i < mesh.positions.size(); ++i) {
+		const unsigned char* boneIndices = &vertexData[i * layout.stride + layout.elements[VERTEX_BONE_INDICES].offset];
+		const unsigned char* boneWeights = &vertexData[i * layout.stride + layout.elements[VERTEX_BONE_WEIGHTS].offset];
+		CHECK(boneIndices[0] == i % 60 && boneIndices[3] == 3);
+		CHECK(boneWeights[0] == 128 && boneWeights[1] == 64 && boneWeights[3] == 0);
+	}
+}
+
+// Past 65536 vertices the indices need 32 bits
+TEST(MeshPackingLargeIndices) {
+	IndexedModel model;
+	model.meshes.resize(1);
+	CreateGrid(256, 1.0f, model.meshes[0]);
+	model.Finalize();
+	const MeshData& mesh = model.meshes[0];
+	CHECK(mesh.positions.size() > 0xFFFF + 1);
+
+	VertexLayout layout = model.ChooseLayout(mesh);
+	vector<unsigned char> vertexData, indexData;
+	GLenum indexType = model.PackVertices(mesh, layout, vertexData, indexData);
+	CHECK(indexType == GL_UNSIGNED_INT);
+	CHECK(indexData.size() == mesh.indices.size() * sizeof(GLuint));
+	CHECK(memcmp(indexData.data(), mesh.indices.data(), indexData.size()) == 0);
+}
\ No newline at end of file
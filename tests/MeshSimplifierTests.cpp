@@ -0,0 +1,235 @@
+#include "Test.h"
+
+// Objects
+#include "Mesh.h"
+
+// Structs
+#include "MeshSimplifier.h"
+
+// Other
+#include <algorithm>
+#include <map>
+using std::map;
+
+// A UV sphere as an importer writes it: the last column repeats the first as a
+// UV seam, and every vertex of the first and last ring sits on a pole
+static void CreateSphere(unsigned int _rings, unsigned int _segments, vector<vec3>& _positions, vector<GLuint>& _indices) {
+	const float pi = 3.14159265f;
+	for (unsigned int ring = 0; ring <= _rings; ++ring) {
+		float latitude = pi * ring / _rings;
+		for (unsigned int segment = 0; segment <= _segments; ++segment) {
+			float longitude = 2.0f * pi * (segment % _segments) / _segments;
+			vec3 position = vec3(sinf(latitude) * cosf(longitude), cosf(latitude), sinf(latitude) * sinf(longitude));
+			if (ring == 0 || ring == _rings) {
+				position = vec3(0, cosf(latitude), 0);
+			}
+			_positions.push_back(position);
+		}
+	}
+	for (unsigned int ring = 0; ring < _rings; ++ring) {
+		for (unsigned int segment = 0; segment < _segments; ++segment) {
+			GLuint a = ring * (_segments + 1) + segment;
+			GLuint b = a + _segments + 1;
+			if (ring != 0) {
+				_indices.push_back(a); _indices.push_back(a + 1); _indices.push_back(b);
+			}
+			if (ring != _rings - 1) {
+				_indices.push_back(a + 1); _indices.push_back(b + 1); _indices.push_back(b);
+			}
+		}
+	}
+}
+
+// Every index in range and no triangle with two corners in the same place
+static bool IsValid(const vector<GLuint>& _indices, const vector<vec3>& _positions) {
+	if (_indices.size() % 3 != 0) {
+		return false;
+	}
+	for (unsigned int i = 0; i < _indices.size(); i += 3) {
+		for (unsigned int j = 0; j < 3; ++j) {
+			if (_indices[i + j] >= _positions.size()) {
+				return false;
+			}
+		}
+		const vec3& a = _positions[_indices[i + 0]];
+		const vec3& b = _positions[_indices[i + 1]];
+		const vec3& c = _positions[_indices[i + 2]];
+		if (a == b || b == c || c == a) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool LessPosition(const vec3& _a, const vec3& _b) {
+	return _a.x != _b.x ? _a.x < _b.x : _a.y != _b.y ? _a.y < _b.y : _a.z < _b.z;
+}
+
+// Closed when every edge between two positions is shared by exactly two
+// triangles, a seam that opened up would leave edges with only one
+static bool IsClosed(const vector<GLuint>& _indices, const vector<vec3>& _positions) {
+	map<vec3, unsigned int, bool(*)(const vec3&, const vec3&)> positionIds(&LessPosition);
+	map<std::pair<unsigned int, unsigned int>, unsigned int> edges;
+	for (unsigned int i = 0; i < _indices.size(); i += 3) {
+		unsigned int ids[3];
+		for (unsigned int j = 0; j < 3; ++j) {
+			ids[j] = positionIds.insert(std::make_pair(_positions[_indices[i + j]], positionIds.size())).first->second;
+		}
+		for (unsigned int j = 0; j < 3; ++j) {
+			unsigned int a = ids[j];
+			unsigned int b = ids[(j + 1) % 3];
+			edges[std::make_pair(std::min(a, b), std::max(a, b))]++;
+		}
+	}
+	for (auto it = edges.begin(); it != edges.end(); ++it) {
+		if (it->second != 2) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Seam vertices are the ones in the first and last column, poles excluded
+static unsigned int CountSeamVertices(const vector<GLuint>& _indices, unsigned int _rings, unsigned int _segments) {
+	vector<bool> used(_indices.size() > 0 ? (_rings + 1) * (_segments + 1) : 0, false);
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < _indices.size(); ++i) {
+		GLuint index = _indices[i];
+		unsigned int ring = index / (_segments + 1);
+		unsigned int segment = index % (_segments + 1);
+		if (!used[index] && ring != 0 && ring != _rings && (segment == 0 || segment == _segments)) {
+			used[index] = true;
+			count++;
+		}
+	}
+	return count;
+}
+
+// Halving a sphere again and again keeps it closed and valid, and the seam
+// simplifies along with the rest of the surface instead of staying at full detail
+TEST(MeshSimplifierKeepsSeamsClosed) {
+	const unsigned int rings = 32;
+	const unsigned int segments = 64;
+	vector<vec3> positions;
+	vector<GLuint> indices;
+	CreateSphere(rings, segments, positions, indices);
+	CHECK(IsValid(indices, positions));
+	CHECK(IsClosed(indices, positions));
+
+	vector<GLuint> previous = indices;
+	vector<GLuint> result;
+	for (unsigned int lod = 0; lod < 3; ++lod) {
+		unsigned int target = previous.size() / 6 * 3;
+		float error = MeshSimplifier::Simplify(previous, positions, target, 1.0f, result);
+		printf("    %u -> %u triangles, error %g, %u of %u seam vertices left\n",
+			(unsigned int)previous.size() / 3, (unsigned int)result.size() / 3, error,
+			CountSeamVertices(result, rings, segments), CountSeamVertices(previous, rings, segments));
+		CHECK(result.size() <= target);
+		CHECK(error >= 0.0f && error <= 1.0f);
+		CHECK(IsValid(result, positions));
+		CHECK(IsClosed(result, positions));
+		CHECK(CountSeamVertices(result, rings, segments) < CountSeamVertices(previous, rings, segments));
+		previous.swap(result);
+	}
+}
+
+// A tight error bound stops the simplifier before the target is reached
+TEST(MeshSimplifierRespectsMaxError) {
+	vector<vec3> positions;
+	vector<GLuint> indices;
+	CreateSphere(16, 32, positions, indices);
+
+	vector<GLuint> result;
+	float maxError = 0.01f;
+	float error = MeshSimplifier::Simplify(indices, positions, 0, maxError, result);
+	printf("    %u -> %u triangles, error %g\n", (unsigned int)indices.size() / 3, (unsigned int)result.size() / 3, error);
+	CHECK(error <= maxError);
+	CHECK(result.size() > 0 && result.size() < indices.size());
+	CHECK(IsValid(result, positions));
+	CHECK(IsClosed(result, positions));
+}
+
+// Corners only touched by triangles without area have no weight in their
+// quadrics, costing collapses there must not put NaNs into the sorted list
+TEST(MeshSimplifierHandlesZeroAreaTriangles) {
+	vector<vec3> positions;
+	vector<GLuint> indices;
+	CreateSphere(16, 32, positions, indices);
+
+	// A tetrahedron flattened onto a line, away from the sphere
+	GLuint first = positions.size();
+	for (unsigned int i = 0; i < 4; ++i) {
+		positions.push_back(vec3(5.0f + i, 0, 0));
+	}
+	const GLuint faces[12] = { 0, 1, 2, 0, 3, 1, 1, 3, 2, 2, 3, 0 };
+	for (unsigned int i = 0; i < 12; ++i) {
+		indices.push_back(first + faces[i]);
+	}
+
+	vector<GLuint> result;
+	float error = MeshSimplifier::Simplify(indices, positions, indices.size() / 6 * 3, 1.0f, result);
+	CHECK(error == error && error <= 1.0f);
+	CHECK(result.size() < indices.size());
+	CHECK(result.size() % 3 == 0);
+	for (unsigned int i = 0; i < result.size(); ++i) {
+		CHECK(result[i] < positions.size());
+	}
+}
+
+// 10k spheres scattered 5m to 500m ahead of a 60 degree camera on a 1080 line screen,
+// which walks forward for a second. The LODs are picked the way MeshRenderer picks them
+TEST(MeshLODTrianglesIn10kScene) {
+	MeshData sphere;
+	CreateSphere(48, 96, sphere.positions, sphere.indices);
+	MeshSimplifier::GenerateLODs(sphere);
+	unsigned int lodCount = sphere.lods.size();
+	float errors[MeshSimplifier::MAX_LODS];
+	for (unsigned int i = 0; i < lodCount; ++i) {
+		errors[i] = sphere.lods[i].error;
+	}
+	CHECK(lodCount > 1);
+
+	srand(7);
+	const unsigned int objectCount = 10000;
+	const int frames = 60;
+	const float radius = glm::length(vec3(1.0f)); //Of the bounds, as MeshRenderer measures it
+	const float pixelScale = 540.0f / tanf(glm::radians(60.0f) * 0.5f);
+	vector<float> distances(objectCount);
+	vector<unsigned int> lods(objectCount, 0);
+	for (unsigned int i = 0; i < objectCount; ++i) {
+		distances[i] = 5.0f + 495.0f * (rand() / (float)RAND_MAX);
+	}
+
+	unsigned long long triangles[2] = { 0, 0 };
+	unsigned int lodChanges = 0;
+	for (int frame = 0; frame < frames; ++frame) {
+		for (unsigned int i = 0; i < objectCount; ++i) {
+			// Objects the camera is inside of always draw at full detail
+			float distance = distances[i] - frame * 0.5f;
+			unsigned int lod = 0;
+			if (distance > radius) {
+				lod = MeshSimplifier::SelectLOD(errors, lodCount, lods[i], radius / distance * pixelScale, 1.0f, 0.25f);
+			}
+			lodChanges += lod != lods[i] && frame > 0 ? 1 : 0;
+			lods[i] = lod;
+			triangles[0] += sphere.lods[0].indexCount / 3;
+			triangles[1] += sphere.lods[lod].indexCount / 3;
+		}
+	}
+	printf("    %u objects, %u LODs: %llu triangles a frame at full detail, %llu with LODs (%.1f%%), %u LOD changes in %d frames\n",
+		objectCount, lodCount, triangles[0] / frames, triangles[1] / frames, 100.0 * triangles[1] / triangles[0], lodChanges, frames);
+	CHECK(triangles[1] * 4 < triangles[0]);
+
+	// An object sitting where LOD 1 gets picked and wobbling back and forth by a
+	// hundredth of a percent keeps its LOD instead of switching every frame
+	float switchPixels = 1.0f * (1.0f - 0.25f) / errors[1];
+	unsigned int lod = MeshSimplifier::SelectLOD(errors, lodCount, 0, switchPixels, 1.0f, 0.25f);
+	unsigned int wobbleChanges = 0;
+	for (int frame = 0; frame < 100; ++frame) {
+		float pixels = switchPixels * (frame % 2 == 0 ? 1.0001f : 0.9999f);
+		unsigned int next = MeshSimplifier::SelectLOD(errors, lodCount, lod, pixels, 1.0f, 0.25f);
+		wobbleChanges += next != lod ? 1 : 0;
+		lod = next;
+	}
+	CHECK(wobbleChanges <= 1);
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "Test.h"
+
+// Structs
+#include "ParticleSystem.h"
+
+// Utilities
+#include "JobSystem.h"
+
+// Other
+#include <chrono>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// A million particles falling for one second, once on the main thread alone and
+// once across the default number of workers. There are no colliders in the
+// tests, so this is gravity, drag, ageing and removal only
+TEST(ParticleSystemMillionUpdate) {
+	const unsigned int particleCount = 1000000;
+	const int steps = 60;
+	const float deltaTime = 1.0f / 60.0f;
+	const vec3 gravity(0, -9.807f, 0);
+	vector<vec4> written[2];
+	unsigned int counts[2];
+	double times[2];
+	unsigned int workerCount = 0;
+	for (unsigned int threaded = 0; threaded < 2; ++threaded) {
+		if (threaded == 1) {
+			JobSystem::Create();
+			workerCount = JobSystem::GetWorkerCount();
+		}
+		ParticleSystem system;
+		system.Reserve(particleCount);
+		for (unsigned int i = 0; i < particleCount; ++i) {
+			// Lifetimes stay clear of one second, so exactly a quarter die
+			float lifetime = 0.25f + (i % 8) * 0.5f;
+			system.Emit(vec3((float)(i % 1000), 10.0f, (float)(i / 1000)), vec3(1.0f, 5.0f, 0.0f), lifetime);
+		}
+		CHECK(system.GetCount() == particleCount);
+		CHECK(!system.Emit(vec3(0), vec3(0), 1.0f));
+
+		times[threaded] = 0.0;
+		for (int step = 0; step < steps; ++step) {
+			Clock::time_point start = Clock::now();
+			system.Update(deltaTime, gravity);
+			times[threaded] += std::chrono::duration<double, std::milli>(Clock::now() - start).count() / steps;
+		}
+		counts[threaded] = system.GetCount();
+		written[threaded].resize(system.GetCount());
+		system.Write(&written[threaded][0]);
+		JobSystem::Shutdown();
+	}
+	printf("    %u particles: main thread %.2fms, %u workers %.2fms per update, %u alive after a second\n",
+		particleCount, times[0], workerCount, times[1], counts[0]);
+	CHECK(counts[0] == particleCount * 3 / 4);
+	CHECK(counts[1] == counts[0]);
+	CHECK(written[1] == written[0]);
+
+	// Every survivor rose and fell like one particle stepped on its own, and is part way through its life
+	ParticleSystem reference;
+	float velocityY = 5.0f;
+	float positionY = 10.0f;
+	for (int step = 0; step < steps; ++step) {
+		velocityY = (velocityY + gravity.y * deltaTime) * (1.0f - reference.drag * deltaTime);
+		positionY += velocityY * deltaTime;
+	}
+	bool alive = true;
+	for (unsigned int i = 0; i < written[0].size(); ++i) {
+		alive = alive && written[0][i].w > 0.0f && written[0][i].w < 1.0f && fabsf(written[0][i].y - positionY) < 1e-4f;
+	}
+	CHECK(alive);
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "Test.h"
+
+// Structs
+#include "TriangleTree.h"
+
+// Other
+#include <chrono>
+#include <cstdlib>
+#include <cfloat>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static float RandomRange(float _min, float _max) {
+	return _min + (_max - _min) * (rand() / (float)RAND_MAX);
+}
+
+// Rolling terrain with a soup of loose triangles floating above it
+static void CreateScene(vector<vec3>& _positions, vector<unsigned int>& _indices) {
+	const unsigned int size = 128;
+	for (unsigned int z = 0; z <= size; ++z) {
+		for (unsigned int x = 0; x <= size; ++x) {
+			float height = sinf(x * 0.2f) * cosf(z * 0.15f) * 3.0f + RandomRange(-0.2f, 0.2f);
+			_positions.push_back(vec3((float)x - size * 0.5f, height, (float)z - size * 0.5f));
+		}
+	}
+	for (unsigned int z = 0; z < size; ++z) {
+		for (unsigned int x = 0; x < size; ++x) {
+			unsigned int a = x + z * (size + 1);
+			unsigned int b = a + size + 1;
+			_indices.push_back(a); _indices.push_back(b); _indices.push_back(a + 1);
+			_indices.push_back(a + 1); _indices.push_back(b); _indices.push_back(b + 1);
+		}
+	}
+	for (unsigned int i = 0; i < 2000; ++i) {
+		vec3 center(RandomRange(-60.0f, 60.0f), RandomRange(5.0f, 40.0f), RandomRange(-60.0f, 60.0f));
+		for (unsigned int j = 0; j < 3; ++j) {
+			_indices.push_back(_positions.size());
+			_positions.push_back(center + vec3(RandomRange(-2.0f, 2.0f), RandomRange(-2.0f, 2.0f), RandomRange(-2.0f, 2.0f)));
+		}
+	}
+}
+
+// Closest two sided hit over every triangle, _smallestWeight is near zero when the ray grazes an edge
+static bool RaycastBruteForce(const vector<vec3>& _positions, const vector<unsigned int>& _indices,
+	const Ray& _ray, float _maxDistance, float& _distance, float& _smallestWeight) {
+	bool found = false;
+	_distance = _maxDistance;
+	for (unsigned int i = 0; i < _indices.size(); i += 3) {
+		const vec3& a = _positions[_indices[i + 0]];
+		vec3 edge1 = _positions[_indices[i + 1]] - a;
+		vec3 edge2 = _positions[_indices[i + 2]] - a;
+		vec3 p = glm::cross(_ray.direction, edge2);
+		float determinant = glm::dot(edge1, p);
+		if (fabsf(determinant) <= 1e-12f) {
+			continue;
+		}
+		float inverseDeterminant = 1.0f / determinant;
+		vec3 offset = _ray.origin - a;
+		float u = glm::dot(offset, p) * inverseDeterminant;
+		vec3 q = glm::cross(offset, edge1);
+		float v = glm::dot(_ray.direction, q) * inverseDeterminant;
+		float distance = glm::dot(edge2, q) * inverseDeterminant;
+		if (u < 0.0f || v < 0.0f || u + v > 1.0f || distance < 0.0f || distance >= _distance) {
+			continue;
+		}
+		found = true;
+		_distance = distance;
+		_smallestWeight = glm::min(glm::min(u, v), 1.0f - u - v);
+	}
+	return found;
+}
+
+// Rays from all around the scene have to hit the same surface at the same distance
+// as a test against every triangle. Rays grazing an edge are skipped, either
+// neighbour is a right answer there.
+TEST(TriangleTreeRaycastMatchesBruteForce) {
+	srand(7);
+	vector<vec3> positions;
+	vector<unsigned int> indices;
+	CreateScene(positions, indices);
+	TriangleTree tree;
+	tree.AddMesh(positions, indices);
+	tree.Build();
+	CHECK(tree.GetTriangleCount() == indices.size() / 3);
+
+	const unsigned int rayCount = 2000;
+	vector<Ray> rays;
+	for (unsigned int i = 0; i < rayCount; ++i) {
+		vec3 origin(RandomRange(-80.0f, 80.0f), RandomRange(-10.0f, 60.0f), RandomRange(-80.0f, 80.0f));
+		vec3 target(RandomRange(-64.0f, 64.0f), RandomRange(-5.0f, 20.0f), RandomRange(-64.0f, 64.0f));
+		rays.push_back(Ray(origin, glm::normalize(target - origin)));
+	}
+
+	unsigned int hitCount = 0;
+	unsigned int mismatchCount = 0;
+	double treeTime = 0.0, bruteForceTime = 0.0;
+	for (unsigned int i = 0; i < rayCount; ++i) {
+		Clock::time_point start = Clock::now();
+		TriangleHit hit;
+		bool treeHit = tree.Raycast(rays[i], 1000.0f, hit);
+		treeTime += std::chrono::duration<double>(Clock::now() - start).count();
+
+		start = Clock::now();
+		float distance, smallestWeight;
+		bool expectedHit = RaycastBruteForce(positions, indices, rays[i], 1000.0f, distance, smallestWeight);
+		bruteForceTime += std::chrono::duration<double>(Clock::now() - start).count();
+
+		hitCount += expectedHit ? 1 : 0;
+		if (expectedHit && smallestWeight < 1e-4f) {
+			continue;
+		}
+		if (treeHit != expectedHit || (expectedHit && fabsf(hit.distance - distance) > 1e-3f * glm::max(1.0f, distance))) {
+			mismatchCount++;
+		}
+	}
+	printf("    %u triangles, %u of %u rays hit, tree %.0f rays/s, brute force %.0f rays/s\n",
+		tree.GetTriangleCount(), hitCount, rayCount, rayCount / treeTime, rayCount / bruteForceTime);
+	CHECK(mismatchCount == 0);
+	CHECK(hitCount > rayCount / 4 && hitCount < rayCount);
+}
+
+// A world ray against the placed tree keeps its distances in world units
+TEST(TriangleTreeRaycastInWorldSpace) {
+	srand(8);
+	vector<vec3> positions;
+	vector<unsigned int> indices;
+	CreateScene(positions, indices);
+	TriangleTree tree;
+	tree.AddMesh(positions, indices);
+	tree.Build();
+
+	mat4 worldMatrix = glm::translate(vec3(10, -5, 30)) * glm::rotate(40.0f, vec3(0, 1, 0)) * glm::scale(vec3(2.0f));
+	vector<vec3> worldPositions;
+	for (unsigned int i = 0; i < positions.size(); ++i) {
+		worldPositions.push_back(vec3(worldMatrix * vec4(positions[i], 1.0f)));
+	}
+
+	unsigned int mismatchCount = 0;
+	for (unsigned int i = 0; i < 500; ++i) {
+		vec3 origin(RandomRange(-150.0f, 150.0f), RandomRange(20.0f, 100.0f), RandomRange(-150.0f, 150.0f));
+		// Aim inside a random triangle so every ray hits something
+		unsigned int triangle = (rand() % (indices.size() / 3)) * 3;
+		vec3 weights(RandomRange(0.1f, 1.0f), RandomRange(0.1f, 1.0f), RandomRange(0.1f, 1.0f));
+		weights /= weights.x + weights.y + weights.z;
+		vec3 target = worldPositions[indices[triangle + 0]] * weights.x +
+			worldPositions[indices[triangle + 1]] * weights.y + worldPositions[indices[triangle + 2]] * weights.z;
+		Ray ray(origin, glm::normalize(target - origin));
+
+		TriangleHit hit;
+		bool treeHit = tree.Raycast(ray, worldMatrix, 1000.0f, hit);
+		float distance, smallestWeight;
+		bool expectedHit = RaycastBruteForce(worldPositions, indices, ray, 1000.0f, distance, smallestWeight);
+		if (expectedHit && smallestWeight < 1e-4f) {
+			continue;
+		}
+		if (!treeHit || !expectedHit || fabsf(hit.distance - distance) > 1e-3f * glm::max(1.0f, distance)) {
+			mismatchCount++;
+		}
+	}
+	CHECK(mismatchCount == 0);
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "Test.h"
+
+// Sub-engines
+#include "RenderingEngine.h"
+
+// Other
+#include <algorithm>
+#include <cstdlib>
+
+struct DrawState {
+	unsigned int program;
+	unsigned int material;
+	unsigned int vao;
+	unsigned int lod;
+	float depth;
+	inline bool SameState(const DrawState& _other) const {
+		return program == _other.program && material == _other.material && vao == _other.vao && lod == _other.lod;
+	}
+};
+
+// Sorting by key has to leave every combination of shader, material, mesh and
+// LOD in one unbroken run, which is what lets FindInstanceRun collapse it into
+// a single instanced draw, and draw each run front to back
+TEST(SortKeysKeepInstanceRunsTogether) {
+	srand(5);
+	const unsigned int itemCount = 50000;
+	vector<std::pair<unsigned long long, DrawState> > items;
+	for (unsigned int i = 0; i < itemCount; ++i) {
+		DrawState state = { 1u + rand() % 4, 1u + rand() % 6, 1u + rand() % 5, (unsigned int)rand() % 4, rand() / (float)RAND_MAX };
+		items.push_back(std::make_pair(RenderingEngine::PackSortKey(state.program, state.material, state.vao, state.lod, state.depth), state));
+	}
+	std::sort(items.begin(), items.end(), [](const std::pair<unsigned long long, DrawState>& _a,
+		const std::pair<unsigned long long, DrawState>& _b) { return _a.first < _b.first; });
+
+	unsigned int runCount = 1;
+	unsigned int outOfOrderCount = 0;
+	unsigned int splitRunCount = 0;
+	for (unsigned int i = 1; i < itemCount; ++i) {
+		const DrawState& previous = items[i - 1].second;
+		const DrawState& state = items[i].second;
+		if (previous.SameState(state)) {
+			outOfOrderCount += state.depth < previous.depth - 1.0f / 0x3fff ? 1 : 0;
+			continue;
+		}
+		runCount++;
+		// A state seen before this run started means its run was split
+		for (unsigned int j = 0; j + 1 < i; ++j) {
+			if (items[j].second.SameState(state)) {
+				splitRunCount++;
+				break;
+			}
+		}
+	}
+	printf("    %u items sorted into %u runs\n", itemCount, runCount);
+	CHECK(runCount == 4 * 6 * 5 * 4);
+	CHECK(splitRunCount == 0);
+	CHECK(outOfOrderCount == 0);
+}
+
+// Each field keeps to its own bits, so a large id never changes the order of the fields above it
+TEST(SortKeyFieldsDoNotOverlap) {
+	CHECK(RenderingEngine::PackSortKey(0xfff, 0xfffff, 0xffff, 3, 1.0f) == ~0ULL);
+	CHECK(RenderingEngine::PackSortKey(0, 0, 0, 0, 0.0f) == 0ULL);
+	CHECK(RenderingEngine::PackSortKey(1, 0, 0, 0, 0.0f) > RenderingEngine::PackSortKey(0, 0xfffff, 0xffff, 3, 1.0f));
+	CHECK(RenderingEngine::PackSortKey(1, 1, 0, 0, 0.0f) > RenderingEngine::PackSortKey(1, 0, 0xffff, 3, 1.0f));
+	CHECK(RenderingEngine::PackSortKey(1, 1, 1, 0, 0.0f) > RenderingEngine::PackSortKey(1, 1, 0, 3, 1.0f));
+	CHECK(RenderingEngine::PackSortKey(1, 1, 1, 1, 0.0f) > RenderingEngine::PackSortKey(1, 1, 1, 0, 1.0f));
+	CHECK(RenderingEngine::PackSortKey(1, 1, 1, 7, 0.5f) == RenderingEngine::PackSortKey(1, 1, 1, 3, 0.5f));
+	CHECK(RenderingEngine::PackSortKey(1, 1, 1, 0, 2.0f) == RenderingEngine::PackSortKey(1, 1, 1, 0, 1.0f));
+	CHECK(RenderingEngine::PackSortKey(1, 1, 1, 0, -1.0f) == RenderingEngine::PackSortKey(1, 1, 1, 0, 0.0f));
+}
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "Test.h"
+
+// Utilities
+#include "BoundsTree.h"
+
+// Other
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cfloat>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// Note(Manny): The SpatialIndex answers every query from a BoundsTree over the
+// renderers' world bounds. Renderers need a GL context, so these checks build
+// the tree over plain boxes instead.
+
+static float RandomRange(float _min, float _max) {
+	return _min + (_max - _min) * (rand() / (float)RAND_MAX);
+}
+
+// Objects of mixed sizes scattered through a city sized block
+static void CreateBoxes(unsigned int _count, float _extent, vector<Bounds>& _boxes) {
+	_boxes.resize(_count);
+	for (unsigned int i = 0; i < _count; ++i) {
+		vec3 center(RandomRange(-_extent, _extent), RandomRange(0.0f, _extent * 0.1f), RandomRange(-_extent, _extent));
+		vec3 halfSize(RandomRange(0.25f, 2.0f), RandomRange(0.25f, 4.0f), RandomRange(0.25f, 2.0f));
+		_boxes[i].center = center;
+		_boxes[i].size = halfSize;
+		_boxes[i].min = center - halfSize;
+		_boxes[i].max = center + halfSize;
+	}
+}
+static void GetPointers(vector<Bounds>& _boxes, vector<const Bounds*>& _pointers) {
+	_pointers.resize(_boxes.size());
+	for (unsigned int i = 0; i < _boxes.size(); ++i) {
+		_pointers[i] = &_boxes[i];
+	}
+}
+static Ray RandomRay(float _extent) {
+	vec3 origin(RandomRange(-_extent, _extent), RandomRange(0.0f, _extent * 0.2f), RandomRange(-_extent, _extent));
+	vec3 target(RandomRange(-_extent, _extent), RandomRange(0.0f, _extent * 0.1f), RandomRange(-_extent, _extent));
+	return Ray(origin, glm::normalize(target - origin));
+}
+
+// The same slab test the tree uses, a ray starting inside the box hits it at 0
+static bool IntersectBox(const Bounds& _box, const Ray& _ray, float _maxDistance, float& _distance) {
+	vec3 t0 = (_box.min - _ray.origin) * _ray.invDirection;
+	vec3 t1 = (_box.max - _ray.origin) * _ray.invDirection;
+	vec3 tNear = glm::min(t0, t1);
+	vec3 tFar = glm::max(t0, t1);
+	_distance = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+	return _distance <= glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, _maxDistance));
+}
+static float GetDistanceSquared(const Bounds& _box, const vec3& _point) {
+	vec3 offset = glm::max(glm::max(_box.min - _point, _point - _box.max), vec3(0.0f));
+	return glm::dot(offset, offset);
+}
+
+// Only even items count as hits, the way the index skips unselectable objects
+static bool IntersectEven(unsigned int _item, float _maxDistance, float& _distance) {
+	return _item % 2 == 0;
+}
+static bool RaycastBruteForce(const vector<Bounds>& _boxes, const Ray& _ray, float _maxDistance, float& _closest) {
+	bool found = false;
+	_closest = _maxDistance;
+	for (unsigned int i = 0; i < _boxes.size(); i += 2) {
+		float distance;
+		if (IntersectBox(_boxes[i], _ray, _closest, distance) && distance < _closest) {
+			_closest = distance;
+			found = true;
+		}
+	}
+	return found;
+}
+static void OverlapSphereBruteForce(const vector<Bounds>& _boxes, const vec3& _center, float _radius, vector<unsigned int>& _items) {
+	_items.clear();
+	for (unsigned int i = 0; i < _boxes.size(); ++i) {
+		if (GetDistanceSquared(_boxes[i], _center) <= _radius * _radius) {
+			_items.push_back(i);
+		}
+	}
+}
+static void KNearestBruteForce(const vector<Bounds>& _boxes, const vec3& _point, unsigned int _count, vector<float>& _distances) {
+	_distances.resize(_boxes.size());
+	for (unsigned int i = 0; i < _boxes.size(); ++i) {
+		_distances[i] = GetDistanceSquared(_boxes[i], _point);
+	}
+	std::partial_sort(_distances.begin(), _distances.begin() + _count, _distances.end());
+	_distances.resize(_count);
+}
+
+// Every query has to find what testing all boxes finds, before and after the boxes move
+static unsigned int CheckQueries(const BoundsTree& _tree, const vector<Bounds>& _boxes, float _extent) {
+	unsigned int mismatches = 0;
+	for (unsigned int i = 0; i < 200; ++i) {
+		Ray ray = RandomRay(_extent);
+		unsigned int item = 0;
+		float distance = 0.0f;
+		float expected;
+		bool hit = _tree.Raycast(ray, 1000.0f, &IntersectEven, item, distance);
+		bool expectedHit = RaycastBruteForce(_boxes, ray, 1000.0f, expected);
+		if (hit != expectedHit || (hit && (item % 2 != 0 || distance != expected))) {
+			mismatches++;
+		}
+
+		vector<unsigned int> items;
+		vector<float> distances;
+		_tree.RaycastAll(ray, 1000.0f, &IntersectEven, items, distances);
+		unsigned int expectedCount = 0;
+		for (unsigned int j = 0; j < _boxes.size(); j += 2) {
+			expectedCount += IntersectBox(_boxes[j], ray, 1000.0f, expected) ? 1 : 0;
+		}
+		if (items.size() != expectedCount) {
+			mismatches++;
+		}
+
+		vec3 center(RandomRange(-_extent, _extent), RandomRange(0.0f, _extent * 0.1f), RandomRange(-_extent, _extent));
+		float radius = RandomRange(1.0f, _extent * 0.1f);
+		vector<unsigned int> expectedItems;
+		_tree.OverlapSphere(center, radius, items);
+		OverlapSphereBruteForce(_boxes, center, radius, expectedItems);
+		std::sort(items.begin(), items.end());
+		if (items != expectedItems) {
+			mismatches++;
+		}
+
+		// Ties may come back in either order, so only the distances are compared
+		const unsigned int count = 16;
+		vector<float> expectedDistances;
+		_tree.KNearest(center, count, items);
+		KNearestBruteForce(_boxes, center, count, expectedDistances);
+		bool matches = items.size() == count;
+		for (unsigned int j = 0; matches && j < count; ++j) {
+			matches = GetDistanceSquared(_boxes[items[j]], center) == expectedDistances[j];
+		}
+		if (!matches) {
+			mismatches++;
+		}
+	}
+	return mismatches;
+}
+
+TEST(SpatialIndexMatchesBruteForce) {
+	srand(11);
+	const float extent = 200.0f;
+	vector<Bounds> boxes;
+	CreateBoxes(3000, extent, boxes);
+	vector<const Bounds*> pointers;
+	GetPointers(boxes, pointers);
+	BoundsTree tree;
+	tree.Build(pointers);
+	CHECK(CheckQueries(tree, boxes, extent) == 0);
+
+	// Refitting keeps every query exact, only slower once the boxes spread out
+	for (unsigned int i = 0; i < boxes.size(); ++i) {
+		vec3 offset(RandomRange(-20.0f, 20.0f), RandomRange(-2.0f, 2.0f), RandomRange(-20.0f, 20.0f));
+		boxes[i].center += offset;
+		boxes[i].min += offset;
+		boxes[i].max += offset;
+	}
+	tree.Refit();
+	CHECK(CheckQueries(tree, boxes, extent) == 0);
+
+	// Boxes left out of the build are never returned
+	pointers[0] = nullptr;
+	tree.Build(pointers);
+	vector<unsigned int> items;
+	tree.OverlapBox(boxes[0].center, boxes[0].max - boxes[0].center, items);
+	CHECK(std::find(items.begin(), items.end(), 0u) == items.end());
+}
+
+// Build and refit cost against queries answered by the tree and by testing every box
+TEST(SpatialIndexQueryTimes) {
+	srand(5);
+	const unsigned int counts[2] = { 10000, 100000 };
+	const unsigned int queryCount = 1000;
+	for (unsigned int i = 0; i < 2; ++i) {
+		float extent = sqrtf((float)counts[i]) * 4.0f;
+		vector<Bounds> boxes;
+		CreateBoxes(counts[i], extent, boxes);
+		vector<const Bounds*> pointers;
+		GetPointers(boxes, pointers);
+		BoundsTree tree;
+
+		Clock::time_point start = Clock::now();
+		tree.Build(pointers);
+		double buildTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		start = Clock::now();
+		tree.Refit();
+		double refitTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		vector<Ray> rays;
+		vector<vec3> points;
+		for (unsigned int j = 0; j < queryCount; ++j) {
+			rays.push_back(RandomRay(extent));
+			points.push_back(vec3(RandomRange(-extent, extent), 0.0f, RandomRange(-extent, extent)));
+		}
+		double treeTimes[3] = { 0.0, 0.0, 0.0 };
+		double bruteForceTimes[3] = { 0.0, 0.0, 0.0 };
+		unsigned int mismatches = 0;
+		vector<unsigned int> items;
+		vector<unsigned int> expectedItems;
+		vector<float> distances;
+		for (unsigned int j = 0; j < queryCount; ++j) {
+			unsigned int item;
+			float distance, expected;
+			start = Clock::now();
+			bool hit = tree.Raycast(rays[j], 1000.0f, &IntersectEven, item, distance);
+			treeTimes[0] += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			start = Clock::now();
+			bool expectedHit = RaycastBruteForce(boxes, rays[j], 1000.0f, expected);
+			bruteForceTimes[0] += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			mismatches += hit != expectedHit || (hit && distance != expected) ? 1 : 0;
+
+			start = Clock::now();
+			tree.OverlapSphere(points[j], 10.0f, items);
+			treeTimes[1] += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			start = Clock::now();
+			OverlapSphereBruteForce(boxes, points[j], 10.0f, expectedItems);
+			bruteForceTimes[1] += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			mismatches += items.size() != expectedItems.size() ? 1 : 0;
+
+			start = Clock::now();
+			tree.KNearest(points[j], 8, items);
+			treeTimes[2] += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			start = Clock::now();
+			KNearestBruteForce(boxes, points[j], 8, distances);
+			bruteForceTimes[2] += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			mismatches += GetDistanceSquared(boxes[items.back()], points[j]) != distances.back() ? 1 : 0;
+		}
+		printf("    %u objects: build %.2fms, refit %.2fms\n", counts[i], buildTime, refitTime);
+		printf("      %u queries, tree against brute force: raycast %.2fms / %.2fms, sphere %.2fms / %.2fms, 8 nearest %.2fms / %.2fms\n",
+			queryCount, treeTimes[0], bruteForceTimes[0], treeTimes[1], bruteForceTimes[1], treeTimes[2], bruteForceTimes[2]);
+		CHECK(mismatches == 0);
+	}
+}
\ No newline at end of file
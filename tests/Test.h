@@ -0,0 +1,50 @@
+/*=============================================
+-----------------------------------
+Copyright (c) 2015 Emmanuel Vaccaro
+-----------------------------------
+@file: Test.h
+@date: 16/08/2015
+@author: Emmanuel Vaccaro
+@brief: Registers the headless checks run by
+the Tests project. Nothing here creates a
+window or a GL context.
+===============================================*/
+
+#ifndef _TEST_H_
+#define _TEST_H_
+
+// Other
+#include <vector>
+using std::vector;
+#include <cstdio>
+
+typedef void (*TestFunction)();
+
+struct TestCase {
+	const char* name;
+	TestFunction function;
+};
+
+class TestRegistry {
+public:
+	static bool Register(const char* _name, TestFunction _function);
+	static void Fail(const char* _file, int _line, const char* _expression);
+	static vector<TestCase>& GetTests();
+
+	static unsigned int failureCount; //Failed checks of the test that is running
+};
+
+// Defines a test that runs with the others from TestMain
+#define TEST(_name) \
+	static void _name(); \
+	static bool _name##Registered = TestRegistry::Register(#_name, &_name); \
+	static void _name()
+
+#define CHECK(_expression) \
+	do { \
+		if (!(_expression)) { \
+			TestRegistry::Fail(__FILE__, __LINE__, #_expression); \
+		} \
+	} while (false)
+
+#endif // _TEST_H_
\ No newline at end of file
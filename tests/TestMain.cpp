@@ -0,0 +1,51 @@
+#include "Test.h"
+
+// Other
+#include <chrono>
+#include <cstring>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+unsigned int TestRegistry::failureCount = 0;
+
+bool TestRegistry::Register(const char* _name, TestFunction _function) {
+	TestCase test;
+	test.name = _name;
+	test.function = _function;
+	GetTests().push_back(test);
+	return true;
+}
+void TestRegistry::Fail(const char* _file, int _line, const char* _expression) {
+	printf("    %s(%d): CHECK(%s) failed\n", _file, _line, _expression);
+	failureCount++;
+}
+vector<TestCase>& TestRegistry::GetTests() {
+	static vector<TestCase> tests;
+	return tests;
+}
+
+// Runs every test, or only those whose name contains the first argument
+int main(int _argc, char** _argv) {
+	const char* filter = _argc > 1 ? _argv[1] : nullptr;
+	vector<TestCase>& tests = TestRegistry::GetTests();
+	unsigned int runCount = 0;
+	unsigned int failedCount = 0;
+	for (unsigned int i = 0; i < tests.size(); ++i) {
+		if (filter != nullptr && strstr(tests[i].name, filter) == nullptr) {
+			continue;
+		}
+		printf("[ RUN  ] %s\n", tests[i].name);
+		TestRegistry::failureCount = 0;
+		Clock::time_point start = Clock::now();
+		tests[i].function();
+		double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		printf("[ %s ] %s (%.1fms)\n", TestRegistry::failureCount == 0 ? " OK " : "FAIL", tests[i].name, milliseconds);
+
+		runCount++;
+		if (TestRegistry::failureCount > 0) {
+			failedCount++;
+		}
+	}
+	printf("%u of %u tests passed\n", runCount - failedCount, runCount);
+	return failedCount > 0 ? 1 : 0;
+}
\ No newline at end of file